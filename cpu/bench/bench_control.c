@@ -0,0 +1,466 @@
+/*----------------------------------------------------------------------
+
+                     This file is part of Freetribe
+
+                https://github.com/bangcorrupt/freetribe
+
+                                License
+
+                   GNU AFFERO GENERAL PUBLIC LICENSE
+                      Version 3, 19 November 2007
+
+                           AGPL-3.0-or-later
+
+ Freetribe is free software: you can redistribute it and/or modify it
+under the terms of the GNU Affero General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+                  (at your option) any later version.
+
+     Freetribe is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty
+        of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+          See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+                       Copyright bangcorrupt 2024
+
+----------------------------------------------------------------------*/
+
+/**
+ * @file    bench_control.c
+ *
+ * @brief   Host benchmark of control rate maths.
+ *
+ * Runs the modulation tick the monosynth app ran on the CPU,
+ * once in float with param_scale.h conversions and once with
+ * fixed_control.c, and reports cost per tick and the largest
+ * difference between them.
+ */
+
+/*----- Includes -----------------------------------------------------*/
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "fixed_control.h"
+#include "param_scale.h"
+
+/*----- Macros -------------------------------------------------------*/
+
+#define DEFAULT_TICKS 1000000
+
+/// Control ticks per second, as monosynth CONTROL_RATE.
+#define CONTROL_RATE 1000
+
+/// Ticks between gate changes, so envelopes pass every stage.
+#define GATE_TICKS 700
+
+#define ENV_ATTACK 50
+#define ENV_DECAY 200
+#define ENV_SUSTAIN 0.5f
+#define ENV_RELEASE 300
+#define ENV_TIME_CONSTANTS 5
+
+#define LFO_FREQ 3.0f
+
+#define MOD_DEPTH 0.05f
+#define BASE_CV 0.4f
+
+#define Q31_SCALE 2147483648.0
+
+/// CV is 0.1 per octave.
+#define CENTS_PER_CV 12000
+
+/*----- Typedefs -----------------------------------------------------*/
+
+typedef enum {
+    ENV_IDLE,
+    ENV_ATTACK_STAGE,
+    ENV_DECAY_STAGE,
+    ENV_SUSTAIN_STAGE,
+    ENV_RELEASE_STAGE,
+} e_env_state;
+
+/// Float envelope, same shape as t_adsr.
+typedef struct {
+    e_env_state state;
+    float level;
+    float velocity;
+    float sustain;
+    float attack_step;
+    float decay_coef;
+    float release_coef;
+} t_float_adsr;
+
+typedef struct {
+    float phase;
+    float increment;
+} t_float_lfo;
+
+/// Values sent to DSP by one tick.
+typedef struct {
+    int32_t amp;
+    int32_t cutoff;
+    int32_t freq;
+} t_tick_out;
+
+typedef struct {
+    t_float_adsr amp_env;
+    t_float_adsr filter_env;
+    t_float_lfo amp_lfo;
+    t_float_lfo filter_lfo;
+    t_float_lfo pitch_lfo;
+} t_float_voice;
+
+typedef struct {
+    t_adsr amp_env;
+    t_adsr filter_env;
+    t_tri_lfo amp_lfo;
+    t_tri_lfo filter_lfo;
+    t_tri_lfo pitch_lfo;
+} t_fixed_voice;
+
+/*----- Static variable definitions ----------------------------------*/
+
+static t_float_voice g_float;
+static t_fixed_voice g_fixed;
+
+static volatile int32_t g_sink;
+
+/*----- Extern variable definitions ----------------------------------*/
+
+/*----- Static function prototypes -----------------------------------*/
+
+static void _float_adsr_init(t_float_adsr *env);
+static void _float_adsr_on(t_float_adsr *env, float velocity);
+static void _float_adsr_off(t_float_adsr *env);
+static float _float_adsr_tick(t_float_adsr *env);
+static void _float_lfo_init(t_float_lfo *lfo, float freq);
+static float _float_lfo_tick(t_float_lfo *lfo);
+
+static void _voice_init(void);
+static void _gate(uint32_t tick);
+static t_tick_out _float_tick(void);
+static t_tick_out _fixed_tick(void);
+
+static double _now(void);
+static double _cents(int32_t a, int32_t b);
+static void _report_accuracy(void);
+
+/*----- Extern function implementations ------------------------------*/
+
+int main(int argc, char **argv) {
+
+    uint32_t ticks = DEFAULT_TICKS;
+    uint32_t i;
+    t_tick_out out;
+    double start;
+    double float_ns;
+    double fixed_ns;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:h")) != -1) {
+
+        switch (opt) {
+
+        case 'n':
+            ticks = strtoul(optarg, NULL, 0);
+            break;
+
+        default:
+            fprintf(stderr, "Usage: %s [-n ticks]\n", argv[0]);
+            return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+    _voice_init();
+
+    start = _now();
+    for (i = 0; i < ticks; i++) {
+        _gate(i);
+        out = _float_tick();
+        g_sink = out.amp ^ out.cutoff ^ out.freq;
+    }
+    float_ns = (_now() - start) / ticks;
+
+    _voice_init();
+
+    start = _now();
+    for (i = 0; i < ticks; i++) {
+        _gate(i);
+        out = _fixed_tick();
+        g_sink = out.amp ^ out.cutoff ^ out.freq;
+    }
+    fixed_ns = (_now() - start) / ticks;
+
+    printf("Ticks:          %u\n", ticks);
+    printf("Float tick:     %.1f ns\n", float_ns);
+    printf("Fixed tick:     %.1f ns\n", fixed_ns);
+    printf("Speedup:        %.2f\n", float_ns / fixed_ns);
+
+    _report_accuracy();
+
+    return EXIT_SUCCESS;
+}
+
+/*----- Static function implementations ------------------------------*/
+
+static void _float_adsr_init(t_float_adsr *env) {
+
+    env->state = ENV_IDLE;
+    env->level = 0;
+    env->velocity = 1;
+    env->sustain = ENV_SUSTAIN;
+    env->attack_step = 1000.0f / (ENV_ATTACK * CONTROL_RATE);
+    env->decay_coef =
+        1000.0f * ENV_TIME_CONSTANTS / (ENV_DECAY * CONTROL_RATE);
+    env->release_coef =
+        1000.0f * ENV_TIME_CONSTANTS / (ENV_RELEASE * CONTROL_RATE);
+}
+
+static void _float_adsr_on(t_float_adsr *env, float velocity) {
+
+    env->state = ENV_ATTACK_STAGE;
+    env->velocity = velocity;
+}
+
+static void _float_adsr_off(t_float_adsr *env) {
+
+    if (env->state != ENV_IDLE) {
+        env->state = ENV_RELEASE_STAGE;
+    }
+}
+
+static float _float_adsr_tick(t_float_adsr *env) {
+
+    switch (env->state) {
+
+    case ENV_ATTACK_STAGE:
+
+        env->level += env->attack_step;
+
+        if (env->level >= 1.0f) {
+            env->level = 1.0f;
+            env->state = ENV_DECAY_STAGE;
+        }
+        break;
+
+    case ENV_DECAY_STAGE:
+
+        env->level += (env->sustain - env->level) * env->decay_coef;
+
+        if (env->level - env->sustain <= 1.0f / 256) {
+            env->level = env->sustain;
+            env->state = ENV_SUSTAIN_STAGE;
+        }
+        break;
+
+    case ENV_SUSTAIN_STAGE:
+        env->level = env->sustain;
+        break;
+
+    case ENV_RELEASE_STAGE:
+
+        env->level -= env->level * env->release_coef;
+
+        if (env->level <= 1.0f / 256) {
+            env->level = 0;
+            env->state = ENV_IDLE;
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    return env->level * env->velocity;
+}
+
+static void _float_lfo_init(t_float_lfo *lfo, float freq) {
+
+    lfo->phase = 0;
+    lfo->increment = freq / CONTROL_RATE;
+}
+
+static float _float_lfo_tick(t_float_lfo *lfo) {
+
+    lfo->phase += lfo->increment;
+
+    if (lfo->phase >= 1.0f) {
+        lfo->phase -= 1.0f;
+    }
+
+    return lfo->phase < 0.5f ? lfo->phase * 4 - 1 : 3 - lfo->phase * 4;
+}
+
+static void _voice_init(void) {
+
+    _float_adsr_init(&g_float.amp_env);
+    _float_adsr_init(&g_float.filter_env);
+    _float_lfo_init(&g_float.amp_lfo, LFO_FREQ);
+    _float_lfo_init(&g_float.filter_lfo, LFO_FREQ);
+    _float_lfo_init(&g_float.pitch_lfo, LFO_FREQ);
+
+    adsr_init(&g_fixed.amp_env, ENV_ATTACK, ENV_DECAY,
+              ENV_SUSTAIN * Q31_SCALE, ENV_RELEASE, CONTROL_RATE);
+    adsr_init(&g_fixed.filter_env, ENV_ATTACK, ENV_DECAY,
+              ENV_SUSTAIN * Q31_SCALE, ENV_RELEASE, CONTROL_RATE);
+
+    tri_lfo_init(&g_fixed.amp_lfo, CONTROL_RATE);
+    tri_lfo_init(&g_fixed.filter_lfo, CONTROL_RATE);
+    tri_lfo_init(&g_fixed.pitch_lfo, CONTROL_RATE);
+
+    tri_lfo_set_freq(&g_fixed.amp_lfo, LFO_FREQ * FIXED_FIX16_ONE);
+    tri_lfo_set_freq(&g_fixed.filter_lfo, LFO_FREQ * FIXED_FIX16_ONE);
+    tri_lfo_set_freq(&g_fixed.pitch_lfo, LFO_FREQ * FIXED_FIX16_ONE);
+}
+
+static void _gate(uint32_t tick) {
+
+    if (tick % (GATE_TICKS * 2) == 0) {
+        _float_adsr_on(&g_float.amp_env, 1);
+        _float_adsr_on(&g_float.filter_env, 1);
+        adsr_on(&g_fixed.amp_env, FIXED_Q31_MAX);
+        adsr_on(&g_fixed.filter_env, FIXED_Q31_MAX);
+
+    } else if (tick % (GATE_TICKS * 2) == GATE_TICKS) {
+        _float_adsr_off(&g_float.amp_env);
+        _float_adsr_off(&g_float.filter_env);
+        adsr_off(&g_fixed.amp_env);
+        adsr_off(&g_fixed.filter_env);
+    }
+}
+
+// As monosynth module_process() before modulation moved to DSP.
+static t_tick_out _float_tick(void) {
+
+    t_tick_out out;
+    float amp;
+    float cutoff;
+    float freq;
+
+    amp = _float_adsr_tick(&g_float.amp_env);
+    amp += amp * _float_lfo_tick(&g_float.amp_lfo) * MOD_DEPTH;
+
+    cutoff = BASE_CV;
+    cutoff += _float_adsr_tick(&g_float.filter_env) * MOD_DEPTH;
+    cutoff += _float_lfo_tick(&g_float.filter_lfo) * MOD_DEPTH;
+
+    freq = BASE_CV + _float_lfo_tick(&g_float.pitch_lfo) * MOD_DEPTH;
+
+    out.amp = float_to_fract32(clamp_value(amp));
+    out.cutoff = float_to_fix16(
+        cv_to_filter_freq_oversample(clamp_value(cutoff)));
+    out.freq = float_to_fix16(cv_to_osc_freq(clamp_value(freq)));
+
+    return out;
+}
+
+static t_tick_out _fixed_tick(void) {
+
+    const int32_t depth = MOD_DEPTH * Q31_SCALE;
+    const int32_t base = BASE_CV * Q31_SCALE;
+
+    t_tick_out out;
+    int32_t env;
+    int64_t amp;
+    int64_t cutoff;
+    int64_t freq;
+
+    env = adsr_tick(&g_fixed.amp_env);
+    amp = env;
+    amp += fixed_mul_q31(
+        env, fixed_mul_q31(tri_lfo_tick(&g_fixed.amp_lfo), depth));
+
+    cutoff = base;
+    cutoff += fixed_mul_q31(adsr_tick(&g_fixed.filter_env), depth);
+    cutoff += fixed_mul_q31(tri_lfo_tick(&g_fixed.filter_lfo), depth);
+
+    freq = base;
+    freq += fixed_mul_q31(tri_lfo_tick(&g_fixed.pitch_lfo), depth);
+
+    out.amp = fixed_clamp(amp, -FIXED_Q31_MAX, FIXED_Q31_MAX);
+    out.cutoff = fixed_cv_to_filter_freq_oversample(
+        fixed_clamp(cutoff, -FIXED_Q31_MAX, FIXED_Q31_MAX));
+    out.freq = fixed_cv_to_osc_freq(
+        fixed_clamp(freq, -FIXED_Q31_MAX, FIXED_Q31_MAX));
+
+    return out;
+}
+
+static double _now(void) {
+
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+static double _cents(int32_t a, int32_t b) {
+
+    return fabs(1200 * log2((double)a / b));
+}
+
+// Compare over one gate cycle, float LFO phase drifts after.
+static void _report_accuracy(void) {
+
+    t_tick_out reference;
+    t_tick_out out;
+    double amp_error = 0;
+    double cutoff_error = 0;
+    double freq_error = 0;
+    double note_error = 0;
+    double cv_error = 0;
+    double error;
+    uint32_t i;
+    int32_t cv;
+    int note;
+
+    _voice_init();
+
+    for (i = 0; i < GATE_TICKS * 2; i++) {
+
+        _gate(i);
+        reference = _float_tick();
+        out = _fixed_tick();
+
+        error = fabs((double)out.amp - reference.amp) / Q31_SCALE;
+        amp_error = error > amp_error ? error : amp_error;
+
+        error = _cents(out.cutoff, reference.cutoff);
+        cutoff_error = error > cutoff_error ? error : cutoff_error;
+
+        error = _cents(out.freq, reference.freq);
+        freq_error = error > freq_error ? error : freq_error;
+    }
+
+    // Conversion over MIDI note range.
+    for (note = 0; note < 128; note++) {
+
+        cv = fixed_note_to_cv(note);
+
+        error = _cents(fixed_cv_to_osc_freq(cv),
+                       float_to_fix16(cv_to_osc_freq(note_to_cv(note))));
+        note_error = error > note_error ? error : note_error;
+
+        // Round trip through log2.
+        error = fabs(fixed_freq_to_cv(fixed_cv_to_freq(cv)) - (double)cv) /
+                Q31_SCALE * CENTS_PER_CV;
+        cv_error = error > cv_error ? error : cv_error;
+    }
+
+    printf("Amp error:      %.6f\n", amp_error);
+    printf("Cutoff error:   %.3f cents\n", cutoff_error);
+    printf("Freq error:     %.3f cents\n", freq_error);
+    printf("Note error:     %.3f cents\n", note_error);
+    printf("CV error:       %.3f cents\n", cv_error);
+}
+
+/*----- End of file --------------------------------------------------*/
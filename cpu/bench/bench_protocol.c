@@ -0,0 +1,418 @@
+/*----------------------------------------------------------------------
+
+                     This file is part of Freetribe
+
+                https://github.com/bangcorrupt/freetribe
+
+                                License
+
+                   GNU AFFERO GENERAL PUBLIC LICENSE
+                      Version 3, 19 November 2007
+
+                           AGPL-3.0-or-later
+
+ Freetribe is free software: you can redistribute it and/or modify it
+under the terms of the GNU Affero General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+                  (at your option) any later version.
+
+     Freetribe is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty
+        of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+          See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+                       Copyright bangcorrupt 2024
+
+----------------------------------------------------------------------*/
+
+/**
+ * @file    bench_protocol.c
+ *
+ * @brief   Host test and benchmark of CPU/DSP message framing.
+ *
+ * Feeds random, truncated and bit flipped frames through
+ * protocol_receive(), each followed by idle bytes and a valid
+ * frame.  Every corrupt frame must be counted once, and the
+ * valid frame after it decoded intact.  Then reports encode
+ * and decode throughput.
+ *
+ * Exits with failure if any check fails.
+ */
+
+/*----- Includes -----------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ft_protocol.h"
+
+/*----- Macros -------------------------------------------------------*/
+
+#define DEFAULT_FRAMES 100000
+#define DEFAULT_SEED 1
+
+/// Random frames run past receive buffer to exercise overflow.
+#define RANDOM_MAX (PROTOCOL_ENCODED_MAX * 2)
+
+/// Undetected corruption allowed, per corrupt frame.  CRC-16 passes
+/// about 1 in 65536 corrupt frames, a flipped COBS code byte moves
+/// zeros rather than flipping one decoded bit.
+#define UNDETECTED_LIMIT 1000
+
+/// Payload lengths timed for throughput.
+#define BENCH_SMALL 8
+#define BENCH_LARGE PROTOCOL_PAYLOAD_MAX
+
+/*----- Typedefs -----------------------------------------------------*/
+
+typedef enum {
+    CORRUPT_RANDOM,
+    CORRUPT_TRUNCATE,
+    CORRUPT_FLIP,
+    CORRUPT_KINDS
+} e_corrupt_kind;
+
+/// Last frame passed to handler.
+typedef struct {
+    uint32_t count;
+    uint8_t msg_type;
+    uint8_t msg_id;
+    uint8_t sequence;
+    uint8_t payload[PROTOCOL_PAYLOAD_MAX];
+    uint8_t length;
+} t_received;
+
+/*----- Static variable definitions ----------------------------------*/
+
+static const char *g_kind_names[CORRUPT_KINDS] = {"Random", "Truncated",
+                                                  "Bit flip"};
+
+static t_protocol g_protocol;
+
+static t_received g_received;
+
+static uint32_t g_random;
+
+static volatile uint32_t g_sink;
+
+/*----- Extern variable definitions ----------------------------------*/
+
+/*----- Static function prototypes -----------------------------------*/
+
+static void _handler(uint8_t msg_type, uint8_t msg_id, uint8_t sequence,
+                     uint8_t *payload, uint8_t length);
+
+static uint32_t _rand(void);
+static uint16_t _random_frame(uint8_t *frame, uint8_t *payload,
+                              uint8_t *length);
+static uint16_t _corrupt(e_corrupt_kind kind, uint8_t *frame);
+static void _feed(const uint8_t *bytes, uint16_t length);
+static uint32_t _dropped(void);
+
+static bool _run_checks(uint32_t frames);
+static void _run_bench(uint32_t frames, uint8_t length);
+
+static double _now(void);
+
+/*----- Extern function implementations ------------------------------*/
+
+int main(int argc, char **argv) {
+
+    uint32_t frames = DEFAULT_FRAMES;
+    bool passed;
+    int opt;
+
+    g_random = DEFAULT_SEED;
+
+    while ((opt = getopt(argc, argv, "n:s:h")) != -1) {
+
+        switch (opt) {
+
+        case 'n':
+            frames = strtoul(optarg, NULL, 0);
+            break;
+
+        case 's':
+            g_random = strtoul(optarg, NULL, 0);
+            break;
+
+        default:
+            fprintf(stderr, "Usage: %s [-n frames] [-s seed]\n", argv[0]);
+            return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+    // Xorshift never leaves zero.
+    if (g_random == 0) {
+        g_random = DEFAULT_SEED;
+    }
+
+    passed = _run_checks(frames);
+
+    _run_bench(frames, BENCH_SMALL);
+    _run_bench(frames, BENCH_LARGE);
+
+    printf("%s\n", passed ? "PASS" : "FAIL");
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*----- Static function implementations ------------------------------*/
+
+static void _handler(uint8_t msg_type, uint8_t msg_id, uint8_t sequence,
+                     uint8_t *payload, uint8_t length) {
+
+    g_received.count++;
+    g_received.msg_type = msg_type;
+    g_received.msg_id = msg_id;
+    g_received.sequence = sequence;
+    g_received.length = length;
+
+    memcpy(g_received.payload, payload, length);
+}
+
+static uint32_t _rand(void) {
+
+    g_random ^= g_random << 13;
+    g_random ^= g_random >> 17;
+    g_random ^= g_random << 5;
+
+    return g_random;
+}
+
+// Encode frame with random header and payload.
+static uint16_t _random_frame(uint8_t *frame, uint8_t *payload,
+                              uint8_t *length) {
+
+    uint8_t msg_type = _rand();
+    uint8_t msg_id = _rand();
+    uint8_t sequence = _rand();
+    uint16_t i;
+
+    *length = _rand() % (PROTOCOL_PAYLOAD_MAX + 1);
+
+    for (i = 0; i < *length; i++) {
+        payload[i] = _rand();
+    }
+
+    frame[0] = msg_type;
+    frame[1] = msg_id;
+    frame[2] = sequence;
+
+    return protocol_encode(&g_protocol, msg_type, msg_id, sequence, payload,
+                           *length, &frame[3]);
+}
+
+/**
+ * @brief   Build corrupt frame, ending in a delimiter.
+ *
+ * No zero byte precedes the delimiter, so the receiver
+ * sees exactly one frame.
+ *
+ * @return  Length of corrupt frame.
+ */
+static uint16_t _corrupt(e_corrupt_kind kind, uint8_t *frame) {
+
+    uint8_t payload[PROTOCOL_PAYLOAD_MAX];
+    uint8_t length;
+    uint16_t frame_length = 0;
+    uint16_t position;
+    uint8_t bit;
+    uint16_t i;
+
+    switch (kind) {
+
+    case CORRUPT_RANDOM:
+
+        frame_length = 1 + _rand() % RANDOM_MAX;
+
+        for (i = 0; i < frame_length; i++) {
+            frame[i] = 1 + _rand() % 0xff;
+        }
+        break;
+
+    case CORRUPT_TRUNCATE:
+
+        // Encoded frame follows header used for checks.
+        frame_length = _random_frame(frame, payload, &length) - 1;
+        memmove(frame, &frame[3], frame_length);
+
+        // Keep at least one byte, drop at least one.
+        frame_length = 1 + _rand() % (frame_length - 1);
+        break;
+
+    case CORRUPT_FLIP:
+
+        frame_length = _random_frame(frame, payload, &length) - 1;
+        memmove(frame, &frame[3], frame_length);
+
+        position = _rand() % frame_length;
+
+        // Flip bit without making a delimiter.
+        do {
+            bit = 1 << (_rand() % 8);
+        } while ((frame[position] ^ bit) == PROTOCOL_DELIMITER);
+
+        frame[position] ^= bit;
+        break;
+
+    default:
+        break;
+    }
+
+    frame[frame_length++] = PROTOCOL_DELIMITER;
+
+    return frame_length;
+}
+
+static void _feed(const uint8_t *bytes, uint16_t length) {
+
+    while (length--) {
+        protocol_receive(&g_protocol, *bytes++);
+    }
+}
+
+static uint32_t _dropped(void) {
+
+    return g_protocol.stats.crc_errors + g_protocol.stats.frame_errors +
+           g_protocol.stats.overflows;
+}
+
+static bool _run_checks(uint32_t frames) {
+
+    static uint8_t corrupt[RANDOM_MAX + 1];
+    static uint8_t frame[3 + PROTOCOL_ENCODED_MAX];
+
+    const uint8_t idle[] = {PROTOCOL_DELIMITER, PROTOCOL_DELIMITER};
+
+    uint32_t counted[CORRUPT_KINDS] = {0};
+    uint32_t undetected[CORRUPT_KINDS] = {0};
+    uint32_t lost[CORRUPT_KINDS] = {0};
+    uint32_t total[CORRUPT_KINDS] = {0};
+    uint8_t payload[PROTOCOL_PAYLOAD_MAX];
+    e_corrupt_kind kind;
+    t_protocol_stats before;
+    uint32_t received;
+    uint16_t frame_length;
+    uint8_t length;
+    bool passed = true;
+    uint32_t i;
+
+    protocol_init(&g_protocol, _handler);
+
+    for (i = 0; i < frames; i++) {
+
+        kind = i % CORRUPT_KINDS;
+        total[kind]++;
+
+        before = g_protocol.stats;
+
+        _feed(corrupt, _corrupt(kind, corrupt));
+
+        // Each corrupt frame counted as dropped or, rarely, received.
+        if (_dropped() - (before.crc_errors + before.frame_errors +
+                          before.overflows) ==
+            1) {
+            counted[kind]++;
+
+        } else if (g_protocol.stats.rx_frames - before.rx_frames == 1) {
+            undetected[kind]++;
+        }
+
+        // Idle bytes, then a valid frame must decode intact.
+        _feed(idle, sizeof(idle));
+
+        frame_length = _random_frame(frame, payload, &length);
+        received = g_received.count;
+
+        _feed(&frame[3], frame_length);
+
+        if (g_received.count != received + 1 ||
+            g_received.msg_type != frame[0] || g_received.msg_id != frame[1] ||
+            g_received.sequence != frame[2] || g_received.length != length ||
+            memcmp(g_received.payload, payload, length) != 0) {
+
+            lost[kind]++;
+        }
+    }
+
+    printf("%-16s%10s%10s%12s%10s\n", "Corrupt frames", "Total", "Dropped",
+           "Undetected", "Lost");
+
+    for (kind = 0; kind < CORRUPT_KINDS; kind++) {
+
+        printf("%-16s%10u%10u%12u%10u\n", g_kind_names[kind], total[kind],
+               counted[kind], undetected[kind], lost[kind]);
+
+        if (counted[kind] + undetected[kind] != total[kind] ||
+            lost[kind] != 0 ||
+            undetected[kind] * UNDETECTED_LIMIT > total[kind]) {
+
+            passed = false;
+        }
+    }
+
+    printf("CRC errors:     %u\n", g_protocol.stats.crc_errors);
+    printf("Frame errors:   %u\n", g_protocol.stats.frame_errors);
+    printf("Overflows:      %u\n", g_protocol.stats.overflows);
+
+    return passed;
+}
+
+// Time encode and decode of frames with fixed payload length.
+static void _run_bench(uint32_t frames, uint8_t length) {
+
+    static uint8_t frame[PROTOCOL_ENCODED_MAX];
+
+    uint8_t payload[PROTOCOL_PAYLOAD_MAX];
+    uint16_t frame_length = 0;
+    double start;
+    double encode_ns;
+    double decode_ns;
+    uint32_t i;
+
+    for (i = 0; i < length; i++) {
+        payload[i] = _rand();
+    }
+
+    protocol_init(&g_protocol, _handler);
+
+    start = _now();
+    for (i = 0; i < frames; i++) {
+        payload[0] = i;
+        frame_length = protocol_encode(&g_protocol, MSG_TYPE_MODULE, 0, i,
+                                       payload, length, frame);
+        g_sink = frame[frame_length / 2];
+    }
+    encode_ns = (_now() - start) / frames;
+
+    start = _now();
+    for (i = 0; i < frames; i++) {
+        _feed(frame, frame_length);
+    }
+    decode_ns = (_now() - start) / frames;
+
+    printf("Payload %3u:    encode %7.1f ns %7.1f MB/s, "
+           "decode %7.1f ns %7.1f MB/s\n",
+           length, encode_ns, frame_length * 1e3 / encode_ns, decode_ns,
+           frame_length * 1e3 / decode_ns);
+}
+
+static double _now(void) {
+
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+/*----- End of file --------------------------------------------------*/
@@ -0,0 +1,495 @@
+/*----------------------------------------------------------------------
+
+                     This file is part of Freetribe
+
+                https://github.com/bangcorrupt/freetribe
+
+                                License
+
+                   GNU AFFERO GENERAL PUBLIC LICENSE
+                      Version 3, 19 November 2007
+
+                           AGPL-3.0-or-later
+
+ Freetribe is free software: you can redistribute it and/or modify it
+under the terms of the GNU Affero General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+                  (at your option) any later version.
+
+     Freetribe is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty
+        of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+          See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+                       Copyright bangcorrupt 2024
+
+----------------------------------------------------------------------*/
+
+/**
+ * @file    fixed_control.c
+ *
+ * @brief   Fixed point control rate primitives.
+ *
+ * Tick functions use only 32 bit adds, shifts and 32x32 bit
+ * multiplies.  Divisions happen when settings change.
+ */
+
+/*----- Includes -----------------------------------------------------*/
+
+#include <stdint.h>
+
+#include "fixed_control.h"
+
+/*----- Macros -------------------------------------------------------*/
+
+/// Decay and release settle within this many time constants.
+#define ADSR_TIME_CONSTANTS 5
+
+/// Level treated as settled, about -48 dB.
+#define ADSR_SETTLE (FIXED_Q31_MAX >> 8)
+
+#define Q30_ONE (1 << 30)
+
+/// 2^x - 1 for x in [0, 1), Q30, within 0.01 cents.
+#define EXP2_C1 744098419
+#define EXP2_C2 259379085
+#define EXP2_C3 55568583
+#define EXP2_C4 14695737
+
+/// log2(1 + x) for x in [0, 1), Q30, within 0.2 cents.
+#define LOG2_C1 1544119390
+#define LOG2_C2 -724525187
+#define LOG2_C3 340376932
+#define LOG2_C4 -86229311
+
+/// CV is 0.1 per octave, 0 == 27.5 Hz (A0), as param_scale.h.
+#define CV_OCTAVES 10
+#define CV_CENTRE_NOTE 21
+
+/// Q31 CV per semitone, 1 / 120.
+#define CV_PER_NOTE 17895697
+
+/// Q31 of 1 / CV_OCTAVES.
+#define CV_PER_OCTAVE 214748365
+
+/// log2(27.5), fix16.
+#define CV_CENTRE_LOG2 313351
+
+/// Frequency at CV 0 in each destination format, fix16.
+#define CV_CENTRE_FREQ 1802240
+#define CV_CENTRE_OSC_FREQ 1230329
+#define CV_CENTRE_FILTER_FREQ 7730387
+#define CV_CENTRE_FILTER_FREQ_OVERSAMPLE 3865193
+
+/*----- Typedefs -----------------------------------------------------*/
+
+/*----- Static variable definitions ----------------------------------*/
+
+/*----- Extern variable definitions ----------------------------------*/
+
+/*----- Static function prototypes -----------------------------------*/
+
+static uint32_t _ms_to_ticks(uint32_t ms, uint32_t rate);
+static int32_t _time_coef(uint32_t ms, uint32_t rate);
+static int32_t _approach(int32_t level, int32_t target, int32_t coef);
+static int64_t _cv_to_octaves(int32_t cv);
+static int32_t _scale_exp2(int32_t base, int64_t octaves);
+
+/*----- Extern function implementations ------------------------------*/
+
+/**
+ * @brief   Initialise envelope.
+ *
+ * @param[in]   env     Envelope.
+ * @param[in]   attack  Attack time in milliseconds.
+ * @param[in]   decay   Time to settle at sustain in milliseconds.
+ * @param[in]   sustain Sustain level, Q31.
+ * @param[in]   release Time to settle at 0 in milliseconds.
+ * @param[in]   rate    Ticks per second.
+ */
+void adsr_init(t_adsr *env, uint32_t attack, uint32_t decay, int32_t sustain,
+               uint32_t release, uint32_t rate) {
+
+    env->state = ADSR_IDLE;
+    env->level = 0;
+    env->velocity = FIXED_Q31_MAX;
+    env->rate = rate;
+
+    adsr_set_attack(env, attack);
+    adsr_set_decay(env, decay);
+    adsr_set_sustain(env, sustain);
+    adsr_set_release(env, release);
+}
+
+void adsr_set_attack(t_adsr *env, uint32_t attack) {
+
+    uint32_t ticks = _ms_to_ticks(attack, env->rate);
+
+    env->attack_step = ticks > 1 ? FIXED_Q31_MAX / ticks : FIXED_Q31_MAX;
+}
+
+void adsr_set_decay(t_adsr *env, uint32_t decay) {
+
+    env->decay_coef = _time_coef(decay, env->rate);
+}
+
+void adsr_set_sustain(t_adsr *env, int32_t sustain) {
+
+    env->sustain = sustain < 0 ? 0 : sustain;
+}
+
+void adsr_set_release(t_adsr *env, uint32_t release) {
+
+    env->release_coef = _time_coef(release, env->rate);
+}
+
+/**
+ * @brief   Start attack from current level.
+ *
+ * @param[in]   env         Envelope.
+ * @param[in]   velocity    Output scale, Q31.
+ */
+void adsr_on(t_adsr *env, int32_t velocity) {
+
+    env->state = ADSR_ATTACK;
+    env->velocity = velocity < 0 ? 0 : velocity;
+}
+
+void adsr_off(t_adsr *env) {
+
+    if (env->state != ADSR_IDLE) {
+        env->state = ADSR_RELEASE;
+    }
+}
+
+/**
+ * @brief   Advance envelope by one tick.
+ *
+ * @param[in]   env     Envelope.
+ *
+ * @return  Level scaled by velocity, Q31.
+ */
+int32_t adsr_tick(t_adsr *env) {
+
+    switch (env->state) {
+
+    case ADSR_ATTACK:
+
+        if (env->level >= FIXED_Q31_MAX - env->attack_step) {
+            env->level = FIXED_Q31_MAX;
+            env->state = ADSR_DECAY;
+
+        } else {
+            env->level += env->attack_step;
+        }
+        break;
+
+    case ADSR_DECAY:
+
+        env->level = _approach(env->level, env->sustain, env->decay_coef);
+
+        if (env->level - env->sustain <= ADSR_SETTLE) {
+            env->level = env->sustain;
+            env->state = ADSR_SUSTAIN;
+        }
+        break;
+
+    case ADSR_SUSTAIN:
+        env->level = env->sustain;
+        break;
+
+    case ADSR_RELEASE:
+
+        env->level = _approach(env->level, 0, env->release_coef);
+
+        if (env->level <= ADSR_SETTLE) {
+            env->level = 0;
+            env->state = ADSR_IDLE;
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    return fixed_mul_q31(env->level, env->velocity);
+}
+
+/**
+ * @brief   Initialise LFO at phase 0, stopped.
+ *
+ * @param[in]   lfo     LFO.
+ * @param[in]   rate    Ticks per second, at most 65536.
+ */
+void tri_lfo_init(t_tri_lfo *lfo, uint32_t rate) {
+
+    lfo->phase = 0;
+    lfo->increment = 0;
+    lfo->rate = rate;
+}
+
+/**
+ * @brief   Set LFO frequency.
+ *
+ * @param[in]   lfo     LFO.
+ * @param[in]   freq    Frequency in Hz, fix16.
+ */
+void tri_lfo_set_freq(t_tri_lfo *lfo, int32_t freq) {
+
+    uint32_t whole;
+    uint32_t part;
+
+    if (freq <= 0) {
+        lfo->increment = 0;
+        return;
+    }
+
+    // (freq << 16) / rate, without 64 bit division.
+    whole = (uint32_t)freq / lfo->rate;
+    part = (uint32_t)freq % lfo->rate;
+
+    lfo->increment = (whole << 16) + (part << 16) / lfo->rate;
+}
+
+/**
+ * @brief   Set LFO phase.
+ *
+ * @param[in]   lfo     LFO.
+ * @param[in]   phase   Q31, full scale is one cycle.
+ */
+void tri_lfo_set_phase(t_tri_lfo *lfo, int32_t phase) {
+
+    lfo->phase = (uint32_t)phase << 1;
+}
+
+/**
+ * @brief   Advance LFO by one tick.
+ *
+ * @param[in]   lfo     LFO.
+ *
+ * @return  Bipolar triangle, Q31.
+ */
+int32_t tri_lfo_tick(t_tri_lfo *lfo) {
+
+    uint32_t folded;
+
+    lfo->phase += lfo->increment;
+
+    // Rising over first half cycle, falling over second.
+    folded = lfo->phase ^ (uint32_t)((int32_t)lfo->phase >> 31);
+
+    return (int32_t)((folded << 1) - FIXED_Q31_MAX);
+}
+
+/**
+ * @brief   Saturate sum to range.
+ *
+ * @param[in]   value   Wide sum of Q31 or fix16 values.
+ * @param[in]   min     Minimum.
+ * @param[in]   max     Maximum.
+ *
+ * @return  Value within range.
+ */
+int32_t fixed_clamp(int64_t value, int32_t min, int32_t max) {
+
+    if (value < min) {
+        return min;
+    }
+
+    if (value > max) {
+        return max;
+    }
+
+    return value;
+}
+
+// Q31 multiply, single SMULL on ARM926.
+int32_t fixed_mul_q31(int32_t a, int32_t b) {
+
+    return ((int64_t)a * b) >> 31;
+}
+
+/**
+ * @brief   Raise 2 to fixed point power.
+ *
+ * @param[in]   x   Exponent, fix16.
+ *
+ * @return  2^x, fix16, saturated.
+ */
+int32_t fixed_exp2(int32_t x) {
+
+    return _scale_exp2(FIXED_FIX16_ONE, (int64_t)x << 16);
+}
+
+/**
+ * @brief   Base 2 logarithm.
+ *
+ * @param[in]   x   Positive value, fix16.
+ *
+ * @return  log2(x), fix16, or INT32_MIN if x not positive.
+ */
+int32_t fixed_log2(int32_t x) {
+
+    int32_t msb;
+    int32_t mantissa;
+    int64_t result;
+
+    if (x <= 0) {
+        return INT32_MIN;
+    }
+
+    msb = 31 - __builtin_clz(x);
+
+    // Normalise to [1, 2), Q30.
+    mantissa = msb > 30 ? x >> (msb - 30) : x << (30 - msb);
+    mantissa -= Q30_ONE;
+
+    result = ((int64_t)LOG2_C4 * mantissa >> 30) + LOG2_C3;
+    result = (result * mantissa >> 30) + LOG2_C2;
+    result = (result * mantissa >> 30) + LOG2_C1;
+    result = result * mantissa >> 30;
+
+    return ((msb - 16) << 16) + (int32_t)(result >> 14);
+}
+
+/**
+ * @brief   Convert MIDI note to CV.
+ *
+ * @param[in]   note    MIDI note number.
+ *
+ * @return  CV, Q31.
+ */
+int32_t fixed_note_to_cv(uint8_t note) {
+
+    return (note - CV_CENTRE_NOTE) * CV_PER_NOTE;
+}
+
+/**
+ * @brief   Convert CV to frequency.
+ *
+ * @param[in]   cv  CV, Q31.
+ *
+ * @return  Frequency in Hz, fix16, saturated.
+ */
+int32_t fixed_cv_to_freq(int32_t cv) {
+
+    return _scale_exp2(CV_CENTRE_FREQ, _cv_to_octaves(cv));
+}
+
+/**
+ * @brief   Convert frequency to CV.
+ *
+ * @param[in]   freq    Frequency in Hz, fix16.
+ *
+ * @return  CV, Q31, saturated.
+ */
+int32_t fixed_freq_to_cv(int32_t freq) {
+
+    int64_t octaves;
+    int64_t cv;
+
+    if (freq <= 0) {
+        return INT32_MIN;
+    }
+
+    octaves = (int64_t)fixed_log2(freq) - CV_CENTRE_LOG2;
+
+    // Octaves / CV_OCTAVES, fix16 to Q31.
+    cv = (octaves * CV_PER_OCTAVE) >> 16;
+
+    if (cv > INT32_MAX) {
+        return INT32_MAX;
+    }
+
+    if (cv < INT32_MIN) {
+        return INT32_MIN;
+    }
+
+    return cv;
+}
+
+/// Normalised oscillator frequency, fix16, as cv_to_osc_freq().
+int32_t fixed_cv_to_osc_freq(int32_t cv) {
+
+    return _scale_exp2(CV_CENTRE_OSC_FREQ, _cv_to_octaves(cv));
+}
+
+/// Filter frequency in radians, fix16, as cv_to_filter_freq().
+int32_t fixed_cv_to_filter_freq(int32_t cv) {
+
+    return _scale_exp2(CV_CENTRE_FILTER_FREQ, _cv_to_octaves(cv));
+}
+
+/// Filter frequency 2 times oversampled, fix16.
+int32_t fixed_cv_to_filter_freq_oversample(int32_t cv) {
+
+    return _scale_exp2(CV_CENTRE_FILTER_FREQ_OVERSAMPLE, _cv_to_octaves(cv));
+}
+
+/*----- Static function implementations ------------------------------*/
+
+static uint32_t _ms_to_ticks(uint32_t ms, uint32_t rate) {
+
+    return ms * rate / 1000;
+}
+
+// Coefficient settling in given time.
+static int32_t _time_coef(uint32_t ms, uint32_t rate) {
+
+    uint32_t time_constant = _ms_to_ticks(ms, rate) / ADSR_TIME_CONSTANTS;
+
+    return time_constant > 1 ? FIXED_Q31_MAX / time_constant : FIXED_Q31_MAX;
+}
+
+static int32_t _approach(int32_t level, int32_t target, int32_t coef) {
+
+    return level + fixed_mul_q31(target - level, coef);
+}
+
+// Q31 CV to octaves, 32.32.
+static int64_t _cv_to_octaves(int32_t cv) {
+
+    return (int64_t)cv * CV_OCTAVES * 2;
+}
+
+// Scale by 2^octaves, octaves 32.32, result saturated.
+static int32_t _scale_exp2(int32_t base, int64_t octaves) {
+
+    int32_t whole;
+    int32_t x;
+
+    if (octaves >= (int64_t)31 << 32) {
+        return INT32_MAX;
+    }
+
+    if (octaves < -((int64_t)31 << 32)) {
+        return 0;
+    }
+
+    whole = octaves >> 32;
+    x = (uint32_t)octaves >> 2;
+    int64_t result;
+
+    // 2^x for fraction x, Q30.
+    result = ((int64_t)EXP2_C4 * x >> 30) + EXP2_C3;
+    result = (result * x >> 30) + EXP2_C2;
+    result = (result * x >> 30) + EXP2_C1;
+    result = (result * x >> 30) + Q30_ONE;
+
+    result = result * base >> 30;
+
+    if (whole < 0) {
+        return result >> -whole;
+    }
+
+    if (result > (INT32_MAX >> whole)) {
+        return INT32_MAX;
+    }
+
+    return result << whole;
+}
+
+/*----- End of file --------------------------------------------------*/
@@ -0,0 +1,128 @@
+/*----------------------------------------------------------------------
+
+                     This file is part of Freetribe
+
+                https://github.com/bangcorrupt/freetribe
+
+                                License
+
+                   GNU AFFERO GENERAL PUBLIC LICENSE
+                      Version 3, 19 November 2007
+
+                           AGPL-3.0-or-later
+
+ Freetribe is free software: you can redistribute it and/or modify it
+under the terms of the GNU Affero General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+                  (at your option) any later version.
+
+     Freetribe is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty
+        of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+          See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+                       Copyright bangcorrupt 2024
+
+----------------------------------------------------------------------*/
+
+/**
+ * @file    fixed_control.h
+ *
+ * @brief   Public API for fixed point control rate primitives.
+ *
+ * ADSR envelope, triangle LFO and CV conversion without floating
+ * point, for the ARM926EJ-S which has no FPU.  Calls follow LEAF
+ * tADSRT and tTriLFO, with float arguments replaced by Q31 or
+ * fix16 values.
+ */
+
+#ifndef FIXED_CONTROL_H
+#define FIXED_CONTROL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*----- Includes -----------------------------------------------------*/
+
+#include <stdint.h>
+
+/*----- Macros -------------------------------------------------------*/
+
+#define FIXED_Q31_MAX INT32_MAX
+#define FIXED_FIX16_ONE 0x00010000
+
+/*----- Typedefs -----------------------------------------------------*/
+
+typedef enum {
+    ADSR_IDLE,
+    ADSR_ATTACK,
+    ADSR_DECAY,
+    ADSR_SUSTAIN,
+    ADSR_RELEASE,
+} e_adsr_state;
+
+/// Envelope with linear attack, exponential decay and release.
+typedef struct {
+    e_adsr_state state;
+    // Q31.
+    int32_t level;
+    int32_t velocity;
+    int32_t sustain;
+    // Level added per tick.
+    int32_t attack_step;
+    // Fraction of distance to target per tick, Q31.
+    int32_t decay_coef;
+    int32_t release_coef;
+    // Ticks per second.
+    uint32_t rate;
+} t_adsr;
+
+/// Bipolar triangle, -1 at phase 0, +1 at half cycle.
+typedef struct {
+    uint32_t phase;
+    uint32_t increment;
+    // Ticks per second.
+    uint32_t rate;
+} t_tri_lfo;
+
+/*----- Extern variable declarations ---------------------------------*/
+
+/*----- Extern function prototypes -----------------------------------*/
+
+void adsr_init(t_adsr *env, uint32_t attack, uint32_t decay, int32_t sustain,
+               uint32_t release, uint32_t rate);
+void adsr_set_attack(t_adsr *env, uint32_t attack);
+void adsr_set_decay(t_adsr *env, uint32_t decay);
+void adsr_set_sustain(t_adsr *env, int32_t sustain);
+void adsr_set_release(t_adsr *env, uint32_t release);
+void adsr_on(t_adsr *env, int32_t velocity);
+void adsr_off(t_adsr *env);
+int32_t adsr_tick(t_adsr *env);
+
+void tri_lfo_init(t_tri_lfo *lfo, uint32_t rate);
+void tri_lfo_set_freq(t_tri_lfo *lfo, int32_t freq);
+void tri_lfo_set_phase(t_tri_lfo *lfo, int32_t phase);
+int32_t tri_lfo_tick(t_tri_lfo *lfo);
+
+int32_t fixed_clamp(int64_t value, int32_t min, int32_t max);
+int32_t fixed_mul_q31(int32_t a, int32_t b);
+int32_t fixed_exp2(int32_t x);
+int32_t fixed_log2(int32_t x);
+
+int32_t fixed_note_to_cv(uint8_t note);
+int32_t fixed_cv_to_freq(int32_t cv);
+int32_t fixed_freq_to_cv(int32_t freq);
+int32_t fixed_cv_to_osc_freq(int32_t cv);
+int32_t fixed_cv_to_filter_freq(int32_t cv);
+int32_t fixed_cv_to_filter_freq_oversample(int32_t cv);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* FIXED_CONTROL_H */
+
+/*----- End of file --------------------------------------------------*/
@@ -264,6 +264,24 @@ void ft_set_module_param(uint16_t module_id, uint16_t param_index,
     svc_dsp_set_module_param(module_id, param_index, param_value);
 }
 
+/**
+ * @brief   Set parameter of DSP audio module at DSP frame count.
+ *
+ * Register a callback for SYSTEM_FRAME_COUNT event and call
+ * svc_dsp_get_frame_count() to synchronise with the DSP.
+ *
+ * @param[in]   module_id   Index of module to address.
+ * @param[in]   param_index Index of parameter to set.
+ * @param[in]   param_value Value of parameter.
+ * @param[in]   frame       DSP frame count to apply value.
+ *
+ */
+void ft_set_module_param_at(uint16_t module_id, uint16_t param_index,
+                            int32_t param_value, uint32_t frame) {
+
+    svc_dsp_set_module_param_at(module_id, param_index, param_value, frame);
+}
+
 /**
  * @brief   Request parameter value from DSP audio module.
  *
@@ -279,6 +297,205 @@ void ft_get_module_param(uint16_t module_id, uint16_t param_index) {
     svc_dsp_get_module_param(module_id, param_index);
 }
 
+/**
+ * @brief   Read last known parameter value of DSP audio module.
+ *
+ * Returns value from CPU mirror without waiting for the DSP.
+ *
+ * @param[in]   module_id   Index of module to address.
+ * @param[in]   param_index Index of parameter to read.
+ * @param[out]  param_value Value of parameter.
+ *
+ * @return      SUCCESS if value known, otherwise ERROR.
+ */
+t_status ft_read_module_param(uint16_t module_id, uint16_t param_index,
+                              int32_t *param_value) {
+
+    return svc_dsp_read_module_param(module_id, param_index, param_value);
+}
+
+/**
+ * @brief   Refresh CPU mirror with all parameter values of module.
+ *
+ * Values set while the resync runs are kept.
+ *
+ * @param[in]   module_id   Index of module to address.
+ * @param[in]   callback    Called when resync completes, may be NULL.
+ *
+ * @return      SUCCESS if resync started, otherwise ERROR.
+ */
+t_status ft_resync_module_params(uint16_t module_id,
+                                 t_dsp_resync_callback callback) {
+
+    return svc_dsp_resync_module_params(module_id, callback);
+}
+
+/**
+ * @brief   Fetch parameter descriptors of DSP audio module.
+ *
+ * Name, range, initial value, scale and slew time of each
+ * parameter, so the interface need not be hard coded.
+ *
+ * @param[in]   module_id   Index of module to address.
+ * @param[out]  info        Descriptors, indexed by param_index.
+ * @param[in]   capacity    Descriptors held by info.
+ * @param[in]   callback    Called with parameter count of module.
+ *
+ * @return  ERROR if a query is already running.
+ */
+t_status ft_get_module_info(uint16_t module_id, t_dsp_param_info *info,
+                            uint16_t capacity,
+                            t_dsp_param_info_callback callback) {
+
+    return svc_dsp_get_module_info(module_id, info, capacity, callback);
+}
+
+/**
+ * @brief   Configure DSP envelope or LFO.
+ *
+ * Times in milliseconds, sustain and phase Q31,
+ * LFO rate fix16 Hz.
+ *
+ * @param[in]   source  Envelope or LFO, see e_mod_source.
+ * @param[in]   setting Setting to change, see e_mod_setting.
+ * @param[in]   value   Value of setting.
+ */
+void ft_set_mod_source(uint8_t source, uint8_t setting, int32_t value) {
+
+    svc_dsp_set_mod_source(source, setting, value);
+}
+
+/**
+ * @brief   Open or close DSP envelope gates.
+ *
+ * @param[in]   mask        Bit per envelope to gate.
+ * @param[in]   gate        True to open.
+ * @param[in]   velocity    Q31 velocity, ignored when closing.
+ */
+void ft_set_mod_gate(uint8_t mask, bool gate, int32_t velocity) {
+
+    svc_dsp_set_mod_gate(mask, gate, velocity);
+}
+
+/**
+ * @brief   Route DSP modulation source to module parameter.
+ *
+ * Envelopes and LFOs run on the DSP at block rate,
+ * routed values replace per tick parameter updates.
+ *
+ * @param[in]   route   Index of route, below PROTOCOL_MOD_ROUTES.
+ * @param[in]   config  Route configuration.
+ */
+void ft_set_mod_route(uint8_t route, const t_dsp_mod_route *config) {
+
+    svc_dsp_set_mod_route(route, config);
+}
+
+/**
+ * @brief   Send request to DSP with completion callback.
+ *
+ * Several requests may be outstanding, each callback receives
+ * its own response payload, or TIMEOUT_ERROR.
+ *
+ * @param[in]   msg_type    Message type.
+ * @param[in]   msg_id      Message id.
+ * @param[in]   payload     Request payload.
+ * @param[in]   length      Length of payload.
+ * @param[in]   callback    Completion callback.
+ * @param[in]   context     Passed to callback.
+ *
+ * @return  ERROR if too many requests outstanding.
+ */
+t_status ft_dsp_request(uint8_t msg_type, uint8_t msg_id, uint8_t *payload,
+                        uint8_t length, t_dsp_request_callback callback,
+                        void *context) {
+
+    return svc_dsp_request(msg_type, msg_id, payload, length, callback,
+                           context);
+}
+
+/**
+ * @brief   Measure DSP link throughput and round trip latency.
+ *
+ * Repeat with several lengths to compare payload sizes.
+ *
+ * @param[in]   length      Echo payload length.
+ * @param[in]   count       Number of echo requests.
+ * @param[in]   callback    Called with results.
+ *
+ * @return  ERROR if benchmark already running.
+ */
+t_status ft_dsp_benchmark(uint8_t length, uint32_t count,
+                          t_dsp_benchmark_callback callback) {
+
+    return svc_dsp_benchmark(length, count, callback);
+}
+
+/**
+ * @brief   Select link for DSP requests and bulk transfers.
+ *
+ * HostDP is used once the DSP reports its mailbox,
+ * realtime messages always use SPI.
+ *
+ * @param[in]   transport   DSP_TRANSPORT_SPI or DSP_TRANSPORT_HOSTDP.
+ *
+ * @return  ERROR if mailbox request could not be sent.
+ */
+t_status ft_dsp_set_bulk_transport(t_dsp_transport transport) {
+
+    return svc_dsp_set_bulk_transport(transport);
+}
+
+/**
+ * @brief   Start DSP pushing telemetry at fixed interval.
+ *
+ * Register callback for SYSTEM_TELEMETRY to receive frames.
+ *
+ * @param[in]   interval_ms     Milliseconds between frames, 0 stops.
+ */
+void ft_dsp_set_telemetry(uint16_t interval_ms) {
+
+    svc_dsp_set_telemetry(interval_ms);
+}
+
+/**
+ * @brief   Capture DSP audio into buffer in DDR.
+ *
+ * @param[in]   config      Source, decimation, channels and DSP ring depth.
+ * @param[out]  buffer      Interleaved Q15 samples of selected channels.
+ * @param[in]   frames      Length of buffer in frames.
+ * @param[in]   callback    Called when buffer full or capture stopped.
+ *
+ * @return  ERROR if capture already running.
+ */
+t_status ft_dsp_capture_start(const t_dsp_capture_config *config,
+                              int16_t *buffer, uint32_t frames,
+                              t_dsp_capture_callback callback) {
+
+    return svc_dsp_capture_start(config, buffer, frames, callback);
+}
+
+void ft_dsp_capture_stop(void) { svc_dsp_capture_stop(); }
+
+/**
+ * @brief   Upload samples or wavetables to DSP SDRAM region.
+ *
+ * Modules read the region once the upload completes.
+ *
+ * @param[in]   region      DSP region id.
+ * @param[in]   offset      Byte offset in region.
+ * @param[in]   data        Data, held by caller until callback.
+ * @param[in]   length      Length of data.
+ * @param[in]   callback    Called when upload completes, may be NULL.
+ *
+ * @return  ERROR if upload already running.
+ */
+t_status ft_dsp_upload(uint8_t region, uint32_t offset, const uint8_t *data,
+                       uint32_t length, t_dsp_upload_callback callback) {
+
+    return svc_dsp_upload(region, offset, data, length, callback);
+}
+
 void ft_register_dsp_callback(uint8_t msg_type, uint8_t msg_id,
                               void *callback) {
 
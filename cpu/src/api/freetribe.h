@@ -106,7 +106,33 @@ void ft_set_trigger_mode(uint8_t mode);
 void ft_set_module_param(uint16_t module_id, uint16_t param_index,
                          int32_t param_value);
 
+void ft_set_module_param_at(uint16_t module_id, uint16_t param_index,
+                            int32_t param_value, uint32_t frame);
+
 void ft_get_module_param(uint16_t module_id, uint16_t param_index);
+t_status ft_read_module_param(uint16_t module_id, uint16_t param_index,
+                              int32_t *param_value);
+t_status ft_resync_module_params(uint16_t module_id,
+                                 t_dsp_resync_callback callback);
+t_status ft_get_module_info(uint16_t module_id, t_dsp_param_info *info,
+                            uint16_t capacity,
+                            t_dsp_param_info_callback callback);
+void ft_set_mod_source(uint8_t source, uint8_t setting, int32_t value);
+void ft_set_mod_gate(uint8_t mask, bool gate, int32_t velocity);
+void ft_set_mod_route(uint8_t route, const t_dsp_mod_route *config);
+t_status ft_dsp_request(uint8_t msg_type, uint8_t msg_id, uint8_t *payload,
+                        uint8_t length, t_dsp_request_callback callback,
+                        void *context);
+t_status ft_dsp_benchmark(uint8_t length, uint32_t count,
+                          t_dsp_benchmark_callback callback);
+t_status ft_dsp_set_bulk_transport(t_dsp_transport transport);
+void ft_dsp_set_telemetry(uint16_t interval_ms);
+t_status ft_dsp_capture_start(const t_dsp_capture_config *config,
+                              int16_t *buffer, uint32_t frames,
+                              t_dsp_capture_callback callback);
+void ft_dsp_capture_stop(void);
+t_status ft_dsp_upload(uint8_t region, uint32_t offset, const uint8_t *data,
+                       uint32_t length, t_dsp_upload_callback callback);
 
 void ft_register_dsp_callback(uint8_t msg_type, uint8_t msg_id, void *callback);
 
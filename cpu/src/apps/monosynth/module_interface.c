@@ -38,11 +38,6 @@ under the terms of the GNU Affero General Public License as published by
 
 #include "freetribe.h"
 
-#include "leaf.h"
-
-#include "leaf-envelopes.h"
-#include "leaf-oscillators.h"
-
 #include "param_scale.h"
 #include <stdint.h>
 
@@ -50,52 +45,52 @@ under the terms of the GNU Affero General Public License as published by
 
 /*----- Macros -------------------------------------------------------*/
 
-#define EXP_BUFFER_SIZE (0x400)
-
-#define GATE_OPEN (1)
-#define GATE_CLOSED (0)
 #define GATE_THRESHOLD (0.2)
 
-/*----- Typedefs -----------------------------------------------------*/
+// Envelopes and LFOs run on the DSP.
+#define ENV_AMP (MOD_SOURCE_ENV + 0)
+#define ENV_FILTER (MOD_SOURCE_ENV + 1)
 
-typedef struct {
+#define LFO_AMP (MOD_SOURCE_LFO + 0)
+#define LFO_FILTER (MOD_SOURCE_LFO + 1)
+#define LFO_PITCH (MOD_SOURCE_LFO + 2)
 
-    float next;
-    float last;
-    bool changed;
-} t_cv;
+// Gate amp and filter envelopes together.
+#define ENV_GATE_MASK (0x03)
 
-typedef struct {
-    tADSRT amp_env;
-    tADSRT filter_env;
-    tADSRT pitch_env;
+// Milliseconds at full scale.
+#define ENV_TIME_SCALE (8192.0)
 
-    float vel;
+// Hz at full scale.
+#define LFO_SPEED_SCALE (20)
+#define DEFAULT_LFO_SPEED (10)
+
+#define DEFAULT_ENV_DECAY (1024)
+#define DEFAULT_ENV_RELEASE (1024)
 
-    tTriLFO amp_lfo;
-    float amp_lfo_depth;
+// CV is 0.1 per octave.
+#define CV_OCTAVES (10.0)
 
-    tTriLFO filter_lfo;
-    float filter_lfo_depth;
+#define Q31_MAX (0x7fffffff)
 
-    float filter_cutoff;
-    float filter_env_depth;
+/*----- Typedefs -----------------------------------------------------*/
 
-    float osc_freq;
-    float pitch_env_depth;
+/// DSP modulation routes.
+typedef enum {
+    ROUTE_AMP_ENV,
+    ROUTE_AMP_LFO,
+    ROUTE_FILTER_ENV,
+    ROUTE_FILTER_LFO,
+    ROUTE_PITCH_LFO,
 
-    tTriLFO pitch_lfo;
-    float pitch_lfo_depth;
+    ROUTE_COUNT
+} e_route;
 
-    t_cv amp_cv;
-    t_cv filter_cv;
-    t_cv pitch_cv;
+typedef struct {
 
-    e_mod_type mod_type;
+    float vel;
 
-    bool gate;
-    bool retrigger;
-    bool reset_phase;
+    t_dsp_mod_route routes[ROUTE_COUNT];
 
 } t_module;
 
@@ -103,97 +98,46 @@ typedef struct {
 
 static t_module g_module;
 
-static Lfloat g_exp_buffer[EXP_BUFFER_SIZE];
-
 /*----- Extern variable definitions ----------------------------------*/
 
 /*----- Static function prototypes -----------------------------------*/
 
-static bool _cv_update(t_cv *cv, float value);
+static void _init_route(e_route route, uint8_t source, uint8_t via,
+                        uint16_t param_index, int32_t depth);
+static void _set_route_depth(e_route route, int32_t depth);
+static void _set_lfo_phase(int32_t phase);
 
 /*----- Extern function implementations ------------------------------*/
 
-void module_init(LEAF *leaf) {
+void module_init(void) {
 
-    LEAF_generate_exp(g_exp_buffer, 0.001f, 0.0f, 1.0f, -0.0008f,
-                      EXP_BUFFER_SIZE);
+    uint8_t i;
 
-    tADSRT_init(&g_module.amp_env, 0, 1024, 1, 1024, g_exp_buffer,
-                EXP_BUFFER_SIZE, leaf);
+    for (i = ENV_AMP; i <= ENV_FILTER; i++) {
 
-    tADSRT_init(&g_module.filter_env, 0, 1024, 1, 1024, g_exp_buffer,
-                EXP_BUFFER_SIZE, leaf);
-
-    tADSRT_init(&g_module.pitch_env, 0, 1024, 1, 1024, g_exp_buffer,
-                EXP_BUFFER_SIZE, leaf);
-
-    tTriLFO_init(&g_module.amp_lfo, leaf);
-    tTriLFO_init(&g_module.filter_lfo, leaf);
-    tTriLFO_init(&g_module.pitch_lfo, leaf);
-
-    tTriLFO_setFreq(&g_module.amp_lfo, 10);
-    tTriLFO_setFreq(&g_module.filter_lfo, 10);
-    tTriLFO_setFreq(&g_module.pitch_lfo, 10);
-}
-
-void module_process(void) {
-
-    float amp_mod;
-    float filter_mod;
-    float pitch_mod;
-
-    if (g_module.reset_phase) {
-
-        module_set_param(PARAM_OSC_PHASE, 0);
-        module_set_param(PARAM_LFO_PHASE, 0);
-
-        g_module.reset_phase = false;
+        ft_set_mod_source(i, MOD_ENV_DECAY, DEFAULT_ENV_DECAY);
+        ft_set_mod_source(i, MOD_ENV_SUSTAIN, Q31_MAX);
+        ft_set_mod_source(i, MOD_ENV_RELEASE, DEFAULT_ENV_RELEASE);
     }
 
-    // Amplitude modulation.
-    //
-    amp_mod = tADSRT_tick(&g_module.amp_env);
-
-    amp_mod +=
-        amp_mod * tTriLFO_tick(&g_module.amp_lfo) * g_module.amp_lfo_depth;
-
-    // Only send parameters to DSP if they have changed.
-    if (_cv_update(&g_module.amp_cv, amp_mod)) {
-
-        module_set_param(PARAM_AMP, clamp_value(amp_mod));
-    }
-
-    /// TODO: Should filter LFO follow the
-    ///       envelope, like the amp LFO?
-
-    // Filter cutoff modulation.
-    //
-    filter_mod = g_module.filter_cutoff;
-
-    filter_mod += tADSRT_tick(&g_module.filter_env) * g_module.filter_env_depth;
-
-    filter_mod +=
-        tTriLFO_tick(&g_module.filter_lfo) * g_module.filter_lfo_depth;
+    // Only amplitude follows velocity.
+    ft_set_mod_source(ENV_AMP, MOD_ENV_VELOCITY, true);
 
-    if (_cv_update(&g_module.filter_cv, filter_mod)) {
-
-        module_set_param(PARAM_CUTOFF, clamp_value(filter_mod));
+    for (i = LFO_AMP; i <= LFO_PITCH; i++) {
+        ft_set_mod_source(i, MOD_LFO_RATE,
+                          float_to_fix16(DEFAULT_LFO_SPEED));
     }
 
-    // Pitch modulation.
-    //
-    pitch_mod = g_module.osc_freq;
-
-    /// TODO: Add control for pitch envelope.
-    //
-    // pitch_mod += tADSRT_tick(&g_module.pitch_env) * g_module.pitch_env_depth;
-
-    pitch_mod += (tTriLFO_tick(&g_module.pitch_lfo) * g_module.pitch_lfo_depth);
+    // Amplitude follows envelope, LFO scaled by envelope.
+    _init_route(ROUTE_AMP_ENV, ENV_AMP, MOD_SOURCE_NONE, PARAM_AMP, Q31_MAX);
+    _init_route(ROUTE_AMP_LFO, LFO_AMP, ENV_AMP, PARAM_AMP, 0);
 
-    if (_cv_update(&g_module.pitch_cv, pitch_mod)) {
-
-        module_set_param(PARAM_FREQ, clamp_value(pitch_mod));
-    }
+    // Cutoff and frequency routes are in octaves.
+    _init_route(ROUTE_FILTER_ENV, ENV_FILTER, MOD_SOURCE_NONE, PARAM_CUTOFF,
+                0);
+    _init_route(ROUTE_FILTER_LFO, LFO_FILTER, MOD_SOURCE_NONE, PARAM_CUTOFF,
+                0);
+    _init_route(ROUTE_PITCH_LFO, LFO_PITCH, MOD_SOURCE_NONE, PARAM_FREQ, 0);
 }
 
 /**
@@ -223,27 +167,18 @@ void module_set_param(uint16_t param_index, float value) {
         break;
 
     case PARAM_LFO_PHASE:
-        tTriLFO_setPhase(&g_module.amp_lfo, float_to_fract32(value));
-        tTriLFO_setPhase(&g_module.filter_lfo, float_to_fract32(value));
-        tTriLFO_setPhase(&g_module.pitch_lfo, float_to_fract32(value));
+        _set_lfo_phase(float_to_fract32(value));
         break;
 
     case PARAM_GATE:
 
-        /// TODO:  This ignores velocity for repeated notes,
-        ///        do we want this?
-        //
-        if (((g_module.retrigger == true) || (g_module.gate == GATE_CLOSED)) &&
-            (value >= GATE_THRESHOLD)) {
+        // DSP ignores repeated gate unless retriggering.
+        if (value >= GATE_THRESHOLD) {
+            ft_set_mod_gate(ENV_GATE_MASK, true,
+                            float_to_fract32(g_module.vel));
 
-            g_module.gate = GATE_OPEN;
-            tADSRT_on(&g_module.amp_env, g_module.vel);
-            tADSRT_on(&g_module.filter_env, 1);
-
-        } else if (value < GATE_THRESHOLD) {
-            g_module.gate = GATE_CLOSED;
-            tADSRT_off(&g_module.amp_env);
-            tADSRT_off(&g_module.filter_env);
+        } else {
+            ft_set_mod_gate(ENV_GATE_MASK, false, 0);
         }
         break;
 
@@ -256,44 +191,46 @@ void module_set_param(uint16_t param_index, float value) {
         break;
 
     case PARAM_AMP_ENV_ATTACK:
-        tADSRT_setAttack(&g_module.amp_env, value * 8192.0);
+        ft_set_mod_source(ENV_AMP, MOD_ENV_ATTACK, value * ENV_TIME_SCALE);
         break;
 
     case PARAM_AMP_ENV_DECAY:
-        tADSRT_setDecay(&g_module.amp_env, value * 8192.0);
+        ft_set_mod_source(ENV_AMP, MOD_ENV_DECAY, value * ENV_TIME_SCALE);
         break;
 
     case PARAM_AMP_ENV_SUSTAIN:
-        tADSRT_setSustain(&g_module.amp_env, value);
+        ft_set_mod_source(ENV_AMP, MOD_ENV_SUSTAIN, float_to_fract32(value));
         break;
 
     case PARAM_AMP_ENV_RELEASE:
-        tADSRT_setRelease(&g_module.amp_env, value * 8192.0);
+        ft_set_mod_source(ENV_AMP, MOD_ENV_RELEASE, value * ENV_TIME_SCALE);
         break;
 
     case PARAM_AMP_ENV_DEPTH:
         break;
 
     case PARAM_FILTER_ENV_DEPTH:
-        g_module.filter_env_depth = value;
+        _set_route_depth(ROUTE_FILTER_ENV, float_to_fix16(value * CV_OCTAVES));
         break;
 
     case PARAM_FILTER_ENV_ATTACK:
-        tADSRT_setAttack(&g_module.filter_env, value * 8192.0);
+        ft_set_mod_source(ENV_FILTER, MOD_ENV_ATTACK, value * ENV_TIME_SCALE);
         break;
 
     case PARAM_FILTER_ENV_DECAY:
-        tADSRT_setDecay(&g_module.filter_env, value * 8192.0);
+        ft_set_mod_source(ENV_FILTER, MOD_ENV_DECAY, value * ENV_TIME_SCALE);
         break;
 
     case PARAM_FILTER_ENV_SUSTAIN:
-        tADSRT_setSustain(&g_module.filter_env, value);
+        ft_set_mod_source(ENV_FILTER, MOD_ENV_SUSTAIN, float_to_fract32(value));
         break;
 
     case PARAM_FILTER_ENV_RELEASE:
-        tADSRT_setRelease(&g_module.filter_env, value * 8192.0);
+        ft_set_mod_source(ENV_FILTER, MOD_ENV_RELEASE, value * ENV_TIME_SCALE);
         break;
 
+    /// TODO: Add control for pitch envelope.
+    //
     case PARAM_PITCH_ENV_DEPTH:
         break;
 
@@ -332,48 +269,55 @@ void module_set_param(uint16_t param_index, float value) {
         break;
 
     case PARAM_AMP_LFO_DEPTH:
-        g_module.amp_lfo_depth = value;
+        _set_route_depth(ROUTE_AMP_LFO, float_to_fract32(value));
         break;
 
     case PARAM_AMP_LFO_SPEED:
-        tTriLFO_setFreq(&g_module.amp_lfo, value * 20);
+        ft_set_mod_source(LFO_AMP, MOD_LFO_RATE,
+                          float_to_fix16(value * LFO_SPEED_SCALE));
         break;
 
+    /// TODO: Should filter LFO follow the
+    ///       envelope, like the amp LFO?
+    //
     case PARAM_FILTER_LFO_DEPTH:
-        g_module.filter_lfo_depth = value;
+        _set_route_depth(ROUTE_FILTER_LFO, float_to_fix16(value * CV_OCTAVES));
         break;
 
     case PARAM_FILTER_LFO_SPEED:
-        tTriLFO_setFreq(&g_module.filter_lfo, value * 20);
+        ft_set_mod_source(LFO_FILTER, MOD_LFO_RATE,
+                          float_to_fix16(value * LFO_SPEED_SCALE));
         break;
 
     case PARAM_PITCH_LFO_DEPTH:
-        g_module.pitch_lfo_depth = value;
+        _set_route_depth(ROUTE_PITCH_LFO, float_to_fix16(value * CV_OCTAVES));
         break;
 
     case PARAM_PITCH_LFO_SPEED:
-        tTriLFO_setFreq(&g_module.pitch_lfo, value * 20);
+        ft_set_mod_source(LFO_PITCH, MOD_LFO_RATE,
+                          float_to_fix16(value * LFO_SPEED_SCALE));
         break;
 
+    // Base values, modulated on the DSP.
     case PARAM_OSC_BASE_FREQ:
-        g_module.osc_freq = value;
+        module_set_param(PARAM_FREQ, value);
         break;
 
     case PARAM_FILTER_BASE_CUTOFF:
-        g_module.filter_cutoff = value;
+        module_set_param(PARAM_CUTOFF, value);
         break;
 
     case PARAM_PHASE_RESET:
-        g_module.reset_phase = value;
+
+        if (value) {
+            module_set_param(PARAM_OSC_PHASE, 0);
+            _set_lfo_phase(0);
+        }
         break;
 
     case PARAM_RETRIGGER:
-
-        if (value > 0) {
-            g_module.retrigger = true;
-        } else {
-            g_module.retrigger = false;
-        }
+        ft_set_mod_source(ENV_AMP, MOD_ENV_RETRIGGER, value > 0);
+        ft_set_mod_source(ENV_FILTER, MOD_ENV_RETRIGGER, value > 0);
         break;
 
     default:
@@ -392,19 +336,34 @@ void module_get_param(uint16_t param_index) {
 
 /*----- Static function implementations ------------------------------*/
 
-static bool _cv_update(t_cv *cv, float value) {
+static void _init_route(e_route route, uint8_t source, uint8_t via,
+                        uint16_t param_index, int32_t depth) {
 
-    cv->next = value;
+    t_dsp_mod_route *config = &g_module.routes[route];
 
-    if (cv->next != cv->last) {
-        cv->last = cv->next;
-        cv->changed = true;
+    config->source = source;
+    config->via = via;
+    config->module_id = 0;
+    config->param_index = param_index;
+    config->depth = depth;
 
-    } else {
-        cv->changed = false;
-    }
+    ft_set_mod_route(route, config);
+}
 
-    return cv->changed;
+static void _set_route_depth(e_route route, int32_t depth) {
+
+    g_module.routes[route].depth = depth;
+
+    ft_set_mod_route(route, &g_module.routes[route]);
+}
+
+static void _set_lfo_phase(int32_t phase) {
+
+    uint8_t i;
+
+    for (i = LFO_AMP; i <= LFO_PITCH; i++) {
+        ft_set_mod_source(i, MOD_LFO_PHASE, phase);
+    }
 }
 
 /*----- End of file --------------------------------------------------*/
@@ -45,8 +45,6 @@ extern "C" {
 
 #include <stdint.h>
 
-#include "leaf.h"
-
 /*----- Macros -------------------------------------------------------*/
 
 #define DEFAULT_CUTOFF 0x7f // Index in pitch LUT.
@@ -149,10 +147,7 @@ typedef enum {
 
 /*----- Extern function prototypes -----------------------------------*/
 
-/// TODO: Make LEAF optional dependency.
-//
-void module_init(LEAF *leaf);
-void module_process(void);
+void module_init(void);
 void module_set_param(uint16_t param_index, float value);
 void module_get_param(uint16_t param_index);
 
@@ -44,22 +44,16 @@ under the terms of the GNU Affero General Public License as published by
 #include "ft_error.h"
 #include "keyboard.h"
 
-#include "leaf-config.h"
 #include "param_scale.h"
 #include "svc_dsp.h"
 #include "svc_panel.h"
 
 #include "gui_task.h"
 
-#include "leaf.h"
-
 #include "module_interface.h"
 
 /*----- Macros -------------------------------------------------------*/
 
-#define CONTROL_RATE (1000)
-#define MEMPOOL_SIZE (0x1000)
-
 #define KNOB_LEVEL 0x00
 #define KNOB_PITCH 0x02
 #define KNOB_RES 0x03
@@ -84,15 +78,16 @@ under the terms of the GNU Affero General Public License as published by
 #define DEFAULT_SCALE_TONES 12
 #define DEFAULT_SCALE_MODE 0
 
-#define PROFILE_INTERVAL 100
+/// Milliseconds between DSP telemetry frames.
+#define TELEMETRY_INTERVAL 100
+
+/// Ticks without telemetry before profile is requested instead.
+#define PROFILE_INTERVAL 200
 
 /*----- Typedefs -----------------------------------------------------*/
 
 /*----- Static variable definitions ----------------------------------*/
 
-static LEAF g_leaf;
-static char g_mempool[MEMPOOL_SIZE];
-
 static t_keyboard g_kbd;
 static t_scale g_scale;
 
@@ -103,6 +98,9 @@ static bool g_menu_held;
 static bool g_amp_eg;
 static bool g_retrigger;
 
+// Telemetry received since last profile interval.
+static bool g_telemetry_received;
+
 static float g_midi_pitch_cv_lut[128];
 static float g_amp_cv_lut[256];
 static float g_knob_cv_lut[256];
@@ -115,7 +113,6 @@ static float g_filter_res_lut[256];
 
 /*----- Static function prototypes -----------------------------------*/
 
-static void _tick_callback(void);
 static void _knob_callback(uint8_t index, uint8_t value);
 static void _encoder_callback(uint8_t index, uint8_t value);
 static void _button_callback(uint8_t index, bool state);
@@ -127,7 +124,10 @@ static void _set_mod_speed(uint32_t mod_speed);
 
 static void _lut_init(void);
 
+static void _tick_callback(void);
 static void _profile_callback(uint32_t period, uint32_t cycles);
+static void _telemetry_callback(t_dsp_telemetry *telemetry);
+static void _show_load(uint32_t period, uint32_t cycles);
 
 /*----- Extern function implementations ------------------------------*/
 
@@ -143,9 +143,8 @@ t_status app_init(void) {
 
     t_status status = ERROR;
 
-    LEAF_init(&g_leaf, CONTROL_RATE, g_mempool, MEMPOOL_SIZE, NULL);
-
-    module_init(&g_leaf);
+    // Envelopes and LFOs run on the DSP.
+    module_init();
     _set_filter_type(FILTER_TYPE_LPF);
 
     _lut_init();
@@ -162,6 +161,11 @@ t_status app_init(void) {
 
     ft_register_dsp_callback(MSG_TYPE_SYSTEM, SYSTEM_PROFILE,
                              _profile_callback);
+    ft_register_dsp_callback(MSG_TYPE_SYSTEM, SYSTEM_TELEMETRY,
+                             _telemetry_callback);
+
+    // DSP pushes profile, requested only if telemetry stops.
+    ft_dsp_set_telemetry(TELEMETRY_INTERVAL);
 
     // Initialise GUI.
     gui_task();
@@ -184,18 +188,32 @@ static void _tick_callback(void) {
 
     static uint32_t tick_count;
 
-    module_process();
-
     if (tick_count++ >= PROFILE_INTERVAL) {
 
-        svc_dsp_get_profile();
+        if (!g_telemetry_received) {
+            svc_dsp_get_profile();
+        }
 
+        g_telemetry_received = false;
         tick_count = 0;
     }
 }
 
 static void _profile_callback(uint32_t period, uint32_t cycles) {
 
+    _show_load(period, cycles);
+}
+
+static void _telemetry_callback(t_dsp_telemetry *telemetry) {
+
+    g_telemetry_received = true;
+
+    _show_load(telemetry->period, telemetry->cycles);
+}
+
+// Print DSP load as percentage of audio block period.
+static void _show_load(uint32_t period, uint32_t cycles) {
+
     uint32_t percent;
 
     char buf[4] = {0};
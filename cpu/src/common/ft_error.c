@@ -113,6 +113,11 @@ t_status error_check(t_status error) {
         result = WARNING;
         break;
 
+    case TIMEOUT_ERROR:
+        // No response, handled by caller.
+        result = WARNING;
+        break;
+
     default:
         result = ERROR;
         break;
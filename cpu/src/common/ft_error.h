@@ -57,7 +57,8 @@ typedef enum {
     RING_BUFFER_INIT_ERROR,
     RING_BUFFER_PUT_ERROR,
     RING_BUFFER_GET_ERROR,
-    PANEL_PARSE_ERROR
+    PANEL_PARSE_ERROR,
+    TIMEOUT_ERROR
 } t_status;
 
 /*----- Extern variable declarations ---------------------------------*/
@@ -0,0 +1,364 @@
+/*----------------------------------------------------------------------
+
+                     This file is part of Freetribe
+
+                https://github.com/bangcorrupt/freetribe
+
+                                License
+
+                   GNU AFFERO GENERAL PUBLIC LICENSE
+                      Version 3, 19 November 2007
+
+                           AGPL-3.0-or-later
+
+ Freetribe is free software: you can redistribute it and/or modify it
+under the terms of the GNU Affero General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+                  (at your option) any later version.
+
+     Freetribe is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty
+        of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+          See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+                       Copyright bangcorrupt 2024
+
+----------------------------------------------------------------------*/
+
+/**
+ * @file    ft_hostdp.c
+ *
+ * @brief   CPU to DSP mailbox over the BF523 Host DMA Port.
+ *
+ * The DSP holds a pair of byte rings in its own memory.  The CPU
+ * reaches them through the Host DMA Port on the EMIFA bus, each
+ * access is a short DMA configured by the CPU, so the DSP core
+ * only copies bytes in and out of local memory.
+ *
+ * Frames are the same encoded frames sent over SPI.  Rings carry
+ * whole 16 bit words, odd frames are padded with a zero byte,
+ * which the receiver treats as an empty frame.
+ */
+
+/*----- Includes -----------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ft_hostdp.h"
+#include "ft_protocol.h"
+
+/*----- Macros -------------------------------------------------------*/
+
+/// DSP address of mailbox field.
+#define MAILBOX_FIELD(link, field)                                             \
+    ((link)->mailbox + offsetof(t_hostdp_mailbox, field))
+
+/// Bytes between words of one transfer.
+#define HOSTDP_MODIFY 2
+
+/*----- Typedefs -----------------------------------------------------*/
+
+/*----- Static variable definitions ----------------------------------*/
+
+/*----- Extern variable definitions ----------------------------------*/
+
+/*----- Static function prototypes -----------------------------------*/
+
+static t_status _configure(const t_hostdp_bus *bus, uint16_t control,
+                           uint32_t address, uint16_t count);
+
+static t_status _read_u16(const t_hostdp_bus *bus, uint32_t address,
+                          uint16_t *value);
+static t_status _write_u16(const t_hostdp_bus *bus, uint32_t address,
+                           uint16_t value);
+
+static t_status _ring_write(const t_hostdp_bus *bus, uint32_t ring,
+                            uint16_t position, const uint8_t *data,
+                            uint16_t length);
+static t_status _ring_read(const t_hostdp_bus *bus, uint32_t ring,
+                           uint16_t position, uint8_t *data, uint16_t length);
+
+/*----- Extern function implementations ------------------------------*/
+
+/**
+ * @brief   Attach to mailbox initialised by DSP.
+ *
+ * @param[out]  link    Host side state.
+ * @param[in]   bus     Host bus access.
+ * @param[in]   mailbox DSP address of mailbox, reported by DSP.
+ *
+ * @return  ERROR if mailbox not found at address.
+ */
+t_status hostdp_open(t_hostdp_link *link, const t_hostdp_bus *bus,
+                     uint32_t mailbox) {
+
+    uint8_t magic[4];
+
+    link->bus = bus;
+    link->mailbox = mailbox;
+
+    if (hostdp_read(bus, MAILBOX_FIELD(link, magic), magic, sizeof(magic)) !=
+        SUCCESS) {
+        return ERROR;
+    }
+
+    if ((magic[0] | magic[1] << 8 | magic[2] << 16 |
+         (uint32_t)magic[3] << 24) != HOSTDP_MAGIC) {
+        return ERROR;
+    }
+
+    // Resume from indices left by previous session.
+    if (_read_u16(bus, MAILBOX_FIELD(link, to_dsp.head), &link->tx_head) !=
+        SUCCESS) {
+        return ERROR;
+    }
+
+    return _read_u16(bus, MAILBOX_FIELD(link, to_cpu.tail), &link->rx_tail);
+}
+
+/**
+ * @brief   Write bytes to DSP bound ring.
+ *
+ * @param[in]   link    Host side state.
+ * @param[in]   data    Bytes to send, e.g. an encoded frame.
+ * @param[in]   length  Number of bytes, odd length is padded.
+ *
+ * @return  ERROR if bytes do not fit, nothing is sent,
+ *          TIMEOUT_ERROR if port does not respond.
+ */
+t_status hostdp_send(t_hostdp_link *link, const uint8_t *data,
+                     uint16_t length) {
+
+    const t_hostdp_bus *bus = link->bus;
+    uint16_t even = length & ~1;
+    uint16_t padded = (length + 1) & ~1;
+    uint8_t last[2] = {0, PROTOCOL_DELIMITER};
+    uint16_t tail;
+    t_status status;
+
+    status = _read_u16(bus, MAILBOX_FIELD(link, to_dsp.tail), &tail);
+    if (status != SUCCESS) {
+        return status;
+    }
+
+    if (HOSTDP_RING_LEN - (uint16_t)(link->tx_head - tail) < padded) {
+        return ERROR;
+    }
+
+    status = _ring_write(bus, MAILBOX_FIELD(link, to_dsp.data),
+                         link->tx_head, data, even);
+
+    if (status == SUCCESS && padded > even) {
+
+        last[0] = data[even];
+
+        status = _ring_write(bus, MAILBOX_FIELD(link, to_dsp.data),
+                             link->tx_head + even, last, sizeof(last));
+    }
+
+    if (status != SUCCESS) {
+        return status;
+    }
+
+    link->tx_head += padded;
+
+    // Publish after bytes are written.
+    return _write_u16(bus, MAILBOX_FIELD(link, to_dsp.head), link->tx_head);
+}
+
+/**
+ * @brief   Read bytes from CPU bound ring.
+ *
+ * @param[in]   link    Host side state.
+ * @param[out]  data    Received bytes.
+ * @param[in]   length  Size of data, rounded down to even.
+ *
+ * @return  Number of bytes received.
+ */
+uint16_t hostdp_receive(t_hostdp_link *link, uint8_t *data, uint16_t length) {
+
+    const t_hostdp_bus *bus = link->bus;
+    uint16_t available;
+    uint16_t head;
+
+    if (_read_u16(bus, MAILBOX_FIELD(link, to_cpu.head), &head) != SUCCESS) {
+        return 0;
+    }
+
+    available = head - link->rx_tail;
+
+    // Index corrupt, wait for DSP to reinitialise mailbox.
+    if (available > HOSTDP_RING_LEN) {
+        return 0;
+    }
+
+    if (available > (length & ~1)) {
+        available = length & ~1;
+    }
+
+    if (available == 0 ||
+        _ring_read(bus, MAILBOX_FIELD(link, to_cpu.data), link->rx_tail,
+                   data, available) != SUCCESS) {
+        return 0;
+    }
+
+    link->rx_tail += available;
+
+    // Free space once bytes are read.
+    _write_u16(bus, MAILBOX_FIELD(link, to_cpu.tail), link->rx_tail);
+
+    return available;
+}
+
+/**
+ * @brief   Write DSP memory.
+ *
+ * @param[in]   bus     Host bus access.
+ * @param[in]   address DSP address, even.
+ * @param[in]   data    Bytes to write.
+ * @param[in]   length  Number of bytes, even.
+ *
+ * @return  TIMEOUT_ERROR if port does not accept configuration.
+ */
+t_status hostdp_write(const t_hostdp_bus *bus, uint32_t address,
+                      const uint8_t *data, uint16_t length) {
+
+    uint16_t i;
+
+    if (length == 0) {
+        return SUCCESS;
+    }
+
+    if (_configure(bus, HOSTDP_CONTROL_WNR, address, length / 2) != SUCCESS) {
+        return TIMEOUT_ERROR;
+    }
+
+    for (i = 0; i + 1 < length; i += 2) {
+        bus->write(false, data[i] | data[i + 1] << 8);
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief   Read DSP memory.
+ *
+ * @param[in]   bus     Host bus access.
+ * @param[in]   address DSP address, even.
+ * @param[out]  data    Bytes read.
+ * @param[in]   length  Number of bytes, even.
+ *
+ * @return  TIMEOUT_ERROR if port does not accept configuration.
+ */
+t_status hostdp_read(const t_hostdp_bus *bus, uint32_t address, uint8_t *data,
+                     uint16_t length) {
+
+    uint16_t word;
+    uint16_t i;
+
+    if (length == 0) {
+        return SUCCESS;
+    }
+
+    if (_configure(bus, 0, address, length / 2) != SUCCESS) {
+        return TIMEOUT_ERROR;
+    }
+
+    for (i = 0; i + 1 < length; i += 2) {
+
+        word = bus->read(false);
+
+        data[i] = word & 0xff;
+        data[i + 1] = word >> 8;
+    }
+
+    return SUCCESS;
+}
+
+/*----- Static function implementations ------------------------------*/
+
+// Start DMA of count words, once previous transfer is complete.
+static t_status _configure(const t_hostdp_bus *bus, uint16_t control,
+                           uint32_t address, uint16_t count) {
+
+    uint16_t polls = 0;
+
+    while (!(bus->read(true) & HOSTDP_STATUS_ALLOW_CONFIG)) {
+
+        if (++polls == HOSTDP_STATUS_POLLS) {
+            return TIMEOUT_ERROR;
+        }
+    }
+
+    bus->write(true, control | HOSTDP_CONTROL_WDSIZE_16 | HOSTDP_CONTROL_DMAEN);
+    bus->write(true, address & 0xffff);
+    bus->write(true, address >> 16);
+    bus->write(true, count);
+    bus->write(true, HOSTDP_MODIFY);
+
+    return SUCCESS;
+}
+
+static t_status _read_u16(const t_hostdp_bus *bus, uint32_t address,
+                          uint16_t *value) {
+
+    uint8_t word[2];
+    t_status status;
+
+    status = hostdp_read(bus, address, word, sizeof(word));
+
+    *value = word[0] | word[1] << 8;
+
+    return status;
+}
+
+static t_status _write_u16(const t_hostdp_bus *bus, uint32_t address,
+                           uint16_t value) {
+
+    uint8_t word[] = {value & 0xff, value >> 8};
+
+    return hostdp_write(bus, address, word, sizeof(word));
+}
+
+// Split at end of ring, offsets and lengths are even.
+static t_status _ring_write(const t_hostdp_bus *bus, uint32_t ring,
+                            uint16_t position, const uint8_t *data,
+                            uint16_t length) {
+
+    uint16_t offset = position & HOSTDP_RING_MASK;
+    uint16_t first = HOSTDP_RING_LEN - offset;
+
+    if (first >= length) {
+        return hostdp_write(bus, ring + offset, data, length);
+    }
+
+    if (hostdp_write(bus, ring + offset, data, first) != SUCCESS) {
+        return TIMEOUT_ERROR;
+    }
+
+    return hostdp_write(bus, ring, data + first, length - first);
+}
+
+static t_status _ring_read(const t_hostdp_bus *bus, uint32_t ring,
+                           uint16_t position, uint8_t *data, uint16_t length) {
+
+    uint16_t offset = position & HOSTDP_RING_MASK;
+    uint16_t first = HOSTDP_RING_LEN - offset;
+
+    if (first >= length) {
+        return hostdp_read(bus, ring + offset, data, length);
+    }
+
+    if (hostdp_read(bus, ring + offset, data, first) != SUCCESS) {
+        return TIMEOUT_ERROR;
+    }
+
+    return hostdp_read(bus, ring, data + first, length - first);
+}
+
+/*----- End of file --------------------------------------------------*/
@@ -0,0 +1,136 @@
+/*----------------------------------------------------------------------
+
+                     This file is part of Freetribe
+
+                https://github.com/bangcorrupt/freetribe
+
+                                License
+
+                   GNU AFFERO GENERAL PUBLIC LICENSE
+                      Version 3, 19 November 2007
+
+                           AGPL-3.0-or-later
+
+ Freetribe is free software: you can redistribute it and/or modify it
+under the terms of the GNU Affero General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+                  (at your option) any later version.
+
+     Freetribe is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty
+        of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+          See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+                       Copyright bangcorrupt 2024
+
+----------------------------------------------------------------------*/
+
+/**
+ * @file    ft_hostdp.h
+ *
+ * @brief   CPU to DSP mailbox over the BF523 Host DMA Port.
+ *
+ * Shared by CPU and DSP.
+ */
+
+#ifndef FT_HOSTDP_H
+#define FT_HOSTDP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*----- Includes -----------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ft_error.h"
+
+/*----- Macros -------------------------------------------------------*/
+
+/// Written last by DSP when mailbox is initialised.
+#define HOSTDP_MAGIC 0x50444846
+
+/// Bytes in each mailbox ring, power of 2.
+#define HOSTDP_RING_LEN 0x800
+#define HOSTDP_RING_MASK (HOSTDP_RING_LEN - 1)
+
+/// TODO: Confirm host configuration sequence and status bits
+///       against the BF52x HRM Host DMA Port chapter.
+//
+// Configuration words written with HOST_ADDR high, in order,
+// before count data words written or read with HOST_ADDR low.
+// Control bits follow DMAx_CONFIG.
+#define HOSTDP_CONTROL_DMAEN 0x0001
+#define HOSTDP_CONTROL_WNR 0x0002
+#define HOSTDP_CONTROL_WDSIZE_16 0x0004
+
+// Status read with HOST_ADDR high.
+#define HOSTDP_STATUS_DMA_READY 0x0001
+#define HOSTDP_STATUS_DMA_COMPLETE 0x0008
+#define HOSTDP_STATUS_ALLOW_CONFIG 0x0080
+
+/// Status reads before giving up on configuration.
+#define HOSTDP_STATUS_POLLS 1000
+
+/*----- Typedefs -----------------------------------------------------*/
+
+/**
+ * Byte stream in DSP memory.
+ *
+ * Indices are free running byte counts, the producer writes
+ * head and the consumer writes tail.  Both stay even, so every
+ * transfer is whole 16 bit words.
+ */
+typedef struct {
+    volatile uint16_t head;
+    volatile uint16_t tail;
+    uint8_t data[HOSTDP_RING_LEN];
+} t_hostdp_ring;
+
+/// Held in DSP memory, CPU reads and writes through HostDP.
+typedef struct {
+    volatile uint32_t magic;
+    t_hostdp_ring to_dsp;
+    t_hostdp_ring to_cpu;
+} t_hostdp_mailbox;
+
+/// One 16 bit bus access, config selects the HOST_ADDR pin.
+typedef struct {
+    void (*write)(bool config, uint16_t value);
+    uint16_t (*read)(bool config);
+} t_hostdp_bus;
+
+/// Host side of mailbox, indices owned by host are cached.
+typedef struct {
+    const t_hostdp_bus *bus;
+    uint32_t mailbox;
+    uint16_t tx_head;
+    uint16_t rx_tail;
+} t_hostdp_link;
+
+/*----- Extern variable declarations ---------------------------------*/
+
+/*----- Extern function prototypes -----------------------------------*/
+
+t_status hostdp_open(t_hostdp_link *link, const t_hostdp_bus *bus,
+                     uint32_t mailbox);
+t_status hostdp_send(t_hostdp_link *link, const uint8_t *data,
+                     uint16_t length);
+uint16_t hostdp_receive(t_hostdp_link *link, uint8_t *data, uint16_t length);
+
+t_status hostdp_write(const t_hostdp_bus *bus, uint32_t address,
+                      const uint8_t *data, uint16_t length);
+t_status hostdp_read(const t_hostdp_bus *bus, uint32_t address, uint8_t *data,
+                     uint16_t length);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
+
+/*----- End of file --------------------------------------------------*/
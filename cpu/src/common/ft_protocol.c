@@ -0,0 +1,278 @@
+/*----------------------------------------------------------------------
+
+                     This file is part of Freetribe
+
+                https://github.com/bangcorrupt/freetribe
+
+                                License
+
+                   GNU AFFERO GENERAL PUBLIC LICENSE
+                      Version 3, 19 November 2007
+
+                           AGPL-3.0-or-later
+
+ Freetribe is free software: you can redistribute it and/or modify it
+under the terms of the GNU Affero General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+                  (at your option) any later version.
+
+     Freetribe is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty
+        of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+          See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+                       Copyright bangcorrupt 2024
+
+----------------------------------------------------------------------*/
+
+/**
+ * @file    ft_protocol.c
+ *
+ * @brief   CPU to DSP message framing.
+ *
+ * Each frame holds message type, message id, sequence number,
+ * payload and CRC-16, COBS encoded and terminated by a zero byte.
+ * Zero is also the idle byte clocked on SPI, so idle bytes are
+ * empty frames and a corrupted frame only costs itself; the
+ * receiver resynchronises on the next delimiter.
+ */
+
+/*----- Includes -----------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "ft_protocol.h"
+
+/*----- Macros -------------------------------------------------------*/
+
+/// CRC-16/CCITT-FALSE.
+#define CRC16_POLY 0x1021
+#define CRC16_INIT 0xffff
+
+/*----- Typedefs -----------------------------------------------------*/
+
+/*----- Static variable definitions ----------------------------------*/
+
+/*----- Extern variable definitions ----------------------------------*/
+
+/*----- Static function prototypes -----------------------------------*/
+
+static void _protocol_frame(t_protocol *protocol);
+
+static uint16_t _cobs_encode(const uint8_t *source, uint16_t length,
+                             uint8_t *dest);
+static int32_t _cobs_decode(uint8_t *buffer, uint16_t length);
+
+/*----- Extern function implementations ------------------------------*/
+
+/**
+ * @brief   Initialise receiver state.
+ *
+ * @param[out]  protocol    Receiver state.
+ * @param[in]   handler     Called for each valid frame.
+ */
+void protocol_init(t_protocol *protocol, t_protocol_handler handler) {
+
+    memset(protocol, 0, sizeof(t_protocol));
+
+    protocol->handler = handler;
+}
+
+/**
+ * @brief   Add received byte, handle frame on delimiter.
+ *
+ * @param[in]   protocol    Receiver state.
+ * @param[in]   byte        Received byte.
+ */
+void protocol_receive(t_protocol *protocol, uint8_t byte) {
+
+    if (byte == PROTOCOL_DELIMITER) {
+
+        if (protocol->overflow) {
+            protocol->stats.overflows++;
+
+        } else if (protocol->count > 0) {
+            _protocol_frame(protocol);
+        }
+
+        protocol->count = 0;
+        protocol->overflow = false;
+
+    } else if (protocol->count < sizeof(protocol->buffer)) {
+        protocol->buffer[protocol->count++] = byte;
+
+    } else {
+        // Discard until next delimiter.
+        protocol->overflow = true;
+    }
+}
+
+/**
+ * @brief   Encode message as frame.
+ *
+ * @param[in]   protocol    Link state, for statistics.
+ * @param[in]   msg_type    Message type.
+ * @param[in]   msg_id      Message id.
+ * @param[in]   sequence    Request sequence, echoed in response.
+ * @param[in]   payload     Message payload, may be NULL if length is 0.
+ * @param[in]   length      Payload length.
+ * @param[out]  frame       Must provide PROTOCOL_ENCODED_MAX bytes.
+ *
+ * @return  Length of frame, including delimiter.
+ */
+uint16_t protocol_encode(t_protocol *protocol, uint8_t msg_type,
+                         uint8_t msg_id, uint8_t sequence,
+                         const uint8_t *payload, uint8_t length,
+                         uint8_t *frame) {
+
+    uint8_t raw[PROTOCOL_FRAME_MAX];
+    uint16_t raw_length;
+    uint16_t crc;
+    uint16_t frame_length;
+
+    raw[0] = msg_type;
+    raw[1] = msg_id;
+    raw[2] = sequence;
+
+    if (length > 0) {
+        memcpy(&raw[3], payload, length);
+    }
+
+    raw_length = length + 3;
+
+    crc = protocol_crc16(raw, raw_length);
+
+    raw[raw_length++] = crc & 0xff;
+    raw[raw_length++] = (crc >> 8) & 0xff;
+
+    frame_length = _cobs_encode(raw, raw_length, frame);
+
+    frame[frame_length++] = PROTOCOL_DELIMITER;
+
+    protocol->stats.tx_frames++;
+
+    return frame_length;
+}
+
+/**
+ * @brief   Calculate CRC-16/CCITT-FALSE.
+ *
+ * @param[in]   data    Data to check.
+ * @param[in]   length  Length of data.
+ *
+ * @return  CRC of data.
+ */
+uint16_t protocol_crc16(const uint8_t *data, uint16_t length) {
+
+    uint16_t crc = CRC16_INIT;
+    uint8_t bit;
+
+    while (length--) {
+
+        crc ^= *data++ << 8;
+
+        for (bit = 0; bit < 8; bit++) {
+            crc = crc & 0x8000 ? (crc << 1) ^ CRC16_POLY : crc << 1;
+        }
+    }
+
+    return crc;
+}
+
+/*----- Static function implementations ------------------------------*/
+
+static void _protocol_frame(t_protocol *protocol) {
+
+    int32_t length;
+    uint16_t crc;
+
+    length = _cobs_decode(protocol->buffer, protocol->count);
+
+    if (length < PROTOCOL_OVERHEAD || length > PROTOCOL_FRAME_MAX) {
+        protocol->stats.frame_errors++;
+        return;
+    }
+
+    crc = protocol->buffer[length - 1] << 8 | protocol->buffer[length - 2];
+
+    if (crc != protocol_crc16(protocol->buffer, length - 2)) {
+        protocol->stats.crc_errors++;
+        return;
+    }
+
+    protocol->stats.rx_frames++;
+
+    if (protocol->handler != NULL) {
+        protocol->handler(protocol->buffer[0], protocol->buffer[1],
+                          protocol->buffer[2], &protocol->buffer[3],
+                          length - PROTOCOL_OVERHEAD);
+    }
+}
+
+// Each code byte gives offset to next zero, 0xff for none in 254 bytes.
+static uint16_t _cobs_encode(const uint8_t *source, uint16_t length,
+                             uint8_t *dest) {
+
+    uint16_t code_index = 0;
+    uint16_t index = 1;
+    uint8_t code = 1;
+
+    while (length--) {
+
+        if (*source == 0) {
+            dest[code_index] = code;
+            code_index = index++;
+            code = 1;
+
+        } else {
+            dest[index++] = *source;
+            code++;
+
+            if (code == 0xff) {
+                dest[code_index] = code;
+                code_index = index++;
+                code = 1;
+            }
+        }
+        source++;
+    }
+
+    dest[code_index] = code;
+
+    return index;
+}
+
+// Decode in place, return decoded length or -1 on bad encoding.
+static int32_t _cobs_decode(uint8_t *buffer, uint16_t length) {
+
+    uint16_t read = 0;
+    uint16_t write = 0;
+    uint8_t code;
+    uint8_t i;
+
+    while (read < length) {
+
+        code = buffer[read++];
+
+        for (i = 1; i < code; i++) {
+
+            if (read >= length) {
+                return -1;
+            }
+            buffer[write++] = buffer[read++];
+        }
+
+        if (code != 0xff && read < length) {
+            buffer[write++] = 0;
+        }
+    }
+
+    return write;
+}
+
+/*----- End of file --------------------------------------------------*/
@@ -0,0 +1,250 @@
+/*----------------------------------------------------------------------
+
+                     This file is part of Freetribe
+
+                https://github.com/bangcorrupt/freetribe
+
+                                License
+
+                   GNU AFFERO GENERAL PUBLIC LICENSE
+                      Version 3, 19 November 2007
+
+                           AGPL-3.0-or-later
+
+ Freetribe is free software: you can redistribute it and/or modify it
+under the terms of the GNU Affero General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+                  (at your option) any later version.
+
+     Freetribe is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty
+        of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+          See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+                       Copyright bangcorrupt 2024
+
+----------------------------------------------------------------------*/
+
+/**
+ * @file    ft_protocol.h
+ *
+ * @brief   Public API for CPU to DSP message framing.
+ *
+ * Shared by CPU and DSP.
+ */
+
+#ifndef FT_PROTOCOL_H
+#define FT_PROTOCOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*----- Includes -----------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*----- Macros -------------------------------------------------------*/
+
+/// Type, id, sequence and CRC around payload.
+#define PROTOCOL_OVERHEAD 5
+
+/// Sequence of messages not sent in response to a request.
+#define PROTOCOL_SEQUENCE_NONE 0
+
+/// Maximum payload of one message.
+#define PROTOCOL_PAYLOAD_MAX 0xff
+
+/// Maximum decoded frame length.
+#define PROTOCOL_FRAME_MAX (PROTOCOL_PAYLOAD_MAX + PROTOCOL_OVERHEAD)
+
+/// Maximum encoded length of frame with payload length,
+/// including COBS overhead and delimiter.
+#define PROTOCOL_ENCODED_LENGTH(length)                                        \
+    ((length) + PROTOCOL_OVERHEAD + ((length) + PROTOCOL_OVERHEAD) / 254 + 2)
+
+#define PROTOCOL_ENCODED_MAX PROTOCOL_ENCODED_LENGTH(PROTOCOL_PAYLOAD_MAX)
+
+/// Region id, offset and CRC-16 ahead of SYSTEM_REGION_WRITE data.
+#define PROTOCOL_REGION_HEADER 7
+
+/// Start index and overrun count ahead of SYSTEM_CAPTURE_DATA samples.
+#define PROTOCOL_CAPTURE_HEADER 8
+
+/// Length of SYSTEM_TELEMETRY payload.
+#define PROTOCOL_TELEMETRY_LENGTH 51
+
+/// Module id, first index and parameter count ahead of
+/// MODULE_PARAM_INFO descriptors.
+#define PROTOCOL_PARAM_INFO_HEADER 6
+
+/// Range, initial value, scale and slew ahead of each descriptor
+/// name, which is null terminated.
+#define PROTOCOL_PARAM_INFO_FIXED 15
+
+/// Modulation sources run by DSP kernel.
+#define PROTOCOL_MOD_ENVELOPES 3
+#define PROTOCOL_MOD_LFOS 3
+
+/// Modulation routes held by DSP kernel.
+#define PROTOCOL_MOD_ROUTES 8
+
+/// Frame delimiter, also idle byte on SPI.
+#define PROTOCOL_DELIMITER 0x00
+
+/// Message types, each with an id enumeration below.
+enum e_message_type { MSG_TYPE_MODULE, MSG_TYPE_SYSTEM };
+
+enum e_module_msg_id {
+    MODULE_GET_PARAM_VALUE,
+    MODULE_SET_PARAM_VALUE,
+    MODULE_PARAM_VALUE,
+    MODULE_GET_PARAM_NAME,
+    MODULE_PARAM_NAME,
+    MODULE_SET_GRAPH,
+    MODULE_GET_CYCLES,
+    MODULE_CYCLES,
+    MODULE_SET_PARAM_BATCH,
+    MODULE_GET_ALL_PARAMS,
+    MODULE_ALL_PARAMS,
+    MODULE_GET_PARAM_INFO,
+    MODULE_PARAM_INFO,
+    MODULE_SET_MOD_SOURCE,
+    MODULE_SET_MOD_GATE,
+    MODULE_SET_MOD_ROUTE,
+};
+
+enum e_system_msg_id {
+    SYSTEM_CHECK_READY,
+    SYSTEM_READY,
+    SYSTEM_GET_PORT_STATE,
+    SYSTEM_SET_PORT_STATE,
+    SYSTEM_PORT_STATE,
+    SYSTEM_GET_PROFILE,
+    SYSTEM_PROFILE,
+    SYSTEM_GET_PROFILE_EXT,
+    SYSTEM_PROFILE_EXT,
+    SYSTEM_GET_FRAME_COUNT,
+    SYSTEM_FRAME_COUNT,
+    SYSTEM_GET_LINK_STATS,
+    SYSTEM_LINK_STATS,
+    SYSTEM_ECHO,
+    SYSTEM_ECHO_REPLY,
+    SYSTEM_GET_HOSTDP_MAILBOX,
+    SYSTEM_HOSTDP_MAILBOX,
+    SYSTEM_REGION_OPEN,
+    SYSTEM_REGION_WRITE,
+    SYSTEM_REGION_CLOSE,
+    SYSTEM_REGION_ACK,
+    SYSTEM_CAPTURE_START,
+    SYSTEM_CAPTURE_STOP,
+    SYSTEM_GET_CAPTURE_STATUS,
+    SYSTEM_CAPTURE_STATUS,
+    SYSTEM_CAPTURE_DATA,
+    SYSTEM_SET_TELEMETRY,
+    SYSTEM_TELEMETRY,
+};
+
+/// Control mapping carried in module parameter descriptors.
+enum e_param_scale {
+    PARAM_SCALE_LINEAR,
+    // Exponential, e.g. frequency or time.
+    PARAM_SCALE_EXP,
+    // Discrete choices, min to max.
+    PARAM_SCALE_ENUM,
+    PARAM_SCALE_TOGGLE,
+};
+
+/// Modulation source index, envelopes then LFOs.
+enum e_mod_source {
+    MOD_SOURCE_NONE,
+    MOD_SOURCE_ENV,
+    MOD_SOURCE_LFO = MOD_SOURCE_ENV + PROTOCOL_MOD_ENVELOPES,
+    MOD_SOURCE_COUNT = MOD_SOURCE_LFO + PROTOCOL_MOD_LFOS,
+};
+
+/// Setting carried in MODULE_SET_MOD_SOURCE.
+enum e_mod_setting {
+    // Envelope times in milliseconds, sustain level Q31.
+    MOD_ENV_ATTACK,
+    MOD_ENV_DECAY,
+    MOD_ENV_SUSTAIN,
+    MOD_ENV_RELEASE,
+    // Restart attack on gate while open, otherwise legato.
+    MOD_ENV_RETRIGGER,
+    // Scale envelope by gate velocity.
+    MOD_ENV_VELOCITY,
+    // LFO rate in Hz, fix16.
+    MOD_LFO_RATE,
+    // LFO phase, full scale is one cycle.
+    MOD_LFO_PHASE,
+};
+
+/// Result carried in SYSTEM_REGION_ACK.
+enum e_region_status {
+    REGION_OK,
+    REGION_BAD_ID,
+    REGION_BAD_RANGE,
+    REGION_BAD_CRC,
+};
+
+/// Audio tapped by SYSTEM_CAPTURE_START.
+enum e_capture_source {
+    CAPTURE_SOURCE_INPUT,
+    CAPTURE_SOURCE_OUTPUT,
+};
+
+/*----- Typedefs -----------------------------------------------------*/
+
+/// Called for each valid frame received.
+typedef void (*t_protocol_handler)(uint8_t msg_type, uint8_t msg_id,
+                                   uint8_t sequence, uint8_t *payload,
+                                   uint8_t length);
+
+typedef struct {
+    // Valid frames received.
+    uint32_t rx_frames;
+    // Frames transmitted.
+    uint32_t tx_frames;
+    // Frames dropped on CRC mismatch.
+    uint32_t crc_errors;
+    // Frames dropped on bad encoding or length.
+    uint32_t frame_errors;
+    // Frames dropped on receive buffer overflow.
+    uint32_t overflows;
+    // Requests timed out, and resent, counted by requester.
+    uint32_t timeouts;
+    uint32_t retries;
+} t_protocol_stats;
+
+/// Receiver state, one per link.
+typedef struct {
+    uint8_t buffer[PROTOCOL_ENCODED_MAX];
+    uint16_t count;
+    bool overflow;
+    t_protocol_handler handler;
+    t_protocol_stats stats;
+} t_protocol;
+
+/*----- Extern variable declarations ---------------------------------*/
+
+/*----- Extern function prototypes -----------------------------------*/
+
+void protocol_init(t_protocol *protocol, t_protocol_handler handler);
+void protocol_receive(t_protocol *protocol, uint8_t byte);
+uint16_t protocol_encode(t_protocol *protocol, uint8_t msg_type,
+                         uint8_t msg_id, uint8_t sequence,
+                         const uint8_t *payload, uint8_t length,
+                         uint8_t *frame);
+uint16_t protocol_crc16(const uint8_t *data, uint16_t length);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
+
+/*----- End of file --------------------------------------------------*/
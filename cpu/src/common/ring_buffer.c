@@ -153,6 +153,21 @@ int ring_buffer_get(rbd_t rbd, void *data) {
     return result;
 }
 
+/**
+ * \brief Get number of free elements in the ring buffer
+ * \param[in] rbd - the ring buffer descriptor
+ * \return number of elements that can be added without overwrite
+ */
+size_t ring_buffer_free_space(rbd_t rbd) {
+    size_t result = 0;
+
+    if (rbd < RING_BUFFER_MAX) {
+        result = _rb[rbd].n_elem - (_rb[rbd].head - _rb[rbd].tail);
+    }
+
+    return result;
+}
+
 /// TODO: Return bool?
 static int _ring_buffer_full(struct ring_buffer *rb) {
     return ((rb->head - rb->tail) == rb->n_elem) ? 1 : 0;
@@ -87,6 +87,13 @@ int ring_buffer_put_force(rbd_t rbd, const void *data);
  */
 int ring_buffer_get(rbd_t rbd, void *data);
 
+/**
+ * \brief Get number of free elements in the ring buffer
+ * \param[in] rbd - the ring buffer descriptor
+ * \return number of elements that can be added without overwrite
+ */
+size_t ring_buffer_free_space(rbd_t rbd);
+
 int rb_data_ready(rbd_t rbd);
 int rb_buffer_full(rbd_t rbd);
 
@@ -34,14 +34,16 @@ under the terms of the GNU Affero General Public License as published by
  * @brief   Device driver for communicating with Blackfin DSP.
  */
 
-/// TODO: Separate modules for SPI and EMIFA.
+/// TODO: Separate module for SPI, as dev_dsp_hostdp.c.
 
 /*----- Includes -----------------------------------------------------*/
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "per_gpio.h"
+#include "per_pinmux.h"
 #include "per_spi.h"
 
 #include "dev_dsp.h"
@@ -76,8 +78,18 @@ under the terms of the GNU Affero General Public License as published by
 #define DSP_SPI_COMMAND_CSHOLD false
 
 /// TODO: Centralised header for queue lengths.
-#define DSP_SPI_TX_BUF_LEN 0x100
-#define DSP_SPI_RX_BUF_LEN 0x100
+#define DSP_SPI_TX_BUF_LEN 0x200
+#define DSP_SPI_TX_FRAMES 0x20
+#define DSP_SPI_RX_BUF_LEN 0x400
+
+/// Largest frame sent in one DMA transfer, multiple of cache line.
+#define DSP_SPI_DMA_LEN 0x120
+
+/// Bytes clocked when polling DSP.
+#define DSP_SPI_POLL_LEN 0x10
+
+/// Realtime frames sent before a waiting bulk frame.
+#define DSP_SPI_REALTIME_BURST 4
 
 /// TODO: Use indexed GPIO functions for single pin id.
 #define DSP_RESET_BANK 6
@@ -86,38 +98,80 @@ under the terms of the GNU Affero General Public License as published by
 #define DSP_SPI_ENA_BANK 2
 #define DSP_SPI_ENA_PIN 12
 
+/// TODO: Confirm which CPU pin is wired to DSP PG9.
+//
+// High while DSP has bytes queued for CPU.  Used only when built
+// with DSP_DATA_READY=1, otherwise svc_dsp polls while responses,
+// telemetry or capture are expected.
+//
+// GPIO2 13 shares its pad with SPI1_CLK (PINMUX5 bits 8-11), so this
+// guess cannot be right while the DSP link uses SPI1.  Override the
+// pin and its PINMUX field once the wiring is confirmed.
+#ifndef DSP_DATA_READY_GPIO
+#define DSP_DATA_READY_GPIO 0
+#endif
+
+#ifndef DSP_DATA_READY_BANK
+#define DSP_DATA_READY_BANK 2
+#define DSP_DATA_READY_PIN 13
+#define DSP_DATA_READY_PINMUX 5
+#define DSP_DATA_READY_PINMUX_SHIFT 8
+#endif
+
+/// PINMUX function selecting GPIO.
+#define DSP_DATA_READY_PINMUX_GPIO 8
+
+#define DSP_DATA_READY_INT_CHANNEL DSP_SPI_INT_CHANNEL
+
 /*----- Typedefs -----------------------------------------------------*/
 
+/// Transmit lane, bytes of whole frames and their lengths.
+typedef struct {
+    rbd_t bytes_rbd;
+    rbd_t frames_rbd;
+    char bytes_rbmem[DSP_SPI_TX_BUF_LEN];
+    uint16_t frames_rbmem[DSP_SPI_TX_FRAMES];
+    t_dsp_lane_stats stats;
+} t_dsp_lane;
+
 /*----- Static variable definitions ----------------------------------*/
 
 // DSP SPI RX ring buffer.
 static rbd_t dsp_spi_rx_rbd;
 static char dsp_spi_rx_rbmem[DSP_SPI_RX_BUF_LEN];
 
-// DSP SPI TX ring buffer.
-static rbd_t dsp_spi_tx_rbd;
-static char dsp_spi_tx_rbmem[DSP_SPI_TX_BUF_LEN];
+// DSP SPI TX lanes, realtime drained first.
+static t_dsp_lane g_dsp_lanes[DSP_LANES];
 
-// static uint8_t g_dsp_spi_tx_byte;
-static uint8_t g_dsp_spi_rx_byte;
+// One frame per DMA transfer, buffers own their cache lines.
+static uint8_t g_dsp_spi_tx_frame[DSP_SPI_DMA_LEN]
+    __attribute__((aligned(32)));
+static uint8_t g_dsp_spi_rx_frame[DSP_SPI_DMA_LEN]
+    __attribute__((aligned(32)));
+static uint16_t g_dsp_spi_transfer_length;
 
 volatile static bool g_dsp_spi_tx_complete = false;
-volatile static bool g_dsp_spi_rx_complete = false;
+
+#if DSP_DATA_READY_GPIO
+volatile static bool g_dsp_data_ready = false;
+#endif
 
 /*----- Extern variable definitions ----------------------------------*/
 
 /*----- Static function prototypes -----------------------------------*/
 
 void _dsp_spi_init(void);
+static int _dsp_lane_init(t_dsp_lane *lane);
 
-static int _dsp_spi_tx_dequeue(uint8_t *p_byte);
-static void _dsp_spi_rx_enqueue(uint8_t *p_byte);
+static t_dsp_lane *_dsp_lane_select(void);
 
-static void _dsp_spi_tx_byte(uint8_t *p_byte);
-static void _dsp_spi_rx_byte(void);
+static void _dsp_spi_start(void);
+static void _dsp_spi_transfer(uint16_t length);
 
-static void _dsp_spi_tx_callback(void);
-static void _dsp_spi_rx_callback(void);
+static void _dsp_spi_dma_callback(void);
+#if DSP_DATA_READY_GPIO
+static void _dsp_data_ready_callback(void);
+#endif
 
 bool _dsp_spi_enabled(void);
 
@@ -126,25 +180,87 @@ bool _dsp_spi_enabled(void);
 void dev_dsp_init(void) {
     //
     _dsp_spi_init();
-
-    /// TODO: EMIFA driver.
-    //
-    // _dsp_emifa_init();
 }
 
-void dev_dsp_spi_tx_enqueue(uint8_t *p_byte) {
+/**
+ * @brief   Queue encoded frame for transmission to DSP.
+ *
+ * Frames are sent whole, lanes are only switched between frames.
+ *
+ * @param[in]   lane_id Transmit lane.
+ * @param[in]   frame   Encoded frame, including delimiter.
+ * @param[in]   length  Length of frame.
+ *
+ * @return  Status code, ERROR if frame does not fit in lane.
+ */
+t_status dev_dsp_spi_tx_enqueue_frame(t_dsp_lane_id lane_id, uint8_t *frame,
+                                      uint16_t length) {
+
+    t_dsp_lane *lane;
+    uint32_t depth;
+    uint16_t i;
 
-    /// TODO: Should catch overflow error and
-    ///       redesign so this does not happen.
-    //
-    // Overwrite on overflow.
-    ring_buffer_put_force(dsp_spi_tx_rbd, p_byte);
+    if (lane_id >= DSP_LANES || length > DSP_SPI_DMA_LEN) {
+        return ERROR;
+    }
+
+    lane = &g_dsp_lanes[lane_id];
+
+    if (dev_dsp_spi_tx_free(lane_id) < length) {
+        lane->stats.dropped++;
+        return ERROR;
+    }
+
+    for (i = 0; i < length; i++) {
+        ring_buffer_put(lane->bytes_rbd, &frame[i]);
+    }
+
+    // Publish length after bytes, Tx interrupt dequeues both.
+    ring_buffer_put(lane->frames_rbd, &length);
+
+    lane->stats.queued++;
+
+    depth = DSP_SPI_TX_BUF_LEN - ring_buffer_free_space(lane->bytes_rbd);
+    if (depth > lane->stats.max_depth) {
+        lane->stats.max_depth = depth;
+    }
 
     if (g_dsp_spi_tx_complete) {
 
         // Start transmission.
-        _dsp_spi_tx_callback();
+        _dsp_spi_start();
+    }
+
+    return SUCCESS;
+}
+
+// Return number of bytes that can be queued in lane.
+uint32_t dev_dsp_spi_tx_free(t_dsp_lane_id lane_id) {
+
+    t_dsp_lane *lane = &g_dsp_lanes[lane_id];
+
+    if (ring_buffer_free_space(lane->frames_rbd) == 0) {
+        return 0;
     }
+
+    return ring_buffer_free_space(lane->bytes_rbd);
+}
+
+/**
+ * @brief   Get queue statistics for transmit lane.
+ *
+ * @param[in]   lane_id Transmit lane.
+ *
+ * @return  Statistics, depth in bytes.
+ */
+t_dsp_lane_stats dev_dsp_spi_lane_stats(t_dsp_lane_id lane_id) {
+
+    t_dsp_lane *lane = &g_dsp_lanes[lane_id];
+    t_dsp_lane_stats stats = lane->stats;
+
+    stats.depth = DSP_SPI_TX_BUF_LEN - ring_buffer_free_space(lane->bytes_rbd);
+
+    return stats;
 }
 
 int dev_dsp_spi_rx_dequeue(uint8_t *p_byte) {
@@ -154,7 +270,39 @@ int dev_dsp_spi_rx_dequeue(uint8_t *p_byte) {
 
 // bool dev_dsp_spi_tx_complete(void) { return g_dsp_spi_tx_complete; }
 
-void dev_dsp_spi_poll(void) { _dsp_spi_rx_byte(); }
+// Clock out bytes queued by DSP.
+void dev_dsp_spi_poll(void) {
+
+    // Transfer in progress already clocks DSP.
+    if (g_dsp_spi_tx_complete) {
+
+        memset(g_dsp_spi_tx_frame, 0, DSP_SPI_POLL_LEN);
+
+        _dsp_spi_transfer(DSP_SPI_POLL_LEN);
+    }
+}
+
+/**
+ * @brief   Test if DSP has bytes to transmit.
+ *
+ * True after rising edge of data ready line, or while line is high.
+ * Always false unless built with DSP_DATA_READY_GPIO.
+ *
+ * @return  True if bytes should be clocked from DSP.
+ */
+bool dev_dsp_spi_data_ready(void) {
+
+    bool ready = false;
+
+#if DSP_DATA_READY_GPIO
+    ready = g_dsp_data_ready ||
+            per_gpio_get(DSP_DATA_READY_BANK, DSP_DATA_READY_PIN);
+
+    g_dsp_data_ready = false;
+#endif
+
+    return ready;
+}
 
 void dev_dsp_spi_tx_boot(uint8_t *buffer, uint32_t length) {
 
@@ -212,6 +360,9 @@ void _dsp_spi_init(void) {
         per_spi_init(&config);
     }
 
+    // Whole frames by EDMA3, SPI1 may be initialised by flash driver.
+    per_spi_dma_init(DSP_SPI, DSP_SPI_INT_CHANNEL);
+
     t_spi_format boot_format = {
         .instance = DSP_SPI,
         .index = DSP_SPI_BOOT_DATA_FORMAT,
@@ -230,95 +381,126 @@ void _dsp_spi_init(void) {
 
     per_spi_set_data_format(&command_format);
 
-    // Tx ring buffer attributes.
-    rb_attr_t tx_attr = {sizeof(dsp_spi_tx_rbmem[0]),
-                         ARRAY_SIZE(dsp_spi_tx_rbmem), dsp_spi_tx_rbmem};
-
     // Rx ring buffer attributes.
     rb_attr_t rx_attr = {sizeof(dsp_spi_rx_rbmem[0]),
                          ARRAY_SIZE(dsp_spi_rx_rbmem), dsp_spi_rx_rbmem};
 
     // Initialise DSP SPI message ring buffers.
-    if (ring_buffer_init(&dsp_spi_tx_rbd, &tx_attr) ||
+    if (_dsp_lane_init(&g_dsp_lanes[DSP_LANE_REALTIME]) == 0 &&
+        _dsp_lane_init(&g_dsp_lanes[DSP_LANE_BULK]) == 0 &&
         ring_buffer_init(&dsp_spi_rx_rbd, &rx_attr) == 0) {
 
-        // Register Tx callback.
-        per_spi_register_callback(DSP_SPI, SPI_TX_COMPLETE,
-                                  _dsp_spi_tx_callback);
-
-        // Register Rx callback.
-        per_spi_register_callback(DSP_SPI, SPI_RX_COMPLETE,
-                                  _dsp_spi_rx_callback);
+        // Register transfer complete callback.
+        per_spi_register_callback(DSP_SPI, SPI_DMA_COMPLETE,
+                                  _dsp_spi_dma_callback);
 
         g_dsp_spi_tx_complete = true;
-
-        _dsp_spi_rx_byte();
     }
-}
-
-static int _dsp_spi_tx_dequeue(uint8_t *p_byte) {
 
-    return ring_buffer_get(dsp_spi_tx_rbd, p_byte);
-}
+#if DSP_DATA_READY_GPIO
+    // DSP signals queued responses.
+    per_pinmux_set(DSP_DATA_READY_PINMUX, DSP_DATA_READY_PINMUX_SHIFT,
+                   DSP_DATA_READY_PINMUX_GPIO);
 
-static void _dsp_spi_rx_enqueue(uint8_t *p_byte) {
+    per_gpio_set_input(DSP_DATA_READY_BANK, DSP_DATA_READY_PIN);
 
-    // Overwrite on overflow?
-    ring_buffer_put_force(dsp_spi_rx_rbd, p_byte);
+    per_gpio_enable_interrupt(DSP_DATA_READY_BANK, DSP_DATA_READY_PIN,
+                              DSP_DATA_READY_INT_CHANNEL,
+                              _dsp_data_ready_callback);
+#endif
 }
 
-static void _dsp_spi_tx_byte(uint8_t *p_byte) {
+static int _dsp_lane_init(t_dsp_lane *lane) {
 
-    g_dsp_spi_tx_complete = false;
-    g_dsp_spi_rx_complete = false;
+    rb_attr_t bytes_attr = {sizeof(lane->bytes_rbmem[0]),
+                            ARRAY_SIZE(lane->bytes_rbmem), lane->bytes_rbmem};
 
-    per_spi_chip_format(DSP_SPI, DSP_SPI_COMMAND_DATA_FORMAT,
-                        DSP_SPI_CHIP_SELECT, DSP_SPI_COMMAND_CSHOLD);
+    rb_attr_t frames_attr = {sizeof(lane->frames_rbmem[0]),
+                             ARRAY_SIZE(lane->frames_rbmem),
+                             lane->frames_rbmem};
+
+    if (ring_buffer_init(&lane->bytes_rbd, &bytes_attr) ||
+        ring_buffer_init(&lane->frames_rbd, &frames_attr)) {
+        return -1;
+    }
 
-    per_spi_trx_int(DSP_SPI, p_byte, &g_dsp_spi_rx_byte, 1);
+    return 0;
 }
 
-static void _dsp_spi_rx_byte(void) {
+// Choose lane for next frame, called from Tx interrupt.
+static t_dsp_lane *_dsp_lane_select(void) {
 
-    uint8_t dummy = 0x00;
+    static uint8_t burst;
 
-    // Transmit dummy byte to receive.
-    _dsp_spi_tx_byte(&dummy);
-}
+    bool realtime =
+        ring_buffer_free_space(g_dsp_lanes[DSP_LANE_REALTIME].frames_rbd) <
+        DSP_SPI_TX_FRAMES;
 
-// static void _dsp_spi_tx_callback(void) { g_dsp_spi_tx_complete = true; }
-static void _dsp_spi_tx_callback(void) {
-    //
-    static uint8_t byte;
+    bool bulk = ring_buffer_free_space(g_dsp_lanes[DSP_LANE_BULK].frames_rbd) <
+                DSP_SPI_TX_FRAMES;
+
+    // Realtime first, but let a bulk frame through after each burst.
+    if (realtime && (!bulk || burst < DSP_SPI_REALTIME_BURST)) {
+        burst++;
+        return &g_dsp_lanes[DSP_LANE_REALTIME];
+    }
 
-    // Send next queued byte.
-    if (_dsp_spi_tx_dequeue(&byte) == 0) {
+    burst = 0;
 
-        _dsp_spi_tx_byte(&byte);
+    return bulk ? &g_dsp_lanes[DSP_LANE_BULK] : NULL;
+}
 
-    } else {
+// Send next frame, or go idle.  Called from DMA ISR once running.
+static void _dsp_spi_start(void) {
 
-        /// TODO: Do we need to set or test g_dsp_spi_rx_complete
-        ///       in this callback?
-        ///       If tx complete interrupt always happens before rx interrupt
-        ///       then no.
+    t_dsp_lane *lane = _dsp_lane_select();
+    uint16_t length;
+    uint16_t i;
 
+    if (lane == NULL) {
         g_dsp_spi_tx_complete = true;
+        return;
+    }
+
+    ring_buffer_get(lane->frames_rbd, &length);
+
+    for (i = 0; i < length; i++) {
+        ring_buffer_get(lane->bytes_rbd, &g_dsp_spi_tx_frame[i]);
     }
+
+    lane->stats.sent++;
+
+    _dsp_spi_transfer(length);
 }
 
-static void _dsp_spi_rx_callback(void) {
+static void _dsp_spi_transfer(uint16_t length) {
+
+    g_dsp_spi_tx_complete = false;
+    g_dsp_spi_transfer_length = length;
 
-    _dsp_spi_rx_enqueue(&g_dsp_spi_rx_byte);
+    per_spi_chip_format(DSP_SPI, DSP_SPI_COMMAND_DATA_FORMAT,
+                        DSP_SPI_CHIP_SELECT, DSP_SPI_COMMAND_CSHOLD);
 
-    if (g_dsp_spi_tx_complete == true) {
+    // DSP paces each byte with SPI ENA.
+    per_spi_trx_dma(DSP_SPI, g_dsp_spi_tx_frame, g_dsp_spi_rx_frame, length);
+}
 
-        /// TODO: Do we even need this?
-        ///       It's not currently tested anywhere.
-        ///       Rx is complete when tx is complete.
+static void _dsp_spi_dma_callback(void) {
 
-        g_dsp_spi_rx_complete = true;
+    uint16_t i;
+
+    /// TODO: Should catch overflow error.
+    //
+    // Overwrite on overflow.
+    for (i = 0; i < g_dsp_spi_transfer_length; i++) {
+        ring_buffer_put_force(dsp_spi_rx_rbd, &g_dsp_spi_rx_frame[i]);
     }
+
+    _dsp_spi_start();
 }
 
+#if DSP_DATA_READY_GPIO
+static void _dsp_data_ready_callback(void) { g_dsp_data_ready = true; }
+#endif
+
 /*----- End of file --------------------------------------------------*/
@@ -46,18 +46,44 @@ extern "C" {
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "ft_error.h"
+
 /*----- Macros -------------------------------------------------------*/
 
 /*----- Typedefs -----------------------------------------------------*/
 
+/// Transmit lanes, realtime frames are sent ahead of bulk frames.
+typedef enum {
+    DSP_LANE_REALTIME,
+    DSP_LANE_BULK,
+    DSP_LANES,
+} t_dsp_lane_id;
+
+/// Transmit lane queue statistics.
+typedef struct {
+    // Frames queued and sent since init.
+    uint32_t queued;
+    uint32_t sent;
+    // Frames rejected while lane full.
+    uint32_t dropped;
+    // Bytes waiting, and most bytes waiting since init.
+    uint32_t depth;
+    uint32_t max_depth;
+
+} t_dsp_lane_stats;
+
 /*----- Extern variable declarations ---------------------------------*/
 
 /*----- Extern function prototypes -----------------------------------*/
 
 void dev_dsp_init(void);
-void dev_dsp_spi_tx_enqueue(uint8_t *dsp_spi_msg);
+t_status dev_dsp_spi_tx_enqueue_frame(t_dsp_lane_id lane_id, uint8_t *frame,
+                                      uint16_t length);
+uint32_t dev_dsp_spi_tx_free(t_dsp_lane_id lane_id);
+t_dsp_lane_stats dev_dsp_spi_lane_stats(t_dsp_lane_id lane_id);
 int dev_dsp_spi_rx_dequeue(uint8_t *dsp_spi_msg);
 void dev_dsp_spi_poll(void);
+bool dev_dsp_spi_data_ready(void);
 void dev_dsp_spi_tx_boot(uint8_t *buffer, uint32_t length);
 void dev_dsp_reset(bool state);
 void dev_dsp_spi_transfer(void);
@@ -0,0 +1,185 @@
+/*----------------------------------------------------------------------
+
+                     This file is part of Freetribe
+
+                https://github.com/bangcorrupt/freetribe
+
+                                License
+
+                   GNU AFFERO GENERAL PUBLIC LICENSE
+                      Version 3, 19 November 2007
+
+                           AGPL-3.0-or-later
+
+ Freetribe is free software: you can redistribute it and/or modify it
+under the terms of the GNU Affero General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+                  (at your option) any later version.
+
+     Freetribe is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty
+        of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+          See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+                       Copyright bangcorrupt 2024
+
+----------------------------------------------------------------------*/
+
+/**
+ * @file    dev_dsp_hostdp.c
+ *
+ * @brief   Device driver for communicating with DSP via EMIFA and HostDP.
+ *
+ * The BF523 Host DMA Port sits on an EMIFA asynchronous chip
+ * select.  Frames are exchanged through a mailbox in DSP memory,
+ * see ft_hostdp.c.  The mailbox address is requested over SPI.
+ */
+
+/*----- Includes -----------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "hw_types.h"
+#include "soc_AM1808.h"
+
+#include "per_emifa.h"
+
+#include "dev_dsp_hostdp.h"
+
+#include "ft_hostdp.h"
+
+/*----- Macros -------------------------------------------------------*/
+
+/// TODO: Confirm chip select and HOST_ADDR wiring.
+//
+// HOST_ADDR on EMA_A[0], byte address bit 1 on a 16 bit bus.
+#define DSP_HOSTDP_CHIP_SELECT EMIFA_CHIP_SELECT_3
+#define DSP_HOSTDP_BASE SOC_EMIFA_CS3_ADDR
+#define DSP_HOSTDP_CONFIG_OFFSET 0x2
+
+/// TODO: Timing from BF523 HostDP AC characteristics.
+//
+// Setup, strobe, hold for write and read, then turnaround,
+// in EMIFA clock cycles.  HOST_ACK extends the strobe.
+#define DSP_HOSTDP_TIMING EMIFA_ASYNC_WAITTIME_CONFIG(1, 4, 1, 1, 4, 1, 1)
+
+#define DSP_HOSTDP_WAIT_PIN EMIFA_EMA_WAIT_PIN0
+#define DSP_HOSTDP_WAIT_POLARITY EMIFA_EMA_WAIT_PIN_POLARITY_LOW
+
+/*----- Typedefs -----------------------------------------------------*/
+
+/*----- Static variable definitions ----------------------------------*/
+
+static t_hostdp_link g_hostdp_link;
+static bool g_hostdp_open;
+
+// EMIFA chip select configured.
+static bool g_hostdp_configured;
+
+/*----- Extern variable definitions ----------------------------------*/
+
+/*----- Static function prototypes -----------------------------------*/
+
+static void _hostdp_write(bool config, uint16_t value);
+static uint16_t _hostdp_read(bool config);
+
+static const t_hostdp_bus g_hostdp_bus = {_hostdp_write, _hostdp_read};
+
+/*----- Extern function implementations ------------------------------*/
+
+/**
+ * @brief   Configure EMIFA for host port, once.
+ *
+ * Called only when HostDP is selected, so wiring and timing guesses
+ * do not affect the default SPI transport.
+ */
+void dev_dsp_hostdp_init(void) {
+
+    if (g_hostdp_configured) {
+        return;
+    }
+
+    t_emifa_async_config config = {
+        .chip_select = DSP_HOSTDP_CHIP_SELECT,
+        .bus_width = EMIFA_DATA_BUSWITTH_16BIT,
+        .timing = DSP_HOSTDP_TIMING,
+        .extended_wait = true,
+        .wait_pin = DSP_HOSTDP_WAIT_PIN,
+        .wait_polarity = DSP_HOSTDP_WAIT_POLARITY,
+    };
+
+    per_emifa_async_init(config);
+
+    g_hostdp_open = false;
+    g_hostdp_configured = true;
+}
+
+/**
+ * @brief   Attach to DSP mailbox.
+ *
+ * @param[in]   mailbox DSP address from SYSTEM_HOSTDP_MAILBOX.
+ *
+ * @return  ERROR if mailbox not found.
+ */
+t_status dev_dsp_hostdp_open(uint32_t mailbox) {
+
+    g_hostdp_open =
+        hostdp_open(&g_hostdp_link, &g_hostdp_bus, mailbox) == SUCCESS;
+
+    return g_hostdp_open ? SUCCESS : ERROR;
+}
+
+bool dev_dsp_hostdp_is_open(void) { return g_hostdp_open; }
+
+/**
+ * @brief   Write encoded frame to DSP mailbox.
+ *
+ * @param[in]   frame   Encoded frame, including delimiter.
+ * @param[in]   length  Length of frame.
+ *
+ * @return  ERROR if mailbox full, TIMEOUT_ERROR if port
+ *          does not respond.
+ */
+t_status dev_dsp_hostdp_tx_frame(const uint8_t *frame, uint16_t length) {
+
+    if (!g_hostdp_open) {
+        return TIMEOUT_ERROR;
+    }
+
+    return hostdp_send(&g_hostdp_link, frame, length);
+}
+
+/**
+ * @brief   Read bytes DSP has queued in mailbox.
+ *
+ * @param[out]  buffer  Received bytes.
+ * @param[in]   length  Size of buffer.
+ *
+ * @return  Number of bytes received.
+ */
+uint16_t dev_dsp_hostdp_rx(uint8_t *buffer, uint16_t length) {
+
+    if (!g_hostdp_open) {
+        return 0;
+    }
+
+    return hostdp_receive(&g_hostdp_link, buffer, length);
+}
+
+/*----- Static function implementations ------------------------------*/
+
+static void _hostdp_write(bool config, uint16_t value) {
+
+    HWREGH(DSP_HOSTDP_BASE + (config ? DSP_HOSTDP_CONFIG_OFFSET : 0)) = value;
+}
+
+static uint16_t _hostdp_read(bool config) {
+
+    return HWREGH(DSP_HOSTDP_BASE + (config ? DSP_HOSTDP_CONFIG_OFFSET : 0));
+}
+
+/*----- End of file --------------------------------------------------*/
@@ -0,0 +1,70 @@
+/*----------------------------------------------------------------------
+
+                     This file is part of Freetribe
+
+                https://github.com/bangcorrupt/freetribe
+
+                                License
+
+                   GNU AFFERO GENERAL PUBLIC LICENSE
+                      Version 3, 19 November 2007
+
+                           AGPL-3.0-or-later
+
+ Freetribe is free software: you can redistribute it and/or modify it
+under the terms of the GNU Affero General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+                  (at your option) any later version.
+
+     Freetribe is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty
+        of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+          See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+                       Copyright bangcorrupt 2024
+
+----------------------------------------------------------------------*/
+
+/**
+ * @file    dev_dsp_hostdp.h
+ *
+ * @brief   Public API for communicating with DSP via EMIFA and HostDP.
+ */
+
+#ifndef DEV_DSP_HOSTDP_H
+#define DEV_DSP_HOSTDP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*----- Includes -----------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ft_error.h"
+
+/*----- Macros -------------------------------------------------------*/
+
+/*----- Typedefs -----------------------------------------------------*/
+
+/*----- Extern variable declarations ---------------------------------*/
+
+/*----- Extern function prototypes -----------------------------------*/
+
+void dev_dsp_hostdp_init(void);
+t_status dev_dsp_hostdp_open(uint32_t mailbox);
+bool dev_dsp_hostdp_is_open(void);
+t_status dev_dsp_hostdp_tx_frame(const uint8_t *frame, uint16_t length);
+uint16_t dev_dsp_hostdp_rx(uint8_t *buffer, uint16_t length);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
+
+/*----- End of file --------------------------------------------------*/
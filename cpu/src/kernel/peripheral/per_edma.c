@@ -0,0 +1,186 @@
+/*----------------------------------------------------------------------
+
+                     This file is part of Freetribe
+
+                https://github.com/bangcorrupt/freetribe
+
+                                License
+
+                   GNU AFFERO GENERAL PUBLIC LICENSE
+                      Version 3, 19 November 2007
+
+                           AGPL-3.0-or-later
+
+ Freetribe is free software: you can redistribute it and/or modify it
+under the terms of the GNU Affero General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+                  (at your option) any later version.
+
+     Freetribe is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty
+        of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+          See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+                       Copyright bangcorrupt 2024
+
+----------------------------------------------------------------------*/
+
+/**
+ * @file    per_edma.c
+ *
+ * @brief   Configuration and handling for EDMA3 peripheral.
+ *
+ * Channel n uses PaRAM set n and transfer completion code n,
+ * all on event queue 0.
+ */
+
+/*----- Includes -----------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "hw_edma3cc.h"
+#include "soc_AM1808.h"
+
+#include "csl_edma.h"
+#include "csl_interrupt.h"
+
+#include "per_edma.h"
+
+/*----- Macros -------------------------------------------------------*/
+
+#define EDMA_BASE SOC_EDMA30CC_0_REGS
+#define EDMA_QUEUE 0
+
+/// PaRAM link address terminating transfer.
+#define EDMA_LINK_NULL 0xffff
+
+/*----- Typedefs -----------------------------------------------------*/
+
+/*----- Static variable definitions ----------------------------------*/
+
+static void (*g_callback[EDMA_CHANNELS])(void);
+
+static bool g_initialised = false;
+
+/*----- Extern variable definitions ----------------------------------*/
+
+/*----- Static function prototypes -----------------------------------*/
+
+static void _edma_isr(void);
+
+/*----- Extern function implementations ------------------------------*/
+
+/// TODO: Error interrupt.
+//
+void per_edma_init(uint8_t int_channel) {
+
+    // EDMA3 CC0 and TC0 powered on in startup.
+    EDMA3Init(EDMA_BASE, EDMA_QUEUE);
+
+    // Set interrupt channel.
+    IntChannelSet(SYS_INT_CCINT0, int_channel);
+
+    // Register completion ISR in the Interrupt Vector Table of AINTC.
+    IntRegister(SYS_INT_CCINT0, _edma_isr);
+
+    // Enable system interrupt in AINTC.
+    IntSystemEnable(SYS_INT_CCINT0);
+
+    g_initialised = true;
+}
+
+bool per_edma_initialised(void) { return g_initialised; }
+
+/**
+ * @brief   Claim event triggered channel.
+ *
+ * @param[in]   channel     Channel, e.g. EDMA3_CHA_SPI1_RX.
+ * @param[in]   callback    Called from ISR when transfer complete,
+ *                          or NULL for no completion interrupt.
+ *
+ * @return  ERROR if channel could not be claimed.
+ */
+t_status per_edma_request(uint8_t channel, void (*callback)(void)) {
+
+    if (channel >= EDMA_CHANNELS ||
+        !EDMA3RequestChannel(EDMA_BASE, EDMA3_CHANNEL_TYPE_DMA, channel,
+                             channel, EDMA_QUEUE)) {
+        return ERROR;
+    }
+
+    g_callback[channel] = callback;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief   Arm channel to move bytes on each peripheral event.
+ *
+ * Caller maintains cache coherence of memory buffers.
+ *
+ * @param[in]   channel     Claimed channel.
+ * @param[in]   transfer    Addresses, increments and byte count.
+ */
+void per_edma_transfer(uint8_t channel, t_edma_transfer *transfer) {
+
+    EDMA3CCPaRAMEntry param = {
+        .srcAddr = transfer->src,
+        .destAddr = transfer->dst,
+        .aCnt = 1,
+        .bCnt = transfer->count,
+        .cCnt = 1,
+        .srcBIdx = transfer->src_index,
+        .destBIdx = transfer->dst_index,
+        .srcCIdx = 0,
+        .destCIdx = 0,
+        .bCntReload = 0,
+        .linkAddr = EDMA_LINK_NULL,
+    };
+
+    // A synchronised, completion code matches channel.
+    param.opt = (channel << EDMA3CC_OPT_TCC_SHIFT) & EDMA3CC_OPT_TCC;
+
+    if (g_callback[channel] != NULL) {
+        param.opt |= EDMA3CC_OPT_TCINTEN;
+    }
+
+    EDMA3SetPaRAM(EDMA_BASE, channel, &param);
+
+    EDMA3EnableTransfer(EDMA_BASE, channel, EDMA3_TRIG_MODE_EVENT);
+}
+
+/*----- Static function implementations ------------------------------*/
+
+static void _edma_isr(void) {
+
+    uint32_t pending;
+    uint8_t channel;
+
+#if NESTED_INTERRUPTS
+    // System interrupt already cleared in IRQHandler.
+#else
+    IntSystemStatusClear(SYS_INT_CCINT0);
+#endif
+
+    // Handle all pending completions.
+    while ((pending = EDMA3GetIntrStatus(EDMA_BASE))) {
+
+        for (channel = 0; channel < EDMA_CHANNELS; channel++) {
+
+            if (pending & (1u << channel)) {
+
+                EDMA3ClrIntr(EDMA_BASE, channel);
+
+                if (g_callback[channel] != NULL) {
+                    g_callback[channel]();
+                }
+            }
+        }
+    }
+}
+
+/*----- End of file --------------------------------------------------*/
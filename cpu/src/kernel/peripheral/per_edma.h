@@ -0,0 +1,85 @@
+/*----------------------------------------------------------------------
+
+                     This file is part of Freetribe
+
+                https://github.com/bangcorrupt/freetribe
+
+                                License
+
+                   GNU AFFERO GENERAL PUBLIC LICENSE
+                      Version 3, 19 November 2007
+
+                           AGPL-3.0-or-later
+
+ Freetribe is free software: you can redistribute it and/or modify it
+under the terms of the GNU Affero General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+                  (at your option) any later version.
+
+     Freetribe is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty
+        of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+          See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+                       Copyright bangcorrupt 2024
+
+----------------------------------------------------------------------*/
+
+/**
+ * @file    per_edma.h
+ *
+ * @brief   Public API for EDMA3 peripheral driver.
+ */
+
+#ifndef PER_EDMA_H
+#define PER_EDMA_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*----- Includes -----------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "csl_edma.h"
+#include "edma_event.h"
+
+#include "ft_error.h"
+
+/*----- Macros -------------------------------------------------------*/
+
+/// Channels of EDMA3 channel controller 0.
+#define EDMA_CHANNELS 32
+
+/*----- Typedefs -----------------------------------------------------*/
+
+/// Event triggered transfer of count bytes, one byte per event.
+typedef struct {
+    uint32_t src;
+    uint32_t dst;
+    // Address increment after each byte, 0 for peripheral register.
+    int16_t src_index;
+    int16_t dst_index;
+    uint16_t count;
+} t_edma_transfer;
+
+/*----- Extern variable declarations ---------------------------------*/
+
+/*----- Extern function prototypes -----------------------------------*/
+
+void per_edma_init(uint8_t int_channel);
+bool per_edma_initialised(void);
+t_status per_edma_request(uint8_t channel, void (*callback)(void));
+void per_edma_transfer(uint8_t channel, t_edma_transfer *transfer);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
+
+/*----- End of file --------------------------------------------------*/
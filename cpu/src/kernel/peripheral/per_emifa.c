@@ -0,0 +1,87 @@
+/*----------------------------------------------------------------------
+
+                     This file is part of Freetribe
+
+                https://github.com/bangcorrupt/freetribe
+
+                                License
+
+                   GNU AFFERO GENERAL PUBLIC LICENSE
+                      Version 3, 19 November 2007
+
+                           AGPL-3.0-or-later
+
+ Freetribe is free software: you can redistribute it and/or modify it
+under the terms of the GNU Affero General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+                  (at your option) any later version.
+
+     Freetribe is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty
+        of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+          See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+                       Copyright bangcorrupt 2024
+
+----------------------------------------------------------------------*/
+
+/**
+ * @file    per_emifa.c
+ *
+ * @brief   Peripheral driver for EMIFA.
+ */
+
+/*----- Includes -----------------------------------------------------*/
+
+#include <stdint.h>
+
+#include "csl_emifa.h"
+#include "soc_AM1808.h"
+
+#include "per_emifa.h"
+
+/*----- Macros -------------------------------------------------------*/
+
+/// Wait cycles before EMIFA gives up on extended wait.
+#define EMIFA_MAX_EXT_WAIT 0x80
+
+/*----- Typedefs -----------------------------------------------------*/
+
+/*----- Static variable definitions ----------------------------------*/
+
+/*----- Extern variable definitions ----------------------------------*/
+
+/*----- Static function prototypes -----------------------------------*/
+
+/*----- Extern function implementations ------------------------------*/
+
+/// TODO: Timeout interrupt if extended wait exceeds maximum.
+
+void per_emifa_async_init(t_emifa_async_config config) {
+
+    EMIFAAsyncDevOpModeSelect(SOC_EMIFA_0_REGS, config.chip_select,
+                              EMIFA_ASYNC_INTERFACE_NORMAL_MODE);
+
+    EMIFAAsyncDevDataBusWidthSelect(SOC_EMIFA_0_REGS, config.chip_select,
+                                    config.bus_width);
+
+    EMIFAWaitTimingConfig(SOC_EMIFA_0_REGS, config.chip_select, config.timing);
+
+    if (config.extended_wait) {
+
+        EMIFAMaxExtWaitCycleSet(SOC_EMIFA_0_REGS, EMIFA_MAX_EXT_WAIT);
+
+        EMIFAWaitPinPolaritySelect(SOC_EMIFA_0_REGS, config.wait_pin,
+                                   config.wait_polarity);
+
+        EMIFAExtendedWaitConfig(SOC_EMIFA_0_REGS, config.chip_select,
+                                EMIFA_EXTENDED_WAIT_ENABLE);
+    }
+}
+
+/*----- Static function implementations ------------------------------*/
+
+/*----- End of file --------------------------------------------------*/
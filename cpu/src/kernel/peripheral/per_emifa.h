@@ -0,0 +1,78 @@
+/*----------------------------------------------------------------------
+
+                     This file is part of Freetribe
+
+                https://github.com/bangcorrupt/freetribe
+
+                                License
+
+                   GNU AFFERO GENERAL PUBLIC LICENSE
+                      Version 3, 19 November 2007
+
+                           AGPL-3.0-or-later
+
+ Freetribe is free software: you can redistribute it and/or modify it
+under the terms of the GNU Affero General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+                  (at your option) any later version.
+
+     Freetribe is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty
+        of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+          See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+                       Copyright bangcorrupt 2024
+
+----------------------------------------------------------------------*/
+
+/**
+ * @file    per_emifa.h
+ *
+ * @brief   Public API for EMIFA peripheral driver.
+ */
+
+#ifndef PER_EMIFA_H
+#define PER_EMIFA_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*----- Includes -----------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "csl_emifa.h"
+
+/*----- Macros -------------------------------------------------------*/
+
+/*----- Typedefs -----------------------------------------------------*/
+
+/// Asynchronous chip select, values as csl_emifa.h.
+typedef struct {
+    uint32_t chip_select;
+    uint32_t bus_width;
+    // EMIFA_ASYNC_WAITTIME_CONFIG().
+    uint32_t timing;
+    // Stretch strobe while wait pin asserted.
+    bool extended_wait;
+    uint32_t wait_pin;
+    uint32_t wait_polarity;
+} t_emifa_async_config;
+
+/*----- Extern variable declarations ---------------------------------*/
+
+/*----- Extern function prototypes -----------------------------------*/
+
+void per_emifa_async_init(t_emifa_async_config config);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
+
+/*----- End of file --------------------------------------------------*/
@@ -44,20 +44,42 @@ under the terms of the GNU Affero General Public License as published by
 
 #include "soc_AM1808.h"
 
+#include "startup.h"
+
 #include "csl_gpio.h"
+#include "csl_interrupt.h"
 
 #include "per_gpio.h"
 
 /*----- Macros -------------------------------------------------------*/
 
+#define GPIO_BANKS 9
+#define GPIO_INT_MAX 4
+
 /*----- Typedefs -----------------------------------------------------*/
 
+typedef struct {
+    uint8_t pin_index;
+    uint32_t system_int;
+    void (*callback)(void);
+} t_gpio_int;
+
 /*----- Static variable definitions ----------------------------------*/
 
+static const uint32_t g_system_interrupt[GPIO_BANKS] = {
+    SYS_INT_GPIOB0, SYS_INT_GPIOB1, SYS_INT_GPIOB2,
+    SYS_INT_GPIOB3, SYS_INT_GPIOB4, SYS_INT_GPIOB5,
+    SYS_INT_GPIOB6, SYS_INT_GPIOB7, SYS_INT_GPIOB8};
+
+static t_gpio_int g_gpio_int[GPIO_INT_MAX];
+static uint8_t g_gpio_int_count;
+
 /*----- Extern variable definitions ----------------------------------*/
 
 /*----- Static function prototypes -----------------------------------*/
 
+static void _gpio_isr(void);
+
 /*----- Extern function implementations ------------------------------*/
 
 /*
@@ -126,6 +148,14 @@ void per_gpio_set(uint8_t bank, uint8_t pin, bool state) {
     per_gpio_set_indexed(pin_index, state);
 }
 
+void per_gpio_set_input(uint8_t bank, uint8_t pin) {
+
+    // Pins indexed from 1 to 0x90.
+    uint8_t pin_index = (bank << 4) + pin + 1;
+
+    GPIODirModeSet(SOC_GPIO_0_REGS, pin_index, GPIO_DIR_INPUT);
+}
+
 void per_gpio_toggle(uint8_t bank, uint8_t pin) {
 
     // Pins indexed from 1 to 0x90.
@@ -152,6 +182,69 @@ void per_gpio_toggle_indexed(uint8_t pin_index) {
     GPIOPinWrite(SOC_GPIO_0_REGS, pin_index, !state);
 }
 
+/**
+ * @brief   Call function on rising edge of pin.
+ *
+ * @param[in]   bank        GPIO bank.
+ * @param[in]   pin         Pin within bank.
+ * @param[in]   int_channel AINTC channel for bank interrupt.
+ * @param[in]   callback    Function called from interrupt.
+ */
+void per_gpio_enable_interrupt(uint8_t bank, uint8_t pin, uint8_t int_channel,
+                               void (*callback)(void)) {
+
+    t_gpio_int *gpio_int;
+
+    if (bank < GPIO_BANKS && g_gpio_int_count < GPIO_INT_MAX) {
+
+        gpio_int = &g_gpio_int[g_gpio_int_count++];
+
+        // Pins indexed from 1 to 0x90.
+        gpio_int->pin_index = (bank << 4) + pin + 1;
+        gpio_int->system_int = g_system_interrupt[bank];
+        gpio_int->callback = callback;
+
+        GPIOIntTypeSet(SOC_GPIO_0_REGS, gpio_int->pin_index,
+                       GPIO_INT_TYPE_RISEDGE);
+
+        GPIOBankIntEnable(SOC_GPIO_0_REGS, bank);
+
+        // Set interrupt channel.
+        IntChannelSet(gpio_int->system_int, int_channel);
+
+        // Register the GPIO Isr in the Interrupt Vector Table of AINTC.
+        IntRegister(gpio_int->system_int, _gpio_isr);
+
+        // Enable system interrupt in AINTC.
+        IntSystemEnable(gpio_int->system_int);
+    }
+}
+
 /*----- Static function implementations ------------------------------*/
 
+static void _gpio_isr(void) {
+
+    t_gpio_int *gpio_int;
+    uint8_t i;
+
+    for (i = 0; i < g_gpio_int_count; i++) {
+
+        gpio_int = &g_gpio_int[i];
+
+#if NESTED_INTERRUPTS
+        // System interrupt already cleared in IRQHandler.
+#else
+        IntSystemStatusClear(gpio_int->system_int);
+#endif
+
+        if (GPIOPinIntStatus(SOC_GPIO_0_REGS, gpio_int->pin_index) ==
+            GPIO_INT_PEND) {
+
+            GPIOPinIntClear(SOC_GPIO_0_REGS, gpio_int->pin_index);
+
+            gpio_int->callback();
+        }
+    }
+}
+
 /*----- End of file --------------------------------------------------*/
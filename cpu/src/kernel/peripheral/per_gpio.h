@@ -58,11 +58,15 @@ void per_gpio_init(void);
 bool per_gpio_get(uint8_t bank, uint8_t pin);
 void per_gpio_set(uint8_t bank, uint8_t pin, bool state);
 void per_gpio_toggle(uint8_t bank, uint8_t pin);
+void per_gpio_set_input(uint8_t bank, uint8_t pin);
 
 bool per_gpio_get_indexed(uint8_t pin_index);
 void per_gpio_set_indexed(uint8_t pin_index, bool state);
 void per_gpio_toggle_indexed(uint8_t pin_index);
 
+void per_gpio_enable_interrupt(uint8_t bank, uint8_t pin, uint8_t int_channel,
+                               void (*callback)(void));
+
 #ifdef __cplusplus
 }
 #endif
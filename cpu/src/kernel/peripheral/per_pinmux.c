@@ -36,6 +36,8 @@ under the terms of the GNU Affero General Public License as published by
 
 /*----- Includes -----------------------------------------------------*/
 
+#include <stdint.h>
+
 #include "hw_syscfg0_AM1808.h"
 #include "hw_types.h"
 
@@ -122,6 +124,23 @@ void per_pinmux_init(void) {
     HWREG(SOC_SYSCFG_0_REGS + SYSCFG0_PINMUX(19)) = 0x18888888;
 }
 
+/**
+ * @brief   Set one pin function after initialisation.
+ *
+ * @param[in]   reg     PINMUX register index.
+ * @param[in]   shift   Bit offset of 4 bit field.
+ * @param[in]   value   Pin function.
+ */
+void per_pinmux_set(uint8_t reg, uint8_t shift, uint8_t value) {
+
+    uint32_t pinmux = HWREG(SOC_SYSCFG_0_REGS + SYSCFG0_PINMUX(reg));
+
+    pinmux &= ~(0xfUL << shift);
+    pinmux |= (uint32_t)(value & 0xf) << shift;
+
+    HWREG(SOC_SYSCFG_0_REGS + SYSCFG0_PINMUX(reg)) = pinmux;
+}
+
 /*----- Static function implementations ------------------------------*/
 
 /*----- End of file --------------------------------------------------*/
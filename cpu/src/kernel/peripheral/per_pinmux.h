@@ -43,6 +43,8 @@ extern "C" {
 
 /*----- Includes -----------------------------------------------------*/
 
+#include <stdint.h>
+
 /*----- Macros -------------------------------------------------------*/
 
 /*----- Typedefs -----------------------------------------------------*/
@@ -52,6 +54,7 @@ extern "C" {
 /*----- Extern function prototypes -----------------------------------*/
 
 void per_pinmux_init(void);
+void per_pinmux_set(uint8_t reg, uint8_t shift, uint8_t value);
 
 #ifdef __cplusplus
 }
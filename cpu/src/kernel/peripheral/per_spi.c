@@ -47,6 +47,7 @@ under the terms of the GNU Affero General Public License as published by
 #include "csl_interrupt.h"
 #include "csl_spi.h"
 
+#include "per_edma.h"
 #include "per_gpio.h"
 #include "per_spi.h"
 
@@ -71,6 +72,7 @@ typedef struct {
 
     void (*tx_callback)(void);
     void (*rx_callback)(void);
+    void (*dma_callback)(void);
 
     bool initialised;
 
@@ -81,6 +83,9 @@ typedef struct {
 static void _spi0_isr(void);
 static void _spi1_isr(void);
 
+static void _spi0_dma_complete(void);
+static void _spi1_dma_complete(void);
+
 /*----- Static variable definitions ----------------------------------*/
 
 static const uint32_t g_base_address[SPI_INSTANCES] = {SPI0_BASE, SPI1_BASE};
@@ -90,6 +95,15 @@ static const uint32_t g_system_interrupt[SPI_INSTANCES] = {SYS_INT_SPIINT0,
 
 static const void *g_isr_address[SPI_INSTANCES] = {&_spi0_isr, &_spi1_isr};
 
+static const uint8_t g_dma_rx_channel[SPI_INSTANCES] = {EDMA3_CHA_SPI0_RX,
+                                                        EDMA3_CHA_SPI1_RX};
+
+static const uint8_t g_dma_tx_channel[SPI_INSTANCES] = {EDMA3_CHA_SPI0_TX,
+                                                        EDMA3_CHA_SPI1_TX};
+
+static void (*const g_dma_complete[SPI_INSTANCES])(void) = {
+    &_spi0_dma_complete, &_spi1_dma_complete};
+
 static t_spi g_spi[SPI_INSTANCES];
 
 /*----- Extern variable definitions ----------------------------------*/
@@ -109,6 +123,7 @@ void per_spi_init(t_spi_config *config) {
     spi->rx_length = 0;
     spi->tx_callback = NULL;
     spi->rx_callback = NULL;
+    spi->dma_callback = NULL;
     spi->initialised = false;
 
     // SPI in reset
@@ -253,6 +268,75 @@ void per_spi_trx_int(uint8_t instance, uint8_t *tx_buffer, uint8_t *rx_buffer,
     }
 }
 
+/// TODO: Return status if channels unavailable.
+//
+/**
+ * @brief   Claim EDMA3 channels for per_spi_trx_dma().
+ *
+ * @param[in]   instance        SPI instance.
+ * @param[in]   int_channel     AINTC channel, if EDMA3 not
+ *                              already initialised.
+ */
+void per_spi_dma_init(uint8_t instance, uint8_t int_channel) {
+
+    if (!per_edma_initialised()) {
+        per_edma_init(int_channel);
+    }
+
+    // Whole transfer received when Rx channel completes.
+    per_edma_request(g_dma_rx_channel[instance], g_dma_complete[instance]);
+
+    per_edma_request(g_dma_tx_channel[instance], NULL);
+}
+
+/**
+ * @brief   Exchange buffers using EDMA3, one interrupt per transfer.
+ *
+ * Requires per_spi_dma_init().  SPI_DMA_COMPLETE callback
+ * runs when the last byte has been received.
+ *
+ * @param[in]   instance    SPI instance.
+ * @param[in]   tx_buffer   Bytes to send.
+ * @param[out]  rx_buffer   Bytes received, must not share
+ *                          cache lines with other data.
+ * @param[in]   length      Number of bytes each way.
+ */
+void per_spi_trx_dma(uint8_t instance, uint8_t *tx_buffer, uint8_t *rx_buffer,
+                     uint32_t length) {
+
+    t_spi *spi = &g_spi[instance];
+
+    if (tx_buffer != NULL && rx_buffer != NULL && length != 0) {
+
+        t_edma_transfer rx = {
+            .src = spi->address + SPI_SPIBUF,
+            .dst = (uint32_t)rx_buffer,
+            .src_index = 0,
+            .dst_index = 1,
+            .count = length,
+        };
+
+        // Byte write leaves chip select and format in SPIDAT1 intact.
+        t_edma_transfer tx = {
+            .src = (uint32_t)tx_buffer,
+            .dst = spi->address + SPI_SPIDAT1,
+            .src_index = 1,
+            .dst_index = 0,
+            .count = length,
+        };
+
+        // Write back Tx bytes, discard stale Rx lines.
+        CP15DCacheCleanBuff((uint32_t)tx_buffer, length);
+        CP15DCacheFlushBuff((uint32_t)rx_buffer, length);
+
+        per_edma_transfer(g_dma_rx_channel[instance], &rx);
+        per_edma_transfer(g_dma_tx_channel[instance], &tx);
+
+        // SPI events start the transfer.
+        SPIIntEnable(spi->address, SPI_DMA_REQUEST_ENA_INT);
+    }
+}
+
 /// TODO: Do these non-interrupt functions work
 ///       if interrupts are not enabled?
 
@@ -312,6 +396,10 @@ void per_spi_register_callback(uint8_t instance, t_spi_event event,
         g_spi[instance].rx_callback = callback;
         break;
 
+    case SPI_DMA_COMPLETE:
+        g_spi[instance].dma_callback = callback;
+        break;
+
         // case SPI_ERROR:
 
     default:
@@ -397,4 +485,19 @@ static void _spi0_isr(void) { _spi_isr(&g_spi[0]); }
 
 static void _spi1_isr(void) { _spi_isr(&g_spi[1]); }
 
+// Called from EDMA3 completion ISR.
+static inline void _spi_dma_complete(t_spi *spi) {
+
+    // Stop SPI events until next transfer.
+    SPIIntDisable(spi->address, SPI_DMA_REQUEST_ENA_INT);
+
+    if (spi->dma_callback != NULL) {
+        spi->dma_callback();
+    }
+}
+
+static void _spi0_dma_complete(void) { _spi_dma_complete(&g_spi[0]); }
+
+static void _spi1_dma_complete(void) { _spi_dma_complete(&g_spi[1]); }
+
 /*----- End of file --------------------------------------------------*/
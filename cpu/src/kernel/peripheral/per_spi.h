@@ -95,6 +95,7 @@ extern "C" {
 typedef enum {
     SPI_TX_COMPLETE,
     SPI_RX_COMPLETE,
+    SPI_DMA_COMPLETE,
 } t_spi_event;
 
 typedef struct {
@@ -123,6 +124,9 @@ void per_spi_set_data_format(t_spi_format *format);
 void per_spi_tx_int(uint8_t instance, uint8_t *buffer, uint32_t length);
 void per_spi_trx_int(uint8_t instance, uint8_t *tx_buffer, uint8_t *rx_buffer,
                      uint32_t length);
+void per_spi_dma_init(uint8_t instance, uint8_t int_channel);
+void per_spi_trx_dma(uint8_t instance, uint8_t *tx_buffer, uint8_t *rx_buffer,
+                     uint32_t length);
 
 bool per_spi_initialised(uint8_t instance);
 void per_spi_chip_format(uint8_t instance, uint8_t data_format,
@@ -38,8 +38,10 @@ under the terms of the GNU Affero General Public License as published by
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "dev_dsp.h"
+#include "dev_dsp_hostdp.h"
 
 #include "ft_error.h"
 
@@ -52,7 +54,55 @@ under the terms of the GNU Affero General Public License as published by
 
 /*----- Macros -------------------------------------------------------*/
 
-#define MSG_START 0xf0
+/// Index and value of one parameter in batch.
+#define PARAM_BATCH_ENTRY_LENGTH 6
+
+/// Maximum parameters in one batch.
+//  Keeps whole frame well inside the SPI tx queue.
+#define PARAM_BATCH_MAX 32
+
+/// Poll for response if data ready not signalled.
+#define RESPONSE_POLL_US 1000
+
+/// Requests awaiting response.
+#define REQUEST_SLOTS 16
+
+/// Time to wait for response before completing with TIMEOUT_ERROR.
+#define REQUEST_TIMEOUT_US 50000
+
+/// Longest wait for SPI tx lane or HostDP mailbox to drain.
+#define TX_WAIT_US 1000
+
+/// Distinct parameters held pending transmission.
+#define PARAM_PENDING_SLOTS 64
+
+/// Bytes read from HostDP mailbox per task call.
+#define HOSTDP_RX_CHUNK 0x100
+
+/// Upload chunks in flight.
+#define UPLOAD_WINDOW 4
+
+/// Data bytes per upload chunk, fits one payload with header.
+#define UPLOAD_CHUNK 240
+
+/// Attempts per chunk, or region open and close, before upload fails.
+#define UPLOAD_ATTEMPTS 3
+
+/// Ready checks before DSP boot fails, DSP may still be initialising.
+#define READY_ATTEMPTS 20
+
+/// Attempts per chunk before parameter resync fails.
+#define RESYNC_ATTEMPTS 3
+
+/// Echo requests in flight during link benchmark.
+#define BENCH_WINDOW 4
+
+/// Round trip latency histogram, last bucket counts all beyond.
+#define BENCH_HIST_BUCKETS 64
+#define BENCH_BUCKET_US 25
+
+/// Latency percentile reported by benchmark.
+#define BENCH_PERCENTILE 99
 
 /*----- Typedefs -----------------------------------------------------*/
 
@@ -67,17 +117,179 @@ typedef enum {
     STATE_ERROR
 } t_dsp_task_state;
 
-typedef enum {
-    PARSE_START,
-    PARSE_MSG_TYPE,
-    PARSE_MSG_ID,
-    PARSE_PAYLOAD_LENGTH,
-    PARSE_PAYLOAD
-} t_msg_parse_state;
+/// Latest value set for one module parameter, pending transmission.
+typedef struct {
+
+    uint16_t module_id;
+    uint16_t param_index;
+    int32_t value;
+
+} t_param_slot;
+
+/// Last known value of each module parameter.
+typedef struct {
+
+    int32_t value[DSP_MIRROR_MODULES][DSP_MIRROR_PARAMS];
+    uint32_t valid[DSP_MIRROR_MODULES][DSP_MIRROR_PARAMS / 32];
+    // Resync generation when value last set by CPU.
+    uint32_t generation[DSP_MIRROR_MODULES][DSP_MIRROR_PARAMS];
+
+} t_param_mirror;
+
+/// Parameter mirror resync of one module, a chunk at a time.
+typedef struct {
+
+    bool running;
+    // Resync requested again while chunk in flight.
+    bool restart;
+    uint16_t module_id;
+    uint16_t start_index;
+    // Mirror generation when chunk requested.
+    uint32_t generation;
+    uint8_t attempts;
+    t_dsp_resync_callback callback;
+
+} t_dsp_resync;
+
+/// DSP ready handshake.
+typedef struct {
+
+    bool waiting;
+    t_status status;
+    uint8_t attempts;
+    // Nodes in default module graph.
+    uint8_t node_count;
+
+} t_dsp_handshake;
+
+/// Outstanding request, matched to response by sequence.
+typedef struct {
+
+    bool active;
+    uint8_t sequence;
+    t_delay_state timeout;
+    t_dsp_request_callback callback;
+    void *context;
+
+} t_dsp_request;
+
+/// Link benchmark state.
+typedef struct {
+
+    bool running;
+    uint32_t remaining;
+    uint8_t in_flight;
+    // Round trip timer per echo in flight.
+    t_delay_state timers[BENCH_WINDOW];
+    bool busy[BENCH_WINDOW];
+    t_delay_state elapsed;
+    uint64_t total_us;
+    uint32_t hist[BENCH_HIST_BUCKETS];
+    t_dsp_benchmark result;
+    t_dsp_benchmark_callback callback;
+
+} t_dsp_bench;
+
+typedef enum { UPLOAD_OPEN, UPLOAD_DATA, UPLOAD_CLOSE } t_upload_phase;
+
+typedef enum { CHUNK_FREE, CHUNK_SENT, CHUNK_RESEND } t_chunk_state;
+
+/// Upload chunk in flight.
+typedef struct {
+
+    t_chunk_state state;
+    // Offset in upload data.
+    uint32_t offset;
+    uint8_t attempts;
+
+} t_upload_chunk;
+
+/// Region upload state.
+typedef struct {
+
+    bool running;
+    t_upload_phase phase;
+    // Region open or close awaiting acknowledgement.
+    bool waiting;
+    uint8_t attempts;
+    uint8_t region;
+    // Region offset of first data byte.
+    uint32_t offset;
+    const uint8_t *data;
+    uint32_t length;
+    // Data bytes sent at least once, and acknowledged.
+    uint32_t sent;
+    uint32_t acked;
+    t_upload_chunk chunks[UPLOAD_WINDOW];
+    // First failure, reported when chunks in flight complete.
+    t_status status;
+    t_dsp_upload_callback callback;
+
+} t_dsp_upload;
+
+/// Capture stream into CPU buffer.
+typedef struct {
+
+    bool running;
+    // Stop requested, and request sent.
+    bool stopping;
+    bool stop_sent;
+    uint8_t channels;
+    // Interleaved Q15 samples, length in frames.
+    int16_t *buffer;
+    uint32_t length;
+    // Frames stored, and dropped by DSP.
+    uint32_t frames;
+    uint32_t overruns;
+    t_dsp_capture_callback callback;
+
+} t_dsp_capture;
+
+/// Module parameter descriptor query.
+typedef struct {
+
+    bool running;
+    uint16_t module_id;
+    t_dsp_param_info *info;
+    uint16_t capacity;
+    t_dsp_param_info_callback callback;
+
+} t_dsp_param_query;
 
 /*----- Static variable definitions ----------------------------------*/
 
-static uint32_t g_pending_response;
+static t_param_slot g_param_slots[PARAM_PENDING_SLOTS];
+static uint8_t g_param_slot_count;
+
+static t_param_mirror g_param_mirror;
+static uint32_t g_mirror_generation;
+
+static t_dsp_resync g_resyncs[DSP_MIRROR_MODULES];
+
+static t_dsp_handshake g_handshake;
+
+static t_protocol g_protocol;
+static t_protocol g_hostdp_protocol;
+
+// Realtime messages always use SPI.
+static t_dsp_transport g_bulk_transport = DSP_TRANSPORT_SPI;
+
+static t_dsp_request g_requests[REQUEST_SLOTS];
+static uint8_t g_request_count;
+static uint8_t g_sequence;
+
+static t_delay_state g_poll_delay;
+
+// DSP pushes telemetry while non-zero.
+static uint16_t g_telemetry_interval;
+
+static t_dsp_bench g_bench;
+
+static t_dsp_upload g_upload;
+
+static t_dsp_capture g_capture;
+
+static t_dsp_param_query g_param_query;
 
 static bool g_dsp_ready = false;
 
@@ -85,14 +297,27 @@ typedef void (*t_module_param_value_callback)(uint16_t module_id,
                                               uint16_t param_index,
                                               int32_t param_value);
 
+typedef void (*t_module_cycles_callback)(uint16_t module_id, uint32_t cycles);
+
 typedef void (*t_system_port_state_callback)(uint16_t port_f, uint16_t port_g,
                                              uint16_t port_h);
 
 typedef void (*t_system_profile_callback)(uint32_t period, uint32_t cycles);
 
+typedef void (*t_system_profile_ext_callback)(t_dsp_profile *profile);
+typedef void (*t_system_link_stats_callback)(t_protocol_stats *stats);
+
+typedef void (*t_system_frame_count_callback)(uint32_t frame_count);
+typedef void (*t_system_telemetry_callback)(t_dsp_telemetry *telemetry);
+
 static t_module_param_value_callback p_module_param_value_callback;
+static t_module_cycles_callback p_module_cycles_callback;
 static t_system_port_state_callback p_system_port_state_callback;
 static t_system_profile_callback p_system_profile_callback;
+static t_system_profile_ext_callback p_system_profile_ext_callback;
+static t_system_link_stats_callback p_system_link_stats_callback;
+static t_system_frame_count_callback p_system_frame_count_callback;
+static t_system_telemetry_callback p_system_telemetry_callback;
 
 /*----- Extern variable definitions ----------------------------------*/
 
@@ -100,16 +325,75 @@ static t_system_profile_callback p_system_profile_callback;
 
 static t_status _dsp_init(void);
 static void _dsp_boot(void);
-static void _dsp_receive(uint8_t byte);
-static void _dsp_check_ready(void);
-
-static void _dsp_response_required(void);
-static void _dsp_response_received(void);
+static t_status _dsp_check_ready(void);
+static void _dsp_ready_ack(t_status status, uint8_t *payload, uint8_t length,
+                           void *context);
+static void _dsp_resync_done(t_status status, uint16_t module_id);
+
+static void _link_task(void);
+
+static t_status _transmit_request(uint8_t msg_type, uint8_t msg_id,
+                                  uint8_t *payload, uint8_t length,
+                                  t_dsp_request_callback callback,
+                                  void *context);
+static void _complete_request(uint8_t sequence, t_status status,
+                              uint8_t *payload, uint8_t length);
+static void _check_request_timeouts(void);
 
 static void _transmit_message(uint8_t msg_type, uint8_t msg_id,
                               uint8_t *payload, uint8_t length);
-
-static void _handle_message(uint8_t msg_type, uint8_t msg_id, uint8_t *payload,
+static t_status _enqueue_message(t_dsp_lane_id lane, uint8_t msg_type,
+                                 uint8_t msg_id, uint8_t sequence,
+                                 uint8_t *payload, uint8_t length);
+
+static void _flush_param_slots(bool wait);
+
+static void _hostdp_receive(void);
+static void _hostdp_mailbox(t_status status, uint8_t *payload, uint8_t length,
+                            void *context);
+
+static void _upload_task(void);
+static void _upload_region(uint8_t msg_id, uint32_t value);
+static void _upload_region_ack(t_status status, uint8_t *payload,
+                               uint8_t length, void *context);
+static void _upload_chunk(t_upload_chunk *chunk);
+static void _upload_chunk_ack(t_status status, uint8_t *payload,
+                              uint8_t length, void *context);
+static void _upload_finish(t_status status);
+
+static void _capture_task(void);
+static void _capture_started(t_status status, uint8_t *payload,
+                             uint8_t length, void *context);
+static void _capture_stopped(t_status status, uint8_t *payload,
+                             uint8_t length, void *context);
+static void _capture_finish(t_status status);
+
+static t_status _param_info_request(uint16_t start_index);
+static void _param_info_chunk(t_status status, uint8_t *payload,
+                              uint8_t length, void *context);
+static void _param_info_finish(t_status status, uint16_t count);
+
+static void _benchmark_task(void);
+static void _benchmark_echo(t_status status, uint8_t *payload, uint8_t length,
+                            void *context);
+static void _benchmark_finish(void);
+static uint32_t _benchmark_percentile(uint32_t percentile);
+
+static void _mirror_store(uint16_t module_id, uint16_t param_index,
+                          int32_t param_value);
+static void _mirror_set(uint16_t module_id, uint16_t param_index,
+                        int32_t param_value);
+static void _mirror_invalidate(void);
+static bool _param_slot_pending(uint16_t module_id, uint16_t param_index);
+
+static t_status _request_all_params(t_dsp_resync *resync);
+static void _resync_chunk(t_status status, uint8_t *payload, uint8_t length,
+                          void *context);
+static void _resync_finish(t_dsp_resync *resync, t_status status);
+static t_status _wait_tx_free(t_dsp_lane_id lane, uint32_t length);
+
+static void _handle_message(uint8_t msg_type, uint8_t msg_id,
+                            uint8_t sequence, uint8_t *payload,
                             uint8_t length);
 
 static t_status _handle_module_message(uint8_t msg_id, uint8_t *payload,
@@ -119,10 +403,18 @@ static t_status _handle_system_message(uint8_t msg_id, uint8_t *payload,
                                        uint8_t length);
 
 static t_status _handle_module_param_value(uint8_t *payload, uint8_t length);
+static t_status _handle_module_cycles(uint8_t *payload, uint8_t length);
 static t_status _handle_system_port_state(uint8_t *payload, uint8_t length);
-static t_status _handle_system_ready(void);
 
 static t_status _handle_system_profile(uint8_t *payload, uint8_t length);
+static t_status _handle_system_profile_ext(uint8_t *payload, uint8_t length);
+static t_status _handle_system_frame_count(uint8_t *payload, uint8_t length);
+static t_status _handle_system_link_stats(uint8_t *payload, uint8_t length);
+static t_status _handle_system_capture_data(uint8_t *payload, uint8_t length);
+static t_status _handle_system_telemetry(uint8_t *payload, uint8_t length);
+
+static uint16_t _unpack_u16(uint8_t *payload);
+static uint32_t _unpack_u32(uint8_t *payload);
 
 void _register_module_callback(uint8_t msg_id, void *callback);
 void _register_system_callback(uint8_t msg_id, void *callback);
@@ -135,7 +427,7 @@ void svc_dsp_task(void) {
 
     static t_delay_state reset_delay;
 
-    static uint8_t dsp_byte;
+    uint8_t i;
 
     switch (state) {
 
@@ -174,25 +466,61 @@ void svc_dsp_task(void) {
         if (delay_us(&reset_delay)) {
 
             _dsp_boot();
+            state = STATE_CHECK_READY;
+        }
+        break;
+
+    case STATE_CHECK_READY:
+        if (_dsp_check_ready() == SUCCESS) {
+            state = STATE_WAIT_READY;
+        }
+        break;
+
+    case STATE_WAIT_READY:
+        _link_task();
+
+        if (g_handshake.waiting) {
+            break;
+        }
+
+        if (g_handshake.status == SUCCESS) {
+
+            // Populate parameter mirror from default module graph.
+            for (i = 0; i < g_handshake.node_count && i < DSP_MIRROR_MODULES;
+                 i++) {
+
+                error_check(svc_dsp_resync_module_params(i, _dsp_resync_done));
+            }
+
+            g_dsp_ready = true;
             state = STATE_RUN;
+
+        } else if (g_handshake.status == TIMEOUT_ERROR &&
+                   ++g_handshake.attempts < READY_ATTEMPTS) {
+
+            g_protocol.stats.retries++;
+            state = STATE_CHECK_READY;
+
+        } else {
+            error_check(g_handshake.status);
+            state = STATE_ERROR;
         }
         break;
 
     case STATE_RUN:
-        // Handle received bytes.
-        if (dev_dsp_spi_rx_dequeue(&dsp_byte) == SUCCESS) {
-            _dsp_receive(dsp_byte);
-        }
+        _link_task();
 
-        else if (g_pending_response > 0) {
+        if (g_upload.running) {
+            _upload_task();
+        }
 
-            /// TODO: Can we use GPIO to signal?
-            //
-            // Poll Blackfin for queued bytes.
-            dev_dsp_spi_poll();
+        if (g_capture.running) {
+            _capture_task();
         }
 
-        g_dsp_ready = true;
+        if (g_bench.running) {
+            _benchmark_task();
+        }
         break;
 
     case STATE_ERROR:
@@ -227,19 +555,74 @@ void svc_dsp_register_callback(uint8_t msg_type, uint8_t msg_id,
     }
 }
 
-/// TODO: Move to separate module.
+/**
+ * @brief   Set module parameter.
+ *
+ * Value is held in a pending slot until the next task call, then sent
+ * in a MODULE_SET_PARAM_BATCH message. Setting the same parameter again
+ * before transmission replaces the pending value.
+ *
+ * @param[in]   module_id   Index of module to address.
+ * @param[in]   param_index Index of parameter to set.
+ * @param[in]   param_value Value of parameter.
+ */
 void svc_dsp_set_module_param(uint16_t module_id, uint16_t param_index,
                               int32_t param_value) {
 
+    t_param_slot *slot;
+    uint8_t i;
+
+    _mirror_set(module_id, param_index, param_value);
+
+    // Last writer wins.
+    for (i = 0; i < g_param_slot_count; i++) {
+
+        slot = &g_param_slots[i];
+
+        if (slot->module_id == module_id && slot->param_index == param_index) {
+
+            slot->value = param_value;
+            return;
+        }
+    }
+
+    if (g_param_slot_count == PARAM_PENDING_SLOTS) {
+        _flush_param_slots(true);
+    }
+
+    slot = &g_param_slots[g_param_slot_count++];
+
+    slot->module_id = module_id;
+    slot->param_index = param_index;
+    slot->value = param_value;
+}
+
+/**
+ * @brief   Set module parameter at DSP frame count.
+ *
+ * The DSP applies the value on the exact frame, or at the start
+ * of the next block if the frame has passed.
+ *
+ * @param[in]   module_id   Index of module to address.
+ * @param[in]   param_index Index of parameter to set.
+ * @param[in]   param_value Value of parameter.
+ * @param[in]   frame       DSP frame count, see svc_dsp_get_frame_count().
+ */
+void svc_dsp_set_module_param_at(uint16_t module_id, uint16_t param_index,
+                                 int32_t param_value, uint32_t frame) {
+
     const uint8_t msg_type = MSG_TYPE_MODULE;
     const uint8_t msg_id = MODULE_SET_PARAM_VALUE;
 
-    /// TODO: Union struct / static allocation?
     uint8_t payload[] = {
         (module_id & 0xff),         (module_id >> 8) & 0xff,
         (param_index & 0xff),       (param_index >> 8) & 0xff,
         (param_value & 0xff),       (param_value >> 8) & 0xff,
-        (param_value >> 16) & 0xff, (param_value >> 24) & 0xff};
+        (param_value >> 16) & 0xff, (param_value >> 24) & 0xff,
+        (frame & 0xff),             (frame >> 8) & 0xff,
+        (frame >> 16) & 0xff,       (frame >> 24) & 0xff};
+
+    _mirror_set(module_id, param_index, param_value);
 
     _transmit_message(msg_type, msg_id, payload, sizeof(payload));
 }
@@ -252,275 +635,1589 @@ void svc_dsp_get_module_param(uint16_t module_id, uint16_t param_index) {
     uint8_t payload[] = {(module_id & 0xff), (module_id >> 8) & 0xff,
                          (param_index & 0xff), (param_index >> 8) & 0xff};
 
-    _dsp_response_required();
-
-    _transmit_message(msg_type, msg_id, payload, sizeof(payload));
+    _transmit_request(msg_type, msg_id, payload, sizeof(payload), NULL, NULL);
 }
 
-/// TODO: svc_dsp_get_module_param_count
-///       svc_dsp_get_module_param_name
+/**
+ * @brief   Read module parameter from CPU mirror.
+ *
+ * Mirror holds values sent to the DSP and values received
+ * in MODULE_PARAM_VALUE or MODULE_ALL_PARAMS messages.
+ *
+ * @param[in]   module_id   Index of module to address.
+ * @param[in]   param_index Index of parameter to read.
+ * @param[out]  param_value Value of parameter.
+ *
+ * @return      SUCCESS if value known, otherwise ERROR.
+ */
+t_status svc_dsp_read_module_param(uint16_t module_id, uint16_t param_index,
+                                   int32_t *param_value) {
 
-// Request state of Port F, Port G, Port H GPIO.
-void svc_dsp_get_port_state(void) {
+    if (module_id >= DSP_MIRROR_MODULES || param_index >= DSP_MIRROR_PARAMS ||
+        !(g_param_mirror.valid[module_id][param_index / 32] &
+          (1UL << (param_index % 32)))) {
 
-    const uint8_t msg_type = MSG_TYPE_SYSTEM;
-    const uint8_t msg_id = SYSTEM_GET_PORT_STATE;
+        return ERROR;
+    }
 
-    _dsp_response_required();
+    *param_value = g_param_mirror.value[module_id][param_index];
 
-    _transmit_message(msg_type, msg_id, NULL, 0);
+    return SUCCESS;
 }
 
-void svc_dsp_get_profile(void) {
+/**
+ * @brief   Request all parameter values of module.
+ *
+ * Values are received in chunks to update the mirror.  Values set
+ * after a chunk is requested are kept.  A resync already running
+ * for the module starts again, and reports to the new callback.
+ *
+ * @param[in]   module_id   Index of module to address.
+ * @param[in]   callback    Called when resync completes, may be NULL.
+ *
+ * @return      SUCCESS if resync started, otherwise ERROR.
+ */
+t_status svc_dsp_resync_module_params(uint16_t module_id,
+                                      t_dsp_resync_callback callback) {
 
-    const uint8_t msg_type = MSG_TYPE_SYSTEM;
-    const uint8_t msg_id = SYSTEM_GET_PROFILE;
+    t_dsp_resync *resync;
 
-    _dsp_response_required();
+    if (module_id >= DSP_MIRROR_MODULES) {
+        return ERROR;
+    }
 
-    _transmit_message(msg_type, msg_id, NULL, 0);
-}
+    resync = &g_resyncs[module_id];
 
-bool svc_dsp_ready(void) { return g_dsp_ready; }
+    resync->callback = callback;
 
-/*----- Static function implementations ------------------------------*/
+    if (resync->running) {
+        // Values in flight may predate request, start again on arrival.
+        resync->restart = true;
+        return SUCCESS;
+    }
 
-void _dsp_check_ready(void) {
+    resync->module_id = module_id;
+    resync->start_index = 0;
+    resync->attempts = 0;
+    resync->restart = false;
 
-    const uint8_t msg_type = MSG_TYPE_SYSTEM;
-    const uint8_t msg_id = SYSTEM_CHECK_READY;
+    if (_request_all_params(resync) != SUCCESS) {
+        return ERROR;
+    }
 
-    _dsp_response_required();
+    resync->running = true;
 
-    _transmit_message(msg_type, msg_id, NULL, 0);
+    return SUCCESS;
 }
 
-void _register_module_callback(uint8_t msg_id, void *callback) {
+/**
+ * @brief   Replace DSP module graph.
+ *
+ * Nodes are indexed by module_id, last node provides output.
+ *
+ * @param[in]   nodes   Graph node configuration.
+ * @param[in]   count   Number of nodes.
+ */
+void svc_dsp_set_module_graph(const t_dsp_node *nodes, uint8_t count) {
 
-    switch (msg_id) {
+    const uint8_t msg_type = MSG_TYPE_MODULE;
+    const uint8_t msg_id = MODULE_SET_GRAPH;
 
-    case MODULE_PARAM_VALUE:
-        p_module_param_value_callback = (t_module_param_value_callback)callback;
-        break;
+    uint8_t payload[DSP_MAX_NODES * 2];
+    uint8_t i;
 
-    default:
-        break;
+    if (count == 0 || count > DSP_MAX_NODES) {
+        return;
     }
-}
 
-void _register_system_callback(uint8_t msg_id, void *callback) {
-
-    switch (msg_id) {
+    for (i = 0; i < count; i++) {
+        payload[i * 2] = nodes[i].type;
+        payload[i * 2 + 1] = nodes[i].source;
+    }
 
-    case SYSTEM_PORT_STATE:
-        p_system_port_state_callback = (t_system_port_state_callback)callback;
-        break;
+    _transmit_message(msg_type, msg_id, payload, count * 2);
 
-    case SYSTEM_PROFILE:
-        p_system_profile_callback = (t_system_profile_callback)callback;
-        break;
+    // Module ids now refer to new nodes.
+    _mirror_invalidate();
 
-    default:
-        break;
+    for (i = 0; i < count && i < DSP_MIRROR_MODULES; i++) {
+        svc_dsp_resync_module_params(i, NULL);
     }
 }
 
-/// TODO: Return status.
-static void _transmit_message(uint8_t msg_type, uint8_t msg_id,
-                              uint8_t *payload, uint8_t length) {
-    //
-    uint8_t msg_start = MSG_START;
+// Request cycles spent by module in last audio block.
+void svc_dsp_get_module_cycles(uint16_t module_id) {
+
+    const uint8_t msg_type = MSG_TYPE_MODULE;
+    const uint8_t msg_id = MODULE_GET_CYCLES;
 
-    dev_dsp_spi_tx_enqueue(&msg_start);
-    dev_dsp_spi_tx_enqueue(&msg_type);
-    dev_dsp_spi_tx_enqueue(&msg_id);
-    dev_dsp_spi_tx_enqueue(&length);
+    uint8_t payload[] = {(module_id & 0xff), (module_id >> 8) & 0xff};
 
-    while (length--) {
-        dev_dsp_spi_tx_enqueue(payload++);
-    }
+    _transmit_request(msg_type, msg_id, payload, sizeof(payload), NULL, NULL);
 }
 
-static t_status _dsp_init(void) {
-
-    t_status result = TASK_INIT_ERROR;
+/**
+ * @brief   Fetch parameter descriptors of module.
+ *
+ * Descriptors arrive in chunks, each requested when the last
+ * is received.  One query runs at a time.
+ *
+ * @param[in]   module_id   Index of module to address.
+ * @param[out]  info        Descriptors, indexed by param_index.
+ * @param[in]   capacity    Descriptors held by info.
+ * @param[in]   callback    Called with parameter count of module.
+ *
+ * @return      SUCCESS if query started, otherwise ERROR.
+ */
+t_status svc_dsp_get_module_info(uint16_t module_id, t_dsp_param_info *info,
+                                 uint16_t capacity,
+                                 t_dsp_param_info_callback callback) {
 
-    dev_dsp_init();
+    if (g_param_query.running || info == NULL || capacity == 0) {
+        return ERROR;
+    }
 
-    result = SUCCESS;
+    g_param_query.module_id = module_id;
+    g_param_query.info = info;
+    g_param_query.capacity = capacity;
+    g_param_query.callback = callback;
 
-    return result;
-}
+    if (_param_info_request(0) != SUCCESS) {
+        return ERROR;
+    }
 
-static void _dsp_boot(void) {
+    g_param_query.running = true;
 
-    /// TODO: Use queue and interrupt?
-    ///         SPI hardware ENA max timeout
-    ///         is too short for DSP boot.
-    ///         Requires polling.
-    //
-    // Transmit LDR to DSP.
-    dev_dsp_spi_tx_boot(bfin_ldr, bfin_ldr_len);
+    return SUCCESS;
 }
 
-/// TODO: Move to protocol separate module.
-///          Maybe this should be userspace?
-//
-static void _dsp_receive(uint8_t byte) {
+/**
+ * @brief   Configure DSP modulation source.
+ *
+ * @param[in]   source  Envelope or LFO, see e_mod_source.
+ * @param[in]   setting Setting to change, see e_mod_setting.
+ * @param[in]   value   Value of setting.
+ */
+void svc_dsp_set_mod_source(uint8_t source, uint8_t setting, int32_t value) {
 
-    static t_msg_parse_state state = PARSE_START;
+    const uint8_t msg_type = MSG_TYPE_MODULE;
+    const uint8_t msg_id = MODULE_SET_MOD_SOURCE;
 
-    static uint8_t msg_type;
-    static uint8_t msg_id;
-    static uint8_t length;
-    static uint8_t payload[0xff];
-    static uint8_t count;
+    uint8_t payload[] = {source,
+                         setting,
+                         value & 0xff,
+                         (value >> 8) & 0xff,
+                         (value >> 16) & 0xff,
+                         (value >> 24) & 0xff};
 
-    switch (state) {
+    _transmit_message(msg_type, msg_id, payload, sizeof(payload));
+}
 
-        /// TODO: Handshake.
+/**
+ * @brief   Open or close DSP envelope gates.
+ *
+ * @param[in]   mask        Bit per envelope to gate.
+ * @param[in]   gate        True to open.
+ * @param[in]   velocity    Q31 velocity, ignored when closing.
+ */
+void svc_dsp_set_mod_gate(uint8_t mask, bool gate, int32_t velocity) {
 
-    case PARSE_START:
-        if (byte == MSG_START) {
-            state = PARSE_MSG_TYPE;
-        }
-        /// TODO: Error handling and reset protocol.
-        break;
+    const uint8_t msg_type = MSG_TYPE_MODULE;
+    const uint8_t msg_id = MODULE_SET_MOD_GATE;
 
-    case PARSE_MSG_TYPE:
-        msg_type = byte;
-        state = PARSE_MSG_ID;
-        break;
+    uint8_t payload[] = {mask,
+                         gate,
+                         velocity & 0xff,
+                         (velocity >> 8) & 0xff,
+                         (velocity >> 16) & 0xff,
+                         (velocity >> 24) & 0xff};
 
-    case PARSE_MSG_ID:
-        msg_id = byte;
-        state = PARSE_PAYLOAD_LENGTH;
-        break;
+    _transmit_message(msg_type, msg_id, payload, sizeof(payload));
+}
 
-    case PARSE_PAYLOAD_LENGTH:
-        length = byte;
-        state = PARSE_PAYLOAD;
-        break;
+/**
+ * @brief   Replace DSP modulation route.
+ *
+ * @param[in]   route   Index of route, below PROTOCOL_MOD_ROUTES.
+ * @param[in]   config  Route configuration.
+ */
+void svc_dsp_set_mod_route(uint8_t route, const t_dsp_mod_route *config) {
 
-    case PARSE_PAYLOAD:
-        if (count < length) {
-            payload[count] = byte;
-            count++;
-        } // else {
-        // Handle message before returning,
-        // else it is not handled until first
-        // byte of next message is received.
-        if (count >= length) {
-            count = 0;
-            _handle_message(msg_type, msg_id, payload, length);
-            state = PARSE_START;
-        }
-        break;
+    const uint8_t msg_type = MSG_TYPE_MODULE;
+    const uint8_t msg_id = MODULE_SET_MOD_ROUTE;
+
+    uint8_t payload[] = {route,
+                         config->source,
+                         config->via,
+                         config->module_id & 0xff,
+                         (config->module_id >> 8) & 0xff,
+                         config->param_index & 0xff,
+                         (config->param_index >> 8) & 0xff,
+                         config->depth & 0xff,
+                         (config->depth >> 8) & 0xff,
+                         (config->depth >> 16) & 0xff,
+                         (config->depth >> 24) & 0xff};
 
-    default:
-        break;
-    }
+    _transmit_message(msg_type, msg_id, payload, sizeof(payload));
 }
 
-static void _handle_message(uint8_t msg_type, uint8_t msg_id, uint8_t *payload,
-                            uint8_t length) {
-
-    switch (msg_type) {
-
-    case MSG_TYPE_MODULE:
-        _handle_module_message(msg_id, payload, length);
-        break;
+// Request state of Port F, Port G, Port H GPIO.
+void svc_dsp_get_port_state(void) {
 
-    case MSG_TYPE_SYSTEM:
-        _handle_system_message(msg_id, payload, length);
-        break;
+    const uint8_t msg_type = MSG_TYPE_SYSTEM;
+    const uint8_t msg_id = SYSTEM_GET_PORT_STATE;
 
-    default:
-        break;
-    }
+    _transmit_request(msg_type, msg_id, NULL, 0, NULL, NULL);
 }
 
-static t_status _handle_module_message(uint8_t msg_id, uint8_t *payload,
-                                       uint8_t length) {
+void svc_dsp_get_profile(void) {
 
-    t_status result = ERROR;
+    const uint8_t msg_type = MSG_TYPE_SYSTEM;
+    const uint8_t msg_id = SYSTEM_GET_PROFILE;
 
-    switch (msg_id) {
+    _transmit_request(msg_type, msg_id, NULL, 0, NULL, NULL);
+}
 
-    case MODULE_PARAM_VALUE:
-        result = _handle_module_param_value(payload, length);
-        break;
+/**
+ * @brief   Request extended profile.
+ *
+ * @param[in]   reset   Reset DSP statistics after responding.
+ */
+void svc_dsp_get_profile_ext(bool reset) {
 
-    default:
-        break;
-    }
+    const uint8_t msg_type = MSG_TYPE_SYSTEM;
+    const uint8_t msg_id = SYSTEM_GET_PROFILE_EXT;
 
-    /// TODO: Error handling and protocol reset.
-    if (result == SUCCESS) {
-        _dsp_response_received();
-    }
+    uint8_t payload[] = {reset};
 
-    return result;
+    _transmit_request(msg_type, msg_id, payload, sizeof(payload), NULL, NULL);
 }
 
-static t_status _handle_system_message(uint8_t msg_id, uint8_t *payload,
-                                       uint8_t length) {
-
-    t_status result = ERROR;
+// Request number of audio frames processed by DSP.
+void svc_dsp_get_frame_count(void) {
 
-    switch (msg_id) {
+    const uint8_t msg_type = MSG_TYPE_SYSTEM;
+    const uint8_t msg_id = SYSTEM_GET_FRAME_COUNT;
 
-    case SYSTEM_READY:
-        result = _handle_system_ready();
-        break;
+    _transmit_request(msg_type, msg_id, NULL, 0, NULL, NULL);
+}
 
-    case SYSTEM_PORT_STATE:
-        result = _handle_system_port_state(payload, length);
-        break;
+/**
+ * @brief   Start DSP pushing telemetry at fixed interval.
+ *
+ * Frames are passed to callback registered for SYSTEM_TELEMETRY,
+ * replacing requests for profile and frame count.
+ *
+ * @param[in]   interval_ms     Milliseconds between frames, 0 stops.
+ */
+void svc_dsp_set_telemetry(uint16_t interval_ms) {
 
-    case SYSTEM_PROFILE:
-        result = _handle_system_profile(payload, length);
-        break;
+    const uint8_t msg_type = MSG_TYPE_SYSTEM;
+    const uint8_t msg_id = SYSTEM_SET_TELEMETRY;
 
-    default:
-        break;
-    }
+    uint8_t payload[] = {interval_ms & 0xff, (interval_ms >> 8) & 0xff};
 
-    /// TODO: Error handling and protocol reset.
-    if (result == SUCCESS) {
-        _dsp_response_received();
-    }
+    g_telemetry_interval = interval_ms;
 
-    return result;
+    _transmit_message(msg_type, msg_id, payload, sizeof(payload));
 }
 
-/// TODO: Test payload length.
-static t_status _handle_module_param_value(uint8_t *payload, uint8_t length) {
-
-    t_status result = ERROR;
-
-    if (p_module_param_value_callback != NULL) {
+/**
+ * @brief   Send request to DSP.
+ *
+ * Callback receives the response payload, or TIMEOUT_ERROR if no
+ * response arrives.  Many requests may be outstanding at once,
+ * responses are matched by sequence number.  Message callbacks
+ * registered with svc_dsp_register_callback() are also called.
+ *
+ * @param[in]   msg_type    Message type.
+ * @param[in]   msg_id      Message id.
+ * @param[in]   payload     Request payload.
+ * @param[in]   length      Length of payload.
+ * @param[in]   callback    Completion callback, may be NULL.
+ * @param[in]   context     Passed to callback.
+ *
+ * @return  ERROR if too many requests outstanding.
+ */
+t_status svc_dsp_request(uint8_t msg_type, uint8_t msg_id, uint8_t *payload,
+                         uint8_t length, t_dsp_request_callback callback,
+                         void *context) {
+
+    return _transmit_request(msg_type, msg_id, payload, length, callback,
+                             context);
+}
+
+/**
+ * @brief   Get CPU side link statistics.
+ *
+ * @return  Frame and error counters for frames received from DSP,
+ *          and timeouts and retries of requests on either transport.
+ */
+t_protocol_stats svc_dsp_link_stats(void) { return g_protocol.stats; }
+
+/**
+ * @brief   Get transmit lane queue statistics.
+ *
+ * @param[in]   lane    DSP_LANE_REALTIME or DSP_LANE_BULK.
+ *
+ * @return  Frame counts and queue depth in bytes.
+ */
+t_dsp_lane_stats svc_dsp_lane_stats(t_dsp_lane_id lane) {
+
+    return dev_dsp_spi_lane_stats(lane);
+}
+
+/**
+ * @brief   Measure link throughput and round trip latency.
+ *
+ * Sends count echo requests, keeping BENCH_WINDOW in flight.
+ * Call after svc_dsp_ready(), elapsed time starts immediately.
+ *
+ * @param[in]   length      Echo payload length.
+ * @param[in]   count       Number of echo requests.
+ * @param[in]   callback    Called with results when all complete.
+ *
+ * @return  ERROR if benchmark already running.
+ */
+t_status svc_dsp_benchmark(uint8_t length, uint32_t count,
+                           t_dsp_benchmark_callback callback) {
+
+    if (g_bench.running || count == 0) {
+        return ERROR;
+    }
+
+    memset(&g_bench, 0, sizeof(g_bench));
+
+    g_bench.remaining = count;
+    g_bench.callback = callback;
+    g_bench.result.length = length;
+    g_bench.result.min = UINT32_MAX;
+
+    delay_start(&g_bench.elapsed, UINT32_MAX);
+
+    g_bench.running = true;
+
+    return SUCCESS;
+}
+
+bool svc_dsp_benchmark_running(void) { return g_bench.running; }
+
+/**
+ * @brief   Upload data to DSP SDRAM region.
+ *
+ * The region is opened, written in CRC checked chunks with
+ * UPLOAD_WINDOW in flight, then closed with valid length of
+ * offset + length.  Chunks failing CRC or timing out are resent.
+ * Modules see the region as not ready until closed.
+ *
+ * @param[in]   region      DSP region id.
+ * @param[in]   offset      Byte offset in region.
+ * @param[in]   data        Data, held by caller until callback.
+ * @param[in]   length      Length of data.
+ * @param[in]   callback    Called when upload completes, may be NULL.
+ *
+ * @return  ERROR if upload already running.
+ */
+t_status svc_dsp_upload(uint8_t region, uint32_t offset, const uint8_t *data,
+                        uint32_t length, t_dsp_upload_callback callback) {
+
+    if (g_upload.running) {
+        return ERROR;
+    }
+
+    memset(&g_upload, 0, sizeof(g_upload));
+
+    g_upload.region = region;
+    g_upload.offset = offset;
+    g_upload.data = data;
+    g_upload.length = length;
+    g_upload.callback = callback;
+    g_upload.status = SUCCESS;
+    g_upload.phase = UPLOAD_OPEN;
+
+    g_upload.running = true;
+
+    return SUCCESS;
+}
+
+bool svc_dsp_upload_running(void) { return g_upload.running; }
+
+/**
+ * @brief   Capture DSP audio into buffer.
+ *
+ * Frames are stored at their capture index, so frames lost on
+ * the link leave the previous buffer contents.  Frames the DSP
+ * drops while its ring is full are not in the stream, and are
+ * counted as overruns.  Capture stops when the buffer is full.
+ *
+ * The stream uses the bulk transport selected at start.
+ *
+ * @param[in]   config      Capture settings.
+ * @param[out]  buffer      Interleaved Q15 samples of selected channels.
+ * @param[in]   frames      Length of buffer in frames.
+ * @param[in]   callback    Called when capture stops, may be NULL.
+ *
+ * @return  ERROR if capture already running or request not sent.
+ */
+t_status svc_dsp_capture_start(const t_dsp_capture_config *config,
+                               int16_t *buffer, uint32_t frames,
+                               t_dsp_capture_callback callback) {
+
+    uint8_t payload[5];
+    uint8_t channels = 0;
+    uint8_t i;
+
+    if (g_capture.running) {
+        return ERROR;
+    }
+
+    for (i = 0; i < 8; i++) {
+        if (config->channel_mask & (1 << i)) {
+            channels++;
+        }
+    }
+
+    if (channels == 0 || frames == 0) {
+        return ERROR;
+    }
+
+    memset(&g_capture, 0, sizeof(g_capture));
+
+    g_capture.channels = channels;
+    g_capture.buffer = buffer;
+    g_capture.length = frames;
+    g_capture.callback = callback;
+
+    payload[0] = config->source;
+    payload[1] = config->decimation;
+    payload[2] = config->channel_mask;
+    payload[3] = config->depth & 0xff;
+    payload[4] = (config->depth >> 8) & 0xff;
+
+    if (_transmit_request(MSG_TYPE_SYSTEM, SYSTEM_CAPTURE_START, payload,
+                          sizeof(payload), _capture_started,
+                          NULL) != SUCCESS) {
+        return ERROR;
+    }
+
+    g_capture.running = true;
+
+    return SUCCESS;
+}
+
+/// Stop capture, callback runs when DSP confirms.
+void svc_dsp_capture_stop(void) {
+
+    if (g_capture.running) {
+        g_capture.stopping = true;
+    }
+}
+
+bool svc_dsp_capture_running(void) { return g_capture.running; }
+
+/**
+ * @brief   Select link for requests and their responses.
+ *
+ * Bulk transfers move over HostDP at far higher bandwidth, realtime
+ * messages stay on SPI.  HostDP is selected once the DSP reports
+ * its mailbox address and the mailbox is found, until then and
+ * if the port stops responding, requests use SPI.
+ *
+ * @param[in]   transport   DSP_TRANSPORT_SPI or DSP_TRANSPORT_HOSTDP.
+ *
+ * @return  ERROR if mailbox request could not be sent.
+ */
+t_status svc_dsp_set_bulk_transport(t_dsp_transport transport) {
+
+    if (transport == DSP_TRANSPORT_SPI || dev_dsp_hostdp_is_open()) {
+
+        g_bulk_transport = transport;
+
+        return SUCCESS;
+    }
+
+    // EMIFA left untouched until HostDP is selected.
+    dev_dsp_hostdp_init();
+
+    // Mailbox address is requested over SPI.
+    return _transmit_request(MSG_TYPE_SYSTEM, SYSTEM_GET_HOSTDP_MAILBOX, NULL,
+                             0, _hostdp_mailbox, NULL);
+}
+
+t_dsp_transport svc_dsp_bulk_transport(void) { return g_bulk_transport; }
+
+// Request DSP side link statistics.
+void svc_dsp_get_link_stats(void) {
+
+    const uint8_t msg_type = MSG_TYPE_SYSTEM;
+    const uint8_t msg_id = SYSTEM_GET_LINK_STATS;
+
+    _transmit_request(msg_type, msg_id, NULL, 0, NULL, NULL);
+}
+
+bool svc_dsp_ready(void) { return g_dsp_ready; }
+
+/*----- Static function implementations ------------------------------*/
+
+static t_status _dsp_check_ready(void) {
+
+    const uint8_t msg_type = MSG_TYPE_SYSTEM;
+    const uint8_t msg_id = SYSTEM_CHECK_READY;
+
+    g_handshake.waiting = true;
+
+    if (_transmit_request(msg_type, msg_id, NULL, 0, _dsp_ready_ack, NULL) !=
+        SUCCESS) {
+
+        g_handshake.waiting = false;
+        return ERROR;
+    }
+
+    return SUCCESS;
+}
+
+// DSP replies with node count of default module graph.
+static void _dsp_ready_ack(t_status status, uint8_t *payload, uint8_t length,
+                           void *context) {
+
+    if (status == SUCCESS && length < 1) {
+        status = ERROR;
+    }
+
+    if (status == SUCCESS) {
+        g_handshake.node_count = payload[0];
+    }
+
+    g_handshake.status = status;
+    g_handshake.waiting = false;
+}
+
+// Startup resync failure leaves mirror incomplete.
+static void _dsp_resync_done(t_status status, uint16_t module_id) {
+
+    if (status != SUCCESS) {
+        error_check(status);
+    }
+}
+
+// Exchange messages with DSP, shared by handshake and run states.
+static void _link_task(void) {
+
+    uint8_t dsp_byte;
+
+    // Send parameters set since last call, as queue space allows.
+    _flush_param_slots(false);
+
+    // Handle received bytes, a whole transfer may be waiting.
+    while (dev_dsp_spi_rx_dequeue(&dsp_byte) == SUCCESS) {
+        protocol_receive(&g_protocol, dsp_byte);
+    }
+
+    // Clock out bytes DSP has signalled ready.
+    if (dev_dsp_spi_data_ready()) {
+        dev_dsp_spi_poll();
+
+        delay_start(&g_poll_delay, RESPONSE_POLL_US);
+    }
+
+    // Poll slowly while responses or unsolicited frames are expected,
+    // the default, or if the data ready signal was missed.
+    else if ((g_request_count > 0 || g_telemetry_interval > 0 ||
+              g_capture.running) &&
+             delay_us(&g_poll_delay)) {
+        dev_dsp_spi_poll();
+
+        delay_start(&g_poll_delay, RESPONSE_POLL_US);
+    }
+
+    // Responses to requests sent over HostDP return the same way,
+    // as does capture started over HostDP.
+    if ((g_request_count > 0 || g_capture.running) &&
+        dev_dsp_hostdp_is_open()) {
+        _hostdp_receive();
+    }
+
+    _check_request_timeouts();
+}
+
+void _register_module_callback(uint8_t msg_id, void *callback) {
+
+    switch (msg_id) {
+
+    case MODULE_PARAM_VALUE:
+        p_module_param_value_callback = (t_module_param_value_callback)callback;
+        break;
+
+    case MODULE_CYCLES:
+        p_module_cycles_callback = (t_module_cycles_callback)callback;
+        break;
+
+    default:
+        break;
+    }
+}
+
+void _register_system_callback(uint8_t msg_id, void *callback) {
+
+    switch (msg_id) {
+
+    case SYSTEM_PORT_STATE:
+        p_system_port_state_callback = (t_system_port_state_callback)callback;
+        break;
+
+    case SYSTEM_PROFILE:
+        p_system_profile_callback = (t_system_profile_callback)callback;
+        break;
+
+    case SYSTEM_PROFILE_EXT:
+        p_system_profile_ext_callback =
+            (t_system_profile_ext_callback)callback;
+        break;
+
+    case SYSTEM_LINK_STATS:
+        p_system_link_stats_callback = (t_system_link_stats_callback)callback;
+        break;
+
+    case SYSTEM_FRAME_COUNT:
+        p_system_frame_count_callback =
+            (t_system_frame_count_callback)callback;
+        break;
+
+    case SYSTEM_TELEMETRY:
+        p_system_telemetry_callback = (t_system_telemetry_callback)callback;
+        break;
+
+    default:
+        break;
+    }
+}
+
+// Send realtime message after pending parameters, preserving order.
+static void _transmit_message(uint8_t msg_type, uint8_t msg_id,
+                              uint8_t *payload, uint8_t length) {
+
+    _flush_param_slots(true);
+
+    _enqueue_message(DSP_LANE_REALTIME, msg_type, msg_id,
+                     PROTOCOL_SEQUENCE_NONE, payload, length);
+}
+
+/**
+ * @brief   Send message expecting response.
+ *
+ * Requests use the bulk lane, so may be overtaken by realtime messages.
+ * Callback is only called if the request was queued.
+ *
+ * @return  ERROR if too many requests outstanding or frame dropped.
+ */
+static t_status _transmit_request(uint8_t msg_type, uint8_t msg_id,
+                                  uint8_t *payload, uint8_t length,
+                                  t_dsp_request_callback callback,
+                                  void *context) {
+
+    t_dsp_request *request = NULL;
+    t_status status;
+    uint8_t i;
+
+    for (i = 0; i < REQUEST_SLOTS; i++) {
+        if (!g_requests[i].active) {
+            request = &g_requests[i];
+            break;
+        }
+    }
+
+    if (request == NULL) {
+        return ERROR;
+    }
+
+    // Sequence 0 marks messages not sent in response.
+    if (++g_sequence == PROTOCOL_SEQUENCE_NONE) {
+        g_sequence++;
+    }
+
+    request->active = true;
+    request->sequence = g_sequence;
+    request->callback = callback;
+    request->context = context;
+
+    delay_start(&request->timeout, REQUEST_TIMEOUT_US);
+
+    g_request_count++;
+
+    // Allow time for data ready signal before polling.
+    delay_start(&g_poll_delay, RESPONSE_POLL_US);
+
+    _flush_param_slots(true);
+
+    status = _enqueue_message(DSP_LANE_BULK, msg_type, msg_id,
+                              request->sequence, payload, length);
+
+    // Frame dropped, release slot without callback.
+    if (status != SUCCESS) {
+        request->active = false;
+        g_request_count--;
+    }
+
+    return status;
+}
+
+// Free request slot before callback, so callback may issue requests.
+static void _complete_request(uint8_t sequence, t_status status,
+                              uint8_t *payload, uint8_t length) {
+
+    t_dsp_request request;
+    uint8_t i;
+
+    for (i = 0; i < REQUEST_SLOTS; i++) {
+
+        if (g_requests[i].active && g_requests[i].sequence == sequence) {
+
+            request = g_requests[i];
+
+            g_requests[i].active = false;
+            g_request_count--;
+
+            if (request.callback != NULL) {
+                request.callback(status, payload, length, request.context);
+            }
+            break;
+        }
+    }
+}
+
+static void _check_request_timeouts(void) {
+
+    uint8_t i;
+
+    for (i = 0; i < REQUEST_SLOTS; i++) {
+
+        if (g_requests[i].active && delay_us(&g_requests[i].timeout)) {
+
+            g_protocol.stats.timeouts++;
+
+            _complete_request(g_requests[i].sequence, TIMEOUT_ERROR, NULL, 0);
+        }
+    }
+}
+
+// Open region, keep chunks in flight until all acknowledged, then close.
+static void _upload_task(void) {
+
+    t_upload_chunk *chunk;
+    bool idle = true;
+    uint8_t slot;
+
+    switch (g_upload.phase) {
+
+    case UPLOAD_OPEN:
+        if (!g_upload.waiting) {
+            _upload_region(SYSTEM_REGION_OPEN, 0);
+        }
+        break;
+
+    case UPLOAD_DATA:
+        for (slot = 0; slot < UPLOAD_WINDOW; slot++) {
+
+            chunk = &g_upload.chunks[slot];
+
+            if (chunk->state == CHUNK_FREE && g_upload.status == SUCCESS &&
+                g_upload.sent < g_upload.length) {
+
+                chunk->offset = g_upload.sent;
+                chunk->attempts = 0;
+                chunk->state = CHUNK_RESEND;
+
+                g_upload.sent += g_upload.length - g_upload.sent < UPLOAD_CHUNK
+                                     ? g_upload.length - g_upload.sent
+                                     : UPLOAD_CHUNK;
+            }
+
+            if (chunk->state == CHUNK_RESEND) {
+                _upload_chunk(chunk);
+            }
+
+            if (chunk->state != CHUNK_FREE) {
+                idle = false;
+            }
+        }
+
+        // Failure reported once chunks in flight complete.
+        if (idle && g_upload.status != SUCCESS) {
+            _upload_finish(g_upload.status);
+
+        } else if (idle && g_upload.acked == g_upload.length) {
+            g_upload.phase = UPLOAD_CLOSE;
+            g_upload.attempts = 0;
+        }
+        break;
+
+    case UPLOAD_CLOSE:
+        if (!g_upload.waiting) {
+            _upload_region(SYSTEM_REGION_CLOSE,
+                           g_upload.offset + g_upload.length);
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+// Request region open, or close with valid length.
+static void _upload_region(uint8_t msg_id, uint32_t value) {
+
+    uint8_t payload[5];
+
+    payload[0] = g_upload.region;
+    payload[1] = value & 0xff;
+    payload[2] = (value >> 8) & 0xff;
+    payload[3] = (value >> 16) & 0xff;
+    payload[4] = (value >> 24) & 0xff;
+
+    // Retry next task if request slots full.
+    if (_transmit_request(MSG_TYPE_SYSTEM, msg_id, payload,
+                          msg_id == SYSTEM_REGION_OPEN ? 1 : sizeof(payload),
+                          _upload_region_ack, NULL) == SUCCESS) {
+
+        g_upload.waiting = true;
+
+        if (g_upload.attempts++ > 0) {
+            g_protocol.stats.retries++;
+        }
+    }
+}
+
+static void _upload_region_ack(t_status status, uint8_t *payload,
+                               uint8_t length, void *context) {
+
+    g_upload.waiting = false;
+
+    if (status == SUCCESS && (length < 6 || payload[5] != REGION_OK)) {
+        _upload_finish(ERROR);
+
+    } else if (status != SUCCESS) {
+
+        // Timed out, resent by next task.
+        if (g_upload.attempts == UPLOAD_ATTEMPTS) {
+            _upload_finish(status);
+        }
+
+    } else if (g_upload.phase == UPLOAD_OPEN) {
+        g_upload.phase = UPLOAD_DATA;
+
+    } else {
+        _upload_finish(SUCCESS);
+    }
+}
+
+// Send chunk with CRC of its data.
+static void _upload_chunk(t_upload_chunk *chunk) {
+
+    static uint8_t payload[PROTOCOL_REGION_HEADER + UPLOAD_CHUNK];
+
+    uint32_t offset = g_upload.offset + chunk->offset;
+    uint16_t length;
+    uint16_t crc;
+
+    length = g_upload.length - chunk->offset < UPLOAD_CHUNK
+                 ? g_upload.length - chunk->offset
+                 : UPLOAD_CHUNK;
+
+    crc = protocol_crc16(&g_upload.data[chunk->offset], length);
+
+    payload[0] = g_upload.region;
+    payload[1] = offset & 0xff;
+    payload[2] = (offset >> 8) & 0xff;
+    payload[3] = (offset >> 16) & 0xff;
+    payload[4] = (offset >> 24) & 0xff;
+    payload[5] = crc & 0xff;
+    payload[6] = (crc >> 8) & 0xff;
+
+    memcpy(&payload[PROTOCOL_REGION_HEADER], &g_upload.data[chunk->offset],
+           length);
+
+    // Retry next task if request slots full.
+    if (_transmit_request(MSG_TYPE_SYSTEM, SYSTEM_REGION_WRITE, payload,
+                          PROTOCOL_REGION_HEADER + length, _upload_chunk_ack,
+                          chunk) == SUCCESS) {
+
+        chunk->state = CHUNK_SENT;
+
+        if (chunk->attempts++ > 0) {
+            g_protocol.stats.retries++;
+        }
+    }
+}
+
+static void _upload_chunk_ack(t_status status, uint8_t *payload,
+                              uint8_t length, void *context) {
+
+    t_upload_chunk *chunk = (t_upload_chunk *)context;
+    uint8_t result = REGION_BAD_CRC;
+
+    if (status == SUCCESS && length >= 6) {
+        result = payload[5];
+    }
+
+    if (result == REGION_OK) {
+
+        chunk->state = CHUNK_FREE;
+
+        g_upload.acked += g_upload.length - chunk->offset < UPLOAD_CHUNK
+                              ? g_upload.length - chunk->offset
+                              : UPLOAD_CHUNK;
+
+    } else if (result == REGION_BAD_CRC &&
+               chunk->attempts < UPLOAD_ATTEMPTS &&
+               g_upload.status == SUCCESS) {
+
+        // Corrupt or lost, resent by next task.
+        chunk->state = CHUNK_RESEND;
+
+    } else {
+
+        chunk->state = CHUNK_FREE;
+
+        if (g_upload.status == SUCCESS) {
+            g_upload.status = status == SUCCESS ? ERROR : status;
+        }
+    }
+}
+
+static void _upload_finish(t_status status) {
+
+    g_upload.running = false;
+
+    if (g_upload.callback != NULL) {
+        g_upload.callback(status, g_upload.region,
+                          g_upload.offset + g_upload.length);
+    }
+}
+
+// Send stop request, retried while request slots full.
+static void _capture_task(void) {
+
+    if (g_capture.stopping && !g_capture.stop_sent &&
+        _transmit_request(MSG_TYPE_SYSTEM, SYSTEM_CAPTURE_STOP, NULL, 0,
+                          _capture_stopped, NULL) == SUCCESS) {
+
+        g_capture.stop_sent = true;
+    }
+}
+
+// DSP reports running flag, clear if settings rejected.
+static void _capture_started(t_status status, uint8_t *payload,
+                             uint8_t length, void *context) {
+
+    if (status != SUCCESS) {
+        _capture_finish(status);
+
+    } else if (length < 9 || !payload[0]) {
+        _capture_finish(ERROR);
+    }
+}
+
+static void _capture_stopped(t_status status, uint8_t *payload,
+                             uint8_t length, void *context) {
+
+    if (status == SUCCESS && length >= 9) {
+        g_capture.overruns = _unpack_u32(&payload[5]);
+    }
+
+    _capture_finish(status);
+}
+
+static void _capture_finish(t_status status) {
+
+    if (!g_capture.running) {
+        return;
+    }
+
+    g_capture.running = false;
+
+    if (g_capture.callback != NULL) {
+        g_capture.callback(status, g_capture.frames, g_capture.overruns);
+    }
+}
+
+static t_status _param_info_request(uint16_t start_index) {
+
+    uint16_t module_id = g_param_query.module_id;
+
+    uint8_t payload[] = {(module_id & 0xff), (module_id >> 8) & 0xff,
+                         (start_index & 0xff), (start_index >> 8) & 0xff};
+
+    return _transmit_request(MSG_TYPE_MODULE, MODULE_GET_PARAM_INFO, payload,
+                             sizeof(payload), _param_info_chunk, NULL);
+}
+
+/**
+ * @brief   Store chunk of parameter descriptors.
+ *
+ * Request next chunk until all descriptors received
+ * or caller buffer is full.
+ */
+static void _param_info_chunk(t_status status, uint8_t *payload,
+                              uint8_t length, void *context) {
+
+    t_dsp_param_info *info;
+    uint8_t *name;
+    uint16_t offset = PROTOCOL_PARAM_INFO_HEADER;
+    uint16_t start_index;
+    uint16_t index;
+    uint16_t count;
+    uint8_t remaining;
+    uint8_t name_length;
+    uint8_t copy_length;
+
+    if (status != SUCCESS) {
+        _param_info_finish(status, 0);
+        return;
+    }
+
+    if (length < PROTOCOL_PARAM_INFO_HEADER ||
+        ((payload[1] << 8) | payload[0]) != g_param_query.module_id) {
+
+        _param_info_finish(ERROR, 0);
+        return;
+    }
+
+    start_index = (payload[3] << 8) | payload[2];
+    count = (payload[5] << 8) | payload[4];
+
+    for (index = start_index; offset + PROTOCOL_PARAM_INFO_FIXED < length;
+         index++) {
+
+        name = &payload[offset + PROTOCOL_PARAM_INFO_FIXED];
+        remaining = length - offset - PROTOCOL_PARAM_INFO_FIXED;
+
+        name_length = 0;
+        while (name_length < remaining && name[name_length] != '\0') {
+            name_length++;
+        }
+
+        if (index < g_param_query.capacity) {
+
+            info = &g_param_query.info[index];
+
+            info->min = _unpack_u32(&payload[offset]);
+            info->max = _unpack_u32(&payload[offset + 4]);
+            info->init = _unpack_u32(&payload[offset + 8]);
+            info->scale = payload[offset + 12];
+            info->slew_ms = (payload[offset + 14] << 8) | payload[offset + 13];
+
+            // Truncate name to fit.
+            copy_length = name_length < DSP_PARAM_NAME_LENGTH
+                              ? name_length
+                              : DSP_PARAM_NAME_LENGTH - 1;
+
+            memcpy(info->name, name, copy_length);
+            info->name[copy_length] = '\0';
+        }
+
+        offset += PROTOCOL_PARAM_INFO_FIXED + name_length + 1;
+    }
+
+    if (index >= count || index >= g_param_query.capacity) {
+        _param_info_finish(SUCCESS, count);
+
+    } else if (index == start_index) {
+        // Empty chunk before count reached would repeat forever.
+        _param_info_finish(ERROR, count);
+
+    } else if (_param_info_request(index) != SUCCESS) {
+        _param_info_finish(ERROR, count);
+    }
+}
+
+static void _param_info_finish(t_status status, uint16_t count) {
+
+    if (!g_param_query.running) {
+        return;
+    }
+
+    g_param_query.running = false;
+
+    if (g_param_query.callback != NULL) {
+        g_param_query.callback(status, g_param_query.module_id, count);
+    }
+}
+
+// Keep echo requests in flight until count sent.
+static void _benchmark_task(void) {
+
+    static uint8_t payload[PROTOCOL_PAYLOAD_MAX];
+
+    uint16_t i;
+    uint8_t slot;
+
+    // Timers must be read at least once per timer period.
+    delay_us(&g_bench.elapsed);
+
+    for (slot = 0; slot < BENCH_WINDOW; slot++) {
+        if (g_bench.busy[slot]) {
+            delay_us(&g_bench.timers[slot]);
+        }
+    }
+
+    for (slot = 0; slot < BENCH_WINDOW && g_bench.remaining > 0; slot++) {
+
+        if (g_bench.busy[slot]) {
+            continue;
+        }
+
+        // Pattern includes zero bytes, exercising COBS.
+        for (i = 0; i < g_bench.result.length; i++) {
+            payload[i] = i;
+        }
+
+        delay_start(&g_bench.timers[slot], UINT32_MAX);
+
+        if (_transmit_request(MSG_TYPE_SYSTEM, SYSTEM_ECHO, payload,
+                              g_bench.result.length, _benchmark_echo,
+                              &g_bench.timers[slot]) != SUCCESS) {
+            break;
+        }
+
+        g_bench.busy[slot] = true;
+        g_bench.in_flight++;
+        g_bench.remaining--;
+    }
+
+    if (g_bench.remaining == 0 && g_bench.in_flight == 0) {
+        _benchmark_finish();
+    }
+}
+
+static void _benchmark_echo(t_status status, uint8_t *payload, uint8_t length,
+                            void *context) {
+
+    t_delay_state *timer = (t_delay_state *)context;
+    t_dsp_benchmark *result = &g_bench.result;
+    uint32_t latency;
+    uint32_t bucket;
+    uint16_t i;
+
+    delay_us(timer);
+    latency = timer->elapsed_us;
+
+    g_bench.busy[timer - g_bench.timers] = false;
+    g_bench.in_flight--;
+
+    if (status != SUCCESS || length != result->length) {
+        result->errors++;
+        return;
+    }
+
+    for (i = 0; i < length; i++) {
+        if (payload[i] != (uint8_t)i) {
+            result->errors++;
+            return;
+        }
+    }
+
+    result->messages++;
+    result->bytes += 2 * length;
+
+    g_bench.total_us += latency;
+
+    if (latency < result->min) {
+        result->min = latency;
+    }
+    if (latency > result->max) {
+        result->max = latency;
+    }
+
+    bucket = latency / BENCH_BUCKET_US;
+    if (bucket >= BENCH_HIST_BUCKETS) {
+        bucket = BENCH_HIST_BUCKETS - 1;
+    }
+    g_bench.hist[bucket]++;
+}
+
+static void _benchmark_finish(void) {
+
+    t_dsp_benchmark *result = &g_bench.result;
+
+    delay_us(&g_bench.elapsed);
+    result->elapsed = g_bench.elapsed.elapsed_us;
+
+    if (result->messages > 0) {
+
+        result->mean = g_bench.total_us / result->messages;
+        result->median = _benchmark_percentile(50);
+        result->percentile = _benchmark_percentile(BENCH_PERCENTILE);
+
+    } else {
+        result->min = 0;
+    }
+
+    if (result->elapsed > 0) {
+
+        result->message_rate =
+            ((uint64_t)result->messages * 1000000) / result->elapsed;
+        result->byte_rate =
+            ((uint64_t)result->bytes * 1000000) / result->elapsed;
+    }
+
+    g_bench.running = false;
+
+    if (g_bench.callback != NULL) {
+        g_bench.callback(result);
+    }
+}
+
+/**
+ * @brief   Find histogram bucket holding percentile of round trips.
+ *
+ * @return  Upper bound of bucket in microseconds, at most maximum.
+ */
+static uint32_t _benchmark_percentile(uint32_t percentile) {
+
+    uint64_t target =
+        ((uint64_t)g_bench.result.messages * percentile + 99) / 100;
+    uint64_t count = 0;
+    uint32_t edge;
+    uint32_t bucket;
+
+    for (bucket = 0; bucket < BENCH_HIST_BUCKETS - 1; bucket++) {
+
+        count += g_bench.hist[bucket];
+
+        if (count >= target) {
+            edge = (bucket + 1) * BENCH_BUCKET_US;
+            return edge < g_bench.result.max ? edge : g_bench.result.max;
+        }
+    }
+
+    // Beyond last bucket edge, worst case is best bound.
+    return g_bench.result.max;
+}
+
+/**
+ * @brief   Send pending parameter values.
+ *
+ * Slots are grouped by module, one batch message per group.
+ * A batch is only queued when the whole frame fits.
+ *
+ * @param[in]   wait    Wait for queue space, otherwise leave
+ *                      remaining slots pending.
+ */
+static void _flush_param_slots(bool wait) {
+
+    static uint8_t payload[2 + PARAM_BATCH_MAX * PARAM_BATCH_ENTRY_LENGTH];
+
+    t_param_slot *slot;
+    uint16_t module_id;
+    uint8_t count;
+    uint8_t length;
+    uint8_t *entry;
+    uint8_t kept;
+    uint8_t i;
+
+    while (g_param_slot_count > 0) {
+
+        module_id = g_param_slots[0].module_id;
+
+        // Batch size for first module, up to PARAM_BATCH_MAX.
+        count = 0;
+        for (i = 0; i < g_param_slot_count && count < PARAM_BATCH_MAX; i++) {
+            if (g_param_slots[i].module_id == module_id) {
+                count++;
+            }
+        }
+
+        length = 2 + count * PARAM_BATCH_ENTRY_LENGTH;
+
+        if (!wait && dev_dsp_spi_tx_free(DSP_LANE_REALTIME) <
+                         PROTOCOL_ENCODED_LENGTH(length)) {
+            return;
+        }
+
+        payload[0] = module_id & 0xff;
+        payload[1] = (module_id >> 8) & 0xff;
+
+        // Pack batched slots and compact the remainder.
+        entry = &payload[2];
+        kept = 0;
+        for (i = 0; i < g_param_slot_count; i++) {
+
+            slot = &g_param_slots[i];
+
+            if (slot->module_id == module_id && count > 0) {
+
+                entry[0] = slot->param_index & 0xff;
+                entry[1] = (slot->param_index >> 8) & 0xff;
+                entry[2] = slot->value & 0xff;
+                entry[3] = (slot->value >> 8) & 0xff;
+                entry[4] = (slot->value >> 16) & 0xff;
+                entry[5] = (slot->value >> 24) & 0xff;
+
+                entry += PARAM_BATCH_ENTRY_LENGTH;
+                count--;
+
+            } else {
+                g_param_slots[kept++] = *slot;
+            }
+        }
+        g_param_slot_count = kept;
+
+        _enqueue_message(DSP_LANE_REALTIME, MSG_TYPE_MODULE,
+                         MODULE_SET_PARAM_BATCH, PROTOCOL_SEQUENCE_NONE,
+                         payload, length);
+    }
+}
+
+// Handle bytes DSP has queued in mailbox.
+static void _hostdp_receive(void) {
+
+    static uint8_t buffer[HOSTDP_RX_CHUNK];
+
+    uint16_t length;
+    uint16_t i;
+
+    length = dev_dsp_hostdp_rx(buffer, sizeof(buffer));
+
+    for (i = 0; i < length; i++) {
+        protocol_receive(&g_hostdp_protocol, buffer[i]);
+    }
+}
+
+// Switch bulk lane to HostDP when mailbox found at reported address.
+static void _hostdp_mailbox(t_status status, uint8_t *payload, uint8_t length,
+                            void *context) {
+
+    if (status == SUCCESS && length >= 4 &&
+        dev_dsp_hostdp_open(_unpack_u32(payload)) == SUCCESS) {
+
+        g_bulk_transport = DSP_TRANSPORT_HOSTDP;
+    }
+}
+
+/**
+ * @brief   Wait for SPI interrupts to drain tx lane.
+ *
+ * Bounded by TX_WAIT_US, so a DSP that stops clocking the link
+ * cannot stall the CPU main loop.
+ *
+ * @return  SUCCESS if length bytes free, otherwise TIMEOUT_ERROR.
+ */
+static t_status _wait_tx_free(t_dsp_lane_id lane, uint32_t length) {
+
+    t_delay_state wait;
+
+    delay_start(&wait, TX_WAIT_US);
+
+    while (dev_dsp_spi_tx_free(lane) < length) {
+
+        if (delay_us(&wait)) {
+            return TIMEOUT_ERROR;
+        }
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief   Encode message and queue for transport.
+ *
+ * Waits up to TX_WAIT_US for HostDP mailbox space, then falls back
+ * to SPI as for a port that stops responding.
+ *
+ * @return  ERROR if SPI tx lane still full, frame dropped.
+ */
+static t_status _enqueue_message(t_dsp_lane_id lane, uint8_t msg_type,
+                                 uint8_t msg_id, uint8_t sequence,
+                                 uint8_t *payload, uint8_t length) {
+
+    static uint8_t frame[PROTOCOL_ENCODED_MAX];
+
+    t_delay_state wait;
+    uint16_t frame_length;
+    t_status status;
+
+    if (lane == DSP_LANE_BULK && g_bulk_transport == DSP_TRANSPORT_HOSTDP) {
 
-        /// TODO: Union struct for message parsing.
+        frame_length = protocol_encode(&g_hostdp_protocol, msg_type, msg_id,
+                                       sequence, payload, length, frame);
 
-        uint16_t module_id = (payload[1] << 8) | payload[0];
+        delay_start(&wait, TX_WAIT_US);
 
-        uint16_t param_index = (payload[3] << 8) | payload[2];
+        // Wait for DSP to drain mailbox.
+        do {
+            status = dev_dsp_hostdp_tx_frame(frame, frame_length);
+        } while (status == ERROR && !delay_us(&wait));
 
-        uint32_t param_value = (payload[7] << 24) | (payload[6] << 16) |
-                               (payload[5] << 8) | payload[4];
+        if (status == SUCCESS) {
+            return SUCCESS;
+        }
 
-        p_module_param_value_callback(module_id, param_index, param_value);
+        // Mailbox not drained or port not responding, fall back to SPI.
+        g_bulk_transport = DSP_TRANSPORT_SPI;
+    }
+
+    frame_length = protocol_encode(&g_protocol, msg_type, msg_id, sequence,
+                                   payload, length, frame);
+
+    // Lane still full is counted as dropped.
+    _wait_tx_free(lane, frame_length);
+
+    return dev_dsp_spi_tx_enqueue_frame(lane, frame, frame_length);
+}
+
+static t_status _dsp_init(void) {
+
+    t_status result = TASK_INIT_ERROR;
+
+    protocol_init(&g_protocol, _handle_message);
+    protocol_init(&g_hostdp_protocol, _handle_message);
+
+    dev_dsp_init();
+
+    result = SUCCESS;
+
+    return result;
+}
+
+static void _dsp_boot(void) {
+
+    /// TODO: Use queue and interrupt?
+    ///         SPI hardware ENA max timeout
+    ///         is too short for DSP boot.
+    ///         Requires polling.
+    //
+    // Transmit LDR to DSP.
+    dev_dsp_spi_tx_boot(bfin_ldr, bfin_ldr_len);
+}
+
+static void _handle_message(uint8_t msg_type, uint8_t msg_id,
+                            uint8_t sequence, uint8_t *payload,
+                            uint8_t length) {
+
+    switch (msg_type) {
+
+    case MSG_TYPE_MODULE:
+        _handle_module_message(msg_id, payload, length);
+        break;
+
+    case MSG_TYPE_SYSTEM:
+        _handle_system_message(msg_id, payload, length);
+        break;
+
+    default:
+        break;
+    }
+
+    if (sequence != PROTOCOL_SEQUENCE_NONE) {
+        _complete_request(sequence, SUCCESS, payload, length);
+    }
+}
+
+static t_status _handle_module_message(uint8_t msg_id, uint8_t *payload,
+                                       uint8_t length) {
+
+    t_status result = ERROR;
+
+    switch (msg_id) {
+
+    case MODULE_PARAM_VALUE:
+        result = _handle_module_param_value(payload, length);
+        break;
+
+    case MODULE_CYCLES:
+        result = _handle_module_cycles(payload, length);
+        break;
+
+    default:
+        break;
+    }
+
+    return result;
+}
+
+static t_status _handle_system_message(uint8_t msg_id, uint8_t *payload,
+                                       uint8_t length) {
+
+    t_status result = ERROR;
+
+    switch (msg_id) {
+
+    case SYSTEM_PORT_STATE:
+        result = _handle_system_port_state(payload, length);
+        break;
+
+    case SYSTEM_PROFILE:
+        result = _handle_system_profile(payload, length);
+        break;
+
+    case SYSTEM_PROFILE_EXT:
+        result = _handle_system_profile_ext(payload, length);
+        break;
+
+    case SYSTEM_LINK_STATS:
+        result = _handle_system_link_stats(payload, length);
+        break;
+
+    case SYSTEM_FRAME_COUNT:
+        result = _handle_system_frame_count(payload, length);
+        break;
+
+    case SYSTEM_CAPTURE_DATA:
+        result = _handle_system_capture_data(payload, length);
+        break;
+
+    case SYSTEM_TELEMETRY:
+        result = _handle_system_telemetry(payload, length);
+        break;
 
-        result = SUCCESS;
+    default:
+        break;
     }
 
     return result;
 }
 
-static t_status _handle_system_ready(void) {
+static t_status _handle_module_param_value(uint8_t *payload, uint8_t length) {
+
+    uint16_t module_id;
+    uint16_t param_index;
+    int32_t param_value;
+
+    if (length < 8) {
+        return ERROR;
+    }
+
+    /// TODO: Union struct for message parsing.
+
+    module_id = (payload[1] << 8) | payload[0];
+
+    param_index = (payload[3] << 8) | payload[2];
+
+    param_value = _unpack_u32(&payload[4]);
+
+    _mirror_store(module_id, param_index, param_value);
+
+    if (p_module_param_value_callback != NULL) {
+        p_module_param_value_callback(module_id, param_index, param_value);
+    }
+
+    return SUCCESS;
+}
+
+static t_status _handle_module_cycles(uint8_t *payload, uint8_t length) {
+
+    if (length < 6) {
+        return ERROR;
+    }
+
+    if (p_module_cycles_callback != NULL) {
+
+        uint16_t module_id = (payload[1] << 8) | payload[0];
+
+        uint32_t cycles = _unpack_u32(&payload[2]);
 
-    // g_dsp_ready = true;
+        p_module_cycles_callback(module_id, cycles);
+    }
 
     return SUCCESS;
 }
@@ -555,11 +2252,322 @@ static t_status _handle_system_profile(uint8_t *payload, uint8_t length) {
     return SUCCESS;
 }
 
-static void _dsp_response_required(void) { g_pending_response++; }
+static t_status _handle_system_profile_ext(uint8_t *payload, uint8_t length) {
+
+    t_dsp_profile profile;
+
+    if (length < 32) {
+        return ERROR;
+    }
+
+    if (p_system_profile_ext_callback != NULL) {
+
+        profile.period = _unpack_u32(&payload[0]);
+        profile.cycles = _unpack_u32(&payload[4]);
+        profile.min = _unpack_u32(&payload[8]);
+        profile.max = _unpack_u32(&payload[12]);
+        profile.mean = _unpack_u32(&payload[16]);
+        profile.percentile = _unpack_u32(&payload[20]);
+        profile.blocks = _unpack_u32(&payload[24]);
+        profile.overruns = _unpack_u32(&payload[28]);
+
+        p_system_profile_ext_callback(&profile);
+    }
+
+    return SUCCESS;
+}
+
+static t_status _handle_system_frame_count(uint8_t *payload, uint8_t length) {
+
+    if (length < 4) {
+        return ERROR;
+    }
+
+    if (p_system_frame_count_callback != NULL) {
+
+        p_system_frame_count_callback(_unpack_u32(payload));
+    }
+
+    return SUCCESS;
+}
+
+static t_status _handle_system_link_stats(uint8_t *payload, uint8_t length) {
+
+    t_protocol_stats stats;
+
+    if (length < 20) {
+        return ERROR;
+    }
+
+    if (p_system_link_stats_callback != NULL) {
+
+        stats.rx_frames = _unpack_u32(&payload[0]);
+        stats.tx_frames = _unpack_u32(&payload[4]);
+        stats.crc_errors = _unpack_u32(&payload[8]);
+        stats.frame_errors = _unpack_u32(&payload[12]);
+        stats.overflows = _unpack_u32(&payload[16]);
+
+        // DSP sends no requests.
+        stats.timeouts = 0;
+        stats.retries = 0;
+
+        p_system_link_stats_callback(&stats);
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief   Store captured frames at their capture index.
+ *
+ * Payload holds index of first frame, DSP overrun count,
+ * then interleaved Q15 samples.
+ */
+static t_status _handle_system_capture_data(uint8_t *payload,
+                                            uint8_t length) {
+
+    uint32_t index;
+    uint32_t frames;
+    uint32_t count;
+    uint32_t i;
+    int16_t *dest;
+
+    if (!g_capture.running || g_capture.stopping ||
+        length < PROTOCOL_CAPTURE_HEADER) {
+        return ERROR;
+    }
+
+    index = _unpack_u32(&payload[0]);
+    g_capture.overruns = _unpack_u32(&payload[4]);
+
+    frames = (length - PROTOCOL_CAPTURE_HEADER) / sizeof(int16_t) /
+             g_capture.channels;
+
+    if (index >= g_capture.length) {
+        return ERROR;
+    }
+
+    if (frames > g_capture.length - index) {
+        frames = g_capture.length - index;
+    }
+
+    count = frames * g_capture.channels;
+    dest = &g_capture.buffer[index * g_capture.channels];
+    payload += PROTOCOL_CAPTURE_HEADER;
+
+    for (i = 0; i < count; i++) {
+        dest[i] = payload[2 * i] | (payload[2 * i + 1] << 8);
+    }
+
+    if (index + frames > g_capture.frames) {
+        g_capture.frames = index + frames;
+    }
+
+    if (g_capture.frames == g_capture.length) {
+        svc_dsp_capture_stop();
+    }
+
+    return SUCCESS;
+}
+
+static t_status _handle_system_telemetry(uint8_t *payload, uint8_t length) {
+
+    t_dsp_telemetry telemetry;
+    uint8_t *level = &payload[28];
+    uint8_t i;
+
+    if (length < PROTOCOL_TELEMETRY_LENGTH) {
+        return ERROR;
+    }
+
+    if (p_system_telemetry_callback != NULL) {
+
+        telemetry.frame_count = _unpack_u32(&payload[0]);
+        telemetry.period = _unpack_u32(&payload[4]);
+        telemetry.cycles = _unpack_u32(&payload[8]);
+        telemetry.mean = _unpack_u32(&payload[12]);
+        telemetry.max = _unpack_u32(&payload[16]);
+        telemetry.percentile = _unpack_u32(&payload[20]);
+        telemetry.overruns = _unpack_u32(&payload[24]);
+
+        for (i = 0; i < DSP_TELEMETRY_CHANNELS; i++) {
+
+            telemetry.input[i].peak = _unpack_u16(&level[i * 4]);
+            telemetry.input[i].rms = _unpack_u16(&level[i * 4 + 2]);
+
+            telemetry.output[i].peak =
+                _unpack_u16(&level[(DSP_TELEMETRY_CHANNELS + i) * 4]);
+            telemetry.output[i].rms =
+                _unpack_u16(&level[(DSP_TELEMETRY_CHANNELS + i) * 4 + 2]);
+        }
+
+        telemetry.events = payload[44];
+        telemetry.capture = _unpack_u16(&payload[45]);
+        telemetry.spi_tx_free = _unpack_u16(&payload[47]);
+        telemetry.hostdp_tx_free = _unpack_u16(&payload[49]);
+
+        p_system_telemetry_callback(&telemetry);
+    }
+
+    return SUCCESS;
+}
+
+static uint16_t _unpack_u16(uint8_t *payload) {
+
+    return payload[1] << 8 | payload[0];
+}
+
+static uint32_t _unpack_u32(uint8_t *payload) {
+
+    return payload[3] << 24 | payload[2] << 16 | payload[1] << 8 | payload[0];
+}
+
+static void _mirror_store(uint16_t module_id, uint16_t param_index,
+                          int32_t param_value) {
+
+    if (module_id < DSP_MIRROR_MODULES && param_index < DSP_MIRROR_PARAMS) {
+
+        g_param_mirror.value[module_id][param_index] = param_value;
+        g_param_mirror.valid[module_id][param_index / 32] |=
+            1UL << (param_index % 32);
+    }
+}
+
+// Store value set by CPU, newer than any resync chunk in flight.
+static void _mirror_set(uint16_t module_id, uint16_t param_index,
+                        int32_t param_value) {
+
+    _mirror_store(module_id, param_index, param_value);
+
+    if (module_id < DSP_MIRROR_MODULES && param_index < DSP_MIRROR_PARAMS) {
+        g_param_mirror.generation[module_id][param_index] =
+            g_mirror_generation;
+    }
+}
+
+static void _mirror_invalidate(void) {
+
+    memset(g_param_mirror.valid, 0, sizeof(g_param_mirror.valid));
+}
+
+static bool _param_slot_pending(uint16_t module_id, uint16_t param_index) {
+
+    uint8_t i;
+
+    for (i = 0; i < g_param_slot_count; i++) {
+
+        if (g_param_slots[i].module_id == module_id &&
+            g_param_slots[i].param_index == param_index) {
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static t_status _request_all_params(t_dsp_resync *resync) {
+
+    uint16_t module_id = resync->module_id;
+    uint16_t start_index = resync->start_index;
+
+    uint8_t payload[] = {(module_id & 0xff), (module_id >> 8) & 0xff,
+                         (start_index & 0xff), (start_index >> 8) & 0xff};
+
+    // Values set from now on are newer than the response.
+    resync->generation = ++g_mirror_generation;
+
+    return _transmit_request(MSG_TYPE_MODULE, MODULE_GET_ALL_PARAMS, payload,
+                             sizeof(payload), _resync_chunk, resync);
+}
+
+/**
+ * @brief   Store chunk of parameter values in mirror.
+ *
+ * Values set since the chunk was requested, or pending
+ * transmission, are newer and kept.  Request next chunk
+ * until all parameters received.
+ */
+static void _resync_chunk(t_status status, uint8_t *payload, uint8_t length,
+                          void *context) {
+
+    t_dsp_resync *resync = context;
+    uint16_t module_id = resync->module_id;
+    uint16_t param_index;
+    uint16_t param_count;
+    uint16_t received;
+    uint16_t i;
+
+    if (resync->restart) {
+
+        resync->restart = false;
+        resync->start_index = 0;
+        resync->attempts = 0;
+
+    } else if (status == TIMEOUT_ERROR &&
+               ++resync->attempts < RESYNC_ATTEMPTS) {
+
+        // Request same chunk again.
+        g_protocol.stats.retries++;
+
+    } else if (status != SUCCESS) {
+        _resync_finish(resync, status);
+        return;
+
+    } else {
+
+        if (length < 6 || _unpack_u16(&payload[0]) != module_id ||
+            _unpack_u16(&payload[2]) != resync->start_index) {
+
+            _resync_finish(resync, ERROR);
+            return;
+        }
+
+        param_count = _unpack_u16(&payload[4]);
+        received = (length - 6) / 4;
+
+        for (i = 0; i < received; i++) {
+
+            param_index = resync->start_index + i;
+
+            if (param_index < DSP_MIRROR_PARAMS &&
+                g_param_mirror.generation[module_id][param_index] <
+                    resync->generation &&
+                !_param_slot_pending(module_id, param_index)) {
+
+                _mirror_store(module_id, param_index,
+                              _unpack_u32(&payload[6 + i * 4]));
+            }
+        }
+
+        resync->start_index += received;
+        resync->attempts = 0;
+
+        if (resync->start_index >= param_count ||
+            resync->start_index >= DSP_MIRROR_PARAMS) {
+
+            _resync_finish(resync, SUCCESS);
+            return;
+        }
+
+        if (received == 0) {
+            // Empty chunk before count reached would repeat forever.
+            _resync_finish(resync, ERROR);
+            return;
+        }
+    }
+
+    if (_request_all_params(resync) != SUCCESS) {
+        _resync_finish(resync, ERROR);
+    }
+}
+
+static void _resync_finish(t_dsp_resync *resync, t_status status) {
 
-static void _dsp_response_received(void) {
+    resync->running = false;
 
-    if (g_pending_response > 0) {
-        g_pending_response--;
+    if (resync->callback != NULL) {
+        resync->callback(status, resync->module_id);
     }
 }
+
@@ -46,34 +46,174 @@ extern "C" {
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "dev_dsp.h"
 #include "ft_error.h"
+#include "ft_protocol.h"
 
 /*----- Macros -------------------------------------------------------*/
 
-/// TODO: Move protocol definition to common module.
-///       Union struct for message.
-enum e_message_type { MSG_TYPE_MODULE, MSG_TYPE_SYSTEM };
-
-enum e_module_msg_id {
-    MODULE_GET_PARAM_VALUE,
-    MODULE_SET_PARAM_VALUE,
-    MODULE_PARAM_VALUE,
-    MODULE_GET_PARAM_NAME,
-    MODULE_PARAM_NAME
-};
-
-enum e_system_msg_id {
-    SYSTEM_CHECK_READY,
-    SYSTEM_READY,
-    SYSTEM_GET_PORT_STATE,
-    SYSTEM_SET_PORT_STATE,
-    SYSTEM_PORT_STATE,
-    SYSTEM_GET_PROFILE,
-    SYSTEM_PROFILE,
-};
+/// Node source for DSP module graph input.
+#define DSP_SOURCE_INPUT 0xff
+
+/// Maximum number of nodes in DSP module graph.
+#define DSP_MAX_NODES 8
+
+/// Modules and parameters held in CPU mirror of DSP values.
+#define DSP_MIRROR_MODULES 8
+#define DSP_MIRROR_PARAMS 64
+
+/// Input and output channels metered in DSP telemetry.
+#define DSP_TELEMETRY_CHANNELS 2
+
+/// Length of DSP parameter name, including null terminator.
+#define DSP_PARAM_NAME_LENGTH 16
 
 /*----- Typedefs -----------------------------------------------------*/
 
+/// Link carrying requests and their responses.
+typedef enum {
+    DSP_TRANSPORT_SPI,
+    // EMIFA to BF523 Host DMA Port.
+    DSP_TRANSPORT_HOSTDP,
+} t_dsp_transport;
+
+/// DSP module graph node, indexed by module_id.
+typedef struct {
+
+    // Index of module type in DSP build MODULE list.
+    uint8_t type;
+
+    // module_id of node providing input, or DSP_SOURCE_INPUT.
+    uint8_t source;
+
+} t_dsp_node;
+
+/// Extended DSP profile, cycle counts are per audio block.
+typedef struct {
+    uint32_t period;
+    uint32_t cycles;
+    // Minimum and maximum since reset.
+    uint32_t min;
+    uint32_t max;
+    // Mean of recent blocks.
+    uint32_t mean;
+    // 99th percentile, histogram bucket upper bound.
+    uint32_t percentile;
+    uint32_t blocks;
+    // Blocks not processed before next block received.
+    uint32_t overruns;
+
+} t_dsp_profile;
+
+/// Channel level over telemetry interval, Q15.
+typedef struct {
+    uint16_t peak;
+    uint16_t rms;
+} t_dsp_level;
+
+/// Telemetry pushed by DSP, cycle counts are per audio block.
+typedef struct {
+    uint32_t frame_count;
+    uint32_t period;
+    uint32_t cycles;
+    // Mean of recent blocks, maximum since reset.
+    uint32_t mean;
+    uint32_t max;
+    // 99th percentile, histogram bucket upper bound.
+    uint32_t percentile;
+    uint32_t overruns;
+    t_dsp_level input[DSP_TELEMETRY_CHANNELS];
+    t_dsp_level output[DSP_TELEMETRY_CHANNELS];
+    // Queue depths, events pending and capture frames unsent.
+    uint8_t events;
+    uint16_t capture;
+    // Bytes free in DSP tx buffers.
+    uint16_t spi_tx_free;
+    uint16_t hostdp_tx_free;
+
+} t_dsp_telemetry;
+
+/// Link benchmark results, times in microseconds.
+typedef struct {
+    // Echo payload length.
+    uint8_t length;
+    // Echoes completed, and payload bytes carried in both directions.
+    uint32_t messages;
+    uint32_t bytes;
+    // Timeouts and corrupt replies.
+    uint32_t errors;
+    uint32_t elapsed;
+    // Per second of elapsed time.
+    uint32_t message_rate;
+    uint32_t byte_rate;
+    // Round trip latency.
+    uint32_t min;
+    uint32_t mean;
+    uint32_t max;
+    // Histogram bucket upper bounds.
+    uint32_t median;
+    uint32_t percentile;
+
+} t_dsp_benchmark;
+
+typedef void (*t_dsp_benchmark_callback)(t_dsp_benchmark *result);
+
+/// Called when upload completes, length is valid bytes in region.
+typedef void (*t_dsp_upload_callback)(t_status status, uint8_t region,
+                                      uint32_t length);
+
+/// Capture stream settings.
+typedef struct {
+    // Audio tapped, see e_capture_source.
+    uint8_t source;
+    // Frames averaged per captured frame, 1 for full rate.
+    uint8_t decimation;
+    // Bit per channel captured.
+    uint8_t channel_mask;
+    // DSP ring depth in samples, 0 for maximum.
+    uint16_t depth;
+} t_dsp_capture_config;
+
+/// Called when capture stops, frames stored and dropped by DSP.
+typedef void (*t_dsp_capture_callback)(t_status status, uint32_t frames,
+                                       uint32_t overruns);
+
+/// DSP module parameter descriptor.
+typedef struct {
+    char name[DSP_PARAM_NAME_LENGTH];
+    // Values set are clamped to range.
+    int32_t min;
+    int32_t max;
+    int32_t init;
+    // Control mapping, see e_param_scale.
+    uint8_t scale;
+    // Time to reach new value, 0 to step.
+    uint16_t slew_ms;
+} t_dsp_param_info;
+
+/// Called when descriptors received, count is parameters of module.
+typedef void (*t_dsp_param_info_callback)(t_status status, uint16_t module_id,
+                                          uint16_t count);
+
+/// Called when parameter resync of module completes.
+typedef void (*t_dsp_resync_callback)(t_status status, uint16_t module_id);
+
+/// DSP modulation route, scales source onto module parameter.
+typedef struct {
+    // Modulation source, see e_mod_source, MOD_SOURCE_NONE clears.
+    uint8_t source;
+    // Source multiplying route depth, or MOD_SOURCE_NONE.
+    uint8_t via;
+    uint16_t module_id;
+    uint16_t param_index;
+    // Parameter units, or fix16 octaves for PARAM_SCALE_EXP.
+    int32_t depth;
+} t_dsp_mod_route;
+
+/// Called with response payload, or TIMEOUT_ERROR.
+typedef void (*t_dsp_request_callback)(t_status status, uint8_t *payload,
+                                       uint8_t length, void *context);
+
 /*----- Extern variable declarations ---------------------------------*/
 
 /*----- Extern function prototypes -----------------------------------*/
@@ -86,12 +226,59 @@ void svc_dsp_register_callback(uint8_t msg_type, uint8_t msg_id,
 void svc_dsp_set_module_param(uint16_t module_id, uint16_t param_index,
                               int32_t param_value);
 
+void svc_dsp_set_module_param_at(uint16_t module_id, uint16_t param_index,
+                                 int32_t param_value, uint32_t frame);
+
 void svc_dsp_get_module_param(uint16_t module_id, uint16_t param_index);
 
+t_status svc_dsp_read_module_param(uint16_t module_id, uint16_t param_index,
+                                   int32_t *param_value);
+t_status svc_dsp_resync_module_params(uint16_t module_id,
+                                      t_dsp_resync_callback callback);
+
+void svc_dsp_set_module_graph(const t_dsp_node *nodes, uint8_t count);
+void svc_dsp_get_module_cycles(uint16_t module_id);
+t_status svc_dsp_get_module_info(uint16_t module_id, t_dsp_param_info *info,
+                                 uint16_t capacity,
+                                 t_dsp_param_info_callback callback);
+
+void svc_dsp_set_mod_source(uint8_t source, uint8_t setting, int32_t value);
+void svc_dsp_set_mod_gate(uint8_t mask, bool gate, int32_t velocity);
+void svc_dsp_set_mod_route(uint8_t route, const t_dsp_mod_route *config);
+
 void svc_dsp_get_port_state(void);
 bool svc_dsp_ready(void);
 
 void svc_dsp_get_profile(void);
+void svc_dsp_get_profile_ext(bool reset);
+
+void svc_dsp_get_frame_count(void);
+void svc_dsp_set_telemetry(uint16_t interval_ms);
+
+t_status svc_dsp_request(uint8_t msg_type, uint8_t msg_id, uint8_t *payload,
+                         uint8_t length, t_dsp_request_callback callback,
+                         void *context);
+
+t_protocol_stats svc_dsp_link_stats(void);
+t_dsp_lane_stats svc_dsp_lane_stats(t_dsp_lane_id lane);
+
+t_status svc_dsp_benchmark(uint8_t length, uint32_t count,
+                           t_dsp_benchmark_callback callback);
+bool svc_dsp_benchmark_running(void);
+
+t_status svc_dsp_upload(uint8_t region, uint32_t offset, const uint8_t *data,
+                        uint32_t length, t_dsp_upload_callback callback);
+bool svc_dsp_upload_running(void);
+
+t_status svc_dsp_capture_start(const t_dsp_capture_config *config,
+                               int16_t *buffer, uint32_t frames,
+                               t_dsp_capture_callback callback);
+void svc_dsp_capture_stop(void);
+bool svc_dsp_capture_running(void);
+
+t_status svc_dsp_set_bulk_transport(t_dsp_transport transport);
+t_dsp_transport svc_dsp_bulk_transport(void);
+void svc_dsp_get_link_stats(void);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,195 @@
+/*----------------------------------------------------------------------
+
+                     This file is part of Freetribe
+
+                https://github.com/bangcorrupt/freetribe
+
+                                License
+
+                   GNU AFFERO GENERAL PUBLIC LICENSE
+                      Version 3, 19 November 2007
+
+                           AGPL-3.0-or-later
+
+ Freetribe is free software: you can redistribute it and/or modify it
+under the terms of the GNU Affero General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+                  (at your option) any later version.
+
+     Freetribe is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty
+        of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+          See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+                       Copyright bangcorrupt 2024
+
+----------------------------------------------------------------------*/
+
+/**
+ * @file    fract_math.h
+ *
+ * @brief   Host stand-in for Blackfin fractional arithmetic.
+ *
+ * Portable C versions of the saturating fract16 and fract32
+ * builtins used by modules and libraries.
+ */
+
+#ifndef SIM_FRACT_MATH_H
+#define SIM_FRACT_MATH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*----- Includes -----------------------------------------------------*/
+
+#include <stdint.h>
+
+#include "types.h"
+
+/*----- Macros -------------------------------------------------------*/
+
+#define FR32_MAX ((fract32)0x7fffffff)
+#define FR32_MIN ((fract32)0x80000000)
+
+#define FR16_MAX ((fract16)0x7fff)
+#define FR16_MIN ((fract16)0x8000)
+
+/*----- Typedefs -----------------------------------------------------*/
+
+/*----- Extern variable declarations ---------------------------------*/
+
+/*----- Extern function prototypes -----------------------------------*/
+
+static inline fract32 sat_fr1x32(int64_t x) {
+
+    if (x > FR32_MAX) {
+        return FR32_MAX;
+    }
+    if (x < FR32_MIN) {
+        return FR32_MIN;
+    }
+    return (fract32)x;
+}
+
+static inline fract32 add_fr1x32(fract32 x, fract32 y) {
+    return sat_fr1x32((int64_t)x + y);
+}
+
+static inline fract32 sub_fr1x32(fract32 x, fract32 y) {
+    return sat_fr1x32((int64_t)x - y);
+}
+
+static inline fract32 mult_fr1x32x32(fract32 x, fract32 y) {
+    return sat_fr1x32(((int64_t)x * y) >> 31);
+}
+
+static inline fract32 negate_fr1x32(fract32 x) {
+    return sat_fr1x32(-(int64_t)x);
+}
+
+static inline fract32 abs_fr1x32(fract32 x) {
+    return sat_fr1x32(x < 0 ? -(int64_t)x : x);
+}
+
+static inline fract32 shl_fr1x32(fract32 x, int shift) {
+    return shift >= 0 ? sat_fr1x32((int64_t)x << shift) : x >> -shift;
+}
+
+static inline fract32 shr_fr1x32(fract32 x, int shift) {
+    return shl_fr1x32(x, -shift);
+}
+
+static inline fract32 mult_fr1x32x32NS(fract32 x, fract32 y) {
+    return (fract32)(((int64_t)x * y) >> 31);
+}
+
+static inline fract32 min_fr1x32(fract32 x, fract32 y) { return x < y ? x : y; }
+
+static inline fract32 max_fr1x32(fract32 x, fract32 y) { return x > y ? x : y; }
+
+/// Number of redundant sign bits.
+static inline int norm_fr1x32(fract32 x) {
+
+    uint32_t bits = (uint32_t)x;
+    int count = 0;
+
+    if (x == 0) {
+        return 0;
+    }
+    while (count < 31 && !((bits ^ (bits << 1)) & 0x80000000)) {
+        bits <<= 1;
+        count++;
+    }
+    return count;
+}
+
+static inline fract16 sat_fr1x16(int32_t x) {
+
+    if (x > FR16_MAX) {
+        return FR16_MAX;
+    }
+    if (x < FR16_MIN) {
+        return FR16_MIN;
+    }
+    return (fract16)x;
+}
+
+static inline fract16 add_fr1x16(fract16 x, fract16 y) {
+    return sat_fr1x16((int32_t)x + y);
+}
+
+static inline fract16 sub_fr1x16(fract16 x, fract16 y) {
+    return sat_fr1x16((int32_t)x - y);
+}
+
+static inline fract16 mult_fr1x16(fract16 x, fract16 y) {
+    return sat_fr1x16(((int32_t)x * y) >> 15);
+}
+
+static inline fract16 multr_fr1x16(fract16 x, fract16 y) {
+    return sat_fr1x16((((int32_t)x * y) + 0x4000) >> 15);
+}
+
+/// Multiply fract16 values to fract32 result.
+static inline fract32 mult_fr1x32(fract16 x, fract16 y) {
+    return sat_fr1x32((int64_t)x * y * 2);
+}
+
+static inline fract16 negate_fr1x16(fract16 x) {
+    return sat_fr1x16(-(int32_t)x);
+}
+
+static inline fract16 abs_fr1x16(fract16 x) {
+    return sat_fr1x16(x < 0 ? -(int32_t)x : x);
+}
+
+static inline fract16 min_fr1x16(fract16 x, fract16 y) { return x < y ? x : y; }
+
+static inline fract16 max_fr1x16(fract16 x, fract16 y) { return x > y ? x : y; }
+
+static inline fract16 shl_fr1x16(fract16 x, int shift) {
+    return shift >= 0 ? sat_fr1x16((int32_t)x << shift) : x >> -shift;
+}
+
+static inline fract16 shr_fr1x16(fract16 x, int shift) {
+    return shl_fr1x16(x, -shift);
+}
+
+/// High half of fract32, truncated.
+static inline fract16 trunc_fr1x32(fract32 x) { return (fract16)(x >> 16); }
+
+/// High half of fract32, rounded.
+static inline fract16 round_fr1x32(fract32 x) {
+    return sat_fr1x16(((int64_t)x + 0x8000) >> 16);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
+
+/*----- End of file --------------------------------------------------*/
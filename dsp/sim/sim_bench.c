@@ -0,0 +1,396 @@
+/*----------------------------------------------------------------------
+
+                     This file is part of Freetribe
+
+                https://github.com/bangcorrupt/freetribe
+
+                                License
+
+                   GNU AFFERO GENERAL PUBLIC LICENSE
+                      Version 3, 19 November 2007
+
+                           AGPL-3.0-or-later
+
+ Freetribe is free software: you can redistribute it and/or modify it
+under the terms of the GNU Affero General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+                  (at your option) any later version.
+
+     Freetribe is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty
+        of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+          See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+                       Copyright bangcorrupt 2024
+
+----------------------------------------------------------------------*/
+
+/**
+ * @file    sim_bench.c
+ *
+ * @brief   Host loopback benchmark of the CPU command link.
+ *
+ * Plays the CPU side of the link over pipes, sending echo
+ * requests framed by ft_protocol.c to svc_cpu.c and timing
+ * each reply.  Each payload length in turn is sent count
+ * times, with SIM_BENCH_WINDOW requests in flight.
+ *
+ * Round trip is measured in blocks of simulated time, so
+ * depends on the link transfers per block, and in host
+ * nanoseconds using cycles().
+ */
+
+/*----- Includes -----------------------------------------------------*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ft_protocol.h"
+#include "module.h"
+#include "sim_bench.h"
+#include "sim_hostdp.h"
+#include "sim_spi.h"
+
+#include "knl_profile.h"
+
+/*----- Macros -------------------------------------------------------*/
+
+/// Echo requests in flight, as svc_dsp.c on the CPU.
+#define SIM_BENCH_WINDOW 4
+
+/// Blocks to wait for a reply before counting an error.
+#define SIM_BENCH_TIMEOUT_BLOCKS 1000
+
+/// Nominal block period in nanoseconds.
+#define SIM_BENCH_BLOCK_NS (SPORT_BLOCK_SIZE * 1000000000ULL / SAMPLERATE)
+
+/*----- Typedefs -----------------------------------------------------*/
+
+/// Echo in flight, indexed by sequence.
+typedef struct {
+
+    bool busy;
+    uint64_t block;
+    uint64_t start;
+
+} t_sim_echo;
+
+/*----- Static variable definitions ----------------------------------*/
+
+/// Payload lengths measured, in order.
+static const uint8_t g_lengths[] = {0, 16, 64, 128, PROTOCOL_PAYLOAD_MAX};
+
+static bool g_active;
+static bool g_done;
+
+// Write requests to DSP, read replies from DSP.
+static int g_request_fd = -1;
+static int g_reply_fd = -1;
+
+static t_protocol g_protocol;
+
+static t_sim_echo g_echoes[256];
+static uint8_t g_sequence;
+static uint8_t g_in_flight;
+
+static uint32_t g_count;
+static uint8_t g_length_index;
+static uint32_t g_sent;
+static uint32_t g_received;
+static uint32_t g_errors;
+
+static uint64_t g_block;
+static uint64_t g_start_block;
+
+static uint64_t *g_latency_blocks;
+static uint64_t *g_latency_ns;
+
+/*----- Extern variable definitions ----------------------------------*/
+
+/*----- Static function prototypes -----------------------------------*/
+
+static void _send_echo(void);
+static void _handle_message(uint8_t msg_type, uint8_t msg_id,
+                            uint8_t sequence, uint8_t *payload,
+                            uint8_t length);
+static void _check_timeouts(void);
+static void _report(void);
+
+static int _compare(const void *a, const void *b);
+static uint64_t _percentile(uint64_t *values, uint32_t count,
+                            uint32_t percentile);
+
+/*----- Extern function implementations ------------------------------*/
+
+/**
+ * @brief   Connect link stand-in to benchmark through pipes.
+ *
+ * @param[in]   count   Echo requests per payload length.
+ * @param[in]   hostdp  Use HostDP mailbox instead of SPI.
+ */
+t_status sim_bench_open(uint32_t count, bool hostdp) {
+
+    int request_pipe[2];
+    int reply_pipe[2];
+
+    if (count == 0 || pipe(request_pipe) != 0) {
+        return ERROR;
+    }
+
+    if (pipe(reply_pipe) != 0) {
+        close(request_pipe[0]);
+        close(request_pipe[1]);
+        return ERROR;
+    }
+
+    g_request_fd = request_pipe[1];
+    g_reply_fd = reply_pipe[0];
+
+    fcntl(g_reply_fd, F_SETFL, fcntl(g_reply_fd, F_GETFL) | O_NONBLOCK);
+
+    g_latency_blocks = calloc(count, sizeof(uint64_t));
+    g_latency_ns = calloc(count, sizeof(uint64_t));
+
+    if (g_latency_blocks == NULL || g_latency_ns == NULL) {
+        return ERROR;
+    }
+
+    protocol_init(&g_protocol, _handle_message);
+
+    g_count = count;
+    g_active = true;
+
+    if (hostdp) {
+        return sim_hostdp_open_fd(request_pipe[0], reply_pipe[1]);
+    }
+
+    return sim_spi_open_fd(request_pipe[0], reply_pipe[1]);
+}
+
+/**
+ * @brief   Handle replies and send requests, once per block.
+ */
+void sim_bench_task(void) {
+
+    uint8_t buffer[256];
+    ssize_t length;
+    ssize_t i;
+
+    if (!g_active || g_done) {
+        return;
+    }
+
+    while ((length = read(g_reply_fd, buffer, sizeof(buffer))) > 0) {
+
+        for (i = 0; i < length; i++) {
+            protocol_receive(&g_protocol, buffer[i]);
+        }
+    }
+
+    _check_timeouts();
+
+    // Next payload length when all replies handled.
+    if (g_received + g_errors == g_count) {
+
+        _report();
+
+        g_sent = 0;
+        g_received = 0;
+        g_errors = 0;
+
+        if (++g_length_index == sizeof(g_lengths)) {
+            g_done = true;
+            return;
+        }
+    }
+
+    if (g_sent == 0) {
+        g_start_block = g_block;
+    }
+
+    while (g_in_flight < SIM_BENCH_WINDOW && g_sent < g_count) {
+        _send_echo();
+    }
+
+    g_block++;
+}
+
+bool sim_bench_done(void) { return g_done; }
+
+void sim_bench_close(void) {
+
+    if (g_active && !g_done) {
+        fprintf(stderr, "Echo benchmark stopped at %u byte payload\n",
+                g_lengths[g_length_index]);
+    }
+
+    if (g_request_fd >= 0) {
+        close(g_request_fd);
+    }
+    if (g_reply_fd >= 0) {
+        close(g_reply_fd);
+    }
+    g_request_fd = -1;
+    g_reply_fd = -1;
+
+    free(g_latency_blocks);
+    free(g_latency_ns);
+    g_latency_blocks = NULL;
+    g_latency_ns = NULL;
+
+    g_active = false;
+}
+
+/*----- Static function implementations ------------------------------*/
+
+static void _send_echo(void) {
+
+    uint8_t payload[PROTOCOL_PAYLOAD_MAX];
+    uint8_t frame[PROTOCOL_ENCODED_MAX];
+    uint16_t length = g_lengths[g_length_index];
+    uint16_t frame_length;
+    uint16_t i;
+
+    // Sequence 0 marks messages not sent in response.
+    if (++g_sequence == PROTOCOL_SEQUENCE_NONE) {
+        g_sequence++;
+    }
+
+    // Pattern includes zero bytes, exercising COBS.
+    for (i = 0; i < length; i++) {
+        payload[i] = i;
+    }
+
+    frame_length = protocol_encode(&g_protocol, MSG_TYPE_SYSTEM, SYSTEM_ECHO,
+                                   g_sequence, payload, length, frame);
+
+    g_echoes[g_sequence].busy = true;
+    g_echoes[g_sequence].block = g_block;
+    g_echoes[g_sequence].start = cycles();
+
+    if (write(g_request_fd, frame, frame_length) != frame_length) {
+        fprintf(stderr, "Echo benchmark write failed: %s\n", strerror(errno));
+    }
+
+    g_in_flight++;
+    g_sent++;
+}
+
+static void _handle_message(uint8_t msg_type, uint8_t msg_id,
+                            uint8_t sequence, uint8_t *payload,
+                            uint8_t length) {
+
+    t_sim_echo *echo = &g_echoes[sequence];
+    uint16_t i;
+
+    if (msg_type != MSG_TYPE_SYSTEM || msg_id != SYSTEM_ECHO_REPLY ||
+        !echo->busy) {
+        return;
+    }
+
+    echo->busy = false;
+    g_in_flight--;
+
+    if (length != g_lengths[g_length_index]) {
+        g_errors++;
+        return;
+    }
+
+    for (i = 0; i < length; i++) {
+        if (payload[i] != (uint8_t)i) {
+            g_errors++;
+            return;
+        }
+    }
+
+    g_latency_blocks[g_received] = g_block - echo->block;
+    g_latency_ns[g_received] = cycles() - echo->start;
+
+    g_received++;
+}
+
+static void _check_timeouts(void) {
+
+    uint16_t sequence;
+
+    for (sequence = 0; sequence < sizeof(g_echoes) / sizeof(g_echoes[0]);
+         sequence++) {
+
+        if (g_echoes[sequence].busy &&
+            g_block - g_echoes[sequence].block > SIM_BENCH_TIMEOUT_BLOCKS) {
+
+            g_echoes[sequence].busy = false;
+            g_in_flight--;
+            g_errors++;
+        }
+    }
+}
+
+static void _report(void) {
+
+    uint64_t blocks = g_block - g_start_block;
+    uint64_t bytes = (uint64_t)g_received * g_lengths[g_length_index] * 2;
+    double seconds = (double)blocks * SIM_BENCH_BLOCK_NS / 1e9;
+    uint64_t total = 0;
+    uint64_t median;
+    uint64_t worst;
+    uint32_t i;
+
+    fprintf(stderr, "Echo %3u bytes:  %u messages, %u errors\n",
+            g_lengths[g_length_index], g_received, g_errors);
+
+    if (g_received == 0 || blocks == 0) {
+        return;
+    }
+
+    for (i = 0; i < g_received; i++) {
+        total += g_latency_blocks[i];
+    }
+
+    fprintf(stderr, "  Link rate:     %.0f msg/s, %.0f B/s\n",
+            g_received / seconds, bytes / seconds);
+
+    median = _percentile(g_latency_blocks, g_received, 50);
+    worst = _percentile(g_latency_blocks, g_received, 99);
+
+    fprintf(stderr, "  Round trip:    mean %.0f us, p50 %llu us, p99 %llu us\n",
+            (double)total * SIM_BENCH_BLOCK_NS / g_received / 1000,
+            (unsigned long long)(median * SIM_BENCH_BLOCK_NS / 1000),
+            (unsigned long long)(worst * SIM_BENCH_BLOCK_NS / 1000));
+
+    median = _percentile(g_latency_ns, g_received, 50);
+    worst = _percentile(g_latency_ns, g_received, 99);
+
+    fprintf(stderr, "  Host time:     p50 %llu ns, p99 %llu ns\n",
+            (unsigned long long)median, (unsigned long long)worst);
+}
+
+static int _compare(const void *a, const void *b) {
+
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+// Nearest rank percentile, sorts values in place.
+static uint64_t _percentile(uint64_t *values, uint32_t count,
+                            uint32_t percentile) {
+
+    uint32_t rank = ((uint64_t)count * percentile + 99) / 100;
+
+    qsort(values, count, sizeof(values[0]), _compare);
+
+    return values[rank > 0 ? rank - 1 : 0];
+}
+
+/*----- End of file --------------------------------------------------*/
@@ -0,0 +1,91 @@
+/*----------------------------------------------------------------------
+
+                     This file is part of Freetribe
+
+                https://github.com/bangcorrupt/freetribe
+
+                                License
+
+                   GNU AFFERO GENERAL PUBLIC LICENSE
+                      Version 3, 19 November 2007
+
+                           AGPL-3.0-or-later
+
+ Freetribe is free software: you can redistribute it and/or modify it
+under the terms of the GNU Affero General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+                  (at your option) any later version.
+
+     Freetribe is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty
+        of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+          See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+                       Copyright bangcorrupt 2024
+
+----------------------------------------------------------------------*/
+
+/**
+ * @file    sim_gpio.c
+ *
+ * @brief   Host stand-in for BF523 GPIO.
+ *
+ * Ports are plain variables, so port state messages
+ * read back whatever was last written.
+ */
+
+/*----- Includes -----------------------------------------------------*/
+
+#include <stdint.h>
+#include <string.h>
+
+#include "per_gpio.h"
+
+/*----- Macros -------------------------------------------------------*/
+
+#define GPIO_PORTS 3
+
+/*----- Typedefs -----------------------------------------------------*/
+
+/*----- Static variable definitions ----------------------------------*/
+
+static uint16_t g_port[GPIO_PORTS];
+
+/*----- Extern variable definitions ----------------------------------*/
+
+/*----- Static function prototypes -----------------------------------*/
+
+/*----- Extern function implementations ------------------------------*/
+
+void per_gpio_init(void) { memset(g_port, 0, sizeof(g_port)); }
+
+uint16_t per_gpio_get_port(uint8_t port) {
+
+    return port < GPIO_PORTS ? g_port[port] : 0;
+}
+
+void per_gpio_set(uint8_t port, uint8_t pin, bool state) {
+
+    if (port < GPIO_PORTS) {
+
+        if (state) {
+            g_port[port] |= 1 << pin;
+        } else {
+            g_port[port] &= ~(1 << pin);
+        }
+    }
+}
+
+void per_gpio_set_port(uint8_t port, uint16_t value) {
+
+    if (port < GPIO_PORTS) {
+        g_port[port] = value;
+    }
+}
+
+/*----- Static function implementations ------------------------------*/
+
+/*----- End of file --------------------------------------------------*/
@@ -0,0 +1,393 @@
+/*----------------------------------------------------------------------
+
+                     This file is part of Freetribe
+
+                https://github.com/bangcorrupt/freetribe
+
+                                License
+
+                   GNU AFFERO GENERAL PUBLIC LICENSE
+                      Version 3, 19 November 2007
+
+                           AGPL-3.0-or-later
+
+ Freetribe is free software: you can redistribute it and/or modify it
+under the terms of the GNU Affero General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+                  (at your option) any later version.
+
+     Freetribe is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty
+        of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+          See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+                       Copyright bangcorrupt 2024
+
+----------------------------------------------------------------------*/
+
+/**
+ * @file    sim_hostdp.c
+ *
+ * @brief   Host stand-in for BF523 Host DMA Port.
+ *
+ * Models the port registers as seen from the CPU bus, running
+ * each configured DMA against the buffer the firmware exposed,
+ * and plays the CPU side with the same ft_hostdp.c code the CPU
+ * runs.  Frames read from the Rx stream are written to the
+ * mailbox, and bytes read back from it go to the Tx stream.
+ */
+
+/*----- Includes -----------------------------------------------------*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ft_error.h"
+#include "ft_hostdp.h"
+#include "ft_protocol.h"
+
+#include "per_hostdp.h"
+#include "sim_hostdp.h"
+
+/*----- Macros -------------------------------------------------------*/
+
+/// Address reported for exposed buffer, L1 data bank A.
+#define SIM_HOSTDP_BASE 0xff800000
+
+/// Control, address low and high, count and modify.
+#define SIM_HOSTDP_CONFIG_WORDS 5
+
+/*----- Typedefs -----------------------------------------------------*/
+
+typedef struct {
+
+    // Buffer exposed by firmware.
+    uint8_t *window;
+    uint32_t length;
+
+    uint16_t config[SIM_HOSTDP_CONFIG_WORDS];
+    uint8_t config_count;
+
+    // DMA in progress.
+    uint32_t address;
+    uint16_t remaining;
+    int16_t modify;
+    bool write;
+
+    // Bus accesses, and words outside window.
+    uint32_t accesses;
+    uint32_t faults;
+
+} t_hostdp;
+
+/*----- Static variable definitions ----------------------------------*/
+
+static t_hostdp g_hostdp;
+
+static void _bus_write(bool config, uint16_t value);
+static uint16_t _bus_read(bool config);
+
+static const t_hostdp_bus g_bus = {_bus_write, _bus_read};
+
+static t_hostdp_link g_link;
+static bool g_link_open;
+
+static int g_rx_fd = -1;
+static FILE *g_tx_file;
+
+static bool g_rx_done;
+
+// Frame read from Rx stream, waiting for mailbox space.
+static uint8_t g_frame[PROTOCOL_ENCODED_MAX];
+static uint16_t g_frame_length;
+static bool g_frame_complete;
+
+/*----- Extern variable definitions ----------------------------------*/
+
+/*----- Static function prototypes -----------------------------------*/
+
+static uint8_t *_translate(uint32_t address);
+static void _read_frame(void);
+
+/*----- Extern function implementations ------------------------------*/
+
+void per_hostdp_init(void) { memset(&g_hostdp, 0, sizeof(g_hostdp)); }
+
+uint32_t per_hostdp_expose(void *buffer, uint32_t length) {
+
+    g_hostdp.window = buffer;
+    g_hostdp.length = length;
+
+    return SIM_HOSTDP_BASE;
+}
+
+/**
+ * @brief   Open byte streams, '-' selects stdin or stdout.
+ *
+ * @param[in]   rx_path     Bytes sent by CPU, or NULL.
+ * @param[in]   tx_path     Bytes sent by DSP, or NULL.
+ */
+t_status sim_hostdp_open(const char *rx_path, const char *tx_path) {
+
+    g_rx_done = rx_path == NULL;
+
+    if (rx_path != NULL) {
+
+        g_rx_fd = strcmp(rx_path, "-") == 0 ? STDIN_FILENO
+                                            : open(rx_path, O_RDONLY);
+        if (g_rx_fd < 0) {
+            return ERROR;
+        }
+        fcntl(g_rx_fd, F_SETFL, fcntl(g_rx_fd, F_GETFL) | O_NONBLOCK);
+    }
+
+    if (tx_path != NULL) {
+
+        g_tx_file =
+            strcmp(tx_path, "-") == 0 ? stdout : fopen(tx_path, "wb");
+
+        if (g_tx_file == NULL) {
+            return ERROR;
+        }
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief   Use open descriptors, e.g. pipes to a host test.
+ *
+ * @param[in]   rx_fd   Bytes sent by CPU.
+ * @param[in]   tx_fd   Bytes sent by DSP.
+ */
+t_status sim_hostdp_open_fd(int rx_fd, int tx_fd) {
+
+    g_rx_done = false;
+    g_rx_fd = rx_fd;
+
+    fcntl(g_rx_fd, F_SETFL, fcntl(g_rx_fd, F_GETFL) | O_NONBLOCK);
+
+    g_tx_file = fdopen(tx_fd, "wb");
+
+    if (g_tx_file == NULL) {
+        return ERROR;
+    }
+
+    setvbuf(g_tx_file, NULL, _IONBF, 0);
+
+    return SUCCESS;
+}
+
+/**
+ * @brief   Move frames through mailbox as the CPU would.
+ *
+ * @param[in]   accesses    Bus accesses available, may be exceeded
+ *                          by the last transfer.
+ *
+ * @return  Bus accesses used, 0 if nothing moved.
+ */
+uint32_t sim_hostdp_transfer(uint32_t accesses) {
+
+    uint8_t buffer[256];
+    uint16_t length;
+    uint32_t used = 0;
+    bool moved = true;
+
+    g_hostdp.accesses = 0;
+
+    // Mailbox ready when firmware has exposed it.
+    if (!g_link_open) {
+
+        if (g_hostdp.window == NULL ||
+            hostdp_open(&g_link, &g_bus, SIM_HOSTDP_BASE) != SUCCESS) {
+            return 0;
+        }
+        g_link_open = true;
+    }
+
+    while (moved && g_hostdp.accesses < accesses) {
+
+        moved = false;
+
+        _read_frame();
+
+        if (g_frame_complete &&
+            hostdp_send(&g_link, g_frame, g_frame_length) == SUCCESS) {
+
+            g_frame_length = 0;
+            g_frame_complete = false;
+            moved = true;
+        }
+
+        length = hostdp_receive(&g_link, buffer, sizeof(buffer));
+
+        if (length > 0) {
+
+            if (g_tx_file != NULL) {
+                fwrite(buffer, 1, length, g_tx_file);
+            }
+            moved = true;
+        }
+
+        if (moved) {
+            used = g_hostdp.accesses;
+        }
+    }
+
+    return used;
+}
+
+void sim_hostdp_close(void) {
+
+    if (g_hostdp.faults > 0) {
+        fprintf(stderr, "HostDP accesses outside mailbox: %u\n",
+                g_hostdp.faults);
+    }
+
+    if (g_rx_fd > STDIN_FILENO) {
+        close(g_rx_fd);
+    }
+    g_rx_fd = -1;
+
+    if (g_tx_file != NULL) {
+
+        if (g_tx_file != stdout) {
+            fclose(g_tx_file);
+        } else {
+            fflush(g_tx_file);
+        }
+        g_tx_file = NULL;
+    }
+}
+
+/*----- Static function implementations ------------------------------*/
+
+// Configuration words start a DMA, data words move one word each.
+static void _bus_write(bool config, uint16_t value) {
+
+    uint8_t *word;
+
+    g_hostdp.accesses++;
+
+    if (config) {
+
+        g_hostdp.config[g_hostdp.config_count++] = value;
+
+        if (g_hostdp.config_count == SIM_HOSTDP_CONFIG_WORDS) {
+
+            g_hostdp.config_count = 0;
+
+            if (g_hostdp.config[0] & HOSTDP_CONTROL_DMAEN) {
+
+                g_hostdp.write = g_hostdp.config[0] & HOSTDP_CONTROL_WNR;
+                g_hostdp.address =
+                    g_hostdp.config[1] | (uint32_t)g_hostdp.config[2] << 16;
+                g_hostdp.remaining = g_hostdp.config[3];
+                g_hostdp.modify = g_hostdp.config[4];
+            }
+        }
+        return;
+    }
+
+    if (g_hostdp.remaining == 0 || !g_hostdp.write) {
+        return;
+    }
+
+    word = _translate(g_hostdp.address);
+
+    if (word != NULL) {
+        word[0] = value & 0xff;
+        word[1] = value >> 8;
+    }
+
+    g_hostdp.address += g_hostdp.modify;
+    g_hostdp.remaining--;
+}
+
+static uint16_t _bus_read(bool config) {
+
+    uint8_t *word;
+    uint16_t value = 0;
+
+    g_hostdp.accesses++;
+
+    if (config) {
+        return g_hostdp.remaining == 0
+                   ? HOSTDP_STATUS_ALLOW_CONFIG | HOSTDP_STATUS_DMA_COMPLETE
+                   : HOSTDP_STATUS_DMA_READY;
+    }
+
+    if (g_hostdp.remaining == 0 || g_hostdp.write) {
+        return 0;
+    }
+
+    word = _translate(g_hostdp.address);
+
+    if (word != NULL) {
+        value = word[0] | word[1] << 8;
+    }
+
+    g_hostdp.address += g_hostdp.modify;
+    g_hostdp.remaining--;
+
+    return value;
+}
+
+// Host pointer to word at DSP address, or NULL outside window.
+static uint8_t *_translate(uint32_t address) {
+
+    uint32_t offset = address - SIM_HOSTDP_BASE;
+
+    if (address < SIM_HOSTDP_BASE || offset + 2 > g_hostdp.length) {
+        g_hostdp.faults++;
+        return NULL;
+    }
+
+    return &g_hostdp.window[offset];
+}
+
+// Gather bytes up to delimiter, as the CPU sends whole frames.
+static void _read_frame(void) {
+
+    uint8_t byte;
+    ssize_t result;
+
+    while (!g_frame_complete && !g_rx_done) {
+
+        result = read(g_rx_fd, &byte, 1);
+
+        if (result == 0 || (result < 0 && errno != EAGAIN)) {
+            g_rx_done = true;
+        }
+
+        if (result <= 0) {
+            break;
+        }
+
+        // Idle bytes carry nothing without SPI clocking.
+        if (byte == PROTOCOL_DELIMITER && g_frame_length == 0) {
+            continue;
+        }
+
+        g_frame[g_frame_length++] = byte;
+
+        if (byte == PROTOCOL_DELIMITER || g_frame_length == sizeof(g_frame)) {
+            g_frame_complete = true;
+        }
+    }
+
+    // Send partial frame at end of stream.
+    if (g_rx_done && g_frame_length > 0) {
+        g_frame_complete = true;
+    }
+}
+
+/*----- End of file --------------------------------------------------*/
@@ -0,0 +1,369 @@
+/*----------------------------------------------------------------------
+
+                     This file is part of Freetribe
+
+                https://github.com/bangcorrupt/freetribe
+
+                                License
+
+                   GNU AFFERO GENERAL PUBLIC LICENSE
+                      Version 3, 19 November 2007
+
+                           AGPL-3.0-or-later
+
+ Freetribe is free software: you can redistribute it and/or modify it
+under the terms of the GNU Affero General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+                  (at your option) any later version.
+
+     Freetribe is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty
+        of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+          See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+                       Copyright bangcorrupt 2024
+
+----------------------------------------------------------------------*/
+
+/**
+ * @file    sim_main.c
+ *
+ * @brief   Main function for host simulation of Blackfin firmware.
+ *
+ * Runs the kernel block loop as fast as the host allows,
+ * with audio from WAV files and CPU messages from byte
+ * streams, and reports the cost of each block.
+ */
+
+/*----- Includes -----------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "dev_cpu_hostdp.h"
+#include "module.h"
+#include "per_sport.h"
+#include "sim_bench.h"
+#include "sim_hostdp.h"
+#include "sim_spi.h"
+#include "sim_sport.h"
+#include "sim_wav.h"
+#include "svc_cpu.h"
+
+#include "knl_capture.h"
+#include "knl_event.h"
+#include "knl_profile.h"
+#include "knl_telemetry.h"
+#include "knl_region.h"
+
+/*----- Macros -------------------------------------------------------*/
+
+#define DEFAULT_SECONDS 60
+
+/// SPI bytes clocked per audio block, roughly 1 MHz SPI at 48 kHz.
+#define DEFAULT_SPI_BYTES 80
+
+/// HostDP bus accesses per audio block, roughly 5 M per second.
+#define DEFAULT_HOSTDP_ACCESSES 3200
+
+/// Blocks between Rx DMA and Tx DMA of the same samples.
+#define SPORT_LATENCY_BLOCKS 2
+
+/*----- Typedefs -----------------------------------------------------*/
+
+/*----- Static variable definitions ----------------------------------*/
+
+static t_sim_wav g_wav_in;
+static t_sim_wav g_wav_out;
+
+static bool g_wav_in_done;
+
+/*----- Extern variable definitions ----------------------------------*/
+
+/*----- Static function prototypes -----------------------------------*/
+
+static void _usage(const char *name);
+static void _report(void);
+
+static void _wav_rx_callback(fract32 *block);
+static void _wav_tx_callback(fract32 *block);
+
+/*----- Extern function implementations ------------------------------*/
+
+int main(int argc, char **argv) {
+
+    uint64_t start;
+    uint64_t stop;
+    uint64_t blocks = 0;
+    uint64_t flush = 0;
+
+    const char *wav_in_path = NULL;
+    const char *wav_out_path = NULL;
+    const char *spi_rx_path = NULL;
+    const char *spi_tx_path = NULL;
+
+    double seconds = 0;
+    uint32_t link_budget = 0;
+    uint32_t bench_count = 0;
+    uint32_t transferred;
+    uint32_t used;
+    bool hostdp = false;
+
+    int opt;
+
+    while ((opt = getopt(argc, argv, "i:o:c:r:b:de:s:h")) != -1) {
+
+        switch (opt) {
+
+        case 'i':
+            wav_in_path = optarg;
+            break;
+
+        case 'o':
+            wav_out_path = optarg;
+            break;
+
+        case 'c':
+            spi_rx_path = optarg;
+            break;
+
+        case 'r':
+            spi_tx_path = optarg;
+            break;
+
+        case 'b':
+            link_budget = strtoul(optarg, NULL, 0);
+            break;
+
+        case 'd':
+            hostdp = true;
+            break;
+
+        case 'e':
+            bench_count = strtoul(optarg, NULL, 0);
+            break;
+
+        case 's':
+            seconds = atof(optarg);
+            break;
+
+        default:
+            _usage(argv[0]);
+            return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+    // Run for length of input, unless duration given.
+    if (seconds == 0 && wav_in_path == NULL) {
+        seconds = DEFAULT_SECONDS;
+    }
+
+    if (wav_in_path != NULL) {
+
+        if (sim_wav_open_read(&g_wav_in, wav_in_path) != SUCCESS) {
+            fprintf(stderr, "Failed to open %s\n", wav_in_path);
+            return EXIT_FAILURE;
+        }
+        if (g_wav_in.rate != SAMPLERATE) {
+            fprintf(stderr, "Warning: %s is %u Hz, not resampled to %u Hz\n",
+                    wav_in_path, g_wav_in.rate, SAMPLERATE);
+        }
+        sim_sport_register_callback(SIM_SPORT_RX_BLOCK, _wav_rx_callback);
+    }
+
+    if (wav_out_path != NULL) {
+
+        if (sim_wav_open_write(&g_wav_out, wav_out_path, SPORT0_CHANNELS,
+                               SAMPLERATE) != SUCCESS) {
+            fprintf(stderr, "Failed to open %s\n", wav_out_path);
+            return EXIT_FAILURE;
+        }
+        sim_sport_register_callback(SIM_SPORT_TX_BLOCK, _wav_tx_callback);
+    }
+
+    if (link_budget == 0) {
+        link_budget = hostdp ? DEFAULT_HOSTDP_ACCESSES : DEFAULT_SPI_BYTES;
+    }
+
+    if (bench_count > 0) {
+
+        // Benchmark replaces CPU byte streams.
+        if (sim_bench_open(bench_count, hostdp) != SUCCESS) {
+            fprintf(stderr, "Failed to open echo benchmark\n");
+            return EXIT_FAILURE;
+        }
+
+    } else if (hostdp) {
+
+        if (sim_hostdp_open(spi_rx_path, spi_tx_path) != SUCCESS) {
+            fprintf(stderr, "Failed to open HostDP stream\n");
+            return EXIT_FAILURE;
+        }
+
+    } else if (sim_spi_open(spi_rx_path, spi_tx_path) != SUCCESS) {
+        fprintf(stderr, "Failed to open SPI stream\n");
+        return EXIT_FAILURE;
+    }
+
+    if (hostdp) {
+        // Host has already selected HostDP, as after mailbox request.
+        dev_cpu_hostdp_init();
+    }
+
+    knl_region_init();
+
+    // Initialise communication with CPU.
+    svc_cpu_task();
+
+    sport0_init();
+
+    module_init();
+
+    while (!sim_bench_done() &&
+           (seconds > 0 ? blocks < (uint64_t)(seconds * SAMPLERATE) /
+                                       SPORT_BLOCK_SIZE
+                        : flush < SPORT_LATENCY_BLOCKS)) {
+
+        // Drain output still in DMA buffers after end of input.
+        if (g_wav_in_done) {
+            flush++;
+        }
+
+        // Stand-in for SPORT0 Rx DMA interrupt.
+        sim_sport_dma_complete();
+
+        if (sport0_block_received()) {
+
+            start = cycles();
+
+            knl_event_process(sport0_get_rx_buffer(), sport0_get_tx_buffer(),
+                              SPORT_BLOCK_SIZE);
+
+            // Tap block for capture stream.
+            knl_capture_process(sport0_get_rx_buffer(), sport0_get_tx_buffer(),
+                                SPORT_BLOCK_SIZE);
+
+            // Measure levels for telemetry.
+            knl_telemetry_process(sport0_get_rx_buffer(),
+                                  sport0_get_tx_buffer(), SPORT_BLOCK_SIZE);
+
+            sport0_block_processed();
+
+            stop = cycles();
+
+            knl_profile_update(stop - start);
+        }
+
+        // Stand-in for CPU sending echo requests.
+        sim_bench_task();
+
+        // Stand-in for CPU bus accesses during block period.
+        // Firmware polls the mailbox between bursts.
+        for (transferred = 0; hostdp && transferred < link_budget;
+             transferred += used) {
+
+            used = sim_hostdp_transfer(link_budget - transferred);
+
+            // Process communication with CPU.
+            svc_cpu_task();
+
+            if (used == 0) {
+                break;
+            }
+        }
+
+        // Stand-in for SPI interrupts during block period.
+        // Firmware main loop runs many times per byte,
+        // so handle each byte before the next arrives.
+        for (transferred = 0; !hostdp && transferred < link_budget;
+             transferred++) {
+
+            if (sim_spi_transfer(1) == 0) {
+
+                // Main loop still runs while link idle, e.g. capture.
+                svc_cpu_task();
+                break;
+            }
+
+            // Process communication with CPU.
+            svc_cpu_task();
+        }
+
+        blocks++;
+    }
+
+    _report();
+
+    sim_spi_close();
+    sim_hostdp_close();
+    sim_bench_close();
+    sim_wav_close(&g_wav_in);
+    sim_wav_close(&g_wav_out);
+
+    return EXIT_SUCCESS;
+}
+
+/*----- Static function implementations ------------------------------*/
+
+static void _usage(const char *name) {
+
+    fprintf(stderr,
+            "Usage: %s [-i in.wav] [-o out.wav] [-c cpu_rx] [-r cpu_tx]\n"
+            "          [-b transfers] [-d] [-e count] [-s seconds]\n"
+            "\n"
+            "  -i  Audio input, run until end unless -s given.\n"
+            "  -o  Audio output, 32 bit stereo at %u Hz.\n"
+            "  -c  Bytes from CPU, file or pipe, '-' for stdin.\n"
+            "  -r  Bytes to CPU, '-' for stdout.\n"
+            "  -b  SPI bytes or HostDP accesses per block,\n"
+            "      default %u or %u.\n"
+            "  -d  CPU streams over HostDP mailbox instead of SPI.\n"
+            "  -e  Echo benchmark, count requests per payload length.\n"
+            "  -s  Duration in seconds, default %u without input.\n",
+            name, SAMPLERATE, DEFAULT_SPI_BYTES, DEFAULT_HOSTDP_ACCESSES,
+            DEFAULT_SECONDS);
+}
+
+static void _report(void) {
+
+    t_profile_ext stats = knl_profile_stats_ext();
+
+    if (stats.blocks == 0) {
+        return;
+    }
+
+    fprintf(stderr, "Block size:     %u frames\n", SPORT_BLOCK_SIZE);
+    fprintf(stderr, "Blocks:         %u\n", stats.blocks);
+    fprintf(stderr, "Block period:   %u ns\n", stats.period);
+    fprintf(stderr, "Block cost:     min %u ns, mean %u ns, max %u ns\n",
+            stats.min, stats.mean, stats.max);
+    fprintf(stderr, "Block cost p%u:  %u ns\n", CYCLE_PERCENTILE,
+            stats.percentile);
+    fprintf(stderr, "Frame cost:     %.1f ns\n",
+            (double)stats.mean / SPORT_BLOCK_SIZE);
+    fprintf(stderr, "Host load:      %.3f %%\n",
+            100.0 * stats.mean / stats.period);
+    fprintf(stderr, "Overruns:       %u\n", stats.overruns);
+}
+
+static void _wav_rx_callback(fract32 *block) {
+
+    if (sim_wav_read(&g_wav_in, block, SPORT0_CHANNELS, SPORT_BLOCK_SIZE) <
+        SPORT_BLOCK_SIZE) {
+
+        g_wav_in_done = true;
+    }
+}
+
+static void _wav_tx_callback(fract32 *block) {
+
+    sim_wav_write(&g_wav_out, block, SPORT0_CHANNELS, SPORT_BLOCK_SIZE);
+}
+
+/*----- End of file --------------------------------------------------*/
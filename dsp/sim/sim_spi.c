@@ -0,0 +1,255 @@
+/*----------------------------------------------------------------------
+
+                     This file is part of Freetribe
+
+                https://github.com/bangcorrupt/freetribe
+
+                                License
+
+                   GNU AFFERO GENERAL PUBLIC LICENSE
+                      Version 3, 19 November 2007
+
+                           AGPL-3.0-or-later
+
+ Freetribe is free software: you can redistribute it and/or modify it
+under the terms of the GNU Affero General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+                  (at your option) any later version.
+
+     Freetribe is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty
+        of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+          See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+                       Copyright bangcorrupt 2024
+
+----------------------------------------------------------------------*/
+
+/**
+ * @file    sim_spi.c
+ *
+ * @brief   Host stand-in for BF523 SPI.
+ *
+ * Each byte read from the Rx stream is shifted in as if sent
+ * by the CPU, and the byte shifted out in return is written
+ * to the Tx stream.  As on hardware, the DSP only transmits
+ * while the CPU clocks, so append zero bytes to the Rx stream
+ * to collect responses.
+ */
+
+/*----- Includes -----------------------------------------------------*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ft_error.h"
+
+#include "per_gpio.h"
+#include "per_spi.h"
+#include "sim_spi.h"
+
+/*----- Macros -------------------------------------------------------*/
+
+/*----- Typedefs -----------------------------------------------------*/
+
+typedef struct {
+
+    t_spi_stream *stream;
+
+    // Byte loaded for next transfer, as SPI_TDBR.
+    uint8_t tdbr;
+
+    void (*error_callback)();
+
+} t_spi;
+
+/*----- Static variable definitions ----------------------------------*/
+
+static t_spi g_spi;
+
+static int g_rx_fd = -1;
+static FILE *g_tx_file;
+
+static bool g_rx_done;
+
+/*----- Extern variable definitions ----------------------------------*/
+
+/*----- Static function prototypes -----------------------------------*/
+
+/*----- Extern function implementations ------------------------------*/
+
+void per_spi_init(void) { memset(&g_spi, 0, sizeof(g_spi)); }
+
+void per_spi_stream(t_spi_stream *stream) {
+
+    if (stream != NULL && stream->rx_buffer != NULL &&
+        stream->tx_buffer != NULL) {
+
+        g_spi.stream = stream;
+    }
+}
+
+void per_spi_register_callback(t_spi_event event, void (*callback)()) {
+
+    switch (event) {
+
+    case EVT_SPI_ERROR:
+        g_spi.error_callback = callback;
+        break;
+
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief   Open byte streams, '-' selects stdin or stdout.
+ *
+ * The Rx stream is read without blocking, so a pipe
+ * may be fed while the simulation runs.
+ *
+ * @param[in]   rx_path     Bytes sent by CPU, or NULL.
+ * @param[in]   tx_path     Bytes sent by DSP, or NULL.
+ */
+t_status sim_spi_open(const char *rx_path, const char *tx_path) {
+
+    g_rx_done = rx_path == NULL;
+
+    if (rx_path != NULL) {
+
+        g_rx_fd = strcmp(rx_path, "-") == 0 ? STDIN_FILENO
+                                            : open(rx_path, O_RDONLY);
+        if (g_rx_fd < 0) {
+            return ERROR;
+        }
+        fcntl(g_rx_fd, F_SETFL, fcntl(g_rx_fd, F_GETFL) | O_NONBLOCK);
+    }
+
+    if (tx_path != NULL) {
+
+        g_tx_file =
+            strcmp(tx_path, "-") == 0 ? stdout : fopen(tx_path, "wb");
+
+        if (g_tx_file == NULL) {
+            return ERROR;
+        }
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief   Use open descriptors, e.g. pipes to a host test.
+ *
+ * The Tx stream is unbuffered, so each byte is visible to
+ * the reader as soon as it is clocked.
+ *
+ * @param[in]   rx_fd   Bytes sent by CPU.
+ * @param[in]   tx_fd   Bytes sent by DSP.
+ */
+t_status sim_spi_open_fd(int rx_fd, int tx_fd) {
+
+    g_rx_done = false;
+    g_rx_fd = rx_fd;
+
+    fcntl(g_rx_fd, F_SETFL, fcntl(g_rx_fd, F_GETFL) | O_NONBLOCK);
+
+    g_tx_file = fdopen(tx_fd, "wb");
+
+    if (g_tx_file == NULL) {
+        return ERROR;
+    }
+
+    setvbuf(g_tx_file, NULL, _IONBF, 0);
+
+    return SUCCESS;
+}
+
+/**
+ * @brief   Clock bytes available on the Rx stream.
+ *
+ * @param[in]   length  Maximum number of bytes to transfer.
+ *
+ * @return  Number of bytes transferred.
+ */
+uint32_t sim_spi_transfer(uint32_t length) {
+
+    t_spi_stream *stream = g_spi.stream;
+    uint32_t count = 0;
+    uint8_t byte;
+    ssize_t result;
+
+    // Streaming starts when driver initialised.
+    while (count < length && stream != NULL) {
+
+        result = g_rx_done ? 0 : read(g_rx_fd, &byte, 1);
+
+        if (result == 0 || (result < 0 && errno != EAGAIN)) {
+            g_rx_done = true;
+        }
+
+        if (result <= 0) {
+            // Model CPU, clock dummy bytes while DSP signals data ready.
+            if (!(per_gpio_get_port(PORT_G) & (1 << DATA_READY_PIN))) {
+                // Pipe is empty, try again next block.
+                break;
+            }
+            byte = 0;
+        }
+
+        if (g_tx_file != NULL) {
+            fputc(g_spi.tdbr, g_tx_file);
+        }
+
+        count++;
+
+        // As per_spi.c interrupt handler.
+        stream->rx_buffer[stream->rx_head & stream->rx_mask] = byte;
+        stream->rx_head++;
+
+        if (stream->tx_tail != stream->tx_head) {
+
+            g_spi.tdbr = stream->tx_buffer[stream->tx_tail & stream->tx_mask];
+            stream->tx_tail++;
+
+        } else {
+            g_spi.tdbr = 0;
+
+            per_gpio_set(PORT_G, DATA_READY_PIN, false);
+        }
+    }
+
+    return count;
+}
+
+bool sim_spi_rx_done(void) { return g_rx_done; }
+
+void sim_spi_close(void) {
+
+    if (g_rx_fd > STDIN_FILENO) {
+        close(g_rx_fd);
+    }
+    g_rx_fd = -1;
+
+    if (g_tx_file != NULL) {
+
+        if (g_tx_file != stdout) {
+            fclose(g_tx_file);
+        } else {
+            fflush(g_tx_file);
+        }
+        g_tx_file = NULL;
+    }
+}
+
+/*----- Static function implementations ------------------------------*/
+
+/*----- End of file --------------------------------------------------*/
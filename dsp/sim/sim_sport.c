@@ -0,0 +1,174 @@
+/*----------------------------------------------------------------------
+
+                     This file is part of Freetribe
+
+                https://github.com/bangcorrupt/freetribe
+
+                                License
+
+                   GNU AFFERO GENERAL PUBLIC LICENSE
+                      Version 3, 19 November 2007
+
+                           AGPL-3.0-or-later
+
+ Freetribe is free software: you can redistribute it and/or modify it
+under the terms of the GNU Affero General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+                  (at your option) any later version.
+
+     Freetribe is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty
+        of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+          See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+                       Copyright bangcorrupt 2024
+
+----------------------------------------------------------------------*/
+
+/**
+ * @file    sim_sport.c
+ *
+ * @brief   Host stand-in for SPORT0 audio DMA.
+ *
+ * Mirrors the ping-pong buffering of per_sport.c.  Each call to
+ * sim_sport_dma_complete() stands in for the Rx DMA completing
+ * one half of the buffer, exchanging blocks with registered
+ * callbacks instead of the codec.
+ */
+
+/*----- Includes -----------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "module.h"
+#include "types.h"
+
+#include "per_sport.h"
+#include "sim_sport.h"
+
+#include "knl_profile.h"
+
+/*----- Macros -------------------------------------------------------*/
+
+/// Nominal block period in nanoseconds, matches host cycles().
+#define SIM_SPORT_PERIOD                                                       \
+    ((uint64_t)SPORT_BLOCK_SIZE * 1000000000ULL / SAMPLERATE)
+
+/*----- Typedefs -----------------------------------------------------*/
+
+/*----- Static variable definitions ----------------------------------*/
+
+// Ping-pong buffers, as seen by SPORT0 DMA.
+static fract32 g_codec_tx_buffer[2][SPORT0_BLOCK_WORDS];
+static fract32 g_codec_rx_buffer[2][SPORT0_BLOCK_WORDS];
+
+// Index of next half to be completed by DMA.
+static uint8_t g_sport0_dma_index = 0;
+// Index of half ready for processing.
+static uint8_t g_sport0_block_index = 0;
+
+static bool g_sport0_block_received = false;
+
+static uint32_t g_overruns;
+
+static uint64_t g_block_start;
+
+static t_sim_sport_callback p_rx_callback;
+static t_sim_sport_callback p_tx_callback;
+
+/*----- Extern variable definitions ----------------------------------*/
+
+/*----- Static function prototypes -----------------------------------*/
+
+/*----- Extern function implementations ------------------------------*/
+
+void sport0_init(void) {
+
+    memset(g_codec_rx_buffer, 0, sizeof(g_codec_rx_buffer));
+    memset(g_codec_tx_buffer, 0, sizeof(g_codec_tx_buffer));
+
+    g_sport0_dma_index = 0;
+    g_sport0_block_index = 0;
+    g_sport0_block_received = false;
+    g_overruns = 0;
+}
+
+fract32 *sport0_get_rx_buffer(void) {
+
+    return g_codec_rx_buffer[g_sport0_block_index];
+}
+
+fract32 *sport0_get_tx_buffer(void) {
+
+    return g_codec_tx_buffer[g_sport0_block_index];
+}
+
+bool sport0_block_received(void) { return g_sport0_block_received; }
+
+void sport0_block_processed(void) { g_sport0_block_received = false; }
+
+uint64_t sport0_period(void) { return SIM_SPORT_PERIOD; }
+
+uint64_t sport0_block_start(void) { return g_block_start; }
+
+uint32_t sport0_overruns(void) { return g_overruns; }
+
+void sim_sport_register_callback(t_sim_sport_event event,
+                                 t_sim_sport_callback callback) {
+
+    switch (event) {
+
+    case SIM_SPORT_RX_BLOCK:
+        p_rx_callback = callback;
+        break;
+
+    case SIM_SPORT_TX_BLOCK:
+        p_tx_callback = callback;
+        break;
+
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief   Complete DMA transfer of one block.
+ *
+ * Fill the Rx half from the source, drain the Tx half
+ * to the sink, then swap halves as the SPORT0 ISR does.
+ */
+void sim_sport_dma_complete(void) {
+
+    uint8_t index = g_sport0_dma_index;
+
+    if (p_rx_callback != NULL) {
+        p_rx_callback(g_codec_rx_buffer[index]);
+    } else {
+        memset(g_codec_rx_buffer[index], 0, sizeof(g_codec_rx_buffer[index]));
+    }
+
+    if (p_tx_callback != NULL) {
+        p_tx_callback(g_codec_tx_buffer[index]);
+    }
+
+    // Previous block was not processed in time.
+    if (g_sport0_block_received) {
+        g_overruns++;
+    }
+
+    g_sport0_block_index = index;
+    g_sport0_dma_index ^= 1;
+
+    g_sport0_block_received = true;
+
+    g_block_start = cycles();
+}
+
+/*----- Static function implementations ------------------------------*/
+
+/*----- End of file --------------------------------------------------*/
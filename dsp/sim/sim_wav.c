@@ -0,0 +1,371 @@
+/*----------------------------------------------------------------------
+
+                     This file is part of Freetribe
+
+                https://github.com/bangcorrupt/freetribe
+
+                                License
+
+                   GNU AFFERO GENERAL PUBLIC LICENSE
+                      Version 3, 19 November 2007
+
+                           AGPL-3.0-or-later
+
+ Freetribe is free software: you can redistribute it and/or modify it
+under the terms of the GNU Affero General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+                  (at your option) any later version.
+
+     Freetribe is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty
+        of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+          See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+                       Copyright bangcorrupt 2024
+
+----------------------------------------------------------------------*/
+
+/**
+ * @file    sim_wav.c
+ *
+ * @brief   WAV file access for host simulation.
+ *
+ * Reads 16, 24 and 32 bit integer or 32 bit float PCM,
+ * writes 32 bit integer PCM.  Samples are converted to
+ * and from full scale fract32.
+ */
+
+/*----- Includes -----------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "ft_error.h"
+#include "types.h"
+
+#include "sim_wav.h"
+
+/*----- Macros -------------------------------------------------------*/
+
+#define WAV_HEADER_LENGTH 44
+
+#define WAV_FORMAT_PCM 0x0001
+#define WAV_FORMAT_FLOAT 0x0003
+#define WAV_FORMAT_EXTENSIBLE 0xfffe
+
+/// Largest supported sample, in bytes.
+#define WAV_MAX_SAMPLE 4
+
+/*----- Typedefs -----------------------------------------------------*/
+
+/*----- Static variable definitions ----------------------------------*/
+
+
+/*----- Extern variable definitions ----------------------------------*/
+
+/*----- Static function prototypes -----------------------------------*/
+
+static uint16_t _get_u16(const uint8_t *bytes);
+static uint32_t _get_u32(const uint8_t *bytes);
+static void _put_u16(uint8_t *bytes, uint16_t value);
+static void _put_u32(uint8_t *bytes, uint32_t value);
+
+static fract32 _decode_sample(t_sim_wav *wav, const uint8_t *bytes);
+static void _write_header(t_sim_wav *wav);
+
+/*----- Extern function implementations ------------------------------*/
+
+t_status sim_wav_open_read(t_sim_wav *wav, const char *path) {
+
+    uint8_t chunk[8];
+    uint8_t riff[12];
+    uint8_t fmt[16];
+
+    uint32_t length;
+    uint16_t format;
+
+    bool fmt_found = false;
+
+    memset(wav, 0, sizeof(*wav));
+
+    wav->file = fopen(path, "rb");
+
+    if (wav->file == NULL) {
+        return ERROR;
+    }
+
+    if (fread(riff, sizeof(riff), 1, wav->file) != 1 ||
+        memcmp(riff, "RIFF", 4) != 0 || memcmp(riff + 8, "WAVE", 4) != 0) {
+
+        sim_wav_close(wav);
+        return ERROR;
+    }
+
+    // Walk chunks until sample data.
+    while (fread(chunk, sizeof(chunk), 1, wav->file) == 1) {
+
+        length = _get_u32(chunk + 4);
+
+        if (memcmp(chunk, "fmt ", 4) == 0 && length >= sizeof(fmt)) {
+
+            if (fread(fmt, sizeof(fmt), 1, wav->file) != 1) {
+                break;
+            }
+
+            format = _get_u16(fmt);
+            wav->channels = _get_u16(fmt + 2);
+            wav->rate = _get_u32(fmt + 4);
+            wav->bits = _get_u16(fmt + 14);
+
+            wav->is_float = format == WAV_FORMAT_FLOAT;
+
+            // Extensible format, assume sub format matches sample size.
+            if (format == WAV_FORMAT_EXTENSIBLE) {
+                wav->is_float = false;
+                format = WAV_FORMAT_PCM;
+            }
+
+            if ((format != WAV_FORMAT_PCM && format != WAV_FORMAT_FLOAT) ||
+                (wav->is_float && wav->bits != 32) ||
+                (wav->bits != 16 && wav->bits != 24 && wav->bits != 32) ||
+                wav->channels == 0) {
+                break;
+            }
+
+            fmt_found = true;
+
+            // Chunks are padded to even length.
+            fseek(wav->file, (length - sizeof(fmt)) + (length & 1), SEEK_CUR);
+
+        } else if (memcmp(chunk, "data", 4) == 0 && fmt_found) {
+
+            wav->data_length = length;
+            return SUCCESS;
+
+        } else {
+            fseek(wav->file, length + (length & 1), SEEK_CUR);
+        }
+    }
+
+    sim_wav_close(wav);
+    return ERROR;
+}
+
+t_status sim_wav_open_write(t_sim_wav *wav, const char *path,
+                            uint16_t channels, uint32_t rate) {
+
+    memset(wav, 0, sizeof(*wav));
+
+    wav->file = fopen(path, "wb");
+
+    if (wav->file == NULL) {
+        return ERROR;
+    }
+
+    wav->channels = channels;
+    wav->bits = 32;
+    wav->rate = rate;
+    wav->write = true;
+
+    // Placeholder, lengths are filled in on close.
+    _write_header(wav);
+
+    return SUCCESS;
+}
+
+/**
+ * @brief   Read interleaved frames.
+ *
+ * Mono files are copied to every channel, other missing
+ * channels are zeroed and extra channels are discarded.
+ *
+ * @param[in]   wav         WAV file opened for read.
+ * @param[out]  frames      Buffer of 'count' * 'channels' samples.
+ * @param[in]   channels    Number of channels in each frame.
+ * @param[in]   count       Number of frames to read.
+ *
+ * @return  Number of frames read from file.
+ */
+uint32_t sim_wav_read(t_sim_wav *wav, fract32 *frames, uint16_t channels,
+                      uint32_t count) {
+
+    uint8_t sample[WAV_MAX_SAMPLE];
+    uint16_t sample_length = wav->bits / 8;
+    uint32_t frame_length = sample_length * wav->channels;
+
+    uint32_t read = 0;
+    uint16_t channel;
+    fract32 value = 0;
+
+    while (read < count && wav->data_length >= frame_length) {
+
+        for (channel = 0; channel < wav->channels; channel++) {
+
+            if (fread(sample, sample_length, 1, wav->file) != 1) {
+                wav->data_length = 0;
+                break;
+            }
+            value = _decode_sample(wav, sample);
+
+            if (channel < channels) {
+                frames[channel] = value;
+            }
+        }
+
+        if (wav->data_length == 0) {
+            break;
+        }
+        wav->data_length -= frame_length;
+
+        for (; channel < channels; channel++) {
+            frames[channel] = wav->channels == 1 ? value : 0;
+        }
+
+        frames += channels;
+        read++;
+    }
+
+    // Silence after end of file.
+    memset(frames, 0, (count - read) * channels * sizeof(fract32));
+
+    return read;
+}
+
+uint32_t sim_wav_write(t_sim_wav *wav, const fract32 *frames,
+                       uint16_t channels, uint32_t count) {
+
+    uint8_t sample[WAV_MAX_SAMPLE];
+
+    uint32_t written;
+    uint16_t channel;
+
+    for (written = 0; written < count; written++) {
+
+        for (channel = 0; channel < wav->channels; channel++) {
+
+            _put_u32(sample, channel < channels ? frames[channel] : 0);
+
+            if (fwrite(sample, sizeof(sample), 1, wav->file) != 1) {
+                return written;
+            }
+        }
+
+        wav->data_length += sizeof(sample) * wav->channels;
+        frames += channels;
+    }
+
+    return written;
+}
+
+void sim_wav_close(t_sim_wav *wav) {
+
+    if (wav->file != NULL) {
+
+        if (wav->write) {
+            rewind(wav->file);
+            _write_header(wav);
+        }
+
+        fclose(wav->file);
+        wav->file = NULL;
+    }
+}
+
+/*----- Static function implementations ------------------------------*/
+
+static uint16_t _get_u16(const uint8_t *bytes) {
+
+    return bytes[0] | (bytes[1] << 8);
+}
+
+static uint32_t _get_u32(const uint8_t *bytes) {
+
+    return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) |
+           ((uint32_t)bytes[3] << 24);
+}
+
+static void _put_u16(uint8_t *bytes, uint16_t value) {
+
+    bytes[0] = value & 0xff;
+    bytes[1] = (value >> 8) & 0xff;
+}
+
+static void _put_u32(uint8_t *bytes, uint32_t value) {
+
+    bytes[0] = value & 0xff;
+    bytes[1] = (value >> 8) & 0xff;
+    bytes[2] = (value >> 16) & 0xff;
+    bytes[3] = (value >> 24) & 0xff;
+}
+
+static fract32 _decode_sample(t_sim_wav *wav, const uint8_t *bytes) {
+
+    uint32_t word = 0;
+    float value;
+
+    switch (wav->bits) {
+
+    case 16:
+        word = (uint32_t)_get_u16(bytes) << 16;
+        break;
+
+    case 24:
+        word = ((uint32_t)bytes[0] << 8) | ((uint32_t)bytes[1] << 16) |
+               ((uint32_t)bytes[2] << 24);
+        break;
+
+    case 32:
+        word = _get_u32(bytes);
+        break;
+
+    default:
+        break;
+    }
+
+    if (wav->is_float) {
+
+        memcpy(&value, &word, sizeof(value));
+
+        if (value >= 1.0f) {
+            return 0x7fffffff;
+        }
+        if (value <= -1.0f) {
+            return (fract32)0x80000000;
+        }
+        return (fract32)(value * 2147483648.0f);
+    }
+
+    return (fract32)word;
+}
+
+static void _write_header(t_sim_wav *wav) {
+
+    uint8_t header[WAV_HEADER_LENGTH];
+
+    uint16_t block_align = wav->channels * wav->bits / 8;
+
+    memcpy(header, "RIFF", 4);
+    _put_u32(header + 4, WAV_HEADER_LENGTH - 8 + wav->data_length);
+    memcpy(header + 8, "WAVE", 4);
+
+    memcpy(header + 12, "fmt ", 4);
+    _put_u32(header + 16, 16);
+    _put_u16(header + 20, WAV_FORMAT_PCM);
+    _put_u16(header + 22, wav->channels);
+    _put_u32(header + 24, wav->rate);
+    _put_u32(header + 28, wav->rate * block_align);
+    _put_u16(header + 32, block_align);
+    _put_u16(header + 34, wav->bits);
+
+    memcpy(header + 36, "data", 4);
+    _put_u32(header + 40, wav->data_length);
+
+    fwrite(header, sizeof(header), 1, wav->file);
+}
+
+/*----- End of file --------------------------------------------------*/
@@ -0,0 +1,96 @@
+/*----------------------------------------------------------------------
+
+                     This file is part of Freetribe
+
+                https://github.com/bangcorrupt/freetribe
+
+                                License
+
+                   GNU AFFERO GENERAL PUBLIC LICENSE
+                      Version 3, 19 November 2007
+
+                           AGPL-3.0-or-later
+
+ Freetribe is free software: you can redistribute it and/or modify it
+under the terms of the GNU Affero General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+                  (at your option) any later version.
+
+     Freetribe is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty
+        of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+          See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+                       Copyright bangcorrupt 2024
+
+----------------------------------------------------------------------*/
+
+/**
+ * @file    sim_wav.h
+ *
+ * @brief   Public API for WAV file access in host simulation.
+ */
+
+#ifndef SIM_WAV_H
+#define SIM_WAV_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*----- Includes -----------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "ft_error.h"
+#include "types.h"
+
+/*----- Macros -------------------------------------------------------*/
+
+/*----- Typedefs -----------------------------------------------------*/
+
+typedef struct {
+
+    FILE *file;
+
+    uint16_t channels;
+    uint16_t bits;
+    uint32_t rate;
+
+    // 32 bit float samples.
+    bool is_float;
+
+    // Size of sample data in bytes.
+    uint32_t data_length;
+
+    // Write access, header is updated on close.
+    bool write;
+
+} t_sim_wav;
+
+/*----- Extern variable declarations ---------------------------------*/
+
+/*----- Extern function prototypes -----------------------------------*/
+
+t_status sim_wav_open_read(t_sim_wav *wav, const char *path);
+t_status sim_wav_open_write(t_sim_wav *wav, const char *path,
+                            uint16_t channels, uint32_t rate);
+
+uint32_t sim_wav_read(t_sim_wav *wav, fract32 *frames, uint16_t channels,
+                      uint32_t count);
+uint32_t sim_wav_write(t_sim_wav *wav, const fract32 *frames,
+                       uint16_t channels, uint32_t count);
+
+void sim_wav_close(t_sim_wav *wav);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
+
+/*----- End of file --------------------------------------------------*/
@@ -0,0 +1,179 @@
+/*----------------------------------------------------------------------
+
+                     This file is part of Freetribe
+
+                https://github.com/bangcorrupt/freetribe
+
+                                License
+
+                   GNU AFFERO GENERAL PUBLIC LICENSE
+                      Version 3, 19 November 2007
+
+                           AGPL-3.0-or-later
+
+ Freetribe is free software: you can redistribute it and/or modify it
+under the terms of the GNU Affero General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+                  (at your option) any later version.
+
+     Freetribe is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty
+        of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+          See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+                       Copyright bangcorrupt 2024
+
+----------------------------------------------------------------------*/
+
+/**
+ * @file    dev_cpu_hostdp.c
+ *
+ * @brief   Device driver for communicating with CPU via Host DMA Port.
+ *
+ * The CPU writes frames into the mailbox and reads responses
+ * out of it, see ft_hostdp.c.  Here the mailbox is plain memory.
+ */
+
+/*----- Includes -----------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "ft_hostdp.h"
+
+#include "per_hostdp.h"
+
+#include "dev_cpu_hostdp.h"
+
+/*----- Macros -------------------------------------------------------*/
+
+/*----- Typedefs -----------------------------------------------------*/
+
+/*----- Static variable definitions ----------------------------------*/
+
+static t_hostdp_mailbox g_mailbox;
+
+// Address reported to CPU.
+static uint32_t g_mailbox_address;
+
+static bool g_enabled;
+
+/*----- Extern variable definitions ----------------------------------*/
+
+/*----- Static function prototypes -----------------------------------*/
+
+/*----- Extern function implementations ------------------------------*/
+
+/**
+ * @brief   Enable host port and expose mailbox, once.
+ *
+ * Called when the CPU requests the mailbox, so the port mux is
+ * untouched unless the CPU selects HostDP.
+ */
+void dev_cpu_hostdp_init(void) {
+
+    // Repeat request must not clear frames in flight.
+    if (g_enabled) {
+        return;
+    }
+
+    memset(&g_mailbox, 0, sizeof(g_mailbox));
+
+    per_hostdp_init();
+
+    g_mailbox_address = per_hostdp_expose(&g_mailbox, sizeof(g_mailbox));
+
+    // CPU checks magic before first transfer.
+    g_mailbox.magic = HOSTDP_MAGIC;
+
+    g_enabled = true;
+}
+
+uint32_t dev_cpu_hostdp_address(void) { return g_mailbox_address; }
+
+/// Bytes free in ring to CPU.
+uint32_t dev_cpu_hostdp_tx_free(void) {
+
+    t_hostdp_ring *ring = &g_mailbox.to_cpu;
+
+    return HOSTDP_RING_LEN - (uint16_t)(ring->head - ring->tail);
+}
+
+/**
+ * @brief   Queue bytes for CPU to read.
+ *
+ * @param[in]   data    Bytes to send, e.g. an encoded frame.
+ * @param[in]   length  Number of bytes, odd length is padded.
+ *
+ * @return  ERROR if bytes do not fit, nothing is queued.
+ */
+t_status dev_cpu_hostdp_tx_enqueue(const uint8_t *data, uint32_t length) {
+
+    t_hostdp_ring *ring = &g_mailbox.to_cpu;
+    uint16_t head = ring->head;
+    uint32_t i;
+
+    if (HOSTDP_RING_LEN - (uint16_t)(head - ring->tail) < ((length + 1) & ~1)) {
+        return ERROR;
+    }
+
+    for (i = 0; i < length; i++) {
+        ring->data[head++ & HOSTDP_RING_MASK] = data[i];
+    }
+
+    // Keep head even, zero is an empty frame.
+    if (head & 1) {
+        ring->data[head++ & HOSTDP_RING_MASK] = 0;
+    }
+
+    // Publish after bytes are written.
+    ring->head = head;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief   Get received bytes not yet consumed.
+ *
+ * Returns at most the span up to the end of the ring,
+ * call again after dev_cpu_hostdp_rx_consume() for the rest.
+ *
+ * @param[out]  data    Start of span.
+ *
+ * @return  Length of span.
+ */
+uint32_t dev_cpu_hostdp_rx_span(uint8_t **data) {
+
+    t_hostdp_ring *ring = &g_mailbox.to_dsp;
+    uint16_t offset = ring->tail & HOSTDP_RING_MASK;
+    uint16_t length = ring->head - ring->tail;
+
+    // CPU checks space before writing, so only a corrupt
+    // index overflows.  Resume at head.
+    if (length > HOSTDP_RING_LEN) {
+        ring->tail = ring->head;
+        length = 0;
+    }
+
+    if (length > HOSTDP_RING_LEN - offset) {
+        length = HOSTDP_RING_LEN - offset;
+    }
+
+    *data = &ring->data[offset];
+
+    return length;
+}
+
+void dev_cpu_hostdp_rx_consume(uint32_t length) {
+
+    // Frees space for CPU.
+    g_mailbox.to_dsp.tail += length;
+}
+
+/*----- Static function implementations ------------------------------*/
+
+/*----- End of file --------------------------------------------------*/
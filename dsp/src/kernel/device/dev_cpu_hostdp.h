@@ -0,0 +1,70 @@
+/*----------------------------------------------------------------------
+
+                     This file is part of Freetribe
+
+                https://github.com/bangcorrupt/freetribe
+
+                                License
+
+                   GNU AFFERO GENERAL PUBLIC LICENSE
+                      Version 3, 19 November 2007
+
+                           AGPL-3.0-or-later
+
+ Freetribe is free software: you can redistribute it and/or modify it
+under the terms of the GNU Affero General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+                  (at your option) any later version.
+
+     Freetribe is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty
+        of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+          See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+                       Copyright bangcorrupt 2024
+
+----------------------------------------------------------------------*/
+
+/**
+ * @file    dev_cpu_hostdp.h
+ *
+ * @brief   Public API for communicating with CPU via Host DMA Port.
+ */
+
+#ifndef DEV_CPU_HOSTDP_H
+#define DEV_CPU_HOSTDP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*----- Includes -----------------------------------------------------*/
+
+#include <stdint.h>
+
+#include "ft_error.h"
+
+/*----- Macros -------------------------------------------------------*/
+
+/*----- Typedefs -----------------------------------------------------*/
+
+/*----- Extern variable declarations ---------------------------------*/
+
+/*----- Extern function prototypes -----------------------------------*/
+
+void dev_cpu_hostdp_init(void);
+uint32_t dev_cpu_hostdp_address(void);
+uint32_t dev_cpu_hostdp_tx_free(void);
+t_status dev_cpu_hostdp_tx_enqueue(const uint8_t *data, uint32_t length);
+uint32_t dev_cpu_hostdp_rx_span(uint8_t **data);
+void dev_cpu_hostdp_rx_consume(uint32_t length);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
+
+/*----- End of file --------------------------------------------------*/
@@ -39,112 +39,130 @@ under the terms of the GNU Affero General Public License as published by
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "per_gpio.h"
 #include "per_spi.h"
 
-#include "ring_buffer.h"
+#include "dev_cpu_spi.h"
 
 /*----- Macros -------------------------------------------------------*/
 
 /// TODO: Central header for queue sizes.
 //
+// Powers of 2.
 #define SPI_RX_BUF_LEN 0x200
 #define SPI_TX_BUF_LEN 0x200
 
 /*----- Typedefs -----------------------------------------------------*/
 
 /*----- Static variable definitions ----------------------------------*/
-//
-// SPI Rx ring buffer.
-static rbd_t g_spi_rx_rbd;
-static uint8_t g_spi_rx_rbmem[SPI_RX_BUF_LEN];
 
-// SPI Tx ring buffer.
-static rbd_t g_spi_tx_rbd;
-static uint8_t g_spi_tx_rbmem[SPI_TX_BUF_LEN];
+static uint8_t g_spi_rx_buffer[SPI_RX_BUF_LEN];
+static uint8_t g_spi_tx_buffer[SPI_TX_BUF_LEN];
 
-static uint8_t g_cpu_spi_rx_byte;
-static uint8_t g_cpu_spi_tx_byte;
+// Streamed by SPI interrupt.
+static t_spi_stream g_spi_stream;
 
-static bool g_spi_tx_complete = true;
+// Next received byte to consume.
+static uint32_t g_spi_rx_tail;
 
 /*----- Extern variable definitions ----------------------------------*/
 
 /*----- Static function prototypes -----------------------------------*/
 
-static int _cpu_spi_tx_dequeue(uint8_t *spi_byte);
-static void _cpu_spi_rx_enqueue(uint8_t *spi_byte);
-
-static void _cpu_spi_trx_byte(uint8_t *tx_byte, uint8_t *rx_byte);
-
-static void _cpu_spi_trx_callback();
-
 /*----- Extern function implementations ------------------------------*/
 
 void dev_cpu_spi_init(void) {
-    //
-    // Tx ring buffer attributes.
-    rb_attr_t tx_attr = {sizeof(g_spi_tx_rbmem[0]), ARRAY_SIZE(g_spi_tx_rbmem),
-                         g_spi_tx_rbmem};
 
-    // Rx ring buffer attributes.
-    rb_attr_t rx_attr = {sizeof(g_spi_rx_rbmem[0]), ARRAY_SIZE(g_spi_rx_rbmem),
-                         g_spi_rx_rbmem};
+    g_spi_stream.rx_buffer = g_spi_rx_buffer;
+    g_spi_stream.rx_mask = SPI_RX_BUF_LEN - 1;
+    g_spi_stream.rx_head = 0;
 
-    // Initialise MCU message ring buffers.
-    if (ring_buffer_init(&g_spi_tx_rbd, &tx_attr) ||
-        ring_buffer_init(&g_spi_rx_rbd, &rx_attr) == 0) {
+    g_spi_stream.tx_buffer = g_spi_tx_buffer;
+    g_spi_stream.tx_mask = SPI_TX_BUF_LEN - 1;
+    g_spi_stream.tx_head = 0;
+    g_spi_stream.tx_tail = 0;
 
-        per_spi_init();
+    g_spi_rx_tail = 0;
 
-        per_spi_register_callback(EVT_SPI_TRX_COMPLETE, _cpu_spi_trx_callback);
+    per_spi_init();
 
-        // Initialise transfer.
-        _cpu_spi_trx_byte(&g_cpu_spi_tx_byte, &g_cpu_spi_rx_byte);
-    }
+    per_spi_stream(&g_spi_stream);
 }
 
-/// TODO: Check/return status.
-void dev_cpu_spi_tx_enqueue(uint8_t *spi_byte) {
+/// Bytes free in tx buffer.
+uint32_t dev_cpu_spi_tx_free(void) {
 
-    // Overwrite on overflow?
-    ring_buffer_put_force(g_spi_tx_rbd, spi_byte);
+    return SPI_TX_BUF_LEN - (g_spi_stream.tx_head - g_spi_stream.tx_tail);
 }
 
-int dev_cpu_spi_rx_dequeue(uint8_t *spi_byte) {
+/**
+ * @brief   Queue bytes for CPU to clock out.
+ *
+ * @param[in]   data    Bytes to send, e.g. an encoded frame.
+ * @param[in]   length  Number of bytes.
+ *
+ * @return  ERROR if bytes do not fit, nothing is queued.
+ */
+t_status dev_cpu_spi_tx_enqueue(const uint8_t *data, uint32_t length) {
 
-    return ring_buffer_get(g_spi_rx_rbd, spi_byte);
-}
+    uint32_t head = g_spi_stream.tx_head;
+    uint32_t i;
 
-/*----- Static function implementations ------------------------------*/
+    if (SPI_TX_BUF_LEN - (head - g_spi_stream.tx_tail) < length) {
+        return ERROR;
+    }
 
-static int _cpu_spi_tx_dequeue(uint8_t *spi_byte) {
+    for (i = 0; i < length; i++) {
+        g_spi_tx_buffer[head++ & g_spi_stream.tx_mask] = data[i];
+    }
 
-    return ring_buffer_get(g_spi_tx_rbd, spi_byte);
-}
+    // Publish after bytes are written.
+    g_spi_stream.tx_head = head;
 
-/// TODO: Check/return status.
-static void _cpu_spi_rx_enqueue(uint8_t *spi_byte) {
+    // Signal CPU to clock out queued bytes.
+    per_gpio_set(PORT_G, DATA_READY_PIN, true);
 
-    // Overwrite on overflow?
-    ring_buffer_put_force(g_spi_rx_rbd, spi_byte);
+    return SUCCESS;
 }
 
-static void _cpu_spi_trx_byte(uint8_t *tx_byte, uint8_t *rx_byte) {
+/**
+ * @brief   Get received bytes not yet consumed.
+ *
+ * Returns at most the span up to the end of the buffer,
+ * call again after dev_cpu_spi_rx_consume() for the rest.
+ *
+ * @param[out]  data    Start of span.
+ *
+ * @return  Length of span.
+ */
+uint32_t dev_cpu_spi_rx_span(uint8_t **data) {
 
-    per_spi_trx_int(tx_byte, rx_byte, 1);
-}
+    uint32_t head = g_spi_stream.rx_head;
+    uint32_t offset;
+    uint32_t length;
 
-static void _cpu_spi_trx_callback() {
+    /// TODO: Count overflows.
+    //
+    // Oldest bytes overwritten, resume at head.
+    // Frame in progress fails CRC and is dropped.
+    if (head - g_spi_rx_tail > SPI_RX_BUF_LEN) {
+        g_spi_rx_tail = head;
+    }
 
-    _cpu_spi_rx_enqueue(&g_cpu_spi_rx_byte);
+    offset = g_spi_rx_tail & g_spi_stream.rx_mask;
+    length = head - g_spi_rx_tail;
+
+    if (length > SPI_RX_BUF_LEN - offset) {
+        length = SPI_RX_BUF_LEN - offset;
+    }
 
-    // Transmit 0 if tx queue empty.
-    if (_cpu_spi_tx_dequeue(&g_cpu_spi_tx_byte)) {
-        g_cpu_spi_tx_byte = 0;
-    };
+    *data = &g_spi_rx_buffer[offset];
 
-    // CPU leads, so always re-enable transfer to catch next byte.
-    _cpu_spi_trx_byte(&g_cpu_spi_tx_byte, &g_cpu_spi_rx_byte);
+    return length;
 }
 
+void dev_cpu_spi_rx_consume(uint32_t length) { g_spi_rx_tail += length; }
+
+/*----- Static function implementations ------------------------------*/
+
 /*----- End of file --------------------------------------------------*/
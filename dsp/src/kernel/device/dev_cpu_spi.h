@@ -46,6 +46,8 @@ extern "C" {
 
 #include <stdint.h>
 
+#include "ft_error.h"
+
 /*----- Macros -------------------------------------------------------*/
 
 /*----- Typedefs -----------------------------------------------------*/
@@ -55,8 +57,10 @@ extern "C" {
 /*----- Extern function prototypes -----------------------------------*/
 
 void dev_cpu_spi_init(void);
-int dev_cpu_spi_rx_dequeue(uint8_t *spi_byte);
-void dev_cpu_spi_tx_enqueue(uint8_t *spi_byte);
+uint32_t dev_cpu_spi_tx_free(void);
+t_status dev_cpu_spi_tx_enqueue(const uint8_t *data, uint32_t length);
+uint32_t dev_cpu_spi_rx_span(uint8_t **data);
+void dev_cpu_spi_rx_consume(uint32_t length);
 
 #ifdef __cplusplus
 }
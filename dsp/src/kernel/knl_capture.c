@@ -0,0 +1,284 @@
+/*----------------------------------------------------------------------
+
+                     This file is part of Freetribe
+
+                https://github.com/bangcorrupt/freetribe
+
+                                License
+
+                   GNU AFFERO GENERAL PUBLIC LICENSE
+                      Version 3, 19 November 2007
+
+                           AGPL-3.0-or-later
+
+ Freetribe is free software: you can redistribute it and/or modify it
+under the terms of the GNU Affero General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+                  (at your option) any later version.
+
+     Freetribe is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty
+        of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+          See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+                       Copyright bangcorrupt 2024
+
+----------------------------------------------------------------------*/
+
+/**
+ * @file    knl_capture.c
+ *
+ * @brief   Audio capture stream to CPU.
+ *
+ * Codec input or module output is tapped after each block,
+ * decimated by averaging, and held in a ring of Q15 samples
+ * until svc_cpu ships it.  Frames arriving while the ring is
+ * full are dropped and counted, so the stream never blocks audio.
+ */
+
+/*----- Includes -----------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "ft_error.h"
+#include "ft_protocol.h"
+#include "types.h"
+
+#include "knl_capture.h"
+#include "module.h"
+
+/*----- Macros -------------------------------------------------------*/
+
+/*----- Typedefs -----------------------------------------------------*/
+
+typedef struct {
+
+    t_capture_config config;
+    t_capture_stats stats;
+
+    // Captured channels, and ring capacity in whole frames.
+    uint8_t channels;
+    uint16_t capacity;
+
+    // Frames read, and sample positions of head and tail.
+    uint32_t tail;
+    uint16_t head_pos;
+    uint16_t tail_pos;
+
+    // Frames averaged so far, and their sums.
+    uint8_t count;
+    int32_t sum[MODULE_CHANNELS];
+
+} t_capture;
+
+/*----- Static variable definitions ----------------------------------*/
+
+static t_capture g_capture;
+
+static int16_t g_ring[KNL_CAPTURE_DEPTH_MAX];
+
+/*----- Extern variable definitions ----------------------------------*/
+
+/*----- Static function prototypes -----------------------------------*/
+
+static void _write_frame(void);
+
+/*----- Extern function implementations ------------------------------*/
+
+/**
+ * @brief   Start capture, discarding any frames not read.
+ *
+ * @param[in]   config  Capture configuration.
+ *
+ * @return  ERROR if no channels selected or ring under two frames.
+ */
+t_status knl_capture_start(const t_capture_config *config) {
+
+    uint16_t depth = config->depth;
+    uint8_t channels = 0;
+    uint8_t i;
+
+    for (i = 0; i < MODULE_CHANNELS; i++) {
+        if (config->channel_mask & (1 << i)) {
+            channels++;
+        }
+    }
+
+    if (depth == 0 || depth > KNL_CAPTURE_DEPTH_MAX) {
+        depth = KNL_CAPTURE_DEPTH_MAX;
+    }
+
+    if (channels == 0 || depth < 2 * channels ||
+        config->source > CAPTURE_SOURCE_OUTPUT) {
+        return ERROR;
+    }
+
+    memset(&g_capture, 0, sizeof(g_capture));
+
+    g_capture.config = *config;
+    g_capture.channels = channels;
+    g_capture.capacity = depth / channels;
+
+    if (g_capture.config.decimation == 0) {
+        g_capture.config.decimation = 1;
+    }
+
+    g_capture.stats.running = true;
+
+    return SUCCESS;
+}
+
+/// Stop capture, frames not read are discarded.
+void knl_capture_stop(void) {
+
+    g_capture.stats.running = false;
+    g_capture.channels = 0;
+}
+
+bool knl_capture_running(void) { return g_capture.stats.running; }
+
+/// Samples per captured frame, 0 when stopped.
+uint8_t knl_capture_channels(void) { return g_capture.channels; }
+
+/// Ring depth in whole frames.
+uint16_t knl_capture_capacity(void) { return g_capture.capacity; }
+
+/// Frames waiting in ring.
+uint16_t knl_capture_pending(void) {
+
+    return g_capture.stats.frames - g_capture.tail;
+}
+
+t_capture_stats knl_capture_stats(void) { return g_capture.stats; }
+
+/**
+ * @brief   Capture audio block.
+ *
+ * Call after each block is processed.
+ *
+ * @param[in]   in      Codec input block.
+ * @param[in]   out     Module output block.
+ * @param[in]   frames  Number of interleaved frames in each block.
+ */
+void knl_capture_process(const fract32 *in, const fract32 *out,
+                         uint16_t frames) {
+
+    const fract32 *block;
+    uint16_t frame;
+    uint8_t channel;
+
+    if (!g_capture.stats.running) {
+        return;
+    }
+
+    block = g_capture.config.source == CAPTURE_SOURCE_INPUT ? in : out;
+
+    for (frame = 0; frame < frames; frame++) {
+
+        for (channel = 0; channel < MODULE_CHANNELS; channel++) {
+            g_capture.sum[channel] += block[channel] >> 16;
+        }
+        block += MODULE_CHANNELS;
+
+        if (++g_capture.count == g_capture.config.decimation) {
+            _write_frame();
+        }
+    }
+}
+
+/**
+ * @brief   Copy captured frames without consuming them.
+ *
+ * @param[out]  samples Interleaved Q15 samples of selected channels.
+ * @param[in]   frames  Maximum frames to copy.
+ * @param[out]  index   Capture frame index of first frame copied.
+ *
+ * @return  Number of frames copied.
+ */
+uint16_t knl_capture_read(int16_t *samples, uint16_t frames, uint32_t *index) {
+
+    uint32_t available = g_capture.stats.frames - g_capture.tail;
+    uint16_t size = g_capture.capacity * g_capture.channels;
+    uint16_t pos = g_capture.tail_pos;
+    uint32_t count;
+    uint32_t i;
+
+    if (g_capture.channels == 0) {
+        return 0;
+    }
+
+    if (frames > available) {
+        frames = available;
+    }
+
+    count = frames * g_capture.channels;
+
+    for (i = 0; i < count; i++) {
+
+        samples[i] = g_ring[pos];
+
+        if (++pos == size) {
+            pos = 0;
+        }
+    }
+
+    *index = g_capture.tail;
+
+    return frames;
+}
+
+/// Release frames returned by knl_capture_read().
+void knl_capture_consume(uint16_t frames) {
+
+    uint16_t size = g_capture.capacity * g_capture.channels;
+
+    if (g_capture.channels == 0) {
+        return;
+    }
+
+    g_capture.tail += frames;
+    g_capture.tail_pos =
+        (g_capture.tail_pos + (uint32_t)frames * g_capture.channels) % size;
+}
+
+/*----- Static function implementations ------------------------------*/
+
+// Write averaged frame of selected channels, or drop if ring full.
+static void _write_frame(void) {
+
+    uint16_t size = g_capture.capacity * g_capture.channels;
+    uint8_t decimation = g_capture.config.decimation;
+    uint8_t channel;
+
+    if (g_capture.stats.frames - g_capture.tail >= g_capture.capacity) {
+        g_capture.stats.overruns++;
+
+    } else {
+
+        for (channel = 0; channel < MODULE_CHANNELS; channel++) {
+
+            if (g_capture.config.channel_mask & (1 << channel)) {
+
+                g_ring[g_capture.head_pos] =
+                    decimation == 1 ? g_capture.sum[channel]
+                                    : g_capture.sum[channel] / decimation;
+
+                if (++g_capture.head_pos == size) {
+                    g_capture.head_pos = 0;
+                }
+            }
+        }
+
+        g_capture.stats.frames++;
+    }
+
+    memset(g_capture.sum, 0, sizeof(g_capture.sum));
+    g_capture.count = 0;
+}
+
+/*----- End of file --------------------------------------------------*/
@@ -0,0 +1,101 @@
+/*----------------------------------------------------------------------
+
+                     This file is part of Freetribe
+
+                https://github.com/bangcorrupt/freetribe
+
+                                License
+
+                   GNU AFFERO GENERAL PUBLIC LICENSE
+                      Version 3, 19 November 2007
+
+                           AGPL-3.0-or-later
+
+ Freetribe is free software: you can redistribute it and/or modify it
+under the terms of the GNU Affero General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+                  (at your option) any later version.
+
+     Freetribe is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty
+        of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+          See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+                       Copyright bangcorrupt 2024
+
+----------------------------------------------------------------------*/
+
+/**
+ * @file    knl_capture.h
+ *
+ * @brief   Public API for audio capture stream to CPU.
+ */
+
+#ifndef KNL_CAPTURE_H
+#define KNL_CAPTURE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*----- Includes -----------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ft_error.h"
+#include "types.h"
+
+/*----- Macros -------------------------------------------------------*/
+
+/// Samples held in capture ring.
+#define KNL_CAPTURE_DEPTH_MAX 0x1000
+
+/*----- Typedefs -----------------------------------------------------*/
+
+typedef struct {
+    // Audio tapped, see e_capture_source.
+    uint8_t source;
+    // Frames averaged per captured frame, 1 for full rate.
+    uint8_t decimation;
+    // Bit per channel captured.
+    uint8_t channel_mask;
+    // Ring depth in samples, 0 for KNL_CAPTURE_DEPTH_MAX.
+    uint16_t depth;
+} t_capture_config;
+
+typedef struct {
+    bool running;
+    // Frames written to ring since start.
+    uint32_t frames;
+    // Frames dropped since start, ring full.
+    uint32_t overruns;
+} t_capture_stats;
+
+/*----- Extern variable declarations ---------------------------------*/
+
+/*----- Extern function prototypes -----------------------------------*/
+
+t_status knl_capture_start(const t_capture_config *config);
+void knl_capture_stop(void);
+bool knl_capture_running(void);
+uint8_t knl_capture_channels(void);
+uint16_t knl_capture_capacity(void);
+uint16_t knl_capture_pending(void);
+t_capture_stats knl_capture_stats(void);
+
+void knl_capture_process(const fract32 *in, const fract32 *out,
+                         uint16_t frames);
+
+uint16_t knl_capture_read(int16_t *samples, uint16_t frames, uint32_t *index);
+void knl_capture_consume(uint16_t frames);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* KNL_CAPTURE_H */
+
+/*----- End of file --------------------------------------------------*/
@@ -0,0 +1,203 @@
+/*----------------------------------------------------------------------
+
+                     This file is part of Freetribe
+
+                https://github.com/bangcorrupt/freetribe
+
+                                License
+
+                   GNU AFFERO GENERAL PUBLIC LICENSE
+                      Version 3, 19 November 2007
+
+                           AGPL-3.0-or-later
+
+ Freetribe is free software: you can redistribute it and/or modify it
+under the terms of the GNU Affero General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+                  (at your option) any later version.
+
+     Freetribe is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty
+        of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+          See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+                       Copyright bangcorrupt 2024
+
+----------------------------------------------------------------------*/
+
+/**
+ * @file    knl_event.c
+ *
+ * @brief   Timestamped parameter events.
+ *
+ * Events are held in order of frame timestamp.  Each audio block
+ * is split at event boundaries, so parameters change on the exact
+ * frame requested, independent of when the message arrived.
+ */
+
+/*----- Includes -----------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ft_error.h"
+#include "types.h"
+
+#include "knl_event.h"
+#include "module.h"
+
+/*----- Macros -------------------------------------------------------*/
+
+/*----- Typedefs -----------------------------------------------------*/
+
+typedef struct {
+
+    uint32_t frame;
+    uint16_t module_id;
+    uint16_t param_index;
+    int32_t value;
+
+} t_event;
+
+/*----- Static variable definitions ----------------------------------*/
+
+// Pending events, sorted by frame, earliest first.
+static t_event g_events[KNL_EVENT_QUEUE_LENGTH];
+static uint8_t g_event_count;
+
+// Frame count at start of current block.
+static uint32_t g_frame;
+
+/*----- Extern variable definitions ----------------------------------*/
+
+/*----- Static function prototypes -----------------------------------*/
+
+static inline int32_t _frames_until(uint32_t frame);
+static void _apply_due(uint32_t frame);
+
+/*----- Extern function implementations ------------------------------*/
+
+/**
+ * @brief   Schedule parameter change.
+ *
+ * Events in the past are applied at the start of the next block.
+ *
+ * @param[in]   frame       Absolute frame count, see knl_event_frame_count().
+ * @param[in]   module_id   Index of module in graph.
+ * @param[in]   param_index Index of parameter.
+ * @param[in]   value       Value of parameter.
+ *
+ * @return  SUCCESS, or ERROR if queue full and parameter set immediately.
+ */
+t_status knl_event_set_param(uint32_t frame, uint16_t module_id,
+                             uint16_t param_index, int32_t value) {
+
+    uint8_t index;
+
+    if (g_event_count >= KNL_EVENT_QUEUE_LENGTH) {
+
+        module_set_param(module_id, param_index, value);
+        return ERROR;
+    }
+
+    // Insert after events at same or earlier frame, keeping arrival order.
+    index = g_event_count;
+
+    while (index > 0 && (int32_t)(g_events[index - 1].frame - frame) > 0) {
+
+        g_events[index] = g_events[index - 1];
+        index--;
+    }
+
+    g_events[index].frame = frame;
+    g_events[index].module_id = module_id;
+    g_events[index].param_index = param_index;
+    g_events[index].value = value;
+
+    g_event_count++;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief   Process audio block, applying events on time.
+ *
+ * @param[in]   in      Pointer to input buffer.
+ * @param[out]  out     Pointer to output buffer.
+ * @param[in]   frames  Number of interleaved frames in each buffer.
+ */
+void knl_event_process(fract32 *in, fract32 *out, uint16_t frames) {
+
+    uint16_t offset = 0;
+    uint16_t next;
+    int32_t until;
+
+    while (offset < frames) {
+
+        _apply_due(g_frame + offset);
+
+        // Process up to next event, or end of block.
+        next = frames;
+
+        if (g_event_count > 0) {
+
+            until = _frames_until(g_events[0].frame);
+
+            if (until < frames) {
+                next = until;
+            }
+        }
+
+        module_process(in + offset * MODULE_CHANNELS,
+                       out + offset * MODULE_CHANNELS, next - offset);
+
+        offset = next;
+    }
+
+    g_frame += frames;
+}
+
+/**
+ * @brief   Get number of frames processed.
+ *
+ * Count wraps, timestamps are compared modulo 2^32.
+ */
+uint32_t knl_event_frame_count(void) { return g_frame; }
+
+/// Number of events waiting in queue.
+uint8_t knl_event_pending(void) { return g_event_count; }
+
+/*----- Static function implementations ------------------------------*/
+
+static inline int32_t _frames_until(uint32_t frame) {
+
+    return (int32_t)(frame - g_frame);
+}
+
+/// Apply events due at or before 'frame'.
+static void _apply_due(uint32_t frame) {
+
+    uint8_t due = 0;
+    uint8_t i;
+
+    while (due < g_event_count &&
+           (int32_t)(g_events[due].frame - frame) <= 0) {
+
+        module_set_param(g_events[due].module_id, g_events[due].param_index,
+                         g_events[due].value);
+        due++;
+    }
+
+    if (due > 0) {
+
+        for (i = due; i < g_event_count; i++) {
+            g_events[i - due] = g_events[i];
+        }
+        g_event_count -= due;
+    }
+}
+
+/*----- End of file --------------------------------------------------*/
@@ -0,0 +1,75 @@
+/*----------------------------------------------------------------------
+
+                     This file is part of Freetribe
+
+                https://github.com/bangcorrupt/freetribe
+
+                                License
+
+                   GNU AFFERO GENERAL PUBLIC LICENSE
+                      Version 3, 19 November 2007
+
+                           AGPL-3.0-or-later
+
+ Freetribe is free software: you can redistribute it and/or modify it
+under the terms of the GNU Affero General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+                  (at your option) any later version.
+
+     Freetribe is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty
+        of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+          See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+                       Copyright bangcorrupt 2024
+
+----------------------------------------------------------------------*/
+
+/**
+ * @file    knl_event.h
+ *
+ * @brief   Public API for timestamped parameter events.
+ */
+
+#ifndef KNL_EVENT_H
+#define KNL_EVENT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*----- Includes -----------------------------------------------------*/
+
+#include <stdint.h>
+
+#include "ft_error.h"
+#include "types.h"
+
+/*----- Macros -------------------------------------------------------*/
+
+/// Maximum number of pending events.
+#define KNL_EVENT_QUEUE_LENGTH 32
+
+/*----- Typedefs -----------------------------------------------------*/
+
+/*----- Extern variable declarations ---------------------------------*/
+
+/*----- Extern function prototypes -----------------------------------*/
+
+t_status knl_event_set_param(uint32_t frame, uint16_t module_id,
+                             uint16_t param_index, int32_t value);
+
+void knl_event_process(fract32 *in, fract32 *out, uint16_t frames);
+
+uint32_t knl_event_frame_count(void);
+uint8_t knl_event_pending(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* KNL_EVENT_H */
+
+/*----- End of file --------------------------------------------------*/
@@ -0,0 +1,622 @@
+/*----------------------------------------------------------------------
+
+                     This file is part of Freetribe
+
+                https://github.com/bangcorrupt/freetribe
+
+                                License
+
+                   GNU AFFERO GENERAL PUBLIC LICENSE
+                      Version 3, 19 November 2007
+
+                           AGPL-3.0-or-later
+
+ Freetribe is free software: you can redistribute it and/or modify it
+under the terms of the GNU Affero General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+                  (at your option) any later version.
+
+     Freetribe is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty
+        of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+          See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+                       Copyright bangcorrupt 2024
+
+----------------------------------------------------------------------*/
+
+/**
+ * @file    knl_mod.c
+ *
+ * @brief   Kernel modulation engine.
+ *
+ * Envelopes and LFOs run in fixed point once per call to
+ * module_process(), and a routing matrix adds them to module
+ * parameters.  The CPU sends only gates and settings.
+ *
+ * Each modulated parameter is recomputed from its stored value
+ * every block, and ramped from the last block's value where the
+ * descriptor provides a ramp.  Routes to a PARAM_SCALE_EXP
+ * parameter scale it by octaves, others add in parameter units.
+ */
+
+/*----- Includes -----------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ft_error.h"
+#include "types.h"
+
+#include "knl_mod.h"
+#include "module.h"
+
+/*----- Macros -------------------------------------------------------*/
+
+#define FRAMES_PER_MS (SAMPLERATE / 1000)
+
+/// Full scale source value.
+#define MOD_MAX 0x7fffffff
+
+/// Distance from target at which exponential segments end.
+#define ENV_SETTLE (MOD_MAX >> 8)
+
+/// Octaves beyond which exponential scaling saturates.
+#define OCTAVES_MAX 31
+
+/// Cubic fit of 2^x for 0 <= x < 1, fix16 coefficients.
+#define EXP2_C1 45560
+#define EXP2_C2 14822
+#define EXP2_C3 5155
+
+/*----- Typedefs -----------------------------------------------------*/
+
+typedef enum {
+    ENV_IDLE,
+    ENV_ATTACK,
+    ENV_DECAY,
+    ENV_SUSTAIN,
+    ENV_RELEASE,
+} t_env_state;
+
+typedef struct {
+
+    t_env_state state;
+    int32_t level;
+    int32_t velocity;
+
+    // Segment times in frames.
+    uint32_t attack;
+    uint32_t decay;
+    uint32_t release;
+    int32_t sustain;
+
+    bool retrigger;
+    bool velocity_scale;
+
+} t_envelope;
+
+typedef struct {
+
+    uint32_t phase;
+    // Phase increment per frame.
+    uint32_t increment;
+
+} t_lfo;
+
+typedef struct {
+
+    t_mod_route config;
+
+    // Value applied last block, valid once applied.
+    int32_t output;
+    bool valid;
+
+} t_route;
+
+/*----- Static variable definitions ----------------------------------*/
+
+static t_envelope g_envelopes[KNL_MOD_ENVELOPES];
+static t_lfo g_lfos[KNL_MOD_LFOS];
+
+// Value of each source at end of current block, Q31.
+static int32_t g_sources[MOD_SOURCE_COUNT];
+
+static t_route g_routes[KNL_MOD_ROUTES];
+static uint8_t g_route_count;
+
+/*----- Extern variable definitions ----------------------------------*/
+
+/*----- Static function prototypes -----------------------------------*/
+
+static void _envelope_process(t_envelope *env, uint16_t frames);
+static int32_t _approach(int32_t level, int32_t target, uint32_t time,
+                         uint16_t frames);
+static int32_t _lfo_process(t_lfo *lfo, uint16_t frames);
+
+static void _apply_routes(uint8_t first, uint16_t frames);
+static void _release_param(const t_mod_route *config);
+static bool _same_param(const t_mod_route *a, const t_mod_route *b);
+static int32_t _exp2_scale(int32_t base, int64_t octaves);
+
+/*----- Extern function implementations ------------------------------*/
+
+/**
+ * @brief   Change setting of modulation source.
+ *
+ * @param[in]   source  Envelope or LFO, see e_mod_source.
+ * @param[in]   setting See e_mod_setting.
+ * @param[in]   value   Value of setting.
+ *
+ * @return  SUCCESS, or ERROR if setting does not apply to source.
+ */
+t_status knl_mod_set_source(uint8_t source, uint8_t setting, int32_t value) {
+
+    t_envelope *env;
+    t_lfo *lfo;
+
+    if (source >= MOD_SOURCE_ENV && source < MOD_SOURCE_LFO) {
+
+        env = &g_envelopes[source - MOD_SOURCE_ENV];
+
+        switch (setting) {
+
+        case MOD_ENV_ATTACK:
+            env->attack = (uint32_t)value * FRAMES_PER_MS;
+            break;
+
+        case MOD_ENV_DECAY:
+            env->decay = (uint32_t)value * FRAMES_PER_MS;
+            break;
+
+        case MOD_ENV_SUSTAIN:
+            env->sustain = value < 0 ? 0 : value;
+            break;
+
+        case MOD_ENV_RELEASE:
+            env->release = (uint32_t)value * FRAMES_PER_MS;
+            break;
+
+        case MOD_ENV_RETRIGGER:
+            env->retrigger = value;
+            break;
+
+        case MOD_ENV_VELOCITY:
+            env->velocity_scale = value;
+            break;
+
+        default:
+            return ERROR;
+        }
+
+    } else if (source >= MOD_SOURCE_LFO && source < MOD_SOURCE_COUNT) {
+
+        lfo = &g_lfos[source - MOD_SOURCE_LFO];
+
+        switch (setting) {
+
+        case MOD_LFO_RATE:
+            // Fix16 Hz to fraction of cycle, 2^32 per cycle.
+            lfo->increment =
+                ((int64_t)(value < 0 ? 0 : value) << 16) / SAMPLERATE;
+            break;
+
+        case MOD_LFO_PHASE:
+            lfo->phase = (uint32_t)value << 1;
+            break;
+
+        default:
+            return ERROR;
+        }
+
+    } else {
+        return ERROR;
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief   Open or close envelope gates.
+ *
+ * Envelopes restart from their current level, so retriggering
+ * does not click.
+ *
+ * @param[in]   mask        Bit per envelope, bit 0 is MOD_SOURCE_ENV.
+ * @param[in]   gate        Open or close.
+ * @param[in]   velocity    Peak level of scaled envelopes, Q31.
+ */
+void knl_mod_gate(uint8_t mask, bool gate, int32_t velocity) {
+
+    t_envelope *env;
+    uint8_t i;
+
+    for (i = 0; i < KNL_MOD_ENVELOPES; i++) {
+
+        if (!(mask & (1 << i))) {
+            continue;
+        }
+
+        env = &g_envelopes[i];
+
+        if (gate) {
+
+            if (env->state == ENV_IDLE || env->state == ENV_RELEASE ||
+                env->retrigger) {
+
+                env->state = ENV_ATTACK;
+                env->velocity = velocity < 0 ? 0 : velocity;
+            }
+
+        } else if (env->state != ENV_IDLE) {
+            env->state = ENV_RELEASE;
+        }
+    }
+}
+
+/**
+ * @brief   Configure route from source to module parameter.
+ *
+ * Parameter returns to its stored value when its last route
+ * is cleared.
+ *
+ * @param[in]   route   Index of route.
+ * @param[in]   config  Route configuration.
+ *
+ * @return  SUCCESS, or ERROR if route, source or module invalid.
+ */
+t_status knl_mod_set_route(uint8_t route, const t_mod_route *config) {
+
+    t_route *slot;
+
+    if (route >= KNL_MOD_ROUTES || config->source >= MOD_SOURCE_COUNT ||
+        config->via >= MOD_SOURCE_COUNT) {
+        return ERROR;
+    }
+
+    if (config->source != MOD_SOURCE_NONE &&
+        config->module_id >= module_get_node_count()) {
+        return ERROR;
+    }
+
+    slot = &g_routes[route];
+
+    if (slot->config.source != MOD_SOURCE_NONE) {
+
+        g_route_count--;
+
+        // Restore previous destination, unless route keeps it.
+        if (config->source == MOD_SOURCE_NONE ||
+            !_same_param(&slot->config, config)) {
+
+            slot->config.source = MOD_SOURCE_NONE;
+            _release_param(&slot->config);
+        }
+    }
+
+    slot->config = *config;
+    slot->valid = false;
+
+    if (config->source != MOD_SOURCE_NONE) {
+        g_route_count++;
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief   Clear all routes, e.g. when graph is rebuilt.
+ *
+ * Module ids refer to the old graph, so parameters are not
+ * restored.  Sources keep running.
+ */
+void knl_mod_reset(void) {
+
+    uint8_t i;
+
+    for (i = 0; i < KNL_MOD_ROUTES; i++) {
+        g_routes[i].config.source = MOD_SOURCE_NONE;
+        g_routes[i].valid = false;
+    }
+
+    g_route_count = 0;
+}
+
+/**
+ * @brief   Check if module parameter has a route.
+ *
+ * @param[in]   module_id   Index of node in graph.
+ * @param[in]   param_index Index of parameter.
+ */
+bool knl_mod_routed(uint16_t module_id, uint16_t param_index) {
+
+    uint8_t i;
+
+    for (i = 0; i < KNL_MOD_ROUTES && g_route_count > 0; i++) {
+
+        if (g_routes[i].config.source != MOD_SOURCE_NONE &&
+            g_routes[i].config.module_id == module_id &&
+            g_routes[i].config.param_index == param_index) {
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief   Advance sources and apply routes for one block.
+ *
+ * Called before modules process the block.
+ *
+ * @param[in]   frames  Number of frames in block.
+ */
+void knl_mod_process(uint16_t frames) {
+
+    bool applied[KNL_MOD_ROUTES] = {false};
+    t_envelope *env;
+    uint8_t i;
+    uint8_t j;
+
+    if (frames == 0) {
+        return;
+    }
+
+    // Sources advance without routes, so they keep time when routed.
+    for (i = 0; i < KNL_MOD_ENVELOPES; i++) {
+
+        env = &g_envelopes[i];
+
+        _envelope_process(env, frames);
+
+        g_sources[MOD_SOURCE_ENV + i] =
+            env->velocity_scale ? (int64_t)env->level * env->velocity >> 31
+                                : env->level;
+    }
+
+    for (i = 0; i < KNL_MOD_LFOS; i++) {
+        g_sources[MOD_SOURCE_LFO + i] = _lfo_process(&g_lfos[i], frames);
+    }
+
+    if (g_route_count == 0) {
+        return;
+    }
+
+    // Each parameter is applied once, with the sum of its routes.
+    for (i = 0; i < KNL_MOD_ROUTES; i++) {
+
+        if (g_routes[i].config.source == MOD_SOURCE_NONE || applied[i]) {
+            continue;
+        }
+
+        for (j = i; j < KNL_MOD_ROUTES; j++) {
+            if (_same_param(&g_routes[i].config, &g_routes[j].config)) {
+                applied[j] = true;
+            }
+        }
+
+        _apply_routes(i, frames);
+    }
+}
+
+/*----- Static function implementations ------------------------------*/
+
+static void _envelope_process(t_envelope *env, uint16_t frames) {
+
+    int64_t level;
+
+    switch (env->state) {
+
+    case ENV_ATTACK:
+
+        level = env->level;
+        level += env->attack > frames
+                     ? (int64_t)MOD_MAX * frames / env->attack
+                     : MOD_MAX;
+
+        if (level >= MOD_MAX) {
+            level = MOD_MAX;
+            env->state = ENV_DECAY;
+        }
+        env->level = level;
+        break;
+
+    case ENV_DECAY:
+
+        env->level = _approach(env->level, env->sustain, env->decay, frames);
+
+        if (env->level - env->sustain <= ENV_SETTLE) {
+            env->level = env->sustain;
+            env->state = ENV_SUSTAIN;
+        }
+        break;
+
+    case ENV_SUSTAIN:
+        env->level = env->sustain;
+        break;
+
+    case ENV_RELEASE:
+
+        env->level = _approach(env->level, 0, env->release, frames);
+
+        if (env->level <= ENV_SETTLE) {
+            env->level = 0;
+            env->state = ENV_IDLE;
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+// Exponential approach, time is frames to settle.
+static int32_t _approach(int32_t level, int32_t target, uint32_t time,
+                         uint16_t frames) {
+
+    uint32_t time_constant = time / KNL_MOD_TIME_CONSTANTS;
+
+    if (frames >= time_constant) {
+        return target;
+    }
+
+    return level + ((int64_t)target - level) * frames / time_constant;
+}
+
+// Bipolar triangle, -1 at phase 0, +1 at half cycle.
+static int32_t _lfo_process(t_lfo *lfo, uint16_t frames) {
+
+    int64_t phase;
+
+    lfo->phase += lfo->increment * frames;
+
+    phase = lfo->phase;
+
+    if (phase < 0x80000000) {
+        return phase * 2 - 0x80000000;
+    }
+
+    return 0x17fffffffLL - phase * 2;
+}
+
+/**
+ * @brief   Apply parameter with sum of its routes.
+ *
+ * @param[in]   first   Index of first route to parameter.
+ * @param[in]   frames  Number of frames in block.
+ */
+static void _apply_routes(uint8_t first, uint16_t frames) {
+
+    const t_mod_route *config = &g_routes[first].config;
+    const t_mod_route *other;
+    const t_param_desc *desc;
+    int64_t sum = 0;
+    int64_t amount;
+    int32_t value;
+    int32_t start;
+    uint8_t i;
+
+    desc = module_get_param_desc(config->module_id, config->param_index);
+
+    if (desc == NULL) {
+        return;
+    }
+
+    for (i = first; i < KNL_MOD_ROUTES; i++) {
+
+        other = &g_routes[i].config;
+
+        if (other->source == MOD_SOURCE_NONE || !_same_param(config, other)) {
+            continue;
+        }
+
+        amount = g_sources[other->source];
+
+        if (other->via != MOD_SOURCE_NONE) {
+            amount = amount * g_sources[other->via] >> 31;
+        }
+
+        sum += amount * other->depth >> 31;
+    }
+
+    value = module_get_param(config->module_id, config->param_index);
+
+    if (desc->scale == PARAM_SCALE_EXP) {
+        value = _exp2_scale(value, sum);
+
+    } else {
+        sum += value;
+        value = sum < INT32_MIN ? INT32_MIN : sum > INT32_MAX ? INT32_MAX : sum;
+    }
+
+    value = value < desc->min ? desc->min : value;
+    value = value > desc->max ? desc->max : value;
+
+    start = g_routes[first].valid ? g_routes[first].output : value;
+
+    module_apply_param(config->module_id, config->param_index, start, value,
+                       frames);
+
+    g_routes[first].output = value;
+    g_routes[first].valid = true;
+}
+
+// Apply stored value to parameter with no routes left.
+static void _release_param(const t_mod_route *config) {
+
+    int32_t value;
+    uint8_t i;
+
+    for (i = 0; i < KNL_MOD_ROUTES; i++) {
+
+        if (g_routes[i].config.source != MOD_SOURCE_NONE &&
+            _same_param(&g_routes[i].config, config)) {
+
+            // Next block recomputes without released route.
+            g_routes[i].valid = false;
+            return;
+        }
+    }
+
+    value = module_get_param(config->module_id, config->param_index);
+
+    module_apply_param(config->module_id, config->param_index, value, value,
+                       0);
+}
+
+static bool _same_param(const t_mod_route *a, const t_mod_route *b) {
+
+    return a->module_id == b->module_id && a->param_index == b->param_index;
+}
+
+/**
+ * @brief   Scale value by power of two.
+ *
+ * @param[in]   base    Value to scale, not scaled if negative.
+ * @param[in]   octaves Exponent, fix16.
+ *
+ * @return  base * 2^octaves, saturated.
+ */
+static int32_t _exp2_scale(int32_t base, int64_t octaves) {
+
+    int64_t result;
+    int32_t whole;
+    int32_t x;
+
+    if (base <= 0) {
+        return base;
+    }
+
+    if (octaves > (int64_t)OCTAVES_MAX << 16) {
+        octaves = (int64_t)OCTAVES_MAX << 16;
+
+    } else if (octaves < -((int64_t)OCTAVES_MAX << 16)) {
+        octaves = -((int64_t)OCTAVES_MAX << 16);
+    }
+
+    whole = octaves >> 16;
+    x = octaves - ((int64_t)whole << 16);
+
+    // 2^x for fraction x, fix16.
+    result = (((((int64_t)EXP2_C3 * x >> 16) + EXP2_C2) * x >> 16) +
+              EXP2_C1) * x >> 16;
+    result = (result + 0x10000) * base >> 16;
+
+    if (whole < 0) {
+        result >>= -whole;
+
+    } else if (result > (INT32_MAX >> whole)) {
+        result = INT32_MAX;
+
+    } else {
+        result <<= whole;
+    }
+
+    return result;
+}
+
+/*----- End of file --------------------------------------------------*/
@@ -0,0 +1,99 @@
+/*----------------------------------------------------------------------
+
+                     This file is part of Freetribe
+
+                https://github.com/bangcorrupt/freetribe
+
+                                License
+
+                   GNU AFFERO GENERAL PUBLIC LICENSE
+                      Version 3, 19 November 2007
+
+                           AGPL-3.0-or-later
+
+ Freetribe is free software: you can redistribute it and/or modify it
+under the terms of the GNU Affero General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+                  (at your option) any later version.
+
+     Freetribe is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty
+        of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+          See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+                       Copyright bangcorrupt 2024
+
+----------------------------------------------------------------------*/
+
+/**
+ * @file    knl_mod.h
+ *
+ * @brief   Public API for kernel modulation engine.
+ */
+
+#ifndef KNL_MOD_H
+#define KNL_MOD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*----- Includes -----------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ft_error.h"
+#include "ft_protocol.h"
+
+/*----- Macros -------------------------------------------------------*/
+
+#define KNL_MOD_ENVELOPES PROTOCOL_MOD_ENVELOPES
+#define KNL_MOD_LFOS PROTOCOL_MOD_LFOS
+#define KNL_MOD_ROUTES PROTOCOL_MOD_ROUTES
+
+/// Exponential envelope segments settle after this many time constants.
+#define KNL_MOD_TIME_CONSTANTS 5
+
+/*----- Typedefs -----------------------------------------------------*/
+
+/// Route from modulation source to module parameter.
+typedef struct {
+
+    // See e_mod_source, MOD_SOURCE_NONE clears route.
+    uint8_t source;
+
+    // Source scaling this route, MOD_SOURCE_NONE for full scale.
+    uint8_t via;
+
+    uint16_t module_id;
+    uint16_t param_index;
+
+    // Full scale source adds depth in parameter units,
+    // or depth octaves in fix16 if parameter is PARAM_SCALE_EXP.
+    int32_t depth;
+
+} t_mod_route;
+
+/*----- Extern variable declarations ---------------------------------*/
+
+/*----- Extern function prototypes -----------------------------------*/
+
+t_status knl_mod_set_source(uint8_t source, uint8_t setting, int32_t value);
+void knl_mod_gate(uint8_t mask, bool gate, int32_t velocity);
+
+t_status knl_mod_set_route(uint8_t route, const t_mod_route *config);
+void knl_mod_reset(void);
+bool knl_mod_routed(uint16_t module_id, uint16_t param_index);
+
+void knl_mod_process(uint16_t frames);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* KNL_MOD_H */
+
+/*----- End of file --------------------------------------------------*/
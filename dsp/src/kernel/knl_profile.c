@@ -37,6 +37,7 @@ under the terms of the GNU Affero General Public License as published by
 /*----- Includes -----------------------------------------------------*/
 
 #include <stdint.h>
+#include <string.h>
 
 #include "per_sport.h"
 
@@ -48,12 +49,29 @@ under the terms of the GNU Affero General Public License as published by
 
 /*----- Static variable definitions ----------------------------------*/
 
+// Rolling log of cycles per block.
+static uint32_t g_cycle_log[CYCLE_LOG_LENGTH];
+static uint32_t g_cycle_log_index;
+static uint64_t g_cycle_log_sum;
+
+// Blocks per bucket, bucket spans 1/CYCLE_HIST_BUCKETS of block period.
+static uint32_t g_cycle_hist[CYCLE_HIST_BUCKETS];
+
+static uint32_t g_min_cycles = UINT32_MAX;
+static uint32_t g_max_cycles;
+static uint32_t g_blocks;
+
+// Overrun count at last reset.
+static uint32_t g_overrun_base;
+
 /*----- Extern variable definitions ----------------------------------*/
 
 uint64_t g_module_cycles = 0;
 
 /*----- Static function prototypes -----------------------------------*/
 
+static uint32_t _percentile(uint32_t period);
+
 /*----- Extern function implementations ------------------------------*/
 
 t_profile knl_profile_stats(void) {
@@ -66,6 +84,111 @@ t_profile knl_profile_stats(void) {
     return stats;
 }
 
+/**
+ * @brief   Record cycles spent processing one block.
+ *
+ * @param[in]   block_cycles    Cycles taken by module_process().
+ */
+void knl_profile_update(uint64_t block_cycles) {
+
+    uint32_t cycles = (uint32_t)block_cycles;
+    uint32_t period = (uint32_t)sport0_period();
+    uint32_t bucket;
+
+    g_module_cycles = block_cycles;
+
+    // Replace oldest entry in rolling log.
+    g_cycle_log_sum -= g_cycle_log[g_cycle_log_index];
+    g_cycle_log_sum += cycles;
+    g_cycle_log[g_cycle_log_index] = cycles;
+    g_cycle_log_index = (g_cycle_log_index + 1) & (CYCLE_LOG_LENGTH - 1);
+
+    if (cycles < g_min_cycles) {
+        g_min_cycles = cycles;
+    }
+    if (cycles > g_max_cycles) {
+        g_max_cycles = cycles;
+    }
+
+    // Period unknown until second block, count in first bucket.
+    bucket = period ? ((uint64_t)cycles * CYCLE_HIST_BUCKETS) / period : 0;
+
+    // Last bucket also counts blocks exceeding period.
+    if (bucket >= CYCLE_HIST_BUCKETS) {
+        bucket = CYCLE_HIST_BUCKETS - 1;
+    }
+    g_cycle_hist[bucket]++;
+
+    g_blocks++;
+}
+
+t_profile_ext knl_profile_stats_ext(void) {
+
+    t_profile_ext stats;
+
+    uint32_t logged =
+        g_blocks < CYCLE_LOG_LENGTH ? g_blocks : CYCLE_LOG_LENGTH;
+
+    stats.period = (uint32_t)sport0_period();
+    stats.cycles = (uint32_t)g_module_cycles;
+    stats.min = g_blocks ? g_min_cycles : 0;
+    stats.max = g_max_cycles;
+    stats.mean = logged ? g_cycle_log_sum / logged : 0;
+    stats.percentile = _percentile(stats.period);
+    stats.blocks = g_blocks;
+    stats.overruns = sport0_overruns() - g_overrun_base;
+
+    return stats;
+}
+
+void knl_profile_reset(void) {
+
+    memset(g_cycle_log, 0, sizeof(g_cycle_log));
+    memset(g_cycle_hist, 0, sizeof(g_cycle_hist));
+
+    g_cycle_log_index = 0;
+    g_cycle_log_sum = 0;
+
+    g_min_cycles = UINT32_MAX;
+    g_max_cycles = 0;
+    g_blocks = 0;
+
+    g_overrun_base = sport0_overruns();
+}
+
 /*----- Static function implementations ------------------------------*/
 
+/**
+ * @brief   Find histogram bucket holding CYCLE_PERCENTILE.
+ *
+ * @param[in]   period  Block period in cycles.
+ *
+ * @return  Upper bound of bucket in cycles, at most maximum.
+ */
+static uint32_t _percentile(uint32_t period) {
+
+    uint64_t target = ((uint64_t)g_blocks * CYCLE_PERCENTILE + 99) / 100;
+    uint64_t count = 0;
+    uint32_t bucket;
+    uint32_t edge;
+
+    if (g_blocks == 0) {
+        return 0;
+    }
+
+    for (bucket = 0; bucket < CYCLE_HIST_BUCKETS - 1; bucket++) {
+
+        count += g_cycle_hist[bucket];
+
+        if (count >= target) {
+            edge = ((uint64_t)period * (bucket + 1)) / CYCLE_HIST_BUCKETS;
+
+            return edge < g_max_cycles ? edge : g_max_cycles;
+        }
+    }
+
+    // Beyond last bucket edge, worst case is best bound.
+    return g_max_cycles;
+}
+
 /*----- End of file --------------------------------------------------*/
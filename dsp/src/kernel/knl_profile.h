@@ -45,7 +45,11 @@ extern "C" {
 
 #include <stdint.h>
 
+#if ARCH_BFIN
 #include <blackfin.h>
+#else
+#include <time.h>
+#endif
 
 /// TODO: Including builtins.h breaks build.
 //
@@ -53,7 +57,14 @@ extern "C" {
 
 /*----- Macros -------------------------------------------------------*/
 
-#define CYCLE_LOG_LENGTH (16)
+/// Number of blocks in rolling cycle log, power of 2.
+#define CYCLE_LOG_LENGTH (256)
+
+/// Number of histogram buckets, each spans an equal part of block period.
+#define CYCLE_HIST_BUCKETS (32)
+
+/// Percentile reported from histogram.
+#define CYCLE_PERCENTILE (99)
 
 /*----- Typedefs -----------------------------------------------------*/
 
@@ -63,12 +74,30 @@ typedef struct {
 
 } t_profile;
 
+typedef struct {
+    uint32_t period;
+    uint32_t cycles;
+    // Minimum and maximum since reset.
+    uint32_t min;
+    uint32_t max;
+    // Mean of last CYCLE_LOG_LENGTH blocks.
+    uint32_t mean;
+    // Upper bound of histogram bucket holding percentile.
+    uint32_t percentile;
+    uint32_t blocks;
+    // Blocks not processed before next block received.
+    uint32_t overruns;
+
+} t_profile_ext;
+
 /*----- Extern variable declarations ---------------------------------*/
 
 extern uint64_t g_module_cycles;
 
 /*----- Extern function prototypes -----------------------------------*/
 
+#if ARCH_BFIN
+
 __inline__ __attribute__((always_inline)) static uint64_t cycles(void) {
 
     uint64_t ret;
@@ -78,7 +107,24 @@ __inline__ __attribute__((always_inline)) static uint64_t cycles(void) {
     return ret;
 }
 
+#else
+
+// Host build counts nanoseconds instead of core cycles.
+__inline__ __attribute__((always_inline)) static uint64_t cycles(void) {
+
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+#endif
+
 t_profile knl_profile_stats(void);
+void knl_profile_update(uint64_t block_cycles);
+t_profile_ext knl_profile_stats_ext(void);
+void knl_profile_reset(void);
 
 #ifdef __cplusplus
 }
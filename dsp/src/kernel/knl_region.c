@@ -0,0 +1,196 @@
+/*----------------------------------------------------------------------
+
+                     This file is part of Freetribe
+
+                https://github.com/bangcorrupt/freetribe
+
+                                License
+
+                   GNU AFFERO GENERAL PUBLIC LICENSE
+                      Version 3, 19 November 2007
+
+                           AGPL-3.0-or-later
+
+ Freetribe is free software: you can redistribute it and/or modify it
+under the terms of the GNU Affero General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+                  (at your option) any later version.
+
+     Freetribe is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty
+        of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+          See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+                       Copyright bangcorrupt 2024
+
+----------------------------------------------------------------------*/
+
+/**
+ * @file    knl_region.c
+ *
+ * @brief   SDRAM regions uploaded by CPU.
+ *
+ * The CPU opens a region, writes it in checksummed chunks, then
+ * closes it with the valid length.  Modules read regions through
+ * knl_region_get(), and should treat a region as empty while it
+ * is not ready.  Uploads run between audio blocks, so a module
+ * never sees a chunk half written.
+ */
+
+/*----- Includes -----------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "ft_protocol.h"
+
+#include "knl_region.h"
+
+/*----- Macros -------------------------------------------------------*/
+
+/*----- Typedefs -----------------------------------------------------*/
+
+/*----- Static variable definitions ----------------------------------*/
+
+static t_region g_regions[KNL_REGION_COUNT];
+
+#if !ARCH_BFIN
+// Host build has no SDRAM at KNL_SDRAM_BASE.
+static uint8_t g_sdram[KNL_REGION_COUNT * KNL_REGION_SIZE];
+#endif
+
+/*----- Extern variable definitions ----------------------------------*/
+
+/*----- Static function prototypes -----------------------------------*/
+
+/*----- Extern function implementations ------------------------------*/
+
+/// Call after SDRAM configured.
+void knl_region_init(void) {
+
+    uint8_t *sdram;
+    uint8_t i;
+
+#if ARCH_BFIN
+    sdram = (uint8_t *)KNL_SDRAM_BASE;
+#else
+    sdram = g_sdram;
+#endif
+
+    for (i = 0; i < KNL_REGION_COUNT; i++) {
+
+        g_regions[i].data = sdram + i * KNL_REGION_SIZE;
+        g_regions[i].size = KNL_REGION_SIZE;
+        g_regions[i].length = 0;
+        g_regions[i].generation = 0;
+        g_regions[i].ready = false;
+    }
+}
+
+/**
+ * @brief   Get region for reading.
+ *
+ * @param[in]   region_id   Index of region.
+ *
+ * @return  Region, or NULL if region_id out of range.
+ */
+const t_region *knl_region_get(uint8_t region_id) {
+
+    if (region_id >= KNL_REGION_COUNT) {
+        return NULL;
+    }
+
+    return &g_regions[region_id];
+}
+
+/**
+ * @brief   Start upload, region is not ready until closed.
+ *
+ * @return  REGION_OK or REGION_BAD_ID.
+ */
+uint8_t knl_region_open(uint8_t region_id) {
+
+    if (region_id >= KNL_REGION_COUNT) {
+        return REGION_BAD_ID;
+    }
+
+    g_regions[region_id].ready = false;
+    g_regions[region_id].length = 0;
+
+    return REGION_OK;
+}
+
+/**
+ * @brief   Copy chunk into region and verify it.
+ *
+ * CRC is checked on the bytes as read back from SDRAM,
+ * so covers the copy as well as the link.
+ *
+ * @param[in]   region_id   Index of region.
+ * @param[in]   offset      Byte offset of chunk in region.
+ * @param[in]   data        Chunk bytes.
+ * @param[in]   length      Chunk length.
+ * @param[in]   crc         CRC-16 of chunk, as protocol_crc16().
+ *
+ * @return  Status from e_region_status.
+ */
+uint8_t knl_region_write(uint8_t region_id, uint32_t offset,
+                         const uint8_t *data, uint16_t length, uint16_t crc) {
+
+    t_region *region;
+    uint8_t *dest;
+
+    if (region_id >= KNL_REGION_COUNT) {
+        return REGION_BAD_ID;
+    }
+
+    region = &g_regions[region_id];
+
+    if (offset > region->size || length > region->size - offset) {
+        return REGION_BAD_RANGE;
+    }
+
+    dest = (uint8_t *)region->data + offset;
+
+    memcpy(dest, data, length);
+
+    if (protocol_crc16(dest, length) != crc) {
+        return REGION_BAD_CRC;
+    }
+
+    return REGION_OK;
+}
+
+/**
+ * @brief   Finish upload and publish valid length.
+ *
+ * @return  REGION_OK, REGION_BAD_ID or REGION_BAD_RANGE.
+ */
+uint8_t knl_region_close(uint8_t region_id, uint32_t length) {
+
+    t_region *region;
+
+    if (region_id >= KNL_REGION_COUNT) {
+        return REGION_BAD_ID;
+    }
+
+    region = &g_regions[region_id];
+
+    if (length > region->size) {
+        return REGION_BAD_RANGE;
+    }
+
+    region->length = length;
+    region->generation++;
+    region->ready = true;
+
+    return REGION_OK;
+}
+
+/*----- Static function implementations ------------------------------*/
+
+/*----- End of file --------------------------------------------------*/
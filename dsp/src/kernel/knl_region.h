@@ -0,0 +1,91 @@
+/*----------------------------------------------------------------------
+
+                     This file is part of Freetribe
+
+                https://github.com/bangcorrupt/freetribe
+
+                                License
+
+                   GNU AFFERO GENERAL PUBLIC LICENSE
+                      Version 3, 19 November 2007
+
+                           AGPL-3.0-or-later
+
+ Freetribe is free software: you can redistribute it and/or modify it
+under the terms of the GNU Affero General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+                  (at your option) any later version.
+
+     Freetribe is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty
+        of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+          See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+                       Copyright bangcorrupt 2024
+
+----------------------------------------------------------------------*/
+
+/**
+ * @file    knl_region.h
+ *
+ * @brief   Public API for SDRAM regions uploaded by CPU.
+ */
+
+#ifndef KNL_REGION_H
+#define KNL_REGION_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*----- Includes -----------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ft_protocol.h"
+
+/*----- Macros -------------------------------------------------------*/
+
+/// SDRAM is split into equal regions, indexed by region id.
+#define KNL_REGION_COUNT 4
+#define KNL_REGION_SIZE 0x800000
+
+/// Start of SDRAM, as configured by ebiu_init().
+#define KNL_SDRAM_BASE 0x00000000
+
+/*----- Typedefs -----------------------------------------------------*/
+
+/// Uploaded data, e.g. samples or wavetables.
+typedef struct {
+    const uint8_t *data;
+    uint32_t size;
+    // Bytes valid once ready.
+    uint32_t length;
+    // Incremented each time an upload completes.
+    uint32_t generation;
+    // False while upload in progress.
+    bool ready;
+} t_region;
+
+/*----- Extern variable declarations ---------------------------------*/
+
+/*----- Extern function prototypes -----------------------------------*/
+
+void knl_region_init(void);
+const t_region *knl_region_get(uint8_t region_id);
+
+uint8_t knl_region_open(uint8_t region_id);
+uint8_t knl_region_write(uint8_t region_id, uint32_t offset,
+                         const uint8_t *data, uint16_t length, uint16_t crc);
+uint8_t knl_region_close(uint8_t region_id, uint32_t length);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* KNL_REGION_H */
+
+/*----- End of file --------------------------------------------------*/
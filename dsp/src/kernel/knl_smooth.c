@@ -0,0 +1,251 @@
+/*----------------------------------------------------------------------
+
+                     This file is part of Freetribe
+
+                https://github.com/bangcorrupt/freetribe
+
+                                License
+
+                   GNU AFFERO GENERAL PUBLIC LICENSE
+                      Version 3, 19 November 2007
+
+                           AGPL-3.0-or-later
+
+ Freetribe is free software: you can redistribute it and/or modify it
+under the terms of the GNU Affero General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+                  (at your option) any later version.
+
+     Freetribe is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty
+        of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+          See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+                       Copyright bangcorrupt 2024
+
+----------------------------------------------------------------------*/
+
+/**
+ * @file    knl_smooth.c
+ *
+ * @brief   Kernel parameter smoothing.
+ *
+ * Parameters with a slew time ramp to each new value instead of
+ * stepping.  Ramps advance once per call to module_process(), so
+ * modules receive a start value and per frame increment, or a
+ * new value each block, rather than filtering every sample.
+ *
+ * Parameters with PARAM_SCALE_EXP approach their target
+ * exponentially, others ramp linearly.  Both land exactly on
+ * target when the slew time has elapsed.
+ */
+
+/*----- Includes -----------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ft_error.h"
+#include "types.h"
+
+#include "knl_smooth.h"
+#include "module.h"
+
+/*----- Macros -------------------------------------------------------*/
+
+#define FRAMES_PER_MS (SAMPLERATE / 1000)
+
+/*----- Typedefs -----------------------------------------------------*/
+
+typedef struct {
+
+    // Module type owning parameter, NULL if slot free.
+    const t_module_type *type;
+    uint16_t param_index;
+
+    // Value reached at end of last block.
+    int32_t current;
+
+    // Frames until target reached.
+    uint32_t remaining;
+
+    // Frames per time constant of exponential ramp.
+    uint32_t time_constant;
+
+} t_smooth;
+
+/*----- Static variable definitions ----------------------------------*/
+
+static t_smooth g_slots[KNL_SMOOTH_SLOTS];
+static uint8_t g_active;
+
+/*----- Extern variable definitions ----------------------------------*/
+
+/*----- Static function prototypes -----------------------------------*/
+
+static t_smooth *_find_slot(const t_module_type *type, uint16_t param_index);
+static int32_t _next_value(t_smooth *slot, int32_t target, uint16_t frames);
+
+/*----- Extern function implementations ------------------------------*/
+
+/**
+ * @brief   Ramp parameter to value stored in module type.
+ *
+ * A parameter already ramping continues from its current value
+ * towards the new target, with the full slew time.
+ *
+ * @param[in]   type        Module type owning parameter.
+ * @param[in]   param_index Index of parameter, descriptor has slew time.
+ * @param[in]   from        Value applied before target was stored.
+ *
+ * @return  SUCCESS, or ERROR if no slot free and value must be applied.
+ */
+t_status knl_smooth_start(const t_module_type *type, uint16_t param_index,
+                          int32_t from) {
+
+    const t_param_desc *desc = &type->params[param_index];
+    t_smooth *slot = _find_slot(type, param_index);
+
+    if (slot == NULL) {
+
+        // Nothing to ramp.
+        if (from == type->values[param_index]) {
+            return SUCCESS;
+        }
+
+        slot = _find_slot(NULL, 0);
+
+        if (slot == NULL) {
+            return ERROR;
+        }
+
+        slot->type = type;
+        slot->param_index = param_index;
+        slot->current = from;
+        g_active++;
+    }
+
+    slot->remaining = desc->slew_ms * FRAMES_PER_MS;
+
+    slot->time_constant = slot->remaining / KNL_SMOOTH_EXP_TIME_CONSTANTS;
+    if (slot->time_constant == 0) {
+        slot->time_constant = 1;
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief   Advance ramps by one block.
+ *
+ * Called before modules process the block.  A ramp that landed
+ * in the previous block is stopped with a zero increment.
+ *
+ * @param[in]   frames  Number of frames in block.
+ */
+void knl_smooth_process(uint16_t frames) {
+
+    const t_param_desc *desc;
+    t_smooth *slot;
+    int32_t target;
+    int32_t next;
+    uint8_t i;
+
+    if (g_active == 0 || frames == 0) {
+        return;
+    }
+
+    for (i = 0; i < KNL_SMOOTH_SLOTS; i++) {
+
+        slot = &g_slots[i];
+
+        if (slot->type == NULL) {
+            continue;
+        }
+
+        desc = &slot->type->params[slot->param_index];
+        target = slot->type->values[slot->param_index];
+
+        if (slot->current == target) {
+
+            if (desc->ramp != NULL) {
+                desc->ramp(target, 0);
+            }
+
+            slot->type = NULL;
+            g_active--;
+            continue;
+        }
+
+        next = _next_value(slot, target, frames);
+
+        if (desc->ramp != NULL) {
+            desc->ramp(slot->current,
+                       ((int64_t)next - slot->current) / frames);
+
+        } else if (desc->set != NULL) {
+            desc->set(next);
+        }
+
+        slot->current = next;
+    }
+}
+
+/*----- Static function implementations ------------------------------*/
+
+// Find slot ramping parameter, or free slot if type is NULL.
+static t_smooth *_find_slot(const t_module_type *type, uint16_t param_index) {
+
+    uint8_t i;
+
+    for (i = 0; i < KNL_SMOOTH_SLOTS; i++) {
+
+        if (g_slots[i].type == type &&
+            (type == NULL || g_slots[i].param_index == param_index)) {
+
+            return &g_slots[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief   Get value at end of block.
+ *
+ * @param[in]   slot    Ramp to advance.
+ * @param[in]   target  Value stored in module type.
+ * @param[in]   frames  Number of frames in block.
+ *
+ * @return  Value reached, target if slew time has elapsed.
+ */
+static int32_t _next_value(t_smooth *slot, int32_t target, uint16_t frames) {
+
+    int64_t delta = (int64_t)target - slot->current;
+
+    if (slot->remaining <= frames) {
+
+        slot->remaining = 0;
+        return target;
+    }
+
+    if (slot->type->params[slot->param_index].scale == PARAM_SCALE_EXP) {
+
+        // Fraction of distance covered is frames per time constant.
+        if (frames < slot->time_constant) {
+            delta = delta * frames / slot->time_constant;
+        }
+
+    } else {
+        delta = delta * frames / slot->remaining;
+    }
+
+    slot->remaining -= frames;
+
+    return slot->current + delta;
+}
+
+/*----- End of file --------------------------------------------------*/
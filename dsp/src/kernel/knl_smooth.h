@@ -0,0 +1,75 @@
+/*----------------------------------------------------------------------
+
+                     This file is part of Freetribe
+
+                https://github.com/bangcorrupt/freetribe
+
+                                License
+
+                   GNU AFFERO GENERAL PUBLIC LICENSE
+                      Version 3, 19 November 2007
+
+                           AGPL-3.0-or-later
+
+ Freetribe is free software: you can redistribute it and/or modify it
+under the terms of the GNU Affero General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+                  (at your option) any later version.
+
+     Freetribe is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty
+        of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+          See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+                       Copyright bangcorrupt 2024
+
+----------------------------------------------------------------------*/
+
+/**
+ * @file    knl_smooth.h
+ *
+ * @brief   Public API for kernel parameter smoothing.
+ */
+
+#ifndef KNL_SMOOTH_H
+#define KNL_SMOOTH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*----- Includes -----------------------------------------------------*/
+
+#include <stdint.h>
+
+#include "ft_error.h"
+#include "module.h"
+
+/*----- Macros -------------------------------------------------------*/
+
+/// Maximum number of parameters ramping at once.
+#define KNL_SMOOTH_SLOTS 16
+
+/// Exponential ramps reach target after this many time constants.
+#define KNL_SMOOTH_EXP_TIME_CONSTANTS 5
+
+/*----- Typedefs -----------------------------------------------------*/
+
+/*----- Extern variable declarations ---------------------------------*/
+
+/*----- Extern function prototypes -----------------------------------*/
+
+t_status knl_smooth_start(const t_module_type *type, uint16_t param_index,
+                          int32_t from);
+
+void knl_smooth_process(uint16_t frames);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* KNL_SMOOTH_H */
+
+/*----- End of file --------------------------------------------------*/
@@ -0,0 +1,232 @@
+/*----------------------------------------------------------------------
+
+                     This file is part of Freetribe
+
+                https://github.com/bangcorrupt/freetribe
+
+                                License
+
+                   GNU AFFERO GENERAL PUBLIC LICENSE
+                      Version 3, 19 November 2007
+
+                           AGPL-3.0-or-later
+
+ Freetribe is free software: you can redistribute it and/or modify it
+under the terms of the GNU Affero General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+                  (at your option) any later version.
+
+     Freetribe is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty
+        of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+          See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+                       Copyright bangcorrupt 2024
+
+----------------------------------------------------------------------*/
+
+/**
+ * @file    knl_telemetry.c
+ *
+ * @brief   Periodic telemetry pushed to CPU.
+ *
+ * Peak and RMS level of each channel are measured over a fixed
+ * number of blocks, then latched for svc_cpu to send with profile
+ * and queue state.  The CPU receives one frame per interval
+ * instead of polling for each metric.
+ */
+
+/*----- Includes -----------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "module.h"
+#include "per_sport.h"
+#include "types.h"
+
+#include "knl_telemetry.h"
+
+/*----- Macros -------------------------------------------------------*/
+
+/*----- Typedefs -----------------------------------------------------*/
+
+/// Level measurement of one channel.
+typedef struct {
+    uint16_t peak;
+    uint64_t sum;
+} t_meter;
+
+typedef struct {
+
+    // Blocks per interval, 0 when disabled.
+    uint32_t interval;
+    uint32_t blocks;
+    uint32_t frames;
+
+    t_meter input[MODULE_CHANNELS];
+    t_meter output[MODULE_CHANNELS];
+
+    t_telemetry latched;
+    bool due;
+
+} t_telemetry_state;
+
+/*----- Static variable definitions ----------------------------------*/
+
+static t_telemetry_state g_telemetry;
+
+/*----- Extern variable definitions ----------------------------------*/
+
+/*----- Static function prototypes -----------------------------------*/
+
+static void _meter(t_meter *meter, const fract32 *block, uint16_t frames);
+static void _latch(t_level *level, t_meter *meter, uint32_t frames);
+static uint32_t _isqrt(uint64_t value);
+
+/*----- Extern function implementations ------------------------------*/
+
+/**
+ * @brief   Set telemetry interval, rounded to whole blocks.
+ *
+ * @param[in]   interval_ms     Milliseconds between frames, 0 disables.
+ */
+void knl_telemetry_set_interval(uint16_t interval_ms) {
+
+    uint32_t interval;
+
+    interval = (uint32_t)interval_ms * SAMPLERATE / 1000 / SPORT_BLOCK_SIZE;
+
+    if (interval_ms > 0 && interval == 0) {
+        interval = 1;
+    }
+
+    memset(&g_telemetry, 0, sizeof(g_telemetry));
+
+    g_telemetry.interval = interval;
+}
+
+/**
+ * @brief   Measure audio block.
+ *
+ * Call after each block is processed.
+ *
+ * @param[in]   in      Codec input block.
+ * @param[in]   out     Module output block.
+ * @param[in]   frames  Number of interleaved frames in each block.
+ */
+void knl_telemetry_process(const fract32 *in, const fract32 *out,
+                           uint16_t frames) {
+
+    uint8_t channel;
+
+    if (g_telemetry.interval == 0) {
+        return;
+    }
+
+    for (channel = 0; channel < MODULE_CHANNELS; channel++) {
+        _meter(&g_telemetry.input[channel], in + channel, frames);
+        _meter(&g_telemetry.output[channel], out + channel, frames);
+    }
+
+    g_telemetry.frames += frames;
+
+    if (++g_telemetry.blocks < g_telemetry.interval) {
+        return;
+    }
+
+    // Latest interval replaces one not yet sent.
+    for (channel = 0; channel < MODULE_CHANNELS; channel++) {
+        _latch(&g_telemetry.latched.input[channel],
+               &g_telemetry.input[channel], g_telemetry.frames);
+        _latch(&g_telemetry.latched.output[channel],
+               &g_telemetry.output[channel], g_telemetry.frames);
+    }
+
+    g_telemetry.blocks = 0;
+    g_telemetry.frames = 0;
+    g_telemetry.due = true;
+}
+
+/**
+ * @brief   Take levels of last interval, if not already taken.
+ *
+ * @param[out]  telemetry   Latched levels.
+ *
+ * @return  True if telemetry frame due.
+ */
+bool knl_telemetry_due(t_telemetry *telemetry) {
+
+    if (!g_telemetry.due) {
+        return false;
+    }
+
+    *telemetry = g_telemetry.latched;
+    g_telemetry.due = false;
+
+    return true;
+}
+
+/*----- Static function implementations ------------------------------*/
+
+// Accumulate peak and sum of squares of one interleaved channel.
+static void _meter(t_meter *meter, const fract32 *block, uint16_t frames) {
+
+    int32_t sample;
+    uint16_t level;
+    uint16_t i;
+
+    for (i = 0; i < frames; i++) {
+
+        sample = *block >> 16;
+        block += MODULE_CHANNELS;
+
+        level = sample < 0 ? -sample : sample;
+
+        if (level > meter->peak) {
+            meter->peak = level;
+        }
+
+        meter->sum += sample * sample;
+    }
+}
+
+static void _latch(t_level *level, t_meter *meter, uint32_t frames) {
+
+    level->peak = meter->peak;
+    level->rms = _isqrt(meter->sum / frames);
+
+    meter->peak = 0;
+    meter->sum = 0;
+}
+
+// Integer square root, once per channel per interval.
+static uint32_t _isqrt(uint64_t value) {
+
+    uint64_t bit = (uint64_t)1 << 62;
+    uint64_t root = 0;
+
+    while (bit > value) {
+        bit >>= 2;
+    }
+
+    while (bit != 0) {
+
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return root;
+}
+
+/*----- End of file --------------------------------------------------*/
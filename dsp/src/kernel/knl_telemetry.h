@@ -0,0 +1,82 @@
+/*----------------------------------------------------------------------
+
+                     This file is part of Freetribe
+
+                https://github.com/bangcorrupt/freetribe
+
+                                License
+
+                   GNU AFFERO GENERAL PUBLIC LICENSE
+                      Version 3, 19 November 2007
+
+                           AGPL-3.0-or-later
+
+ Freetribe is free software: you can redistribute it and/or modify it
+under the terms of the GNU Affero General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+                  (at your option) any later version.
+
+     Freetribe is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty
+        of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+          See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+                       Copyright bangcorrupt 2024
+
+----------------------------------------------------------------------*/
+
+/**
+ * @file    knl_telemetry.h
+ *
+ * @brief   Public API for periodic telemetry pushed to CPU.
+ */
+
+#ifndef KNL_TELEMETRY_H
+#define KNL_TELEMETRY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*----- Includes -----------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "module.h"
+#include "types.h"
+
+/*----- Macros -------------------------------------------------------*/
+
+/*----- Typedefs -----------------------------------------------------*/
+
+/// Level of one channel over telemetry interval, Q15.
+typedef struct {
+    uint16_t peak;
+    uint16_t rms;
+} t_level;
+
+/// Levels latched at end of telemetry interval.
+typedef struct {
+    t_level input[MODULE_CHANNELS];
+    t_level output[MODULE_CHANNELS];
+} t_telemetry;
+
+/*----- Extern variable declarations ---------------------------------*/
+
+/*----- Extern function prototypes -----------------------------------*/
+
+void knl_telemetry_set_interval(uint16_t interval_ms);
+void knl_telemetry_process(const fract32 *in, const fract32 *out,
+                           uint16_t frames);
+bool knl_telemetry_due(t_telemetry *telemetry);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* KNL_TELEMETRY_H */
+
+/*----- End of file --------------------------------------------------*/
@@ -47,7 +47,11 @@ under the terms of the GNU Affero General Public License as published by
 #include "per_sport.h"
 #include "svc_cpu.h"
 
+#include "knl_capture.h"
+#include "knl_event.h"
 #include "knl_profile.h"
+#include "knl_telemetry.h"
+#include "knl_region.h"
 
 /*----- Macros -------------------------------------------------------*/
 
@@ -87,6 +91,9 @@ int main(void) {
     pll_init();
     ebiu_init();
 
+    // Upload regions in SDRAM.
+    knl_region_init();
+
     per_gpio_init();
 
     sysint_init();
@@ -102,7 +109,7 @@ int main(void) {
 
     while (true) {
 
-        if (sport0_frame_received()) {
+        if (sport0_block_received()) {
 
             start = cycles();
 
@@ -110,13 +117,22 @@ int main(void) {
 
             /// TODO: Maybe disable interrupts while processing audio.
             //
-            module_process(sport0_get_rx_buffer(), sport0_get_tx_buffer());
+            knl_event_process(sport0_get_rx_buffer(), sport0_get_tx_buffer(),
+                              SPORT_BLOCK_SIZE);
+
+            // Tap block for capture stream.
+            knl_capture_process(sport0_get_rx_buffer(), sport0_get_tx_buffer(),
+                                SPORT_BLOCK_SIZE);
+
+            // Measure levels for telemetry.
+            knl_telemetry_process(sport0_get_rx_buffer(),
+                                  sport0_get_tx_buffer(), SPORT_BLOCK_SIZE);
 
-            sport0_frame_processed();
+            sport0_block_processed();
 
             stop = cycles();
 
-            g_module_cycles = stop - start;
+            knl_profile_update(stop - start);
 
             // enable_interrupts();
         }
@@ -33,55 +33,506 @@ under the terms of the GNU Affero General Public License as published by
 /**
  * @file    module.c
  *
- * @brief   Audio processing module.
+ * @brief   Audio processing module graph.
+ *
+ * Nodes are instances of module types linked in this build,
+ * addressed by module_id, the index of the node in the graph.
+ * Each node takes input from the graph input or one other node.
+ * Processing order is resolved when the graph is built.
+ * Parameters are set and queried through each type's table
+ * of descriptors, indexed by param_index.  Parameters with a
+ * slew time are ramped by knl_smooth, and may be modulated
+ * by knl_mod.
  */
 
 /*----- Includes -----------------------------------------------------*/
 
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "ft_error.h"
+
 #include "module.h"
+#include "per_sport.h"
+#include "utils.h"
+
+#include "knl_mod.h"
+#include "knl_profile.h"
+#include "knl_smooth.h"
 
 /*----- Macros -------------------------------------------------------*/
 
+#define MODULE_TYPE_COUNT                                                      \
+    (sizeof(g_module_types) / sizeof(g_module_types[0]))
+
 /*----- Typedefs -----------------------------------------------------*/
 
+typedef struct {
+
+    const t_module_type *type;
+
+    uint8_t source;
+
+    // Cycles spent processing last block.
+    uint32_t cycles;
+
+    fract32 buffer[SPORT0_BLOCK_WORDS];
+
+} t_node;
+
+/*----- Extern variable declarations ---------------------------------*/
+
+#define MODULE_TYPE(name) extern const t_module_type g_module_##name;
+MODULE_TYPES
+#undef MODULE_TYPE
+
 /*----- Static variable definitions ----------------------------------*/
 
+#define MODULE_TYPE(name) &g_module_##name,
+static const t_module_type *const g_module_types[] = {MODULE_TYPES};
+#undef MODULE_TYPE
+
+static bool g_type_initialised[MODULE_TYPE_COUNT];
+
+static t_node g_nodes[MODULE_MAX_NODES];
+static uint8_t g_node_count;
+
+// Node indices in processing order.
+static uint8_t g_order[MODULE_MAX_NODES];
+
+// Last configured node provides graph output.
+static uint8_t g_output;
+
+// Output node has no dependents, so writes graph output directly.
+static bool g_output_direct;
+
 /*----- Extern variable definitions ----------------------------------*/
 
 /*----- Static function prototypes -----------------------------------*/
 
+static t_status _resolve_order(const t_module_node *nodes, uint8_t count,
+                               uint8_t *order);
+
+static void _init_params(const t_module_type *type);
+static void _set_param(const t_module_type *type, uint16_t param_index,
+                       int32_t value, bool smooth);
+static int32_t _store_param(const t_module_type *type, uint16_t param_index,
+                            int32_t value);
+static void _apply_param(const t_param_desc *desc, int32_t value);
+
 /*----- Extern function implementations ------------------------------*/
 
-__attribute__((weak)) void module_init(void) {
-    //
+/**
+ * @brief   Build default graph, a chain of linked module types.
+ */
+void module_init(void) {
+
+    t_module_node nodes[MODULE_MAX_NODES];
+    uint8_t count = 0;
+
+    while (count < MODULE_TYPE_COUNT && count < MODULE_MAX_NODES) {
+
+        nodes[count].type = count;
+        nodes[count].source = count ? count - 1 : MODULE_SOURCE_INPUT;
+        count++;
+    }
+
+    module_build_graph(nodes, count);
 }
 
-__attribute__((weak)) void module_process(fract32 *in, fract32 *out) {
-    //
+/**
+ * @brief   Process audio through graph.
+ *
+ * @param[in]   in      Pointer to input buffer.
+ * @param[out]  out     Pointer to output buffer.
+ * @param[in]   frames  Number of interleaved frames in each buffer.
+ */
+void module_process(fract32 *in, fract32 *out, uint16_t frames) {
+
+    t_node *node;
+    fract32 *src;
+    fract32 *dst;
+    uint64_t start;
+    uint8_t i;
+
+    if (g_node_count == 0) {
+        memset(out, 0, frames * MODULE_CHANNELS * sizeof(fract32));
+        return;
+    }
+
+    // Advance parameter ramps and modulation for this block.
+    knl_smooth_process(frames);
+    knl_mod_process(frames);
+
+    for (i = 0; i < g_node_count; i++) {
+
+        node = &g_nodes[g_order[i]];
+
+        src = node->source == MODULE_SOURCE_INPUT
+                  ? in
+                  : g_nodes[node->source].buffer;
+
+        dst = g_order[i] == g_output && g_output_direct ? out : node->buffer;
+
+        start = cycles();
+
+        node->type->process(src, dst, frames);
+
+        node->cycles = (uint32_t)(cycles() - start);
+    }
+
+    if (!g_output_direct) {
+        memcpy(out, g_nodes[g_output].buffer,
+               frames * MODULE_CHANNELS * sizeof(fract32));
+    }
 }
 
-__attribute__((weak)) void module_set_param(uint16_t param_index,
-                                            int32_t value) {
-    //
+/**
+ * @brief   Replace processing graph.
+ *
+ * Must not be called from interrupt context, graph is not
+ * modified while module_process() runs.  Each module type may
+ * appear once, as module state is per type.  Last node provides
+ * graph output.  Modulation routes are cleared.
+ *
+ * @param[in]   nodes   Node configuration, indexed by module_id.
+ * @param[in]   count   Number of nodes.
+ *
+ * @return  SUCCESS, or ERROR if configuration invalid.
+ */
+t_status module_build_graph(const t_module_node *nodes, uint8_t count) {
+
+    uint8_t order[MODULE_MAX_NODES];
+    uint8_t i;
+    uint8_t j;
+
+    if (count == 0 || count > MODULE_MAX_NODES) {
+        return ERROR;
+    }
+
+    for (i = 0; i < count; i++) {
+
+        if (nodes[i].type >= MODULE_TYPE_COUNT) {
+            return ERROR;
+        }
+        for (j = 0; j < i; j++) {
+            if (nodes[j].type == nodes[i].type) {
+                return ERROR;
+            }
+        }
+    }
+
+    if (_resolve_order(nodes, count, order) != SUCCESS) {
+        return ERROR;
+    }
+
+    g_output = count - 1;
+    g_output_direct = true;
+
+    for (i = 0; i < count; i++) {
+
+        g_nodes[i].type = g_module_types[nodes[i].type];
+        g_nodes[i].source = nodes[i].source;
+        g_nodes[i].cycles = 0;
+
+        memset(g_nodes[i].buffer, 0, sizeof(g_nodes[i].buffer));
+
+        if (nodes[i].source == g_output) {
+            g_output_direct = false;
+        }
+
+        if (!g_type_initialised[nodes[i].type]) {
+
+            g_nodes[i].type->init();
+            _init_params(g_nodes[i].type);
+            g_type_initialised[nodes[i].type] = true;
+        }
+    }
+
+    memcpy(g_order, order, count);
+    g_node_count = count;
+
+    // Routes address nodes of previous graph.
+    knl_mod_reset();
+
+    return SUCCESS;
 }
 
-__attribute__((weak)) int32_t module_get_param(uint16_t param_index) {
-    //
-    return 0;
+/**
+ * @brief   Set parameter through descriptor table.
+ *
+ * Value is clamped to descriptor range and stored before
+ * the setter is called, or a ramp started if the descriptor
+ * has a slew time.  Routed parameters are only stored, as
+ * the base for modulation.  Unknown indices are ignored.
+ *
+ * @param[in]   module_id   Index of node in graph.
+ * @param[in]   param_index Index of parameter in module type.
+ * @param[in]   value       Value of parameter.
+ */
+void module_set_param(uint16_t module_id, uint16_t param_index,
+                      int32_t value) {
+
+    if (module_id >= g_node_count) {
+        return;
+    }
+
+    // Modulation applies routed parameters each block.
+    if (knl_mod_routed(module_id, param_index)) {
+        _store_param(g_nodes[module_id].type, param_index, value);
+
+    } else {
+        _set_param(g_nodes[module_id].type, param_index, value, true);
+    }
+}
+
+/**
+ * @brief   Get last value set for parameter.
+ *
+ * @param[in]   module_id   Index of node in graph.
+ * @param[in]   param_index Index of parameter in module type.
+ *
+ * @return  Value of parameter, or 0 if index invalid.
+ */
+int32_t module_get_param(uint16_t module_id, uint16_t param_index) {
+
+    int32_t value = 0;
+
+    if (module_id < g_node_count &&
+        param_index < g_nodes[module_id].type->param_count) {
+
+        value = g_nodes[module_id].type->values[param_index];
+    }
+
+    return value;
 }
 
 // Get number of parameters
-__attribute__((weak)) uint32_t module_get_param_count(void) {
-    //
-    return 0;
+uint16_t module_get_param_count(uint16_t module_id) {
+
+    uint16_t count = 0;
+
+    if (module_id < g_node_count) {
+        count = g_nodes[module_id].type->param_count;
+    }
+
+    return count;
 }
 
 // Buffer 'text' must provide 'MAX_PARAM_NAME_LENGTH' bytes of storage.
-__attribute__((weak)) void module_get_param_name(uint16_t param_index,
-                                                 char *text) {
-    //
+void module_get_param_name(uint16_t module_id, uint16_t param_index,
+                           char *text) {
+
+    const t_param_desc *desc = module_get_param_desc(module_id, param_index);
+
+    text[0] = '\0';
+
+    if (desc != NULL) {
+        copy_string(text, (char *)desc->name, MAX_PARAM_NAME_LENGTH);
+    }
+}
+
+/**
+ * @brief   Get parameter descriptor.
+ *
+ * @param[in]   module_id   Index of node in graph.
+ * @param[in]   param_index Index of parameter in module type.
+ *
+ * @return  Pointer to descriptor, or NULL if index invalid.
+ */
+const t_param_desc *module_get_param_desc(uint16_t module_id,
+                                          uint16_t param_index) {
+
+    const t_param_desc *desc = NULL;
+
+    if (module_id < g_node_count &&
+        param_index < g_nodes[module_id].type->param_count) {
+
+        desc = &g_nodes[module_id].type->params[param_index];
+    }
+
+    return desc;
+}
+
+/**
+ * @brief   Apply value to module without storing it.
+ *
+ * Used by modulation, stored value remains the base.  Modules
+ * with a ramp setter receive a per frame increment, others
+ * receive the value at end of block.
+ *
+ * @param[in]   module_id   Index of node in graph.
+ * @param[in]   param_index Index of parameter in module type.
+ * @param[in]   from        Value at first frame of block, in range.
+ * @param[in]   to          Value at end of block, in range.
+ * @param[in]   frames      Number of frames in block, 0 to step.
+ */
+void module_apply_param(uint16_t module_id, uint16_t param_index,
+                        int32_t from, int32_t to, uint16_t frames) {
+
+    const t_param_desc *desc = module_get_param_desc(module_id, param_index);
+
+    if (desc == NULL) {
+        return;
+    }
+
+    if (desc->ramp != NULL) {
+        desc->ramp(frames ? from : to,
+                   frames ? ((int64_t)to - from) / frames : 0);
+
+    } else if (desc->set != NULL) {
+        desc->set(to);
+    }
+}
+
+// Get number of nodes in graph.
+uint8_t module_get_node_count(void) { return g_node_count; }
+
+/**
+ * @brief   Get cycles spent processing last block.
+ *
+ * @param[in]   module_id   Index of node in graph.
+ */
+uint32_t module_get_cycles(uint16_t module_id) {
+
+    uint32_t cycles = 0;
+
+    if (module_id < g_node_count) {
+        cycles = g_nodes[module_id].cycles;
+    }
+
+    return cycles;
 }
 
 /*----- Static function implementations ------------------------------*/
 
+/**
+ * @brief   Order nodes so each follows its source.
+ *
+ * Nodes keep configured order where possible.
+ *
+ * @param[in]   nodes   Node configuration.
+ * @param[in]   count   Number of nodes.
+ * @param[out]  order   Node indices in processing order.
+ *
+ * @return  SUCCESS, or ERROR if sources are invalid or form a loop.
+ */
+static t_status _resolve_order(const t_module_node *nodes, uint8_t count,
+                               uint8_t *order) {
+
+    bool placed[MODULE_MAX_NODES] = {false};
+    uint8_t ordered = 0;
+    uint8_t progress;
+    uint8_t i;
+
+    for (i = 0; i < count; i++) {
+
+        if (nodes[i].source != MODULE_SOURCE_INPUT &&
+            (nodes[i].source >= count || nodes[i].source == i)) {
+            return ERROR;
+        }
+    }
+
+    while (ordered < count) {
+
+        progress = ordered;
+
+        for (i = 0; i < count; i++) {
+
+            if (!placed[i] && (nodes[i].source == MODULE_SOURCE_INPUT ||
+                               placed[nodes[i].source])) {
+
+                order[ordered++] = i;
+                placed[i] = true;
+            }
+        }
+
+        // No node ready, remaining sources form a loop.
+        if (ordered == progress) {
+            return ERROR;
+        }
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief   Set each parameter of module type to initial value.
+ *
+ * @param[in]   type    Module type, already initialised.
+ */
+static void _init_params(const t_module_type *type) {
+
+    uint16_t i;
+
+    for (i = 0; i < type->param_count; i++) {
+        _set_param(type, i, type->params[i].init, false);
+    }
+}
+
+/**
+ * @brief   Clamp and store parameter, then ramp or apply it.
+ *
+ * @param[in]   type        Module type owning parameter.
+ * @param[in]   param_index Index of parameter.
+ * @param[in]   value       Value of parameter.
+ * @param[in]   smooth      Ramp if descriptor has slew time.
+ */
+static void _set_param(const t_module_type *type, uint16_t param_index,
+                       int32_t value, bool smooth) {
+
+    int32_t previous;
+
+    if (param_index >= type->param_count) {
+        return;
+    }
+
+    previous = _store_param(type, param_index, value);
+
+    // Step if no ramp slot free.
+    if (smooth && type->params[param_index].slew_ms > 0 &&
+        knl_smooth_start(type, param_index, previous) == SUCCESS) {
+        return;
+    }
+
+    _apply_param(&type->params[param_index], type->values[param_index]);
+}
+
+/**
+ * @brief   Clamp parameter to descriptor range and store it.
+ *
+ * @return  Value stored before.
+ */
+static int32_t _store_param(const t_module_type *type, uint16_t param_index,
+                            int32_t value) {
+
+    const t_param_desc *desc;
+    int32_t previous;
+
+    if (param_index >= type->param_count) {
+        return 0;
+    }
+
+    desc = &type->params[param_index];
+
+    value = value < desc->min ? desc->min : value;
+    value = value > desc->max ? desc->max : value;
+
+    previous = type->values[param_index];
+    type->values[param_index] = value;
+
+    return previous;
+}
+
+static void _apply_param(const t_param_desc *desc, int32_t value) {
+
+    if (desc->ramp != NULL) {
+        desc->ramp(value, 0);
+
+    } else if (desc->set != NULL) {
+        desc->set(value);
+    }
+}
+
 /*----- End of file --------------------------------------------------*/
@@ -45,6 +45,11 @@ extern "C" {
 
 /*----- Includes -----------------------------------------------------*/
 
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ft_error.h"
+#include "ft_protocol.h"
 #include "types.h"
 
 /*----- Macros -------------------------------------------------------*/
@@ -55,18 +60,107 @@ extern "C" {
 
 #define MAX_PARAM_NAME_LENGTH 16
 
+/// Audio buffers hold interleaved stereo frames.
+#define MODULE_CHANNELS 2
+
+/// Maximum number of nodes in processing graph.
+#define MODULE_MAX_NODES 8
+
+/// Node source for graph input.
+#define MODULE_SOURCE_INPUT 0xff
+
+/// Module types linked in this build, in order of type index.
+/// Set from MODULE list by Makefile.
+#ifndef MODULE_TYPES
+#define MODULE_TYPES MODULE_TYPE(default)
+#endif
+
+/// Declare module type descriptor.
+/// Module source files export one, e.g. 'MODULE_EXPORT(attenuate) = {...}'.
+#define MODULE_EXPORT(name) const t_module_type g_module_##name
+
 /*----- Typedefs -----------------------------------------------------*/
 
+/// Parameter descriptor, one per parameter index.
+typedef struct {
+
+    // At most MAX_PARAM_NAME_LENGTH - 1 characters.
+    const char *name;
+
+    // Values set are clamped to range.
+    int32_t min;
+    int32_t max;
+
+    // Value set when module type is initialised.
+    int32_t init;
+
+    // Control mapping, see e_param_scale.
+    uint8_t scale;
+
+    // Time to reach new value, 0 to step.
+    // Kernel ramps value, see knl_smooth.c.
+    uint16_t slew_ms;
+
+    // Apply value to module state, NULL if value is only stored.
+    // While ramping, called once per block with value at block end.
+    void (*set)(int32_t value);
+
+    // Optional, replaces set.  Apply value at first frame of block,
+    // module adds step after each frame.  Step is 0 when not ramping.
+    void (*ramp)(int32_t value, int32_t step);
+
+} t_param_desc;
+
+/// Module type descriptor, exported by each module.
+typedef struct {
+
+    const char *name;
+
+    void (*init)(void);
+    void (*process)(fract32 *in, fract32 *out, uint16_t frames);
+
+    // Parameters, indexed by param_index.
+    const t_param_desc *params;
+    uint16_t param_count;
+
+    // Last value set for each parameter, param_count words.
+    int32_t *values;
+
+} t_module_type;
+
+/// Graph node configuration.
+typedef struct {
+
+    // Index of module type in MODULE_TYPES.
+    uint8_t type;
+
+    // Index of node providing input, or MODULE_SOURCE_INPUT.
+    uint8_t source;
+
+} t_module_node;
+
 /*----- Extern variable declarations ---------------------------------*/
 
 /*----- Extern function prototypes -----------------------------------*/
 
 void module_init(void);
-void module_process(fract32 *in, fract32 *out);
-void module_set_param(uint16_t index, int32_t value);
-int32_t module_get_param(uint16_t index);
-uint32_t module_get_param_count(void); /// TODO: return uint16_t ?
-void module_get_param_name(uint16_t param_index, char *text);
+void module_process(fract32 *in, fract32 *out, uint16_t frames);
+
+t_status module_build_graph(const t_module_node *nodes, uint8_t count);
+
+void module_set_param(uint16_t module_id, uint16_t param_index,
+                      int32_t value);
+int32_t module_get_param(uint16_t module_id, uint16_t param_index);
+uint16_t module_get_param_count(uint16_t module_id);
+void module_get_param_name(uint16_t module_id, uint16_t param_index,
+                           char *text);
+const t_param_desc *module_get_param_desc(uint16_t module_id,
+                                          uint16_t param_index);
+void module_apply_param(uint16_t module_id, uint16_t param_index,
+                        int32_t from, int32_t to, uint16_t frames);
+
+uint8_t module_get_node_count(void);
+uint32_t module_get_cycles(uint16_t module_id);
 
 #ifdef __cplusplus
 }
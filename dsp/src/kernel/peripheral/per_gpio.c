@@ -89,6 +89,9 @@ void per_gpio_init(void) {
     // p0, p7, p9, p10 are outputs.
     *pPORTGIO_DIR = HWAIT | UART0_TX | PG9 | PG10;
 
+    // No data ready for CPU.
+    *pPORTGIO_CLEAR = PG9;
+
     *pPORTGIO_SET = HWAIT | UART0_TX;
     ssync();
 }
@@ -100,7 +103,38 @@ bool per_gpio_get(uint8_t port, uint8_t pin) {
 }
 
 void per_gpio_set(uint8_t port, uint8_t pin, bool state) {
-    //
+
+    uint16_t mask = 1 << pin;
+
+    switch (port) {
+
+    case PORT_F:
+        if (state) {
+            *pPORTFIO_SET = mask;
+        } else {
+            *pPORTFIO_CLEAR = mask;
+        }
+        break;
+
+    case PORT_G:
+        if (state) {
+            *pPORTGIO_SET = mask;
+        } else {
+            *pPORTGIO_CLEAR = mask;
+        }
+        break;
+
+    case PORT_H:
+        if (state) {
+            *pPORTHIO_SET = mask;
+        } else {
+            *pPORTHIO_CLEAR = mask;
+        }
+        break;
+
+    default:
+        break;
+    }
 }
 
 void per_gpio_toggle(uint8_t port, uint8_t pin) {
@@ -43,6 +43,7 @@ extern "C" {
 
 /*----- Includes -----------------------------------------------------*/
 
+#include <stdbool.h>
 #include <stdint.h>
 
 /*----- Macros -------------------------------------------------------*/
@@ -50,6 +51,9 @@ extern "C" {
 #define HWAIT PG0
 #define UART0_TX PG7
 
+/// PG9 high while DSP has bytes queued for CPU.
+#define DATA_READY_PIN 9
+
 /*----- Typedefs -----------------------------------------------------*/
 
 typedef enum { PORT_F, PORT_G, PORT_H } e_port;
@@ -59,6 +63,7 @@ typedef enum { PORT_F, PORT_G, PORT_H } e_port;
 /*----- Extern function prototypes -----------------------------------*/
 
 void per_gpio_init(void);
+void per_gpio_set(uint8_t port, uint8_t pin, bool state);
 uint16_t per_gpio_get_port(uint8_t port);
 void per_gpio_set_port(uint8_t port, uint16_t value);
 
@@ -0,0 +1,91 @@
+/*----------------------------------------------------------------------
+
+                     This file is part of Freetribe
+
+                https://github.com/bangcorrupt/freetribe
+
+                                License
+
+                   GNU AFFERO GENERAL PUBLIC LICENSE
+                      Version 3, 19 November 2007
+
+                           AGPL-3.0-or-later
+
+ Freetribe is free software: you can redistribute it and/or modify it
+under the terms of the GNU Affero General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+                  (at your option) any later version.
+
+     Freetribe is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty
+        of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+          See the GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+                       Copyright bangcorrupt 2024
+
+----------------------------------------------------------------------*/
+
+/**
+ * @file    per_hostdp.c
+ *
+ * @brief   Peripheral driver for BF523 Host DMA Port.
+ *
+ * The host configures and runs each DMA itself, so the core
+ * only enables the port and tells the host where to look.
+ */
+
+/*----- Includes -----------------------------------------------------*/
+
+#include <stdint.h>
+
+#include <blackfin.h>
+#include <builtins.h>
+
+#include "per_hostdp.h"
+
+/*----- Macros -------------------------------------------------------*/
+
+/*----- Typedefs -----------------------------------------------------*/
+
+/*----- Static variable definitions ----------------------------------*/
+
+/*----- Extern variable definitions ----------------------------------*/
+
+/*----- Static function prototypes -----------------------------------*/
+
+/*----- Extern function implementations ------------------------------*/
+
+/// TODO: Port function enable and mux for HostDP pins,
+///       confirm which pins are wired to CPU EMIFA.
+
+void per_hostdp_init(void) {
+
+    // 16 bit, little endian, acknowledge on write and read.
+    *pHOST_CONTROL = HOST_EN | DATA_SIZE | EHW | EHR;
+    ssync();
+}
+
+/**
+ * @brief   Get address host uses to reach buffer.
+ *
+ * Host DMA reaches L1 data and SDRAM directly,
+ * so this is the core address.
+ *
+ * @param[in]   buffer  Memory shared with host.
+ * @param[in]   length  Length of buffer.
+ *
+ * @return  Address for host configuration.
+ */
+uint32_t per_hostdp_expose(void *buffer, uint32_t length) {
+
+    (void)length;
+
+    return (uint32_t)buffer;
+}
+
+/*----- Static function implementations ------------------------------*/
+
+/*----- End of file --------------------------------------------------*/
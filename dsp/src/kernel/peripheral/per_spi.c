@@ -56,12 +56,8 @@ under the terms of the GNU Affero General Public License as published by
 
 typedef struct {
 
-    uint8_t *tx_buffer;
-    uint8_t *rx_buffer;
+    t_spi_stream *stream;
 
-    uint32_t trx_length;
-
-    void (*trx_callback)();
     void (*error_callback)();
 
 } t_spi;
@@ -124,14 +120,22 @@ void per_spi_init(void) {
     *pPORTGIO_CLEAR = HWAIT;
 }
 
-void per_spi_trx_int(uint8_t *tx_buffer, uint8_t *rx_buffer, uint32_t length) {
-
-    if (tx_buffer != NULL && tx_buffer != NULL && length != 0) {
+/**
+ * @brief   Stream every transfer through circular buffers.
+ *
+ * Each byte received is stored at rx_head, and the next queued
+ * byte, or 0 when idle, is loaded for the following transfer.
+ * The transfer is never re-armed, so the interrupt does no
+ * more than move one byte each way.
+ *
+ * @param[in]   stream  Buffers, owned by caller.
+ */
+void per_spi_stream(t_spi_stream *stream) {
 
-        g_spi.rx_buffer = rx_buffer;
-        g_spi.tx_buffer = tx_buffer;
+    if (stream != NULL && stream->rx_buffer != NULL &&
+        stream->tx_buffer != NULL) {
 
-        g_spi.trx_length = length;
+        g_spi.stream = stream;
 
         _spi_interrupt_enable(SPI_DATA_INT);
     }
@@ -141,10 +145,6 @@ void per_spi_register_callback(t_spi_event event, void (*callback)()) {
 
     switch (event) {
 
-    case EVT_SPI_TRX_COMPLETE:
-        g_spi.trx_callback = callback;
-        break;
-
     case EVT_SPI_ERROR:
         g_spi.error_callback = callback;
         break;
@@ -172,19 +172,24 @@ static inline void _spi_interrupt_disable(uint32_t int_flags) {
 
 __attribute__((interrupt_handler)) static void _spi_isr(void) {
 
+    t_spi_stream *stream = g_spi.stream;
+
     *pPORTGIO_SET = HWAIT;
 
-    *g_spi.rx_buffer++ = *pSPI_RDBR;
+    stream->rx_buffer[stream->rx_head & stream->rx_mask] = *pSPI_RDBR;
+    stream->rx_head++;
 
-    *pSPI_TDBR = *g_spi.tx_buffer++;
+    if (stream->tx_tail != stream->tx_head) {
 
-    if (--g_spi.trx_length == 0) {
+        // Byte loaded for next transfer.
+        *pSPI_TDBR = stream->tx_buffer[stream->tx_tail & stream->tx_mask];
+        stream->tx_tail++;
 
-        _spi_interrupt_disable(SPI_DATA_INT);
+    } else {
+        *pSPI_TDBR = 0;
 
-        if (g_spi.trx_callback != NULL) {
-            g_spi.trx_callback();
-        }
+        // Last queued byte has been clocked out.
+        *pPORTGIO_CLEAR = 1 << DATA_READY_PIN;
     }
 
     ssync();
@@ -50,17 +50,37 @@ extern "C" {
 /*----- Typedefs -----------------------------------------------------*/
 
 typedef enum {
-    EVT_SPI_TRX_COMPLETE,
     EVT_SPI_ERROR,
 } t_spi_event;
 
+/**
+ * Circular buffers streamed by SPI interrupt.
+ *
+ * Lengths are powers of 2, indices wrap through the mask.
+ * Each side only writes its own index.
+ */
+typedef struct {
+
+    uint8_t *rx_buffer;
+    uint32_t rx_mask;
+    // Written by interrupt.
+    volatile uint32_t rx_head;
+
+    uint8_t *tx_buffer;
+    uint32_t tx_mask;
+    volatile uint32_t tx_head;
+    // Written by interrupt.
+    volatile uint32_t tx_tail;
+
+} t_spi_stream;
+
 /*----- Extern variable declarations ---------------------------------*/
 
 /*----- Extern function prototypes -----------------------------------*/
 
 void per_spi_init(void);
 void per_spi_register_callback(t_spi_event event, void (*callback)());
-void per_spi_trx_int(uint8_t *tx_buffer, uint8_t *rx_buffer, uint32_t length);
+void per_spi_stream(t_spi_stream *stream);
 
 #ifdef __cplusplus
 }
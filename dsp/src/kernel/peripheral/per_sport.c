@@ -54,78 +54,170 @@ under the terms of the GNU Affero General Public License as published by
 //
 #define DTYPE_SIGX 0x0004 /* SPORTx RCR1 Data Format Sign Extend */
 
+// Multichannel window size, in groups of 8 channels.
+#define SPORT_MCMC1_WSIZE(channels) (((((channels) + 7) >> 3) - 1) << 12)
+// Multichannel frame delay, in serial clock cycles.
+#define SPORT_MCMC2_MFD(delay) ((delay) << 12)
+
+// Channel select mask for first 'channels' channels.
+#define SPORT_CHANNEL_MASK(channels)                                           \
+    ((channels) >= 32 ? 0xffffffff : ((1UL << (channels)) - 1))
+
+// Large model descriptor, fetch all 9 elements.
+#define SPORT_DMA_RX_CONFIG                                                    \
+    (FLOW_LARGE | NDSIZE_9 | DI_EN | WDSIZE_32 | WNR | DMAEN)
+#define SPORT_DMA_TX_CONFIG (FLOW_LARGE | NDSIZE_9 | WDSIZE_32 | DMAEN)
+
 /*----- Typedefs -----------------------------------------------------*/
 
+typedef enum { SPORT_0, SPORT_1, SPORT_INSTANCES } t_sport_instance;
+
+/// Large model DMA descriptor.
+typedef struct t_dma_descriptor {
+
+    struct t_dma_descriptor *next;
+    void *start_addr;
+    uint16_t config;
+    uint16_t x_count;
+    int16_t x_modify;
+    uint16_t y_count;
+    int16_t y_modify;
+
+} __attribute__((packed, aligned(4))) t_dma_descriptor;
+
 typedef struct {
 
-} t_sport;
+    // SPORT registers.
+    volatile unsigned short *tcr1;
+    volatile unsigned short *tcr2;
+    volatile unsigned short *rcr1;
+    volatile unsigned short *rcr2;
+    volatile unsigned short *mcmc1;
+    volatile unsigned short *mcmc2;
+    volatile unsigned long *mtcs0;
+    volatile unsigned long *mrcs0;
 
-/*----- Static variable definitions ----------------------------------*/
+    // DMA registers.
+    void *volatile *rx_next_desc;
+    volatile unsigned short *rx_dma_config;
+    volatile unsigned short *rx_irq_status;
+    volatile unsigned short *rx_peripheral_map;
+    void *volatile *tx_next_desc;
+    volatile unsigned short *tx_dma_config;
+    volatile unsigned short *tx_peripheral_map;
+
+    uint16_t rx_pmap;
+    uint16_t tx_pmap;
+
+    uint8_t channels;
+    uint16_t block_words;
+
+    // Ping-pong buffers, each half holds one block.
+    fract32 *rx_buffer[2];
+    fract32 *tx_buffer[2];
+
+    // Descriptor chains, ping links to pong links to ping.
+    t_dma_descriptor rx_desc[2];
+    t_dma_descriptor tx_desc[2];
 
-// SPORT0 DMA transmit buffer
-static fract32 g_codec_tx_buffer[2];
-// SPORT0 DMA receive buffer
-static fract32 g_codec_rx_buffer[2];
+    // Index of next half to be completed by DMA.
+    uint8_t dma_index;
+    // Index of half ready for processing.
+    uint8_t block_index;
 
-// 2 channels of input from ADC.
-static fract32 g_codec_in[2];
-// 2 channels of output to DAC.
-static fract32 g_codec_out[2];
+    volatile bool block_received;
 
-static bool g_sport0_frame_received = false;
+    // Blocks received before previous block processed.
+    volatile uint32_t overruns;
 
-static uint64_t g_start;
-static uint64_t g_stop;
-static uint64_t g_elapsed;
+    uint64_t start;
+    uint64_t elapsed;
+
+} t_sport;
+
+/*----- Static variable definitions ----------------------------------*/
+
+// SPORT0 DMA ping-pong buffers, codec audio.
+static fract32 g_codec_tx_buffer[2][SPORT0_BLOCK_WORDS];
+static fract32 g_codec_rx_buffer[2][SPORT0_BLOCK_WORDS];
+
+// SPORT1 DMA ping-pong buffers, TDM audio.
+static fract32 g_sport1_tx_buffer[2][SPORT1_BLOCK_WORDS];
+static fract32 g_sport1_rx_buffer[2][SPORT1_BLOCK_WORDS];
+
+static t_sport g_sport[SPORT_INSTANCES] = {
+
+    [SPORT_0] =
+        {
+            .tcr1 = pSPORT0_TCR1,
+            .tcr2 = pSPORT0_TCR2,
+            .rcr1 = pSPORT0_RCR1,
+            .rcr2 = pSPORT0_RCR2,
+            .mcmc1 = pSPORT0_MCMC1,
+            .mcmc2 = pSPORT0_MCMC2,
+            .mtcs0 = pSPORT0_MTCS0,
+            .mrcs0 = pSPORT0_MRCS0,
+            .rx_next_desc = pDMA3_NEXT_DESC_PTR,
+            .rx_dma_config = pDMA3_CONFIG,
+            .rx_irq_status = pDMA3_IRQ_STATUS,
+            .rx_peripheral_map = pDMA3_PERIPHERAL_MAP,
+            .tx_next_desc = pDMA4_NEXT_DESC_PTR,
+            .tx_dma_config = pDMA4_CONFIG,
+            .tx_peripheral_map = pDMA4_PERIPHERAL_MAP,
+            .rx_pmap = PMAP_SPORT0RX,
+            .tx_pmap = PMAP_SPORT0TX,
+            .channels = SPORT0_CHANNELS,
+            .block_words = SPORT0_BLOCK_WORDS,
+            .rx_buffer = {g_codec_rx_buffer[0], g_codec_rx_buffer[1]},
+            .tx_buffer = {g_codec_tx_buffer[0], g_codec_tx_buffer[1]},
+        },
+
+    [SPORT_1] =
+        {
+            .tcr1 = pSPORT1_TCR1,
+            .tcr2 = pSPORT1_TCR2,
+            .rcr1 = pSPORT1_RCR1,
+            .rcr2 = pSPORT1_RCR2,
+            .mcmc1 = pSPORT1_MCMC1,
+            .mcmc2 = pSPORT1_MCMC2,
+            .mtcs0 = pSPORT1_MTCS0,
+            .mrcs0 = pSPORT1_MRCS0,
+            .rx_next_desc = pDMA5_NEXT_DESC_PTR,
+            .rx_dma_config = pDMA5_CONFIG,
+            .rx_irq_status = pDMA5_IRQ_STATUS,
+            .rx_peripheral_map = pDMA5_PERIPHERAL_MAP,
+            .tx_next_desc = pDMA6_NEXT_DESC_PTR,
+            .tx_dma_config = pDMA6_CONFIG,
+            .tx_peripheral_map = pDMA6_PERIPHERAL_MAP,
+            .rx_pmap = PMAP_SPORT1RX,
+            .tx_pmap = PMAP_SPORT1TX,
+            .channels = SPORT1_CHANNELS,
+            .block_words = SPORT1_BLOCK_WORDS,
+            .rx_buffer = {g_sport1_rx_buffer[0], g_sport1_rx_buffer[1]},
+            .tx_buffer = {g_sport1_tx_buffer[0], g_sport1_tx_buffer[1]},
+        },
+};
 
 /*----- Extern variable definitions ----------------------------------*/
 
 /*----- Static function prototypes -----------------------------------*/
 
+static void _sport_init(t_sport *sport);
+static void _sport_frame_init(t_sport *sport);
+static void _sport_dma_init(t_sport *sport);
+static void _sport_dma_enable(t_sport *sport);
+static void _sport_block_complete(t_sport *sport);
+
 static void _sport0_isr(void) __attribute__((interrupt_handler));
+static void _sport1_isr(void) __attribute__((interrupt_handler));
 
 /*----- Extern function implementations ------------------------------*/
 
 void sport0_init(void) {
 
-    /// TODO: Do we need secondary enabled?
-
-    // Configure SPORT0 Rx.
-    // Clock Falling Edge, Receive Frame Sync, Data Format Sign Extend.
-    *pSPORT0_RCR1 = RCKFE | RFSR | DTYPE_SIGX;
-    // Rx Stereo Frame Sync Enable, Rx Word Length 32 bit.
-    *pSPORT0_RCR2 = RSFSE | SLEN(0x1f); // RXSE;
+    t_sport *sport = &g_sport[SPORT_0];
 
-    // Configure SPORT0 Tx.
-    *pSPORT0_TCR1 = TCKFE | TFSR;
-    *pSPORT0_TCR2 = TSFSE | SLEN(0x1f); // TXSE ;
-    ssync();
-
-    /// TODO: DMA linked descriptor mode.
-
-    // SPORT0 Rx DMA.
-    *pDMA3_PERIPHERAL_MAP = PMAP_SPORT0RX;
-    /* *pDMA3_CONFIG = 0x108a; // 0x760a; */
-    *pDMA3_CONFIG = FLOW_AUTO | DI_EN | WDSIZE_32 | WNR;
-    // Start address of data buffer.
-    *pDMA3_START_ADDR = &g_codec_rx_buffer;
-    // DMA inner loop count.
-    *pDMA3_X_COUNT = 2; // 2 samples.
-    // Inner loop address increment.
-    *pDMA3_X_MODIFY = 4; // 32 bit.
-    ssync();
-
-    // SPORT0 Tx DMA.
-    *pDMA4_PERIPHERAL_MAP = PMAP_SPORT0TX;
-    /* *pDMA4_CONFIG = 0x1008; // 0x7608; */
-    *pDMA4_CONFIG = FLOW_AUTO | WDSIZE_32;
-    // Start address of data buffer
-    *pDMA4_START_ADDR = &g_codec_tx_buffer;
-    // DMA inner loop count
-    *pDMA4_X_COUNT = 2; // 2 samples.
-    // Inner loop address increment
-    *pDMA4_X_MODIFY = 4; // 32 bit.
-    ssync();
+    _sport_init(sport);
 
     // SPORT0 Rx DMA3 interrupt IVG9.
     *pSIC_IAR2 |= P16_IVG(9);
@@ -144,116 +236,219 @@ void sport0_init(void) {
     asm volatile("cli %0; bitset(%0, 9); sti %0; csync;" : "+d"(i));
     ssync();
 
-    // Enable SPORT0 Rx DMA.
-    *pDMA3_CONFIG |= DMAEN;
+    _sport_dma_enable(sport);
+}
+
+/// TODO: CPU McASP configuration to clock SPORT1.
+//
+void sport1_init(void) {
+
+    t_sport *sport = &g_sport[SPORT_1];
+
+    _sport_init(sport);
+
+    // SPORT1 Rx DMA5 interrupt IVG10.
+    *pSIC_IAR2 |= P18_IVG(10);
     ssync();
 
-    // Enable SPORT0 Tx DMA.
-    *pDMA4_CONFIG |= DMAEN;
+    // Set SPORT1 Rx interrupt vector.
+    *pEVT10 = _sport1_isr;
     ssync();
 
-    // Enable SPORT0 Rx.
-    *pSPORT0_RCR1 |= RSPEN;
+    // Enable SPORT1 Rx interrupt.
+    *pSIC_IMASK0 |= IRQ_DMA5;
     ssync();
 
-    // Enable SPORT0 Tx.
-    *pSPORT0_TCR1 |= TSPEN;
+    int i;
+    // unmask in the core event processor
+    asm volatile("cli %0; bitset(%0, 10); sti %0; csync;" : "+d"(i));
     ssync();
+
+    _sport_dma_enable(sport);
 }
 
-void sport1_init(void) {
+fract32 *sport0_get_rx_buffer(void) {
 
-    /// /// TODO: Do we need secondary enabled?
-    ///
-    /// // Configure SPORT1 Rx.
-    /// *pSPORT1_RCR1 = RCKFE | RFSR | DTYPE_SIGX;
-    /// *pSPORT1_RCR2 = RSFSE | SLEN(0x1f); // RXSE ;
-    ///
-    /// // Configure SPORT1 Tx.
-    /// *pSPORT1_TCR1 = TCKFE | TFSR;
-    /// *pSPORT1_TCR2 = TSFSE | SLEN(0x1f); // TXSE  ;
-    /// ssync();
-    ///
-    /// /// TODO: DMA linked descriptor mode.
-    ///
-    /// // SPORT1 Rx DMA.
-    /// *pDMA5_PERIPHERAL_MAP = PMAP_SPORT1RX;
-    /// // Configure DMA.
-    /// *pDMA5_CONFIG = FLOW_AUTO | WDSIZE_32 | WNR;
-    /// // Start address of data buffer.
-    /// *pDMA5_START_ADDR = &g_cpu_rx_buffer;
-    /// // DMA inner loop count.
-    /// *pDMA5_X_COUNT = 2; // 2 samples.
-    /// // Inner loop address increment.
-    /// *pDMA5_X_MODIFY = 4; // 32 bit.
-    /// ssync();
-    ///
-    /// // SPORT1 Tx DMA.
-    /// *pDMA6_PERIPHERAL_MAP = PMAP_SPORT1TX;
-    /// // Configure DMA.
-    /// *pDMA6_CONFIG = FLOW_AUTO | WDSIZE_32;
-    /// // Start address of data buffer
-    /// *pDMA6_START_ADDR = &g_cpu_tx_buffer;
-    /// // DMA inner loop count
-    /// *pDMA6_X_COUNT = 2; // 2 samples.
-    /// // Inner loop address increment
-    /// *pDMA6_X_MODIFY = 4; // 32 bit.
-    /// ssync();
-    ///
-    /// // Enable SPORT1 Rx DMA.
-    /// *pDMA5_CONFIG |= DMAEN;
-    /// ssync();
-    ///
-    /// // Enable SPORT1 Tx DMA.
-    /// *pDMA6_CONFIG |= DMAEN;
-    /// ssync();
-    ///
-    /// // Enable SPORT1 Rx.
-    /// *pSPORT1_RCR1 |= RSPEN;
-    /// ssync();
-    ///
-    /// // Enable SPORT1 Tx.
-    /// *pSPORT1_TCR1 |= TSPEN;
-    /// ssync();
+    return g_sport[SPORT_0].rx_buffer[g_sport[SPORT_0].block_index];
 }
 
-fract32 *sport0_get_rx_buffer(void) { return g_codec_in; }
+fract32 *sport0_get_tx_buffer(void) {
 
-fract32 *sport0_get_tx_buffer(void) { return g_codec_out; }
+    return g_sport[SPORT_0].tx_buffer[g_sport[SPORT_0].block_index];
+}
 
-/// TODO: DMA ping-pong block buffer.
-bool sport0_frame_received(void) { return g_sport0_frame_received; }
+bool sport0_block_received(void) { return g_sport[SPORT_0].block_received; }
 
-void sport0_frame_processed(void) { g_sport0_frame_received = false; }
+void sport0_block_processed(void) { g_sport[SPORT_0].block_received = false; }
 
-uint64_t sport0_period(void) { return g_elapsed; }
+uint64_t sport0_period(void) { return g_sport[SPORT_0].elapsed; }
 
-/// TODO: Block processing.  For now we process each frame as it arrives.
-__attribute__((interrupt_handler)) static void _sport0_isr(void) {
+/// Cycle count when last block was received.
+uint64_t sport0_block_start(void) { return g_sport[SPORT_0].start; }
+
+uint32_t sport0_overruns(void) { return g_sport[SPORT_0].overruns; }
+
+fract32 *sport1_get_rx_buffer(void) {
+
+    return g_sport[SPORT_1].rx_buffer[g_sport[SPORT_1].block_index];
+}
+
+fract32 *sport1_get_tx_buffer(void) {
+
+    return g_sport[SPORT_1].tx_buffer[g_sport[SPORT_1].block_index];
+}
+
+bool sport1_block_received(void) { return g_sport[SPORT_1].block_received; }
+
+void sport1_block_processed(void) { g_sport[SPORT_1].block_received = false; }
+
+uint32_t sport1_overruns(void) { return g_sport[SPORT_1].overruns; }
+
+/*----- Static function implementations ------------------------------*/
+
+static void _sport_init(t_sport *sport) {
+
+    sport->dma_index = 0;
+    sport->block_index = 0;
+    sport->block_received = false;
+    sport->overruns = 0;
+
+    _sport_frame_init(sport);
+
+    _sport_dma_init(sport);
+}
+
+static void _sport_frame_init(t_sport *sport) {
+
+    /// TODO: Do we need secondary enabled?
+
+    // Configure Rx.
+    // Clock Falling Edge, Receive Frame Sync, Data Format Sign Extend.
+    *sport->rcr1 = RCKFE | RFSR | DTYPE_SIGX;
+
+    // Configure Tx.
+    *sport->tcr1 = TCKFE | TFSR;
+
+    if (sport->channels == 2) {
+
+        // Stereo Frame Sync Enable, Word Length 32 bit.
+        *sport->rcr2 = RSFSE | SLEN(0x1f); // RXSE;
+        *sport->tcr2 = TSFSE | SLEN(0x1f); // TXSE ;
+
+        *sport->mcmc2 = 0;
+
+    } else {
+
+        // TDM, one 32 bit word per channel.
+        *sport->rcr2 = SLEN(0x1f);
+        *sport->tcr2 = SLEN(0x1f);
+
+        // Tx shares Rx clock and frame sync in multichannel mode.
+        *sport->mcmc1 = SPORT_MCMC1_WSIZE(sport->channels);
+        *sport->mcmc2 = MCMEN | SPORT_MCMC2_MFD(1);
+
+        // Enable first 'channels' channels.
+        *sport->mrcs0 = SPORT_CHANNEL_MASK(sport->channels);
+        *sport->mtcs0 = SPORT_CHANNEL_MASK(sport->channels);
+    }
+    ssync();
+}
+
+static void _sport_dma_init(t_sport *sport) {
+
+    int i;
+
+    // One descriptor per block, each links to the other.
+    // Rx interrupts on completion of each descriptor,
+    // so the core processes one half while DMA fills the other.
+    for (i = 0; i < 2; i++) {
+
+        sport->rx_desc[i].next = &sport->rx_desc[i ^ 1];
+        sport->rx_desc[i].start_addr = sport->rx_buffer[i];
+        sport->rx_desc[i].config = SPORT_DMA_RX_CONFIG;
+        sport->rx_desc[i].x_count = sport->block_words;
+        sport->rx_desc[i].x_modify = 4; // 32 bit.
+        sport->rx_desc[i].y_count = 0;
+        sport->rx_desc[i].y_modify = 0;
+
+        sport->tx_desc[i].next = &sport->tx_desc[i ^ 1];
+        sport->tx_desc[i].start_addr = sport->tx_buffer[i];
+        sport->tx_desc[i].config = SPORT_DMA_TX_CONFIG;
+        sport->tx_desc[i].x_count = sport->block_words;
+        sport->tx_desc[i].x_modify = 4; // 32 bit.
+        sport->tx_desc[i].y_count = 0;
+        sport->tx_desc[i].y_modify = 0;
+    }
+
+    // Rx DMA.
+    *sport->rx_peripheral_map = sport->rx_pmap;
+    *sport->rx_next_desc = &sport->rx_desc[0];
+    // Fetch first descriptor when enabled.
+    *sport->rx_dma_config = SPORT_DMA_RX_CONFIG & ~DMAEN;
+    ssync();
+
+    // Tx DMA.
+    *sport->tx_peripheral_map = sport->tx_pmap;
+    *sport->tx_next_desc = &sport->tx_desc[0];
+    // Fetch first descriptor when enabled.
+    *sport->tx_dma_config = SPORT_DMA_TX_CONFIG & ~DMAEN;
+    ssync();
+}
+
+static void _sport_dma_enable(t_sport *sport) {
+
+    // Enable Rx DMA.
+    *sport->rx_dma_config |= DMAEN;
+    ssync();
+
+    // Enable Tx DMA.
+    *sport->tx_dma_config |= DMAEN;
+    ssync();
+
+    // Enable Rx.
+    *sport->rcr1 |= RSPEN;
+    ssync();
+
+    // Enable Tx.
+    *sport->tcr1 |= TSPEN;
+    ssync();
+}
+
+static inline void _sport_block_complete(t_sport *sport) {
+
+    uint64_t now;
 
     // Clear interrupt status.
-    *pDMA3_IRQ_STATUS = DMA_DONE;
+    *sport->rx_irq_status = DMA_DONE;
     ssync();
 
-    g_stop = cycles();
+    now = cycles();
 
-    g_elapsed = g_stop - g_start;
+    sport->elapsed = now - sport->start;
+    sport->start = now;
 
-    /// TODO: DMA ping-pong block buffer.
+    // Deadline missed, previous block still unprocessed.
+    if (sport->block_received) {
+        sport->overruns++;
+    }
 
-    // Get input from codec.
-    g_codec_in[0] = g_codec_rx_buffer[0];
-    g_codec_in[1] = g_codec_rx_buffer[1];
+    // Rx DMA has filled one half and moved on to the other.
+    // Tx DMA runs in step, so it is now sending the other half
+    // and the completed half may be overwritten with output.
+    sport->block_index = sport->dma_index;
+    sport->dma_index ^= 1;
 
-    // Send output to codec.
-    g_codec_tx_buffer[0] = g_codec_out[0];
-    g_codec_tx_buffer[1] = g_codec_out[1];
+    sport->block_received = true;
+}
 
-    g_sport0_frame_received = true;
+__attribute__((interrupt_handler)) static void _sport0_isr(void) {
 
-    g_start = cycles();
+    _sport_block_complete(&g_sport[SPORT_0]);
 }
 
-/*----- Static function implementations ------------------------------*/
+__attribute__((interrupt_handler)) static void _sport1_isr(void) {
+
+    _sport_block_complete(&g_sport[SPORT_1]);
+}
 
 /*----- End of file --------------------------------------------------*/
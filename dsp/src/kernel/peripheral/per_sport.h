@@ -48,6 +48,27 @@ extern "C" {
 
 /*----- Macros -------------------------------------------------------*/
 
+/// Number of frames processed per block.
+/// Override at build time, e.g. 'make BLOCK_SIZE=64'.
+#ifndef SPORT_BLOCK_SIZE
+#define SPORT_BLOCK_SIZE 32
+#endif
+
+/// Number of channels in each SPORT0 frame, stereo codec.
+#define SPORT0_CHANNELS 2
+
+/// Number of channels in each SPORT1 frame.
+/// More than 2 channels selects TDM multichannel mode, up to 32.
+#ifndef SPORT1_CHANNELS
+#define SPORT1_CHANNELS 8
+#endif
+
+/// Number of 32 bit words in each SPORT0 block.
+#define SPORT0_BLOCK_WORDS (SPORT_BLOCK_SIZE * SPORT0_CHANNELS)
+
+/// Number of 32 bit words in each SPORT1 block.
+#define SPORT1_BLOCK_WORDS (SPORT_BLOCK_SIZE * SPORT1_CHANNELS)
+
 /*----- Typedefs -----------------------------------------------------*/
 
 /*----- Extern variable declarations ---------------------------------*/
@@ -58,13 +79,24 @@ extern fract32 out[2];
 /*----- Extern function prototypes -----------------------------------*/
 
 void sport0_init(void);
-bool sport0_frame_received(void);
-void sport0_frame_processed(void);
+bool sport0_block_received(void);
+void sport0_block_processed(void);
 
 fract32 *sport0_get_rx_buffer(void);
 fract32 *sport0_get_tx_buffer(void);
 
 uint64_t sport0_period(void);
+uint64_t sport0_block_start(void);
+uint32_t sport0_overruns(void);
+
+void sport1_init(void);
+bool sport1_block_received(void);
+void sport1_block_processed(void);
+
+fract32 *sport1_get_rx_buffer(void);
+fract32 *sport1_get_tx_buffer(void);
+
+uint32_t sport1_overruns(void);
 
 #ifdef __cplusplus
 }
@@ -42,66 +42,91 @@ under the terms of the GNU Affero General Public License as published by
 #include <string.h>
 
 #include "ft_error.h"
+#include "ft_protocol.h"
 
+#include "dev_cpu_hostdp.h"
+#include "dev_cpu_spi.h"
 #include "per_gpio.h"
 #include "per_spi.h"
+#include "per_sport.h"
 
 #include "module.h"
 
+#include "knl_capture.h"
+#include "knl_event.h"
+#include "knl_mod.h"
 #include "knl_profile.h"
+#include "knl_region.h"
+#include "knl_telemetry.h"
 
 /*----- Macros -------------------------------------------------------*/
 
-#define MSG_START 0xf0
+/// Parameter values in each MODULE_ALL_PARAMS message.
+#define ALL_PARAMS_CHUNK 32
+
+/// Fraction of block period kept free before next block is due.
+/// Receive stops at the first frame boundary past this point.
+#define RX_GUARD_DIVISOR 8
+
+/// Tx bytes kept free for responses while capture streams.
+#define CAPTURE_TX_RESERVE 0x80
 
 /*----- Typedefs -----------------------------------------------------*/
 
 typedef enum { STATE_INIT, STATE_RUN, STATE_ERROR } t_cpu_task_state;
 
-typedef enum {
-    PARSE_START,
-    PARSE_MSG_TYPE,
-    PARSE_MSG_ID,
-    PARSE_PAYLOAD_LENGTH,
-    PARSE_PAYLOAD
-} t_msg_parse_state;
-
-// TODO: Move protocol definition to common module.
-//       Union struct for message.
-enum e_message_type { MSG_TYPE_MODULE, MSG_TYPE_SYSTEM };
-
-enum e_module_msg_id {
-    MODULE_GET_PARAM_VALUE,
-    MODULE_SET_PARAM_VALUE,
-    MODULE_PARAM_VALUE,
-    MODULE_GET_PARAM_NAME,
-    MODULE_PARAM_NAME,
-};
+typedef enum { LINK_SPI, LINK_HOSTDP, CPU_LINKS } t_cpu_link_id;
 
-enum e_system_msg_id {
-    SYSTEM_CHECK_READY,
-    SYSTEM_READY,
-    SYSTEM_GET_PORT_STATE,
-    SYSTEM_SET_PORT_STATE,
-    SYSTEM_PORT_STATE,
-    SYSTEM_GET_PROFILE,
-    SYSTEM_PROFILE,
-};
+/// Byte stream to and from CPU.
+typedef struct {
+    uint32_t (*rx_span)(uint8_t **data);
+    void (*rx_consume)(uint32_t length);
+    t_status (*tx_enqueue)(const uint8_t *data, uint32_t length);
+    uint32_t (*tx_free)(void);
+} t_cpu_link;
 
 /*----- Static variable definitions ----------------------------------*/
 
+static const t_cpu_link g_links[CPU_LINKS] = {
+    [LINK_SPI] = {dev_cpu_spi_rx_span, dev_cpu_spi_rx_consume,
+                  dev_cpu_spi_tx_enqueue, dev_cpu_spi_tx_free},
+    [LINK_HOSTDP] = {dev_cpu_hostdp_rx_span, dev_cpu_hostdp_rx_consume,
+                     dev_cpu_hostdp_tx_enqueue, dev_cpu_hostdp_tx_free},
+};
+
+static t_protocol g_protocol[CPU_LINKS];
+
+// Sequence of request being handled, echoed in response.
+static uint8_t g_request_sequence = PROTOCOL_SEQUENCE_NONE;
+
+// Link of request being handled, carries response.
+// Messages not sent in response use SPI.
+static t_cpu_link_id g_request_link = LINK_SPI;
+
+// Receive stops after frame completing past this cycle count.
+static uint64_t g_rx_deadline;
+
+// Link of capture start request, carries capture stream.
+static t_cpu_link_id g_capture_link = LINK_SPI;
+
+// Link of telemetry request, carries telemetry frames.
+static t_cpu_link_id g_telemetry_link = LINK_SPI;
+
 /*----- Extern variable definitions ----------------------------------*/
 
 /*----- Static function prototypes -----------------------------------*/
 
 static t_status _cpu_init(void);
-
-static void _cpu_receive(uint8_t byte);
+static void _set_rx_deadline(void);
+static void _receive(t_cpu_link_id link_id);
+static void _transmit_capture(void);
+static void _transmit_telemetry(t_telemetry *telemetry);
 
 static void _transmit_message(uint8_t msg_type, uint8_t msg_id,
                               uint8_t *payload, uint8_t length);
 
-static void _handle_message(uint8_t msg_type, uint8_t msg_id, uint8_t *payload,
+static void _handle_message(uint8_t msg_type, uint8_t msg_id,
+                            uint8_t sequence, uint8_t *payload,
                             uint8_t length);
 
 static t_status _handle_module_message(uint8_t msg_id, uint8_t *payload,
@@ -118,12 +143,41 @@ static t_status _handle_module_set_param_value(uint8_t *payload,
 
 static t_status _handle_module_get_param_name(uint8_t *payload, uint8_t length);
 
+static t_status _handle_module_set_param_batch(uint8_t *payload,
+                                               uint8_t length);
+
+static t_status _handle_module_get_all_params(uint8_t *payload,
+                                              uint8_t length);
+static t_status _handle_module_get_param_info(uint8_t *payload,
+                                              uint8_t length);
+static t_status _handle_module_set_mod_source(uint8_t *payload,
+                                              uint8_t length);
+static t_status _handle_module_set_mod_gate(uint8_t *payload, uint8_t length);
+static t_status _handle_module_set_mod_route(uint8_t *payload,
+                                             uint8_t length);
+
+static t_status _handle_module_set_graph(uint8_t *payload, uint8_t length);
+static t_status _handle_module_get_cycles(uint8_t *payload, uint8_t length);
+
 static t_status _handle_system_check_ready(void);
 
 static t_status _handle_system_get_port_state(void);
 static t_status _handle_system_set_port_state(uint8_t *payload, uint8_t length);
 
 static t_status _handle_system_get_profile(void);
+static t_status _handle_system_get_profile_ext(uint8_t *payload,
+                                              uint8_t length);
+static t_status _handle_system_get_frame_count(void);
+static t_status _handle_system_get_link_stats(void);
+static t_status _handle_system_echo(uint8_t *payload, uint8_t length);
+static t_status _handle_system_get_hostdp_mailbox(void);
+static t_status _handle_system_region_open(uint8_t *payload, uint8_t length);
+static t_status _handle_system_region_write(uint8_t *payload, uint8_t length);
+static t_status _handle_system_region_close(uint8_t *payload, uint8_t length);
+static t_status _handle_system_capture_start(uint8_t *payload, uint8_t length);
+static t_status _handle_system_capture_stop(void);
+static t_status _handle_system_set_telemetry(uint8_t *payload,
+                                             uint8_t length);
 
 static t_status _respond_module_param_value(uint16_t module_id,
                                             uint16_t param_index,
@@ -133,11 +187,27 @@ static t_status _respond_module_param_name(uint16_t module_id,
                                            uint16_t param_index,
                                            char *param_name);
 
-static t_status _respond_system_check_ready(void);
+static t_status _respond_module_cycles(uint16_t module_id, uint32_t cycles);
+static t_status _respond_module_all_params(uint16_t module_id,
+                                          uint16_t start_index);
+static t_status _respond_module_param_info(uint16_t module_id,
+                                          uint16_t start_index);
+
+static t_status _respond_system_check_ready(uint8_t node_count);
 static t_status _respond_system_port_state(uint16_t port_f, uint16_t port_g,
                                            uint16_t port_h);
 
 static t_status _respond_system_profile(t_profile stats);
+static t_status _respond_system_profile_ext(t_profile_ext stats);
+static t_status _respond_system_frame_count(uint32_t frame_count);
+static t_status _respond_system_link_stats(t_protocol_stats stats);
+static t_status _respond_system_region_ack(uint8_t region_id, uint32_t offset,
+                                           uint8_t status);
+static t_status _respond_system_capture_status(void);
+
+static void _pack_u16(uint8_t *payload, uint16_t value);
+static void _pack_u32(uint8_t *payload, uint32_t value);
+static uint32_t _unpack_u32(uint8_t *payload);
 
 /*----- Extern function implementations ------------------------------*/
 
@@ -145,7 +215,8 @@ void svc_cpu_task(void) {
 
     static t_cpu_task_state state = STATE_INIT;
 
-    static uint8_t cpu_byte;
+    t_cpu_link_id link_id;
+    t_telemetry telemetry;
 
     switch (state) {
 
@@ -161,9 +232,18 @@ void svc_cpu_task(void) {
 
     case STATE_RUN:
 
-        // Handle received bytes.
-        if (dev_cpu_spi_rx_dequeue(&cpu_byte) == SUCCESS) {
-            _cpu_receive(cpu_byte);
+        _set_rx_deadline();
+
+        for (link_id = 0; link_id < CPU_LINKS; link_id++) {
+            _receive(link_id);
+        }
+
+        if (knl_capture_running()) {
+            _transmit_capture();
+        }
+
+        if (knl_telemetry_due(&telemetry)) {
+            _transmit_telemetry(&telemetry);
         }
         break;
 
@@ -186,93 +266,203 @@ static t_status _cpu_init(void) {
 
     t_status result = TASK_INIT_ERROR;
 
-    // Initialise CPU SPI device driver.
-    dev_cpu_spi_init();
+    t_cpu_link_id link_id;
 
-    // _transmit_message(MSG_TYPE_SYSTEM, SYSTEM_READY, NULL, 0);
+    for (link_id = 0; link_id < CPU_LINKS; link_id++) {
+        protocol_init(&g_protocol[link_id], _handle_message);
+    }
 
-    /// TODO: Handhsake.
+    // Initialise CPU SPI device driver.
+    dev_cpu_spi_init();
 
     result = SUCCESS;
 
     return result;
 }
 
+/**
+ * @brief   Set receive budget from time left before next audio block.
+ *
+ * Messages are parsed as CPU time allows, so parameter throughput
+ * scales with free cycles rather than main loop frequency.
+ */
+static void _set_rx_deadline(void) {
+
+    uint64_t period = sport0_period();
+
+    // Period unknown until audio running, no budget.
+    if (period == 0) {
+        g_rx_deadline = UINT64_MAX;
+
+    } else {
+        g_rx_deadline =
+            sport0_block_start() + period - period / RX_GUARD_DIVISOR;
+    }
+}
+
+/**
+ * @brief   Handle received bytes, a contiguous span at a time.
+ *
+ * At least one frame is handled each call, further frames
+ * only while cycles remain before the receive deadline.
+ */
+static void _receive(t_cpu_link_id link_id) {
+
+    const t_cpu_link *link = &g_links[link_id];
+    uint8_t *span;
+    uint32_t length;
+    uint32_t i;
+
+    length = link->rx_span(&span);
+
+    g_request_link = link_id;
+
+    for (i = 0; i < length;) {
+
+        protocol_receive(&g_protocol[link_id], span[i++]);
+
+        // Leave remaining frames for next call once budget spent.
+        if (span[i - 1] == PROTOCOL_DELIMITER && cycles() >= g_rx_deadline) {
+            break;
+        }
+    }
+
+    g_request_link = LINK_SPI;
+
+    link->rx_consume(i);
+}
+
 /// TODO: Return status.
 static void _transmit_message(uint8_t msg_type, uint8_t msg_id,
                               uint8_t *payload, uint8_t length) {
-    //
-    uint8_t msg_start = MSG_START;
 
-    dev_cpu_spi_tx_enqueue(&msg_start);
-    dev_cpu_spi_tx_enqueue(&msg_type);
-    dev_cpu_spi_tx_enqueue(&msg_id);
-    dev_cpu_spi_tx_enqueue(&length);
+    static uint8_t frame[PROTOCOL_ENCODED_MAX];
 
-    while (length--) {
-        dev_cpu_spi_tx_enqueue(payload++);
-    }
+    uint16_t frame_length;
+
+    frame_length =
+        protocol_encode(&g_protocol[g_request_link], msg_type, msg_id,
+                        g_request_sequence, payload, length, frame);
+
+    // Whole frame or nothing, CPU times out request if dropped.
+    g_links[g_request_link].tx_enqueue(frame, frame_length);
 }
 
-/// TODO: Move to separate module.
-static void _cpu_receive(uint8_t byte) {
+/**
+ * @brief   Send captured frames, a full payload at a time,
+ *          or half the ring if smaller.
+ *
+ * Frames wait in the capture ring while the link is busy,
+ * leaving CAPTURE_TX_RESERVE free for responses.
+ */
+static void _transmit_capture(void) {
 
-    static t_msg_parse_state state = PARSE_START;
+    static int16_t samples[(PROTOCOL_PAYLOAD_MAX - PROTOCOL_CAPTURE_HEADER) /
+                           sizeof(int16_t)];
+    static uint8_t payload[PROTOCOL_PAYLOAD_MAX];
+    static uint8_t frame[PROTOCOL_ENCODED_MAX];
 
-    static uint8_t msg_type;
-    static uint8_t msg_id;
-    static uint8_t length;
-    static uint8_t payload[0xff];
-    static uint8_t count;
+    const t_cpu_link *link = &g_links[g_capture_link];
+    uint16_t max_frames;
+    uint16_t frames;
+    uint16_t count;
+    uint16_t frame_length;
+    uint32_t index;
+    uint16_t i;
 
-    switch (state) {
+    max_frames = sizeof(samples) / sizeof(int16_t) / knl_capture_channels();
 
-        /// TODO: Handshake.
+    if (max_frames > knl_capture_capacity() / 2) {
+        max_frames = knl_capture_capacity() / 2;
+    }
 
-    case PARSE_START:
-        if (byte == MSG_START) {
-            state = PARSE_MSG_TYPE;
-        }
-        // TODO: Error handling and reset protocol.
-        break;
+    if (link->tx_free() < PROTOCOL_ENCODED_MAX + CAPTURE_TX_RESERVE) {
+        return;
+    }
 
-    case PARSE_MSG_TYPE:
-        msg_type = byte;
-        state = PARSE_MSG_ID;
-        break;
+    frames = knl_capture_read(samples, max_frames, &index);
 
-    case PARSE_MSG_ID:
-        msg_id = byte;
-        state = PARSE_PAYLOAD_LENGTH;
-        break;
+    if (frames < max_frames) {
+        return;
+    }
 
-    case PARSE_PAYLOAD_LENGTH:
-        length = byte;
-        state = PARSE_PAYLOAD;
-        break;
+    count = frames * knl_capture_channels();
 
-    case PARSE_PAYLOAD:
-        if (count < length) {
-            payload[count] = byte;
-            count++;
-        }
-        // Handle message before returning,
-        // else it is not handled until first
-        // byte of next message is received.
-        if (count >= length) {
-            count = 0;
-            _handle_message(msg_type, msg_id, payload, length);
-            state = PARSE_START;
-        }
-        break;
+    _pack_u32(&payload[0], index);
+    _pack_u32(&payload[4], knl_capture_stats().overruns);
 
-    default:
-        break;
+    for (i = 0; i < count; i++) {
+        payload[PROTOCOL_CAPTURE_HEADER + 2 * i] = samples[i] & 0xff;
+        payload[PROTOCOL_CAPTURE_HEADER + 2 * i + 1] = (samples[i] >> 8) & 0xff;
+    }
+
+    frame_length = protocol_encode(
+        &g_protocol[g_capture_link], MSG_TYPE_SYSTEM, SYSTEM_CAPTURE_DATA,
+        PROTOCOL_SEQUENCE_NONE, payload,
+        PROTOCOL_CAPTURE_HEADER + count * sizeof(int16_t), frame);
+
+    if (link->tx_enqueue(frame, frame_length) == SUCCESS) {
+        knl_capture_consume(frames);
     }
 }
 
-static void _handle_message(uint8_t msg_type, uint8_t msg_id, uint8_t *payload,
+/**
+ * @brief   Send telemetry frame.
+ *
+ * Payload holds frame count, profile, level of each input and
+ * output channel, then queue depths.  Dropped if link is full,
+ * the next interval replaces it.
+ */
+static void _transmit_telemetry(t_telemetry *telemetry) {
+
+    static uint8_t payload[PROTOCOL_TELEMETRY_LENGTH];
+    static uint8_t frame[PROTOCOL_ENCODED_LENGTH(PROTOCOL_TELEMETRY_LENGTH)];
+
+    t_profile_ext profile = knl_profile_stats_ext();
+    uint8_t *level = &payload[28];
+    uint16_t frame_length;
+    uint8_t channel;
+
+    _pack_u32(&payload[0], knl_event_frame_count());
+    _pack_u32(&payload[4], profile.period);
+    _pack_u32(&payload[8], profile.cycles);
+    _pack_u32(&payload[12], profile.mean);
+    _pack_u32(&payload[16], profile.max);
+    _pack_u32(&payload[20], profile.percentile);
+    _pack_u32(&payload[24], profile.overruns);
+
+    for (channel = 0; channel < MODULE_CHANNELS; channel++) {
+
+        _pack_u16(&level[channel * 4], telemetry->input[channel].peak);
+        _pack_u16(&level[channel * 4 + 2], telemetry->input[channel].rms);
+
+        _pack_u16(&level[(MODULE_CHANNELS + channel) * 4],
+                  telemetry->output[channel].peak);
+        _pack_u16(&level[(MODULE_CHANNELS + channel) * 4 + 2],
+                  telemetry->output[channel].rms);
+    }
+
+    payload[44] = knl_event_pending();
+    _pack_u16(&payload[45], knl_capture_pending());
+
+    _pack_u16(&payload[47], dev_cpu_spi_tx_free());
+    _pack_u16(&payload[49], dev_cpu_hostdp_tx_free());
+
+    frame_length = protocol_encode(&g_protocol[g_telemetry_link],
+                                   MSG_TYPE_SYSTEM, SYSTEM_TELEMETRY,
+                                   PROTOCOL_SEQUENCE_NONE, payload,
+                                   sizeof(payload), frame);
+
+    g_links[g_telemetry_link].tx_enqueue(frame, frame_length);
+}
+
+static void _handle_message(uint8_t msg_type, uint8_t msg_id,
+                            uint8_t sequence, uint8_t *payload,
                             uint8_t length) {
+
+    // Responses sent while handling carry request sequence.
+    g_request_sequence = sequence;
+
     // Switch message type.
     switch (msg_type) {
 
@@ -287,6 +477,8 @@ static void _handle_message(uint8_t msg_type, uint8_t msg_id, uint8_t *payload,
     default:
         break;
     }
+
+    g_request_sequence = PROTOCOL_SEQUENCE_NONE;
 }
 
 static t_status _handle_module_message(uint8_t msg_id, uint8_t *payload,
@@ -308,6 +500,38 @@ static t_status _handle_module_message(uint8_t msg_id, uint8_t *payload,
         result = _handle_module_get_param_name(payload, length);
         break;
 
+    case MODULE_SET_PARAM_BATCH:
+        result = _handle_module_set_param_batch(payload, length);
+        break;
+
+    case MODULE_GET_ALL_PARAMS:
+        result = _handle_module_get_all_params(payload, length);
+        break;
+
+    case MODULE_GET_PARAM_INFO:
+        result = _handle_module_get_param_info(payload, length);
+        break;
+
+    case MODULE_SET_MOD_SOURCE:
+        result = _handle_module_set_mod_source(payload, length);
+        break;
+
+    case MODULE_SET_MOD_GATE:
+        result = _handle_module_set_mod_gate(payload, length);
+        break;
+
+    case MODULE_SET_MOD_ROUTE:
+        result = _handle_module_set_mod_route(payload, length);
+        break;
+
+    case MODULE_SET_GRAPH:
+        result = _handle_module_set_graph(payload, length);
+        break;
+
+    case MODULE_GET_CYCLES:
+        result = _handle_module_get_cycles(payload, length);
+        break;
+
     default:
         result = ERROR;
         break;
@@ -324,6 +548,7 @@ static t_status _handle_system_message(uint8_t msg_id, uint8_t *payload,
 
     case SYSTEM_CHECK_READY:
         result = _handle_system_check_ready();
+        break;
 
     case SYSTEM_GET_PORT_STATE:
         result = _handle_system_get_port_state();
@@ -337,6 +562,54 @@ static t_status _handle_system_message(uint8_t msg_id, uint8_t *payload,
         result = _handle_system_get_profile();
         break;
 
+    case SYSTEM_GET_PROFILE_EXT:
+        result = _handle_system_get_profile_ext(payload, length);
+        break;
+
+    case SYSTEM_GET_FRAME_COUNT:
+        result = _handle_system_get_frame_count();
+        break;
+
+    case SYSTEM_GET_LINK_STATS:
+        result = _handle_system_get_link_stats();
+        break;
+
+    case SYSTEM_ECHO:
+        result = _handle_system_echo(payload, length);
+        break;
+
+    case SYSTEM_GET_HOSTDP_MAILBOX:
+        result = _handle_system_get_hostdp_mailbox();
+        break;
+
+    case SYSTEM_REGION_OPEN:
+        result = _handle_system_region_open(payload, length);
+        break;
+
+    case SYSTEM_REGION_WRITE:
+        result = _handle_system_region_write(payload, length);
+        break;
+
+    case SYSTEM_REGION_CLOSE:
+        result = _handle_system_region_close(payload, length);
+        break;
+
+    case SYSTEM_CAPTURE_START:
+        result = _handle_system_capture_start(payload, length);
+        break;
+
+    case SYSTEM_CAPTURE_STOP:
+        result = _handle_system_capture_stop();
+        break;
+
+    case SYSTEM_GET_CAPTURE_STATUS:
+        result = _respond_system_capture_status();
+        break;
+
+    case SYSTEM_SET_TELEMETRY:
+        result = _handle_system_set_telemetry(payload, length);
+        break;
+
     default:
         result = ERROR;
         break;
@@ -355,8 +628,7 @@ static t_status _handle_module_get_param_value(uint8_t *payload,
 
     /// TODO: Register callbacks for message handling?
     //
-    // module_id not supported yet.
-    int32_t param_value = module_get_param(param_index);
+    int32_t param_value = module_get_param(module_id, param_index);
 
     _respond_module_param_value(module_id, param_index, param_value);
 
@@ -368,7 +640,7 @@ static t_status _handle_module_set_param_value(uint8_t *payload,
                                                uint8_t length) {
 
     /// TODO: Union struct for message parsing.
-    int16_t module_id = (payload[1] << 8) | payload[0];
+    uint16_t module_id = (payload[1] << 8) | payload[0];
 
     uint16_t param_index = (payload[3] << 8) | payload[2];
 
@@ -376,8 +648,19 @@ static t_status _handle_module_set_param_value(uint8_t *payload,
     int32_t param_value = (payload[7] << 24) | (payload[6] << 16) |
                           (payload[5] << 8) | payload[4];
 
-    // module_id not supported yet.
-    module_set_param(param_index, param_value);
+    uint32_t frame;
+
+    // Optional timestamp, absolute frame count.
+    if (length >= 12) {
+
+        frame = (payload[11] << 24) | (payload[10] << 16) | (payload[9] << 8) |
+                payload[8];
+
+        knl_event_set_param(frame, module_id, param_index, param_value);
+
+    } else {
+        module_set_param(module_id, param_index, param_value);
+    }
 
     /// TODO: Error handling and protocol reset.
     return SUCCESS;
@@ -396,8 +679,7 @@ static t_status _handle_module_get_param_name(uint8_t *payload,
 
     param_index = (payload[3] << 8) | payload[2];
 
-    // module_id not supported yet.
-    module_get_param_name(param_index, param_name);
+    module_get_param_name(module_id, param_index, param_name);
 
     _respond_module_param_name(module_id, param_index, param_name);
 
@@ -405,18 +687,191 @@ static t_status _handle_module_get_param_name(uint8_t *payload,
     return SUCCESS;
 }
 
-static t_status _handle_system_check_ready(void) {
+/**
+ * @brief   Set several parameters of one module.
+ *
+ * Payload holds module_id, then index and value of each parameter.
+ */
+static t_status _handle_module_set_param_batch(uint8_t *payload,
+                                               uint8_t length) {
 
-    /// TODO: Should initiate from CPU, then reply.
-    //
-    /// _respond_system_check_ready();
+    uint16_t module_id;
+    uint16_t param_index;
+    int32_t param_value;
 
+    if (length < 2) {
+        return ERROR;
+    }
+
+    module_id = (payload[1] << 8) | payload[0];
+
+    payload += 2;
+    length -= 2;
+
+    while (length >= 6) {
+
+        param_index = (payload[1] << 8) | payload[0];
+
+        param_value = (payload[5] << 24) | (payload[4] << 16) |
+                      (payload[3] << 8) | payload[2];
+
+        module_set_param(module_id, param_index, param_value);
+
+        payload += 6;
+        length -= 6;
+    }
+
+    /// TODO: Error handling and protocol reset.
     return SUCCESS;
 }
 
-static t_status _respond_system_check_ready(void) {
+/**
+ * @brief   Respond with values of consecutive parameters.
+ *
+ * Payload holds module_id and index of first parameter.
+ */
+static t_status _handle_module_get_all_params(uint8_t *payload,
+                                              uint8_t length) {
+
+    uint16_t module_id;
+    uint16_t start_index;
+
+    if (length < 4) {
+        return ERROR;
+    }
+
+    module_id = (payload[1] << 8) | payload[0];
+    start_index = (payload[3] << 8) | payload[2];
+
+    return _respond_module_all_params(module_id, start_index);
+}
+
+/**
+ * @brief   Respond with descriptors of consecutive parameters.
+ *
+ * Payload holds module_id and index of first parameter.
+ */
+static t_status _handle_module_get_param_info(uint8_t *payload,
+                                              uint8_t length) {
+
+    uint16_t module_id;
+    uint16_t start_index;
+
+    if (length < 4) {
+        return ERROR;
+    }
+
+    module_id = (payload[1] << 8) | payload[0];
+    start_index = (payload[3] << 8) | payload[2];
+
+    return _respond_module_param_info(module_id, start_index);
+}
+
+/**
+ * @brief   Change envelope or LFO setting.
+ *
+ * Payload holds source, setting and value.
+ */
+static t_status _handle_module_set_mod_source(uint8_t *payload,
+                                              uint8_t length) {
+
+    if (length < 6) {
+        return ERROR;
+    }
+
+    return knl_mod_set_source(payload[0], payload[1], _unpack_u32(&payload[2]));
+}
+
+/**
+ * @brief   Open or close envelope gates.
+ *
+ * Payload holds envelope mask, gate and velocity.
+ */
+static t_status _handle_module_set_mod_gate(uint8_t *payload, uint8_t length) {
+
+    if (length < 6) {
+        return ERROR;
+    }
 
-    _transmit_message(MSG_TYPE_SYSTEM, SYSTEM_READY, NULL, 0);
+    knl_mod_gate(payload[0], payload[1], _unpack_u32(&payload[2]));
+
+    return SUCCESS;
+}
+
+/**
+ * @brief   Configure modulation route.
+ *
+ * Payload holds route index, source, via, module_id,
+ * param_index and depth.
+ */
+static t_status _handle_module_set_mod_route(uint8_t *payload,
+                                             uint8_t length) {
+
+    t_mod_route config;
+
+    if (length < 11) {
+        return ERROR;
+    }
+
+    config.source = payload[1];
+    config.via = payload[2];
+    config.module_id = (payload[4] << 8) | payload[3];
+    config.param_index = (payload[6] << 8) | payload[5];
+    config.depth = _unpack_u32(&payload[7]);
+
+    return knl_mod_set_route(payload[0], &config);
+}
+
+/**
+ * @brief   Replace module graph.
+ *
+ * Payload holds a type index and source node index for each
+ * node, in order of module_id.
+ */
+static t_status _handle_module_set_graph(uint8_t *payload, uint8_t length) {
+
+    t_module_node nodes[MODULE_MAX_NODES];
+    uint8_t count = length / 2;
+    uint8_t i;
+
+    // Type and source per node, no partial node.
+    if (length & 1 || count > MODULE_MAX_NODES) {
+        return ERROR;
+    }
+
+    for (i = 0; i < count; i++) {
+        nodes[i].type = payload[i * 2];
+        nodes[i].source = payload[i * 2 + 1];
+    }
+
+    return module_build_graph(nodes, count);
+}
+
+static t_status _handle_module_get_cycles(uint8_t *payload, uint8_t length) {
+
+    uint16_t module_id;
+
+    if (length < 2) {
+        return ERROR;
+    }
+
+    module_id = (payload[1] << 8) | payload[0];
+
+    _respond_module_cycles(module_id, module_get_cycles(module_id));
+
+    /// TODO: Error handling and protocol reset.
+    return SUCCESS;
+}
+
+// CPU resyncs parameters of nodes in graph once ready.
+static t_status _handle_system_check_ready(void) {
+
+    return _respond_system_check_ready(module_get_node_count());
+}
+
+static t_status _respond_system_check_ready(uint8_t node_count) {
+
+    _transmit_message(MSG_TYPE_SYSTEM, SYSTEM_READY, &node_count, 1);
 
     return SUCCESS;
 }
@@ -443,6 +898,179 @@ static t_status _handle_system_get_profile(void) {
     return SUCCESS;
 }
 
+/**
+ * @brief   Respond with extended profile.
+ *
+ * Payload byte 0 non-zero resets statistics after responding.
+ */
+static t_status _handle_system_get_profile_ext(uint8_t *payload,
+                                              uint8_t length) {
+
+    t_profile_ext stats = knl_profile_stats_ext();
+
+    _respond_system_profile_ext(stats);
+
+    if (length > 0 && payload[0] != 0) {
+        knl_profile_reset();
+    }
+
+    /// TODO: Error handling and protocol reset.
+    return SUCCESS;
+}
+
+static t_status _handle_system_get_frame_count(void) {
+
+    _respond_system_frame_count(knl_event_frame_count());
+
+    /// TODO: Error handling and protocol reset.
+    return SUCCESS;
+}
+
+static t_status _handle_system_get_link_stats(void) {
+
+    // Statistics of link carrying request.
+    _respond_system_link_stats(g_protocol[g_request_link].stats);
+
+    return SUCCESS;
+}
+
+// Return payload unchanged, for link benchmark.
+static t_status _handle_system_echo(uint8_t *payload, uint8_t length) {
+
+    _transmit_message(MSG_TYPE_SYSTEM, SYSTEM_ECHO_REPLY, payload, length);
+
+    return SUCCESS;
+}
+
+// Respond with DSP address of mailbox, for CPU to open HostDP link.
+static t_status _handle_system_get_hostdp_mailbox(void) {
+
+    uint8_t payload[4];
+
+    // Host port enabled only once CPU selects HostDP.
+    dev_cpu_hostdp_init();
+
+    _pack_u32(payload, dev_cpu_hostdp_address());
+
+    _transmit_message(MSG_TYPE_SYSTEM, SYSTEM_HOSTDP_MAILBOX, payload,
+                      sizeof(payload));
+
+    return SUCCESS;
+}
+
+/**
+ * @brief   Start upload to SDRAM region.
+ *
+ * Payload holds region id.
+ */
+static t_status _handle_system_region_open(uint8_t *payload, uint8_t length) {
+
+    if (length < 1) {
+        return ERROR;
+    }
+
+    return _respond_system_region_ack(payload[0], 0,
+                                      knl_region_open(payload[0]));
+}
+
+/**
+ * @brief   Write chunk of upload.
+ *
+ * Payload holds region id, offset, CRC-16 of data, then data.
+ */
+static t_status _handle_system_region_write(uint8_t *payload, uint8_t length) {
+
+    uint32_t offset;
+    uint16_t crc;
+    uint8_t status;
+
+    if (length < PROTOCOL_REGION_HEADER) {
+        return ERROR;
+    }
+
+    offset = _unpack_u32(&payload[1]);
+    crc = (payload[6] << 8) | payload[5];
+
+    status = knl_region_write(payload[0], offset,
+                              &payload[PROTOCOL_REGION_HEADER],
+                              length - PROTOCOL_REGION_HEADER, crc);
+
+    return _respond_system_region_ack(payload[0], offset, status);
+}
+
+/**
+ * @brief   Finish upload.
+ *
+ * Payload holds region id and valid length.
+ */
+static t_status _handle_system_region_close(uint8_t *payload, uint8_t length) {
+
+    uint32_t region_length;
+
+    if (length < 5) {
+        return ERROR;
+    }
+
+    region_length = _unpack_u32(&payload[1]);
+
+    return _respond_system_region_ack(payload[0], region_length,
+                                      knl_region_close(payload[0],
+                                                       region_length));
+}
+
+/**
+ * @brief   Start capture stream on link carrying request.
+ *
+ * Payload holds source, decimation, channel mask and ring depth.
+ */
+static t_status _handle_system_capture_start(uint8_t *payload,
+                                             uint8_t length) {
+
+    t_capture_config config;
+
+    if (length < 5) {
+        return ERROR;
+    }
+
+    config.source = payload[0];
+    config.decimation = payload[1];
+    config.channel_mask = payload[2];
+    config.depth = (payload[4] << 8) | payload[3];
+
+    if (knl_capture_start(&config) == SUCCESS) {
+        g_capture_link = g_request_link;
+    }
+
+    // CPU checks running flag for result.
+    return _respond_system_capture_status();
+}
+
+static t_status _handle_system_capture_stop(void) {
+
+    knl_capture_stop();
+
+    return _respond_system_capture_status();
+}
+
+/**
+ * @brief   Push telemetry at fixed interval on link carrying request.
+ *
+ * Payload holds interval in milliseconds, 0 stops telemetry.
+ */
+static t_status _handle_system_set_telemetry(uint8_t *payload,
+                                             uint8_t length) {
+
+    if (length < 2) {
+        return ERROR;
+    }
+
+    knl_telemetry_set_interval((payload[1] << 8) | payload[0]);
+
+    g_telemetry_link = g_request_link;
+
+    return SUCCESS;
+}
+
 static t_status _respond_module_param_value(uint16_t module_id,
                                             uint16_t param_index,
                                             int32_t param_value) {
@@ -485,6 +1113,114 @@ static t_status _respond_module_param_name(uint16_t module_id,
     return SUCCESS;
 }
 
+static t_status _respond_module_cycles(uint16_t module_id, uint32_t cycles) {
+
+    uint8_t payload[6];
+
+    payload[0] = module_id & 0xff;
+    payload[1] = (module_id >> 8) & 0xff;
+
+    _pack_u32(&payload[2], cycles);
+
+    _transmit_message(MSG_TYPE_MODULE, MODULE_CYCLES, payload,
+                      sizeof(payload));
+
+    return SUCCESS;
+}
+
+/**
+ * @brief   Send one chunk of parameter values.
+ *
+ * Payload holds module_id, first index, total parameter count,
+ * then up to ALL_PARAMS_CHUNK values.  The CPU requests the next
+ * chunk until all values are received.
+ */
+static t_status _respond_module_all_params(uint16_t module_id,
+                                          uint16_t start_index) {
+
+    uint8_t payload[6 + ALL_PARAMS_CHUNK * 4];
+    uint16_t count;
+    uint16_t i;
+
+    count = module_get_param_count(module_id);
+
+    payload[0] = module_id & 0xff;
+    payload[1] = (module_id >> 8) & 0xff;
+    payload[2] = start_index & 0xff;
+    payload[3] = (start_index >> 8) & 0xff;
+    payload[4] = count & 0xff;
+    payload[5] = (count >> 8) & 0xff;
+
+    for (i = 0; i < ALL_PARAMS_CHUNK && start_index + i < count; i++) {
+
+        _pack_u32(&payload[6 + i * 4],
+                  module_get_param(module_id, start_index + i));
+    }
+
+    _transmit_message(MSG_TYPE_MODULE, MODULE_ALL_PARAMS, payload, 6 + i * 4);
+
+    return SUCCESS;
+}
+
+/**
+ * @brief   Send one chunk of parameter descriptors.
+ *
+ * Payload holds module_id, first index, total parameter count,
+ * then as many descriptors as fit, each with range, initial
+ * value, scale, slew time and null terminated name.  The CPU
+ * requests the next chunk until all descriptors are received.
+ */
+static t_status _respond_module_param_info(uint16_t module_id,
+                                          uint16_t start_index) {
+
+    uint8_t payload[PROTOCOL_PAYLOAD_MAX];
+    const t_param_desc *desc;
+    uint16_t length = PROTOCOL_PARAM_INFO_HEADER;
+    uint16_t count;
+    uint16_t index;
+    uint8_t name_length;
+
+    count = module_get_param_count(module_id);
+
+    payload[0] = module_id & 0xff;
+    payload[1] = (module_id >> 8) & 0xff;
+    payload[2] = start_index & 0xff;
+    payload[3] = (start_index >> 8) & 0xff;
+    payload[4] = count & 0xff;
+    payload[5] = (count >> 8) & 0xff;
+
+    for (index = start_index; index < count; index++) {
+
+        desc = module_get_param_desc(module_id, index);
+
+        name_length = strlen(desc->name) < MAX_PARAM_NAME_LENGTH
+                          ? strlen(desc->name)
+                          : MAX_PARAM_NAME_LENGTH - 1;
+
+        if (length + PROTOCOL_PARAM_INFO_FIXED + name_length + 1 >
+            PROTOCOL_PAYLOAD_MAX) {
+            break;
+        }
+
+        _pack_u32(&payload[length], desc->min);
+        _pack_u32(&payload[length + 4], desc->max);
+        _pack_u32(&payload[length + 8], desc->init);
+        payload[length + 12] = desc->scale;
+        _pack_u16(&payload[length + 13], desc->slew_ms);
+
+        length += PROTOCOL_PARAM_INFO_FIXED;
+
+        memcpy(&payload[length], desc->name, name_length);
+        payload[length + name_length] = '\0';
+
+        length += name_length + 1;
+    }
+
+    _transmit_message(MSG_TYPE_MODULE, MODULE_PARAM_INFO, payload, length);
+
+    return SUCCESS;
+}
+
 static t_status _respond_system_port_state(uint16_t port_f, uint16_t port_g,
                                            uint16_t port_h) {
 
@@ -513,4 +1249,101 @@ static t_status _respond_system_profile(t_profile stats) {
     return SUCCESS;
 }
 
+static t_status _respond_system_profile_ext(t_profile_ext stats) {
+
+    uint8_t payload[32];
+
+    _pack_u32(&payload[0], stats.period);
+    _pack_u32(&payload[4], stats.cycles);
+    _pack_u32(&payload[8], stats.min);
+    _pack_u32(&payload[12], stats.max);
+    _pack_u32(&payload[16], stats.mean);
+    _pack_u32(&payload[20], stats.percentile);
+    _pack_u32(&payload[24], stats.blocks);
+    _pack_u32(&payload[28], stats.overruns);
+
+    _transmit_message(MSG_TYPE_SYSTEM, SYSTEM_PROFILE_EXT, payload,
+                      sizeof(payload));
+
+    return SUCCESS;
+}
+
+static t_status _respond_system_frame_count(uint32_t frame_count) {
+
+    uint8_t payload[4];
+
+    _pack_u32(payload, frame_count);
+
+    _transmit_message(MSG_TYPE_SYSTEM, SYSTEM_FRAME_COUNT, payload,
+                      sizeof(payload));
+
+    return SUCCESS;
+}
+
+static t_status _respond_system_link_stats(t_protocol_stats stats) {
+
+    uint8_t payload[20];
+
+    _pack_u32(&payload[0], stats.rx_frames);
+    _pack_u32(&payload[4], stats.tx_frames);
+    _pack_u32(&payload[8], stats.crc_errors);
+    _pack_u32(&payload[12], stats.frame_errors);
+    _pack_u32(&payload[16], stats.overflows);
+
+    _transmit_message(MSG_TYPE_SYSTEM, SYSTEM_LINK_STATS, payload,
+                      sizeof(payload));
+
+    return SUCCESS;
+}
+
+static t_status _respond_system_region_ack(uint8_t region_id, uint32_t offset,
+                                           uint8_t status) {
+
+    uint8_t payload[6];
+
+    payload[0] = region_id;
+    _pack_u32(&payload[1], offset);
+    payload[5] = status;
+
+    _transmit_message(MSG_TYPE_SYSTEM, SYSTEM_REGION_ACK, payload,
+                      sizeof(payload));
+
+    return status == REGION_OK ? SUCCESS : ERROR;
+}
+
+static t_status _respond_system_capture_status(void) {
+
+    t_capture_stats stats = knl_capture_stats();
+    uint8_t payload[9];
+
+    payload[0] = stats.running;
+    _pack_u32(&payload[1], stats.frames);
+    _pack_u32(&payload[5], stats.overruns);
+
+    _transmit_message(MSG_TYPE_SYSTEM, SYSTEM_CAPTURE_STATUS, payload,
+                      sizeof(payload));
+
+    return SUCCESS;
+}
+
+static void _pack_u16(uint8_t *payload, uint16_t value) {
+
+    payload[0] = value & 0xff;
+    payload[1] = (value >> 8) & 0xff;
+}
+
+static void _pack_u32(uint8_t *payload, uint32_t value) {
+
+    payload[0] = value & 0xff;
+    payload[1] = (value >> 8) & 0xff;
+    payload[2] = (value >> 16) & 0xff;
+    payload[3] = (value >> 24) & 0xff;
+}
+
+static uint32_t _unpack_u32(uint8_t *payload) {
+
+    return payload[0] | (payload[1] << 8) | (payload[2] << 16) |
+           ((uint32_t)payload[3] << 24);
+}
+
 /*----- End of file --------------------------------------------------*/
@@ -35,6 +35,7 @@ under the terms of the GNU Affero General Public License as published by
  *
  * @brief   A basic example module.
  *          Applies attenuation with slew to each input signal.
+ *          Kernel ramps each level, see knl_smooth.c.
  */
 
 /*----- Includes -----------------------------------------------------*/
@@ -44,15 +45,10 @@ under the terms of the GNU Affero General Public License as published by
 #include "module.h"
 #include "utils.h"
 
-#include "aleph.h"
-#include "aleph_lpf_one_pole.h"
-
 /*----- Macros -------------------------------------------------------*/
 
-#define MEMPOOL_SIZE (0x2000)
-
-#define PARAM_AMP_MAX 0x7fffffff      ///< Maximum amplitude scale value.
-#define PARAM_SLEW_DEFAULT 0x00010000 ///< Default parameter slew time.
+#define PARAM_AMP_MAX 0x7fffffff ///< Maximum amplitude scale value.
+#define PARAM_SLEW_MS 50         ///< Default parameter slew time.
 
 /*----- Typedefs -----------------------------------------------------*/
 
@@ -75,159 +71,106 @@ typedef struct {
     /// Input parameters for amplitude scaling.
     fract32 level[2];
 
-    /// Parameter slew filters.
-    Aleph_LPFOnePole level_slew[2];
+    /// Level increment per frame while kernel ramps level.
+    fract32 step[2];
 
 } t_module;
 
 /*----- Static variable definitions ----------------------------------*/
 
-static t_Aleph g_aleph;
-
-__attribute__((section(".l1.data.a")))
-__attribute__((aligned(32))) static char g_mempool[MEMPOOL_SIZE];
-
 static t_module g_module;
 
 /*----- Extern variable definitions ----------------------------------*/
 
 /*----- Static function prototypes -----------------------------------*/
 
+static void _module_init(void);
+static void _module_process(fract32 *in, fract32 *out, uint16_t frames);
+static void _ramp_level0(int32_t value, int32_t step);
+static void _ramp_level1(int32_t value, int32_t step);
+
+/// Parameter descriptors, indexed by e_param.
+//  Initial amp is -12db.
+static const t_param_desc g_params[PARAM_COUNT] = {
+    [PARAM_LEVEL0] = {"Level 0", 0, PARAM_AMP_MAX, PARAM_AMP_MAX >> 2,
+                      PARAM_SCALE_LINEAR, PARAM_SLEW_MS, NULL, _ramp_level0},
+    [PARAM_LEVEL1] = {"Level 1", 0, PARAM_AMP_MAX, PARAM_AMP_MAX >> 2,
+                      PARAM_SCALE_LINEAR, PARAM_SLEW_MS, NULL, _ramp_level1},
+};
+
+static int32_t g_values[PARAM_COUNT];
+
+/// Module type descriptor, listed in MODULE_TYPES.
+MODULE_EXPORT(attenuate) = {
+    .name = "attenuate",
+    .init = _module_init,
+    .process = _module_process,
+    .params = g_params,
+    .param_count = PARAM_COUNT,
+    .values = g_values,
+};
+
 /*----- Extern function implementations ------------------------------*/
 
+/*----- Static function implementations ------------------------------*/
+
 /**
  * @brief   Initialise module.
  *
- * Initialise parameters and slew filters.
+ * Kernel then sets initial values.
  */
-void module_init(void) {
-
-    Aleph_init(&g_aleph, SAMPLERATE, g_mempool, MEMPOOL_SIZE, NULL);
-
-    // Initialise 1pole filters for input attenuation slew.
-    Aleph_LPFOnePole_init(&g_module.level_slew[0], &g_aleph);
-    Aleph_LPFOnePole_init(&g_module.level_slew[1], &g_aleph);
-
-    // Set slew defaults.
-    Aleph_LPFOnePole_set_coeff(&g_module.level_slew[0], PARAM_SLEW_DEFAULT);
-    Aleph_LPFOnePole_set_coeff(&g_module.level_slew[1], PARAM_SLEW_DEFAULT);
+static void _module_init(void) {
 
-    // Set amp to -12db.
-    module_set_param(PARAM_LEVEL0, PARAM_AMP_MAX >> 2);
-    module_set_param(PARAM_LEVEL1, PARAM_AMP_MAX >> 2);
+    //
 }
 
 /**
  * @brief   Process audio.
  *
- * Update slewed parameters and scale audio amplitude.
+ * Scale audio amplitude and step levels towards ramp target.
  *
- * @param[in]   in  Pointer to input buffer.
- * @param[out]  out Pointer to input buffer.
+ * @param[in]   in      Pointer to input buffer.
+ * @param[out]  out     Pointer to output buffer.
+ * @param[in]   frames  Number of interleaved frames in each buffer.
  */
-void module_process(fract32 *in, fract32 *out) {
-
-    // Process parameter slew.
-    g_module.level[0] = Aleph_LPFOnePole_next(&g_module.level_slew[0]);
-    g_module.level[1] = Aleph_LPFOnePole_next(&g_module.level_slew[1]);
-
-    // Process audio samples.
-    out[0] = mult_fr1x32x32(in[0], g_module.level[0]);
-    out[1] = mult_fr1x32x32(in[1], g_module.level[1]);
-}
-
-/**
- * @brief   Set parameter.
- *
- * Set input to parameter slew filters.
- *
- * @param[in]   param_index Index of parameter to set.
- * @param[in]   vallue      Value of parameter.
- */
-void module_set_param(uint16_t param_index, int32_t value) {
-
-    switch (param_index) {
+static void _module_process(fract32 *in, fract32 *out, uint16_t frames) {
 
-    // Input attenuation values
-    case PARAM_LEVEL0:
+    while (frames--) {
 
-        value = value < PARAM_AMP_MAX ? value : PARAM_AMP_MAX;
-        // Add value to slew filter to avoid stepping.
-        Aleph_LPFOnePole_set_target(&g_module.level_slew[0], value);
-        break;
+        // Process audio samples.
+        *out++ = mult_fr1x32x32(*in++, g_module.level[0]);
+        *out++ = mult_fr1x32x32(*in++, g_module.level[1]);
 
-    case PARAM_LEVEL1:
-
-        value = value < PARAM_AMP_MAX ? value : PARAM_AMP_MAX;
-        Aleph_LPFOnePole_set_target(&g_module.level_slew[1], value);
-        break;
-
-    default:
-        break;
+        // Ramp lands on target at end of block.
+        g_module.level[0] += g_module.step[0];
+        g_module.level[1] += g_module.step[1];
     }
 }
 
 /**
- * @brief   Get parameter.
- *
- * Return current slew value of parameter.
+ * @brief   Set channel 0 level and increment per frame.
  *
- * @param[in]   param_index Index of parameter to get.
+ * Kernel clamps value to descriptor range.
  *
- * @return      value       Value of parameter.
+ * @param[in]   value   Attenuation multiplier at first frame of block.
+ * @param[in]   step    Added to multiplier after each frame.
  */
-int32_t module_get_param(uint16_t param_index) {
-
-    int32_t value = 0;
-
-    switch (param_index) {
+static void _ramp_level0(int32_t value, int32_t step) {
 
-    // Input attenuation values
-    case PARAM_LEVEL0:
-        value = g_module.level[0];
-
-    case PARAM_LEVEL1:
-        value = g_module.level[1];
-
-    default:
-        break;
-    }
-
-    return value;
+    g_module.level[0] = value;
+    g_module.step[0] = step;
 }
 
-/// TODO: Return uint16_t?
 /**
- * @brief   Get number of parameters.
+ * @brief   Set channel 1 level and increment per frame.
  *
- * @return  Number of parameters
+ * @param[in]   value   Attenuation multiplier at first frame of block.
+ * @param[in]   step    Added to multiplier after each frame.
  */
-uint32_t module_get_param_count(void) { return PARAM_COUNT; }
+static void _ramp_level1(int32_t value, int32_t step) {
 
-/**
- * @brief   Get name of parameter at index.
- *
- * @param[in]   param_index     Index pf parameter.
- * @param[out]  text            Buffer to store string.
- *                              Must provide 'MAX_PARAM_NAME_LENGTH'
- *                              bytes of storage.
- */
-void module_get_param_name(uint16_t param_index, char *text) {
-
-    switch (param_index) {
-
-    // Input attenuation values
-    case PARAM_LEVEL0:
-        copy_string(text, "Level 0", MAX_PARAM_NAME_LENGTH);
-
-    case PARAM_LEVEL1:
-        copy_string(text, "Level 1", MAX_PARAM_NAME_LENGTH);
-
-    default:
-        break;
-    }
+    g_module.level[1] = value;
+    g_module.step[1] = step;
 }
 
-/*----- Static function implementations ------------------------------*/
-
 /*----- End of file --------------------------------------------------*/
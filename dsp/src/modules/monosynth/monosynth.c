@@ -50,15 +50,24 @@ under the terms of the GNU Affero General Public License as published by
 
 #define MEMPOOL_SIZE (0x2000)
 
-/// TODO: Struct for parameter type.
-///         scaler,
-///         range,
-///         default,
-///         display,
-///         etc...,
-
 // #define DEFAULT_CUTOFF 0x7f // Index in pitch LUT.
 #define DEFAULT_OSC_TYPE 2
+#define DEFAULT_FREQ (220 << 16)
+#define DEFAULT_CUTOFF 0x326f6abb
+
+/// Oscillator shapes and filter types, see CPU module_interface.h.
+#define OSC_TYPE_MAX 3
+#define FILTER_TYPE_MAX 2
+
+/// Amp level ramp, see knl_smooth.c.
+#define AMP_LEVEL_SLEW_MS 20
+
+/// Tune is frequency ratio in fix16.
+#define TUNE_MAX (FIX16_ONE * 4)
+
+/// Descriptor for parameter handled by CPU, value only stored.
+#define PARAM_CPU(name)                                                        \
+    {name, 0, FR32_MAX, 0, PARAM_SCALE_LINEAR, 0, NULL}
 
 /// TODO: Move to common location.
 /**
@@ -115,6 +124,8 @@ typedef struct {
 
     Aleph_MonoVoice voice;
     fract32 amp_level;
+    // Amp level increment per frame while kernel ramps level.
+    fract32 amp_step;
     fract32 velocity;
 
 } t_module;
@@ -131,143 +142,170 @@ static t_module g_module;
 
 /*----- Static function prototypes -----------------------------------*/
 
+static void _module_init(void);
+static void _module_process(fract32 *in, fract32 *out, uint16_t frames);
+static void _set_amp(int32_t value);
+static void _set_freq(int32_t value);
+static void _set_osc_phase(int32_t value);
+static void _ramp_amp_level(int32_t value, int32_t step);
+static void _set_cutoff(int32_t value);
+static void _set_res(int32_t value);
+static void _set_tune(int32_t value);
+static void _set_osc_type(int32_t value);
+static void _set_filter_type(int32_t value);
+
+/// Parameter descriptors, indexed by e_param.
+//  Envelopes and LFOs are kernel modulation sources routed to
+//  Amp, Cutoff and Freq, so their parameters are only stored.
+static const t_param_desc g_params[PARAM_COUNT] = {
+    [PARAM_AMP] = {"Amp", 0, FR32_MAX, 0, PARAM_SCALE_LINEAR, 0, _set_amp},
+    [PARAM_FREQ] = {"Freq", 0, INT32_MAX, DEFAULT_FREQ, PARAM_SCALE_EXP, 0,
+                    _set_freq},
+    [PARAM_OSC_PHASE] = {"Osc Phase", 0, FR32_MAX, 0, PARAM_SCALE_LINEAR, 0,
+                         _set_osc_phase},
+    [PARAM_LFO_PHASE] = PARAM_CPU("LFO Phase"),
+    [PARAM_GATE] = {"Gate", 0, 1, 0, PARAM_SCALE_TOGGLE, 0, NULL},
+    [PARAM_VEL] = PARAM_CPU("Velocity"),
+    [PARAM_AMP_LEVEL] = {"Amp Level", 0, FR32_MAX, FR32_MAX,
+                         PARAM_SCALE_LINEAR, AMP_LEVEL_SLEW_MS, NULL,
+                         _ramp_amp_level},
+    [PARAM_AMP_ENV_ATTACK] = PARAM_CPU("Amp Attack"),
+    [PARAM_AMP_ENV_DECAY] = PARAM_CPU("Amp Decay"),
+    [PARAM_AMP_ENV_SUSTAIN] = PARAM_CPU("Amp Sustain"),
+    [PARAM_AMP_ENV_RELEASE] = PARAM_CPU("Amp Release"),
+    [PARAM_AMP_ENV_DEPTH] = PARAM_CPU("Amp Env Depth"),
+    [PARAM_FILTER_ENV_DEPTH] = PARAM_CPU("Flt Env Depth"),
+    [PARAM_FILTER_ENV_ATTACK] = PARAM_CPU("Flt Attack"),
+    [PARAM_FILTER_ENV_DECAY] = PARAM_CPU("Flt Decay"),
+    [PARAM_FILTER_ENV_SUSTAIN] = PARAM_CPU("Flt Sustain"),
+    [PARAM_FILTER_ENV_RELEASE] = PARAM_CPU("Flt Release"),
+    [PARAM_PITCH_ENV_DEPTH] = PARAM_CPU("Pitch Env Depth"),
+    [PARAM_PITCH_ENV_ATTACK] = PARAM_CPU("Pitch Attack"),
+    [PARAM_PITCH_ENV_DECAY] = PARAM_CPU("Pitch Decay"),
+    [PARAM_PITCH_ENV_SUSTAIN] = PARAM_CPU("Pitch Sustain"),
+    [PARAM_PITCH_ENV_RELEASE] = PARAM_CPU("Pitch Release"),
+    [PARAM_CUTOFF] = {"Cutoff", 0, INT32_MAX, DEFAULT_CUTOFF, PARAM_SCALE_EXP,
+                      0, _set_cutoff},
+    [PARAM_RES] = {"Resonance", 0, FR32_MAX, FR32_MAX, PARAM_SCALE_LINEAR, 0,
+                   _set_res},
+    [PARAM_TUNE] = {"Tune", 0, TUNE_MAX, FIX16_ONE, PARAM_SCALE_EXP, 0,
+                    _set_tune},
+    [PARAM_OSC_TYPE] = {"Osc Type", 0, OSC_TYPE_MAX, DEFAULT_OSC_TYPE,
+                        PARAM_SCALE_ENUM, 0, _set_osc_type},
+    [PARAM_FILTER_TYPE] = {"Filter Type", 0, FILTER_TYPE_MAX, 0,
+                           PARAM_SCALE_ENUM, 0, _set_filter_type},
+    [PARAM_AMP_LFO_DEPTH] = PARAM_CPU("Amp LFO Depth"),
+    [PARAM_AMP_LFO_SPEED] = PARAM_CPU("Amp LFO Speed"),
+    [PARAM_FILTER_LFO_DEPTH] = PARAM_CPU("Flt LFO Depth"),
+    [PARAM_FILTER_LFO_SPEED] = PARAM_CPU("Flt LFO Speed"),
+    [PARAM_PITCH_LFO_DEPTH] = PARAM_CPU("Pitch LFO Depth"),
+    [PARAM_PITCH_LFO_SPEED] = PARAM_CPU("Pitch LFO Speed"),
+    [PARAM_OSC_BASE_FREQ] = PARAM_CPU("Osc Base Freq"),
+    [PARAM_FILTER_BASE_CUTOFF] = PARAM_CPU("Flt Base Cutoff"),
+    [PARAM_PHASE_RESET] = {"Phase Reset", 0, 1, 0, PARAM_SCALE_TOGGLE, 0,
+                           NULL},
+    [PARAM_RETRIGGER] = {"Retrigger", 0, 1, 0, PARAM_SCALE_TOGGLE, 0, NULL},
+};
+
+static int32_t g_values[PARAM_COUNT];
+
+/// Module type descriptor, listed in MODULE_TYPES.
+MODULE_EXPORT(monosynth) = {
+    .name = "monosynth",
+    .init = _module_init,
+    .process = _module_process,
+    .params = g_params,
+    .param_count = PARAM_COUNT,
+    .values = g_values,
+};
+
 /*----- Extern function implementations ------------------------------*/
 
+/*----- Static function implementations ------------------------------*/
+
 /**
  * @brief   Initialise module.
+ *
+ * Kernel then sets initial parameter values from g_params.
  */
-void module_init(void) {
+static void _module_init(void) {
 
     Aleph_init(&g_aleph, SAMPLERATE, g_mempool, MEMPOOL_SIZE, NULL);
 
     Aleph_MonoVoice_init(&g_module.voice, &g_aleph);
-
-    /// TODO: Define defaults.
-
-    module_set_param(PARAM_AMP_LEVEL, FR32_MAX);
-    module_set_param(PARAM_OSC_TYPE, 2);
-    module_set_param(PARAM_FREQ, 220 << 16);
-    module_set_param(PARAM_TUNE, FIX16_ONE);
-    module_set_param(PARAM_CUTOFF, 0x326f6abb);
-    module_set_param(PARAM_RES, FR32_MAX);
 }
 
 /**
  * @brief   Process audio.
  *
- * @param[in]   in  Pointer to input buffer.
- * @param[out]  out Pointer to input buffer.
+ * @param[in]   in      Pointer to input buffer.
+ * @param[out]  out     Pointer to output buffer.
+ * @param[in]   frames  Number of interleaved frames in each buffer.
  */
-void module_process(fract32 *in, fract32 *out) {
+static void _module_process(fract32 *in, fract32 *out, uint16_t frames) {
 
     fract32 output;
 
-    output = Aleph_MonoVoice_next(&g_module.voice);
+    while (frames--) {
 
-    // Scale amplitude by level.
-    output = mult_fr1x32x32(output, g_module.amp_level);
+        output = Aleph_MonoVoice_next(&g_module.voice);
 
-    // Set output.
-    out[0] = output;
-    out[1] = output;
-}
+        // Scale amplitude by level.
+        output = mult_fr1x32x32(output, g_module.amp_level);
+        g_module.amp_level += g_module.amp_step;
 
-/**
- * @brief   Set parameter.
- *
- * @param[in]   param_index Index of parameter to set.
- * @param[in]   value       Value of parameter.
- */
-void module_set_param(uint16_t param_index, int32_t value) {
+        // Set output.
+        *out++ = output;
+        *out++ = output;
+    }
+}
 
-    switch (param_index) {
+// Parameter setters, values clamped to descriptor range by kernel.
 
-    case PARAM_AMP:
-        Aleph_MonoVoice_set_amp(&g_module.voice, value);
-        break;
+static void _set_amp(int32_t value) {
 
-    case PARAM_FREQ:
-        Aleph_MonoVoice_set_freq(&g_module.voice, value);
-        break;
+    Aleph_MonoVoice_set_amp(&g_module.voice, value);
+}
 
-    case PARAM_OSC_PHASE:
-        Aleph_MonoVoice_set_phase(&g_module.voice, value);
-        break;
+static void _set_freq(int32_t value) {
 
-    case PARAM_TUNE:
-        Aleph_MonoVoice_set_freq_offset(&g_module.voice, value);
-        break;
+    Aleph_MonoVoice_set_freq(&g_module.voice, value);
+}
 
-    case PARAM_AMP_LEVEL:
-        g_module.amp_level = value;
-        break;
+static void _set_osc_phase(int32_t value) {
 
-    case PARAM_CUTOFF:
-        Aleph_MonoVoice_set_cutoff(&g_module.voice, value);
-        break;
+    Aleph_MonoVoice_set_phase(&g_module.voice, value);
+}
 
-    case PARAM_RES:
-        Aleph_MonoVoice_set_res(&g_module.voice, value);
-        break;
+static void _ramp_amp_level(int32_t value, int32_t step) {
 
-    case PARAM_OSC_TYPE:
-        Aleph_MonoVoice_set_shape(&g_module.voice, value);
-        break;
+    g_module.amp_level = value;
+    g_module.amp_step = step;
+}
 
-    case PARAM_FILTER_TYPE:
-        Aleph_MonoVoice_set_filter_type(&g_module.voice, value);
-        break;
+static void _set_cutoff(int32_t value) {
 
-    default:
-        break;
-    }
+    Aleph_MonoVoice_set_cutoff(&g_module.voice, value);
 }
 
-/**
- * @brief   Get parameter.
- *
- * @param[in]   param_index Index of parameter to get.
- *
- * @return      value       Value of parameter.
- */
-int32_t module_get_param(uint16_t param_index) {
-
-    int32_t value = 0;
+static void _set_res(int32_t value) {
 
-    switch (param_index) {
+    Aleph_MonoVoice_set_res(&g_module.voice, value);
+}
 
-    default:
-        break;
-    }
+static void _set_tune(int32_t value) {
 
-    return value;
+    Aleph_MonoVoice_set_freq_offset(&g_module.voice, value);
 }
 
-/**
- * @brief   Get number of parameters.
- *
- * @return  Number of parameters
- */
-uint32_t module_get_param_count(void) { return PARAM_COUNT; }
+static void _set_osc_type(int32_t value) {
 
-/**
- * @brief   Get name of parameter at index.
- *
- * @param[in]   param_index     Index pf parameter.
- * @param[out]  text            Buffer to store string.
- *                              Must provide 'MAX_PARAM_NAME_LENGTH'
- *                              bytes of storage.
- */
-void module_get_param_name(uint16_t param_index, char *text) {
+    Aleph_MonoVoice_set_shape(&g_module.voice, value);
+}
 
-    switch (param_index) {
+static void _set_filter_type(int32_t value) {
 
-    default:
-        copy_string(text, "Unknown", MAX_PARAM_NAME_LENGTH);
-        break;
-    }
+    Aleph_MonoVoice_set_filter_type(&g_module.voice, value);
 }
 
-/*----- Static function implementations ------------------------------*/
-
 /*----- End of file --------------------------------------------------*/
@@ -60,16 +60,42 @@ enum params {
 
 /*----- Static variable definitions ----------------------------------*/
 
+/// Parameter descriptors, indexed by enum params, e.g.
+//
+// static const t_param_desc g_params[PARAM_COUNT] = {
+//     [PARAM_LEVEL] = {"Level", 0, FR32_MAX, FR32_MAX, PARAM_SCALE_LINEAR,
+//                      10, _set_level},
+// };
+//
+// static int32_t g_values[PARAM_COUNT];
+
 /*----- Extern variable definitions ----------------------------------*/
 
 /*----- Static function prototypes -----------------------------------*/
 
+static void _module_init(void);
+static void _module_process(fract32 *in, fract32 *out, uint16_t frames);
+
+/// Module type descriptor, listed in MODULE_TYPES.
+/// Name must match module directory.
+MODULE_EXPORT(template) = {
+    .name = "template",
+    .init = _module_init,
+    .process = _module_process,
+    // No parameters, see g_params above to add some.
+    .params = NULL,
+    .param_count = PARAM_COUNT,
+    .values = NULL,
+};
+
 /*----- Extern function implementations ------------------------------*/
 
+/*----- Static function implementations ------------------------------*/
+
 /**
  * @brief   Initialise module.
  */
-void module_init(void) {
+static void _module_init(void) {
 
     //
 }
@@ -77,73 +103,12 @@ void module_init(void) {
 /**
  * @brief   Process audio.
  *
- * @param[in]   in  Pointer to input buffer.
- * @param[out]  out Pointer to input buffer.
+ * @param[in]   in      Pointer to input buffer.
+ * @param[out]  out     Pointer to output buffer.
+ * @param[in]   frames  Number of interleaved frames in each buffer.
  */
-void module_process(fract32 *in, fract32 *out) {
+static void _module_process(fract32 *in, fract32 *out, uint16_t frames) {
     //
 }
 
-/**
- * @brief   Set parameter.
- *
- * @param[in]   param_index Index of parameter to set.
- * @param[in]   value      Value of parameter.
- */
-void module_set_param(uint16_t param_index, int32_t value) {
-
-    switch (param_index) {
-
-    default:
-        break;
-    }
-}
-
-/**
- * @brief   Get parameter.
- *
- * @param[in]   param_index Index of parameter to get.
- *
- * @return      value       Value of parameter.
- */
-int32_t module_get_param(uint16_t param_index) {
-
-    int32_t value = 0;
-
-    switch (param_index) {
-
-    default:
-        break;
-    }
-
-    return value;
-}
-
-/**
- * @brief   Get number of parameters.
- *
- * @return  Number of parameters
- */
-uint32_t module_get_param_count(void) { return PARAM_COUNT; }
-
-/**
- * @brief   Get name of parameter at index.
- *
- * @param[in]   param_index     Index pf parameter.
- * @param[out]  text            Buffer to store string.
- *                              Must provide 'MAX_PARAM_NAME_LENGTH'
- *                              bytes of storage.
- */
-void module_get_param_name(uint16_t param_index, char *text) {
-
-    switch (param_index) {
-
-    default:
-        copy_string(text, "Unknown", MAX_PARAM_NAME_LENGTH);
-        break;
-    }
-}
-
-/*----- Static function implementations ------------------------------*/
-
 /*----- End of file --------------------------------------------------*/